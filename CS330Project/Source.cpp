@@ -9,7 +9,13 @@
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
+#include <algorithm>
+#include <filesystem>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory_resource>
+#include <sstream>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -20,7 +26,23 @@
 #include "headers/stb_image.h"      // Image loading Utility functions
 #include "headers/Camera.h"
 #include "headers/Sphere.h"
+#include "headers/Icosphere.h"
+#include "headers/Cubesphere.h"
+#include "headers/SphereTopology.h"
 #include "headers/Cylinder.h"
+#include "headers/TextureArray.h"
+#include "headers/TextureLoader.h"
+#include "headers/AssetManager.h"
+#include "headers/MeshUpload.h"
+#include "headers/MeshOptimizer.h"
+#include "headers/MeshSimplifier.h"
+#include "headers/Meshlets.h"
+#include "headers/GpuCulling.h"
+#include "headers/MeshKernels.h"
+#include "headers/Scene.h"
+#include "headers/StaticPrimitives.h"
+#include "headers/TessellationPlanner.h"
+#include "headers/ThreadPool.h"
 
  /*Shader program Macro*/
 #ifndef GLSL
@@ -36,14 +58,78 @@ const unsigned int SCR_HEIGHT = 600;
 
 const float PI = 3.1415926f;
 
-// mesh struct to contain the vertex array object and buffer objects
-struct GLMesh
+// optional: pack the object textures into GL_TEXTURE_2D_ARRAYs so they are bound once instead of per draw
+const bool USE_TEXTURE_ARRAYS = false;
+const int MAX_TEXTURE_ARRAYS = 4;       // size of the uTextureArrays sampler array
+const int TEXTURE_ARRAY_UNIT = 2;       // first texture unit used by the arrays (0 and 1 stay 2D)
+
+// scene description. the compiled binary (tools/SceneCompile) is used in place; the text form is parsed when the
+// binary is missing or older than it
+const char* const SCENE_BINARY_FILE = "scenes/desk.scenebin";
+const char* const SCENE_TEXT_FILE = "scenes/desk.scene";
+const unsigned int MAX_LIGHTS = 2;      // lights supported by the shaders
+
+// vertex layout of the scene meshes: VERTEX_FORMAT_PACKED (16 bytes) or VERTEX_FORMAT_FLOAT (32 bytes)
+const VertexFormat MESH_VERTEX_FORMAT = VERTEX_FORMAT_PACKED;
+// remove degenerate triangles and reorder generated meshes for the vertex cache before buffering them
+const bool OPTIMIZE_MESHES = true;
+// draw smooth spheres and cylinders as one triangle strip per stack (about 1/3 of the indices, but more vertex shading than optimized lists)
+const bool USE_TRIANGLE_STRIPS = false;
+// generated meshes with at least this many vertices split their rows over all threads, one mesh at a time;
+// smaller ones are built whole, one mesh per thread
+const unsigned int MESH_ROW_SPLIT_VERTICES = 65536;
+// allocate the generated meshes from one monotonic arena that is freed in one go once they are buffered to GPU
+const bool USE_MESH_ARENA = true;
+// replace the sectors and stacks of the scene file by the fewest within an error bound (TessellationPlanner.h): the chord error in pixels at
+// TESSELLATION_REFERENCE_DISTANCE from the camera (in world units with a distance of 0) and the angle between neighbouring face normals in degrees (0 for no limit)
+const bool PLAN_TESSELLATION = true;
+const float TESSELLATION_MAX_CHORD_ERROR = 0.5f;
+const float TESSELLATION_REFERENCE_DISTANCE = 5.0f;     // start distance of the camera from the scene
+const float TESSELLATION_MAX_NORMAL_ERROR = 30.0f;
+// planned counts are rounded up to 3, 4, 6, 8, 12, 16, 24, ... so meshes of similar size still share a unit mesh (SHARE_UNIT_PRIMITIVES), at
+// up to 1.5 times the planned triangles. TESSELLATION_SNAP_TO_STATIC takes STATIC_MESH_SECTORS x STATIC_MESH_STACKS whenever the plan fits in it
+// (except for straight cylinders, which keep 1 stack), so those meshes keep the compile-time generators at the cost of more triangles than planned
+const bool TESSELLATION_ROUND_COUNTS = true;
+const bool TESSELLATION_SNAP_TO_STATIC = false;
+// coarser LODs of the optimized generated meshes (MeshSimplifier.h), up to MESH_LOD_COUNT with MESH_LOD_RATIO of the triangles of the one before;
+// each object draws the coarsest LOD whose error covers at most MESH_LOD_PIXEL_ERROR pixels at its distance from the camera
+const bool BUILD_MESH_LODS = true;
+const unsigned int MESH_LOD_COUNT = 4;      // at most MAX_MESH_LODS
+const float MESH_LOD_RATIO = 0.5f;
+const float MESH_LOD_PIXEL_ERROR = 1.0f;
+// how the objects are culled; the paths are exclusive, so OBJECT_CULLING picks one:
+// - OBJECT_CULLING_NONE: every object is drawn whole, at the LOD picked on the CPU
+// - OBJECT_CULLING_MESHLETS: the optimized generated meshes are split into meshlets (Meshlets.h) and only those in the frustum that face the
+//   camera are drawn, with one glMultiDrawElementsIndirect() per object
+// - OBJECT_CULLING_GPU: compute shaders test every object against the frustum, pick its LOD and write the indirect draws (GpuCulling.h), and
+//   the CPU only draws each batch of consecutive objects with one material and mesh. no meshlets are built, so objects are culled whole:
+//   there is no meshlet frustum or normal cone culling. needs OpenGL 4.3 with vertex shader SSBOs; without them OBJECT_CULLING_MESHLETS is used
+// GPU_OCCLUSION_CULLING also culls objects behind the depth of the previous frame, so an object coming out from behind another can show a frame late
+enum ObjectCulling
 {
-    GLuint vao;         // variable for the vertex array object
-    GLuint vbo;         // variable for the vertex buffer object
-    GLuint ebo;         // variable for the element buffer object
-    GLuint nIndices;    // number of indices for the mesh
+    OBJECT_CULLING_NONE,
+    OBJECT_CULLING_MESHLETS,
+    OBJECT_CULLING_GPU
 };
+const ObjectCulling OBJECT_CULLING = OBJECT_CULLING_GPU;
+const bool GPU_OCCLUSION_CULLING = false;
+// tessellation of the scene's smooth spheres and cylinders; these use the compile-time generators of StaticPrimitives.h
+const int STATIC_MESH_SECTORS = 24;
+const int STATIC_MESH_STACKS = 12;
+// generator of the scene's smooth spheres. SPHERE_TOPOLOGY_ICO and SPHERE_TOPOLOGY_CUBE build them with the chord error their sectors and stacks
+// would give a UV sphere, from fewer triangles (tools/SphereBudget); SPHERE_TOPOLOGY_UV keeps Sphere and its strips
+const SphereTopology SPHERE_TOPOLOGY = SPHERE_TOPOLOGY_ICO;
+// share one unit sphere, cylinder or cone per tessellation (and cone radius ratio) between scene meshes; the size goes into the model matrices.
+// changing the size of a scene mesh at run time (e.g. every frame) is done through its model matrix too: the scene meshes are optimized,
+// shared and their generators freed, so none keeps the vertex order of a live Sphere or Cylinder. updateMeshVertices() (MeshUpload.h)
+// is for standalone meshes uploaded with uploadMesh(mesh, view) from a Sphere or Cylinder that is kept alive
+const bool SHARE_UNIT_PRIMITIVES = true;
+// draw flat spheres and cylinders with the smooth vertices and face normals from screen-space derivatives in the fragment shader,
+// instead of building a vertex per triangle corner (the legacy flat vertices of Sphere and Cylinder, used when this is false)
+const bool SHADER_FLAT_SHADING = true;
+// wireframe overlay, toggled with L: edge color (with alpha) and width in pixels
+const float WIREFRAME_COLOR[4] = { 0.1f, 1.0f, 0.3f, 0.9f };
+const float WIREFRAME_LINE_WIDTH = 1.5f;
 
 // camera
 Camera gCamera(glm::vec3(0.0f, 0.0f, 5.0f));
@@ -54,55 +140,76 @@ bool gFirstMouse = true;
 float gDeltaTime = 0.0f; // time between current frame and last frame
 float gLastFrame = 0.0f;
 
+bool gWireframe = false;        // draw the triangle edges over the scene
+bool gWireframeKeyDown = false; // L was down last frame, so holding it toggles once
+
 GLFWwindow* window = nullptr;
 
-// mesh objects
-GLMesh meshBottleSphere;
-GLMesh meshBottleTopCylinder;
-GLMesh meshBottleBottomCylinder;
-GLMesh meshPenCone;
-GLMesh meshPenCylinder;
-GLMesh meshPenSphere;
-GLMesh meshPerfume;
-GLMesh meshBox;
-GLMesh meshPlane;
-GLMesh meshLight;
-
-// sphere objects
-Sphere bottleSphere;
-Sphere penSphere;
-
-// cylinder objects
-Cylinder bottleBottomCylinder;
-Cylinder bottleTopCylinder;
-Cylinder perfumeCylinder;
-Cylinder penCylinder;
-Cylinder penCone;
+// shared textures, meshes and programs
+AssetManager gAssets;
+
+// scene and the GPU assets it uses, indexed like the scene's mesh and texture arrays
+Scene gScene;
+std::vector<MeshHandle> gSceneMeshes;
+std::vector<TextureHandle> gSceneTextures;
+std::vector<TextureLayer> gSceneTextureLayers; // only used with USE_TEXTURE_ARRAYS
+std::vector<glm::mat4> gObjectModels;           // scene model matrices, scaled for unit meshes with SHARE_UNIT_PRIMITIVES
+std::vector<bool> gSceneMeshFlatShading;        // per scene mesh, flat shaded from smooth vertices with SHADER_FLAT_SHADING
+std::vector<unsigned int> gSceneMeshGpuMeshes;  // per scene mesh, the index of its GLMesh among the distinct ones (shared unit meshes have one)
+std::vector<unsigned int> gObjectOrder;         // draw order of the objects: by material, then GPU mesh and flat shading
+
+// how prepareObjectDraws() has each object drawn this frame: its LOD whole, or the indirect commands of its visible meshlets
+struct ObjectDraw
+{
+    unsigned int lod;
+    bool indirect;
+    unsigned int firstCommand;      // in gIndirectCommands
+    unsigned int commandCount;
+};
+std::vector<ObjectDraw> gObjectDraws;
+std::vector<DrawElementsIndirectCommand> gIndirectCommands;
+GLuint gIndirectBuffer = 0;                     // gIndirectCommands, refilled every frame
 
-// shader programs
-GLuint objectProgramId;
-GLuint planeProgramId;
-GLuint lightProgramId;
+// culling path of this run: OBJECT_CULLING, unless the GPU path is not supported
+ObjectCulling gObjectCulling = OBJECT_CULLING_NONE;
 
-glm::vec3 gObjectColor(1.0f, 0.2f, 0.0f);
+// objects culled and drawn by the GPU (OBJECT_CULLING_GPU): the batch of each, NO_GPU_BATCH for those drawn one by one
+const unsigned int NO_GPU_BATCH = 0xffffffff;
+GpuCuller gGpuCuller;
+std::vector<unsigned int> gObjectBatches;
+
+// mesh drawn for every light
+MeshHandle meshLight;
+
+// a sphere or cylinder written to memory by generateMesh(), on any thread, and buffered to GPU by uploadGeneratedMesh()
+struct GeneratedMesh
+{
+    explicit GeneratedMesh(std::pmr::memory_resource* resource)
+        : source(nullptr), vertices(resource), indices(resource), strips(false), optimized(false) {}
+
+    const SceneMesh* source;
+    std::string name;
+    std::pmr::vector<float> vertices;       // sized by sizeGeneratedMesh(), on the loading thread
+    std::pmr::vector<unsigned int> indices;
+    std::vector<MeshLod> lods;  // LOD ranges of indices, empty without LODs
+    std::vector<Meshlet> meshlets;              // meshlets of each LOD (or of all indices), empty without
+    std::vector<unsigned int> lodFirstMeshlet;  // first meshlet of each LOD, then the meshlet count
+    bool strips;                // indices are triangle strips with primitive restart
+    bool optimized;             // stats are valid
+    MeshOptimizeStats stats;
+};
 
-// light position, scale, and color
-glm::vec3 lightColor1(1.0f, 1.0f, 1.0f); // white light
-glm::vec3 lightPosition1(0.0f, 4.0f, 2.0f);// place light up on y-axis and forward on z-axis
-glm::vec3 lightColor2(1.0f, 1.0f, 0.8784f); // soft yellow light
-glm::vec3 lightPosition2(0.0f, -1.0f, -4.0f); // place light down on y-axis and back on z-axis
-glm::vec3 lightScale(0.2f);
+// shader programs
+ProgramHandle objectProgram;
+ProgramHandle objectArrayProgram;
+ProgramHandle planeProgram;
+ProgramHandle lightProgram;
+ProgramHandle wireframeProgram;
 
-GLuint textureId;
-glm::vec2 textureScale(1.0f, 1.0f);
+glm::vec3 gObjectColor(1.0f, 0.2f, 0.0f);
 
-// variables for textures
-GLuint glassTextureId;
-GLuint labelTextureId;
-GLuint planeTextureId;
-GLuint penTextureId;
-GLuint boxTextureId;
-GLuint perfumeTextureId;
+// texture arrays of the object textures (only used with USE_TEXTURE_ARRAYS)
+TextureArraySet gTextureArrays;
 
 // user defined functions
 void resizeWindow(GLFWwindow* window, int width, int height);
@@ -112,14 +219,40 @@ void processMouseScroll(GLFWwindow* window, double xoffset, double yoffset);
 void createPlaneMesh(GLMesh& mesh);
 void createLightMesh(GLMesh& mesh);
 void createBoxMesh(GLMesh& mesh);
-void createSphereMesh(GLMesh& mesh, Sphere sphere);
-void createCylinderMesh(GLMesh& mesh, Cylinder cylinder);
-void deleteMesh(GLMesh& mesh);
+SceneMesh getUnitMesh(const SceneMesh& mesh, glm::vec3& scale);
+std::string getGeneratedMeshName(const SceneMesh& mesh);
+bool isGeneratedInMemory(const SceneMesh& mesh);
+bool isStaticMesh(const SceneMesh& mesh);
+bool isSubdividedSphere(const SceneMesh& mesh);
+void buildSubdividedSphere(const SceneMesh& mesh, const std::function<void(const MeshView&)>& use);
+void sizeGeneratedMesh(GeneratedMesh& generated);
+void generateMesh(GeneratedMesh& generated, ThreadPool* pool);
+void generateMeshes(std::vector<GeneratedMesh>& meshes);
+unsigned int getGeneratedIndexCapacity(unsigned int indexCount);
+void buildGeneratedMeshLods(std::vector<GeneratedMesh>& meshes, ThreadPool& pool);
+void buildGeneratedMeshlets(std::vector<GeneratedMesh>& meshes, ThreadPool& pool);
+void uploadGeneratedMesh(GLMesh& mesh, const GeneratedMesh& generated);
+MeshHandle getMappedMesh(const std::string& name, const SceneMesh& mesh);
+bool loadScene();
+void selectObjectCulling();
+const char* getObjectVertexShaderSource();
+void sortObjects();
+void createGpuCulling();
+void releaseAssets();
 void render();
-bool createTexture(const char* filename, GLuint& textureId);
-void flipImageVertically(unsigned char* image, int width, int height, int channels);
+void renderWireframe(const glm::mat4& view, const glm::mat4& projection);
+void prepareObjectDraws(const glm::mat4& view, const glm::mat4& projection);
+unsigned int selectMeshLod(const GLMesh& mesh, const glm::mat4& model);
+void drawObject(const GLMesh& mesh, const ObjectDraw& draw);
+void drawMesh(const GLMesh& mesh, unsigned int lod = 0);
+void setFrameUniforms(GLuint programId, const glm::mat4& view, const glm::mat4& projection);
+void bindMaterial(GLuint programId, const SceneMaterial& material);
+bool createObjectTextureArrays();
+void bindObjectTexture(GLuint programId, int texture);
+void bindOverlayTexture(GLuint programId, int texture);
+bool compileShader(GLenum type, const char* source, const char* name, GLuint& shader);
 bool createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource, GLuint& programId);
-void deleteShaderProgram(GLuint programId);
+bool createShaderProgram(const char* vertexShaderSource, const char* geometryShaderSource, const char* fragmentShaderSource, GLuint& programId);
 
 // shader source code
 /* Textured Object Vertex Shader Source Code*/
@@ -138,17 +271,70 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// packed meshes store positions in [-1, 1]; float meshes use scale 1 and bias 0
+uniform vec3 positionScale;
+uniform vec3 positionBias;
+
 void main()
 {
-    gl_Position = projection * view * model * vec4(position, 1.0f); // Transforms vertices into clip coordinates
+    vec3 meshPosition = position * positionScale + positionBias;
+
+    gl_Position = projection * view * model * vec4(meshPosition, 1.0f); // Transforms vertices into clip coordinates
 
-    vertexFragmentPos = vec3(model * vec4(position, 1.0f)); // Gets fragment / pixel position in world space only (exclude view and projection)
+    vertexFragmentPos = vec3(model * vec4(meshPosition, 1.0f)); // Gets fragment / pixel position in world space only (exclude view and projection)
 
     vertexNormal = mat3(transpose(inverse(model))) * normal; // get normal vectors in world space only and exclude normal translation properties
     vertexTextureCoordinate = textureCoordinate;
 }
 );
 
+/* Textured Object Vertex Shader Source Code for GPU culling
+ * Takes the model matrix of a batched object from the instances the GPU culler keeps (SSBO binding 0)
+ */
+const GLchar* objectInstancedVertexShaderSource = GLSL(440,
+
+layout(location = 0) in vec3 position; // VAP position 0 for vertex position data
+layout(location = 1) in vec3 normal; // VAP position 1 for normals
+layout(location = 2) in vec2 textureCoordinate;
+layout(location = 3) in uint instanceIndex; // GPU culling: the visible instance drawn
+
+out vec3 vertexNormal; // For outgoing normals to fragment shader
+out vec3 vertexFragmentPos; // For outgoing color / pixels to fragment shader
+out vec2 vertexTextureCoordinate;
+
+//Uniform / Global variables for the  transform matrices
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+// packed meshes store positions in [-1, 1]; float meshes use scale 1 and bias 0
+uniform vec3 positionScale;
+uniform vec3 positionBias;
+
+// GPU culling: the model matrices of the instances, in the layout of GpuInstance
+struct Instance
+{
+    mat4 model;
+    vec4 boundingSphere;
+    uvec4 ids;
+};
+layout(std430, binding = 0) readonly buffer Instances { Instance instances[]; };
+uniform bool useInstances; // take the model matrix of instanceIndex instead of model
+
+void main()
+{
+    vec3 meshPosition = position * positionScale + positionBias;
+    mat4 objectModel = useInstances ? instances[instanceIndex].model : model;
+
+    gl_Position = projection * view * objectModel * vec4(meshPosition, 1.0f); // Transforms vertices into clip coordinates
+
+    vertexFragmentPos = vec3(objectModel * vec4(meshPosition, 1.0f)); // Gets fragment / pixel position in world space only (exclude view and projection)
+
+    vertexNormal = mat3(transpose(inverse(objectModel))) * normal; // get normal vectors in world space only and exclude normal translation properties
+    vertexTextureCoordinate = textureCoordinate;
+}
+);
+
 /* Object Fragment Shader Source Code
  * Lower specular intensity and option for secondary texture
  */
@@ -167,6 +353,7 @@ uniform vec3 lightColor2;
 uniform vec3 lightPos2;
 uniform vec3 viewPosition;
 uniform bool multipleTextures;
+uniform bool flatShading; // face normals from the position derivatives, for flat meshes sharing smooth vertices
 uniform sampler2D uTexture; // Useful when working with multiple textures
 uniform sampler2D uTexture2; // Useful when working with multiple textures
 uniform vec2 textureScale;
@@ -182,6 +369,8 @@ void main()
 
     //Calculate Diffuse lighting*/
     vec3 norm = normalize(vertexNormal); // Normalize vectors to 1 unit
+    if (flatShading)
+        norm = normalize(cross(dFdx(vertexFragmentPos), dFdy(vertexFragmentPos))); // the triangle's plane, facing the camera
     vec3 lightDirection = normalize(lightPos1 - vertexFragmentPos); // Calculate distance (light direction) between light source and fragments/pixels on cube
     float impact = max(dot(norm, lightDirection), 0.0);// Calculate diffuse impact by generating dot product of normal and light
     vec3 diffuse = impact * lightColor1; // Generate diffuse light color
@@ -204,7 +393,6 @@ void main()
     ambient = ambientStrength * lightColor2; // Generate ambient light color
 
     //Calculate Diffuse lighting*/
-    norm = normalize(vertexNormal); // Normalize vectors to 1 unit
     lightDirection = normalize(lightPos2 - vertexFragmentPos); // Calculate distance (light direction) between light source and fragments/pixels on cube
     impact = max(dot(norm, lightDirection), 0.0);// Calculate diffuse impact by generating dot product of normal and light
     diffuse = impact * lightColor2; // Generate diffuse light color
@@ -225,10 +413,100 @@ void main()
     // Texture holds the color to be used for all three components
     if (multipleTextures)
     {
-        if (texture(uTexture2, vertexTextureCoordinate).a != 0)
-        {
-            textureColor = texture(uTexture2, vertexTextureCoordinate * textureScale);
-        }
+        // the extra texture has premultiplied alpha, so draw it over the object texture
+        vec4 overlayColor = texture(uTexture2, vertexTextureCoordinate * textureScale);
+        textureColor = overlayColor + (1.0 - overlayColor.a) * textureColor;
+    }
+
+    // Calculate phong result
+    phong = (phong + phong2) * textureColor.xyz;
+
+    fragmentColor = vec4(phong, 1.0); // Send lighting results to GPU
+}
+);
+
+/* Object Fragment Shader Source Code for texture arrays
+ * Same lighting as the object shader, textures are selected by (array, layer) uniforms
+ */
+const GLchar* objectArrayFragmentShaderSource = GLSL(440,
+in vec3 vertexNormal; // For incoming normals
+in vec3 vertexFragmentPos; // For incoming fragment position
+in vec2 vertexTextureCoordinate;
+
+out vec4 fragmentColor; // For outgoing cube color to the GPU
+
+// Uniform / Global variables for object color, light color, light position, and camera/view position
+uniform vec3 objectColor;
+uniform vec3 lightColor1;
+uniform vec3 lightPos1;
+uniform vec3 lightColor2;
+uniform vec3 lightPos2;
+uniform vec3 viewPosition;
+uniform bool multipleTextures;
+uniform bool flatShading; // face normals from the position derivatives, for flat meshes sharing smooth vertices
+uniform sampler2DArray uTextureArrays[4]; // one array per texture size class
+uniform ivec2 textureLayer; // (array, layer) of the object texture
+uniform ivec2 textureLayer2; // (array, layer) of the extra texture
+uniform vec2 textureScale;
+
+void main()
+{
+    /*Phong lighting model calculations to generate ambient, diffuse, and specular components*/
+
+    // first light calculations
+    //Calculate Ambient lighting*/
+    float ambientStrength = 0.1f; // Set ambient or global lighting strength
+    vec3 ambient = ambientStrength * lightColor1; // Generate ambient light color
+
+    //Calculate Diffuse lighting*/
+    vec3 norm = normalize(vertexNormal); // Normalize vectors to 1 unit
+    if (flatShading)
+        norm = normalize(cross(dFdx(vertexFragmentPos), dFdy(vertexFragmentPos))); // the triangle's plane, facing the camera
+    vec3 lightDirection = normalize(lightPos1 - vertexFragmentPos); // Calculate distance (light direction) between light source and fragments/pixels on cube
+    float impact = max(dot(norm, lightDirection), 0.0);// Calculate diffuse impact by generating dot product of normal and light
+    vec3 diffuse = impact * lightColor1; // Generate diffuse light color
+
+    //Calculate Specular lighting*/
+    float specularIntensity = 0.1f; // Set specular light strength
+    float highlightSize = 16.0f; // Set specular highlight size
+    vec3 viewDir = normalize(viewPosition - vertexFragmentPos); // Calculate view direction
+    vec3 reflectDir = reflect(-lightDirection, norm);// Calculate reflection vector
+    //Calculate specular component
+    float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), highlightSize);
+    vec3 specular = specularIntensity * specularComponent * lightColor1;
+
+    // Calculate phong result
+    vec3 phong = (ambient + diffuse + specular);
+
+    // second light calculations
+    //Calculate Ambient lighting*/
+    ambientStrength = 0.1f; // Set ambient or global lighting strength
+    ambient = ambientStrength * lightColor2; // Generate ambient light color
+
+    //Calculate Diffuse lighting*/
+    lightDirection = normalize(lightPos2 - vertexFragmentPos); // Calculate distance (light direction) between light source and fragments/pixels on cube
+    impact = max(dot(norm, lightDirection), 0.0);// Calculate diffuse impact by generating dot product of normal and light
+    diffuse = impact * lightColor2; // Generate diffuse light color
+
+    //Calculate Specular lighting*/
+    specularIntensity = 0.1f; // Set specular light strength
+    highlightSize = 16.0f; // Set specular highlight size
+    viewDir = normalize(viewPosition - vertexFragmentPos); // Calculate view direction
+    reflectDir = reflect(-lightDirection, norm);// Calculate reflection vector
+    //Calculate specular component
+    specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), highlightSize);
+    specular = specularIntensity * specularComponent * lightColor2;
+
+    vec3 phong2 = (ambient + diffuse + specular) * 0.5f; // attempt to reduce impact of second light to 10% intensity
+
+    vec4 textureColor = texture(uTextureArrays[textureLayer.x], vec3(vertexTextureCoordinate * textureScale, textureLayer.y));
+
+    // Texture holds the color to be used for all three components
+    if (multipleTextures)
+    {
+        // the extra texture has premultiplied alpha, so draw it over the object texture
+        vec4 overlayColor = texture(uTextureArrays[textureLayer2.x], vec3(vertexTextureCoordinate * textureScale, textureLayer2.y));
+        textureColor = overlayColor + (1.0 - overlayColor.a) * textureColor;
     }
 
     // Calculate phong result
@@ -348,6 +626,74 @@ void main()
 );
 
 
+/* Wireframe Geometry Shader Source Code
+ * Single-pass wireframe (Baerentzen et al.): each triangle is passed on with the
+ * window-space height of every corner over its opposite edge, so the fragment
+ * shader knows how far a fragment is from the nearest edge
+ */
+const GLchar* wireframeGeometryShaderSource = GLSL(440,
+
+layout(triangles) in;
+layout(triangle_strip, max_vertices = 3) out;
+
+uniform vec2 viewportSize; // in pixels
+
+noperspective out vec3 edgeDistance; // distance to the 3 edges in pixels, interpolated linearly on screen
+
+void main()
+{
+    // corners in window space
+    vec2 p0 = 0.5f * viewportSize * gl_in[0].gl_Position.xy / gl_in[0].gl_Position.w;
+    vec2 p1 = 0.5f * viewportSize * gl_in[1].gl_Position.xy / gl_in[1].gl_Position.w;
+    vec2 p2 = 0.5f * viewportSize * gl_in[2].gl_Position.xy / gl_in[2].gl_Position.w;
+
+    // twice the area over the length of the opposite edge is the height of a corner
+    vec2 edge0 = p2 - p1;
+    vec2 edge1 = p2 - p0;
+    vec2 edge2 = p1 - p0;
+    float area = abs(edge1.x * edge2.y - edge1.y * edge2.x);
+
+    edgeDistance = vec3(area / max(length(edge0), 1e-6f), 0.0f, 0.0f);
+    gl_Position = gl_in[0].gl_Position;
+    EmitVertex();
+
+    edgeDistance = vec3(0.0f, area / max(length(edge1), 1e-6f), 0.0f);
+    gl_Position = gl_in[1].gl_Position;
+    EmitVertex();
+
+    edgeDistance = vec3(0.0f, 0.0f, area / max(length(edge2), 1e-6f));
+    gl_Position = gl_in[2].gl_Position;
+    EmitVertex();
+
+    EndPrimitive();
+}
+);
+
+
+/* Wireframe Fragment Shader Source Code
+ * Keeps the fragments near an edge, anti-aliased over one pixel
+ */
+const GLchar* wireframeFragmentShaderSource = GLSL(440,
+
+noperspective in vec3 edgeDistance;
+
+out vec4 fragmentColor;
+
+uniform vec4 lineColor;
+uniform float lineWidth; // in pixels
+
+void main()
+{
+    float nearest = min(edgeDistance.x, min(edgeDistance.y, edgeDistance.z));
+    float coverage = 1.0f - smoothstep(lineWidth * 0.5f - 0.5f, lineWidth * 0.5f + 0.5f, nearest);
+    if (coverage <= 0.0f)
+        discard;
+
+    fragmentColor = vec4(lineColor.rgb, lineColor.a * coverage);
+}
+);
+
+
 int main()
 {
     glfwInit();
@@ -382,117 +728,53 @@ int main()
         return -1;
     }
     
-    // CREATE BOTTLE MESHES
-    //_________________________
-    bottleTopCylinder.set(0.2f, 0.2f, 1.0f, 24, 12, true);
-    createCylinderMesh(meshBottleTopCylinder, bottleTopCylinder); // call the createCylinderMesh() function to initialize our data and buffer it to GPU
-
-    bottleBottomCylinder.set(0.5f, 0.5f, 2.0f, 24, 12, true);
-    createCylinderMesh(meshBottleBottomCylinder, bottleBottomCylinder); // call the createCylinderMesh() function to initialize our data and buffer it to GPU
-
-    bottleSphere.set(.5f, 24, 12, true);
-    createSphereMesh(meshBottleSphere, bottleSphere); // call the createSphereMesh() function to initialize our data and buffer it to GPU
-
-    // CREATE PEN MESHES
-    //_________________________
-    penCone.set(0.04f, 0.0f, 0.1f, 24, 12, true);
-    createCylinderMesh(meshPenCone, penCone); // call the createCylinderMesh() function to initialize our data and buffer it to GPU
-    
-    penCylinder.set(0.04f, 0.04f, .75f, 24, 12, true);
-    createCylinderMesh(meshPenCylinder, penCylinder); // call the createCylinderMesh() function to initialize our data and buffer it to GPU
-    
-    penSphere.set(.04f, 24, 12, true);
-    createSphereMesh(meshPenSphere, penSphere); // call the createSphereMesh() function to initialize our data and buffer it to GPU
-
-    // CREATE OTHER MESHES
-    //_________________________
-    perfumeCylinder.set(0.25f, 0.25f, 2.0f, 24, 12, true);
-    createCylinderMesh(meshPerfume, perfumeCylinder);
-
-    createPlaneMesh(meshPlane); // call the createPlaneMesh() function to initialize our data and buffer it to GPU
-    createLightMesh(meshLight); // call the createLightMesh() function to initialize our data and buffer it to GPU
-    createBoxMesh(meshBox); // call the createBoxMesh() function to initialize our data and buffer it to GPU
-
-
-    // initialize shader program and ensure that it was done properly using createShaderProgram() function
-    if (!createShaderProgram(objectVertexShaderSource, objectFragmentShaderSource, objectProgramId))
+    // load the scene description, build and buffer its meshes to GPU and queue its textures
+    if (!loadScene())
     {
         return -1;
     }
+    meshLight = gAssets.getMesh("light cube", createLightMesh); // call the createLightMesh() function to initialize our data and buffer it to GPU
 
-    // initialize shader program and ensure that it was done properly using createShaderProgram() function
-    if (!createShaderProgram(lightVertexShaderSource, lightFragmentShaderSource, lightProgramId))
-    {
-        return -1;
-    }
 
-    // initialize shader program and ensure that it was done properly using createShaderProgram() function
-    if (!createShaderProgram(objectVertexShaderSource, planeFragmentShaderSource, planeProgramId))
+    // initialize shader programs and ensure that it was done properly using createShaderProgram() function
+    objectProgram = gAssets.getProgram(getObjectVertexShaderSource(), objectFragmentShaderSource, createShaderProgram);
+    lightProgram = gAssets.getProgram(lightVertexShaderSource, lightFragmentShaderSource, createShaderProgram);
+    planeProgram = gAssets.getProgram(getObjectVertexShaderSource(), planeFragmentShaderSource, createShaderProgram);
+    wireframeProgram = gAssets.getProgram(getObjectVertexShaderSource(), wireframeGeometryShaderSource, wireframeFragmentShaderSource, createShaderProgram);
+    if (!objectProgram || !lightProgram || !planeProgram || !wireframeProgram)
     {
         return -1;
     }
 
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 
-    // enables wireframe view to verify that all triangles are shown
-    //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-
-    const char* texFilename = "textures/glass.jpg"; // variable to load image
-
-    // create glass texture
-    if (!createTexture(texFilename, glassTextureId))
+    // strip meshes end each strip with the largest index (0xffff or 0xffffffff)
+    if (std::any_of(gSceneMeshes.begin(), gSceneMeshes.end(), [](const MeshHandle& mesh) { return mesh && mesh->primitive == GL_TRIANGLE_STRIP; }))
     {
-        std::cout << "Failed to load texture " << texFilename << std::endl;
-        return -1;
-    }
-    texFilename = "textures/Label.png"; // variable to load image
-
-    // create label texture
-    if (!createTexture(texFilename, labelTextureId))
-    {
-        std::cout << "Failed to load texture " << texFilename << std::endl;
-        return -1;
-    }
-    texFilename = "textures/plane.jpg"; // variable to load image
-
-    // create plane texture
-    if (!createTexture(texFilename, planeTextureId))
-    {
-        std::cout << "Failed to load texture " << texFilename << std::endl;
-        return -1;
+        glEnable(GL_PRIMITIVE_RESTART_FIXED_INDEX);
     }
-    texFilename = "textures/pen.jpg"; // variable to load image
 
-    // create pen texture
-    if (!createTexture(texFilename, penTextureId))
+    // decode the scene textures on worker threads and upload them as they finish. each file is loaded once however often it is requested
+    if (!gAssets.loadTextures())
     {
-        std::cout << "Failed to load texture " << texFilename << std::endl;
         return -1;
     }
-    texFilename = "textures/box.jpg"; // variable to load image
 
-    // create box texture
-    if (!createTexture(texFilename, boxTextureId))
+    // create the texture arrays of the object textures so they are bound once
+    if (USE_TEXTURE_ARRAYS && !createObjectTextureArrays())
     {
-        std::cout << "Failed to load texture " << texFilename << std::endl;
         return -1;
     }
-    texFilename = "textures/perfume.jpg"; // variable to load image
 
-    // create perfume texture
-    if (!createTexture(texFilename, perfumeTextureId))
-    {
-        std::cout << "Failed to load texture " << texFilename << std::endl;
-        return -1;
-    }
     // Tell OpenGL for each sampler which texture unit it belongs to (only has to be done once).
-    glUseProgram(objectProgramId);
-    // We set the glass texture as texture unit 0.
-    glUniform1i(glGetUniformLocation(objectProgramId, "uTexture"), 0);
-    // We set the label texture as texture unit 1.
-    glUniform1i(glGetUniformLocation(objectProgramId, "uTexture2"), 1);
+    glUseProgram(*objectProgram);
+    // We set the object texture as texture unit 0.
+    glUniform1i(glGetUniformLocation(*objectProgram, "uTexture"), 0);
+    // We set the overlay texture as texture unit 1.
+    glUniform1i(glGetUniformLocation(*objectProgram, "uTexture2"), 1);
     // We set the plane texture as texture unit 0 for its program.
-    glUniform1i(glGetUniformLocation(planeProgramId, "uTexture"), 0);
+    glUseProgram(*planeProgram);
+    glUniform1i(glGetUniformLocation(*planeProgram, "uTexture"), 0);
 
     // render loop
     while (!glfwWindowShouldClose(window))
@@ -510,21 +792,12 @@ int main()
         glfwPollEvents();
     }
 
-    // use delete functions to destroy the mesh and shader program before ending the program
-    deleteMesh(meshBottleTopCylinder);
-    deleteMesh(meshBottleBottomCylinder);
-    deleteMesh(meshBottleSphere);
-    deleteMesh(meshPenSphere);
-    deleteMesh(meshPenCylinder);
-    deleteMesh(meshPenCone);
-    deleteMesh(meshBox);
-    deleteMesh(meshPlane);
-    deleteMesh(meshPerfume);
-    deleteMesh(meshLight);
-
-    deleteShaderProgram(planeProgramId);
-    deleteShaderProgram(objectProgramId);
-    deleteShaderProgram(lightProgramId);
+    // release the meshes, textures and shader programs while the context still exists
+    releaseAssets();
+    if (USE_TEXTURE_ARRAYS)
+    {
+        gTextureArrays.release();
+    }
 
     glfwTerminate(); // terminate GLFW when done rendering
     return 0;
@@ -552,6 +825,12 @@ void processInput(GLFWwindow* window)
     if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS)
         gCamera.ProcessKeyboard(DOWN, gDeltaTime);
 
+    // toggle the wireframe overlay to verify that all triangles are shown
+    bool wireframeKeyDown = glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS;
+    if (wireframeKeyDown && !gWireframeKeyDown)
+        gWireframe = !gWireframe;
+    gWireframeKeyDown = wireframeKeyDown;
+
     // attempt to perform perspective shift
     if (glfwGetKey(window, GLFW_KEY_P) == GLFW_PRESS)
     {
@@ -607,297 +886,346 @@ void render()
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    glActiveTexture(GL_TEXTURE0); // set active texture
-    glBindTexture(GL_TEXTURE_2D, planeTextureId); // bind texture that was created
-
-    // Model matrix: Transformations are applied right-to-left.
-    glm::mat4 model = glm::mat4(1.0f);
-
-    model = glm::translate(model, glm::vec3(0.0f, 1.0f, 0.0f));
-
     glm::mat4 view = gCamera.GetViewMatrix();
 
     glm::mat4 projection = glm::perspective(glm::radians(gCamera.Zoom), (GLfloat)SCR_WIDTH / (GLfloat)SCR_HEIGHT, 0.1f, 100.0f);
 
-    /*
-     * INITIALIZE planeProgramId UNIFORMS
-     */
+    // pick the LODs and cull the meshlets of every object, for this pass and the wireframe
+    prepareObjectDraws(view, projection);
 
-     // use the shader program created in createShaderProgram()
-    glUseProgram(planeProgramId);
-
-    // retrieves and passes transform matrices to the Shader program
-    GLint modelLoc = glGetUniformLocation(planeProgramId, "model");
-    GLint viewLoc = glGetUniformLocation(planeProgramId, "view");
-    GLint projLoc = glGetUniformLocation(planeProgramId, "projection");
+    // cull the batched objects and build their draws on the GPU; this binds the draw buffers of drawBatch() after prepareObjectDraws()
+    if (gGpuCuller.getBatchCount() > 0)
+    {
+        float lodScale = getPixelWorldSize(MESH_LOD_PIXEL_ERROR, 1.0f, glm::radians(gCamera.Zoom), SCR_HEIGHT);
+        gGpuCuller.cull(glm::value_ptr(projection * view), glm::value_ptr(gCamera.Position), lodScale);
+    }
 
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
+    // SCENE: draw the objects
+    //----------------
+    // objects are drawn by material and then GPU mesh (gObjectOrder), so the program and textures only change between groups
+    const unsigned int* objectMeshes = gScene.getObjectMeshes();
+    const unsigned int* objectMaterials = gScene.getObjectMaterials();
+    const SceneMaterial* materials = gScene.getMaterials();
+
+    GLuint programId = 0;
+    GLint modelLoc = -1;
+    GLint positionScaleLoc = -1;
+    GLint positionBiasLoc = -1;
+    GLint flatShadingLoc = -1;
+    GLint useInstancesLoc = -1;
+    const GLMesh* boundMesh = nullptr;
+    int flatShading = -1;
+    int useInstances = -1;
+    unsigned int material = gScene.getMaterialCount();
+    for (unsigned int k = 0; k < gScene.getObjectCount(); ++k)
+    {
+        unsigned int i = gObjectOrder[k];
+        if (objectMaterials[i] != material)
+        {
+            material = objectMaterials[i];
+
+            // use the plane or object program created in createShaderProgram(), or the object texture array variant
+            GLuint materialProgramId = *planeProgram;
+            if (materials[material].program == SCENE_PROGRAM_OBJECT)
+                materialProgramId = USE_TEXTURE_ARRAYS ? *objectArrayProgram : *objectProgram;
+
+            if (materialProgramId != programId)
+            {
+                programId = materialProgramId;
+                glUseProgram(programId);
+                setFrameUniforms(programId, view, projection);
+                modelLoc = glGetUniformLocation(programId, "model");
+                positionScaleLoc = glGetUniformLocation(programId, "positionScale");
+                positionBiasLoc = glGetUniformLocation(programId, "positionBias");
+                flatShadingLoc = glGetUniformLocation(programId, "flatShading");
+                useInstancesLoc = glGetUniformLocation(programId, "useInstances");
+                boundMesh = nullptr;
+                flatShading = -1;
+                useInstances = -1;
+            }
+
+            bindMaterial(programId, materials[material]);
+        }
 
-    // reference matrix uniforms from the plane shader program for the object color, light color, light position, and camera position
-    GLint objectColorLoc = glGetUniformLocation(planeProgramId, "objectColor");
-    GLint lightColor1Loc = glGetUniformLocation(planeProgramId, "lightColor1");
-    GLint lightPosition1Loc = glGetUniformLocation(planeProgramId, "lightPos1");
-    GLint lightColor2Loc = glGetUniformLocation(planeProgramId, "lightColor2");
-    GLint lightPosition2Loc = glGetUniformLocation(planeProgramId, "lightPos2");
-    GLint viewPositionLoc = glGetUniformLocation(planeProgramId, "viewPosition");
-
-    // pass color, light, and camera data to the plane shader program's corresponding uniforms
-    glUniform3f(objectColorLoc, gObjectColor.r, gObjectColor.g, gObjectColor.b);
-    glUniform3f(lightColor1Loc, lightColor1.r, lightColor1.g, lightColor1.b);
-    glUniform3f(lightPosition1Loc, lightPosition1.x, lightPosition1.y, lightPosition1.z);
-    glUniform3f(lightColor2Loc, lightColor2.r, lightColor2.g, lightColor2.b);
-    glUniform3f(lightPosition2Loc, lightPosition2.x, lightPosition2.y, lightPosition2.z);
-    const glm::vec3 cameraPosition = gCamera.Position;
-    glUniform3f(viewPositionLoc, cameraPosition.x, cameraPosition.y, cameraPosition.z);
+        // flat and smooth objects can share a mesh, so the shading is set per object when it changes
+        int objectFlatShading = gSceneMeshFlatShading[objectMeshes[i]] ? 1 : 0;
+        if (objectFlatShading != flatShading)
+        {
+            flatShading = objectFlatShading;
+            glUniform1i(flatShadingLoc, flatShading);
+        }
 
-    GLint TextureScaleLoc = glGetUniformLocation(planeProgramId, "textureScale");
-    glUniform2fv(TextureScaleLoc, 1, glm::value_ptr(textureScale));
+        // objects of a material are drawn by GPU mesh, so the VAO and position scale/bias change per group
+        const GLMesh& mesh = *gSceneMeshes[objectMeshes[i]];
+        if (&mesh != boundMesh)
+        {
+            boundMesh = &mesh;
+            glBindVertexArray(mesh.vao);
+            glUniform3fv(positionScaleLoc, 1, mesh.positionScale);
+            glUniform3fv(positionBiasLoc, 1, mesh.positionBias);
+        }
 
-    glBindVertexArray(meshPlane.vao);
+        // a batch of the GPU culler is drawn whole at its first object, with the model matrices of its instances
+        unsigned int batch = gObjectBatches[i];
+        int objectUseInstances = batch != NO_GPU_BATCH ? 1 : 0;
+        if (objectUseInstances != useInstances)
+        {
+            useInstances = objectUseInstances;
+            glUniform1i(useInstancesLoc, useInstances);
+        }
+        if (batch != NO_GPU_BATCH)
+        {
+            gGpuCuller.drawBatch(batch, mesh.primitive, mesh.indexType);
+            k += gGpuCuller.getBatchInstanceCount(batch) - 1;
+            continue;
+        }
 
-    glDrawElements(GL_TRIANGLES, meshPlane.nIndices, GL_UNSIGNED_INT, (void*)0); // draw triangles
+        // the model matrices include the size of unit meshes
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gObjectModels[i]));
+        drawObject(mesh, gObjectDraws[i]);
+    }
 
-    /*
-     * INITIALIZE objectProgramId UNIFORMS
-     */
+    // WIREFRAME: draw the triangle edges over the objects
+    //----------------
+    if (gWireframe)
+    {
+        renderWireframe(view, projection);
+    }
 
-     // use the shader program created in createShaderProgram()
-    glUseProgram(objectProgramId);
+    // LIGHTS: draw lights
+    //----------------
+    GLuint lightProgramId = *lightProgram;
+    glUseProgram(lightProgramId);
 
-    // retrieves and passes transform matrices to the Shader program
-    modelLoc = glGetUniformLocation(objectProgramId, "model");
-    viewLoc = glGetUniformLocation(objectProgramId, "view");
-    projLoc = glGetUniformLocation(objectProgramId, "projection");
+    // reference matrix uniforms from the light shader program
+    modelLoc = glGetUniformLocation(lightProgramId, "model");
+    GLint viewLoc = glGetUniformLocation(lightProgramId, "view");
+    GLint projLoc = glGetUniformLocation(lightProgramId, "projection");
 
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    // pass matrix data to the light shader program's matrix uniforms
     glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
     glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
 
-    // reference matrix uniforms from the object shader program for the object color, light color, light position, and camera position
-    objectColorLoc = glGetUniformLocation(objectProgramId, "objectColor");
-    lightColor1Loc = glGetUniformLocation(objectProgramId, "lightColor1");
-    lightPosition1Loc = glGetUniformLocation(objectProgramId, "lightPos1");
-    lightColor2Loc = glGetUniformLocation(objectProgramId, "lightColor2");
-    lightPosition2Loc = glGetUniformLocation(objectProgramId, "lightPos2");
-    viewPositionLoc = glGetUniformLocation(objectProgramId, "viewPosition");
-
-    // pass color, light, and camera data to the object shader program's corresponding uniforms
-    glUniform3f(objectColorLoc, gObjectColor.r, gObjectColor.g, gObjectColor.b);
-    glUniform3f(lightColor1Loc, lightColor1.r, lightColor1.g, lightColor1.b);
-    glUniform3f(lightPosition1Loc, lightPosition1.x, lightPosition1.y, lightPosition1.z);
-    glUniform3f(lightColor2Loc, lightColor2.r, lightColor2.g, lightColor2.b);
-    glUniform3f(lightPosition2Loc, lightPosition2.x, lightPosition2.y, lightPosition2.z);
-    glUniform3f(viewPositionLoc, cameraPosition.x, cameraPosition.y, cameraPosition.z);
-
-    TextureScaleLoc = glGetUniformLocation(objectProgramId, "textureScale");
-    glUniform2fv(TextureScaleLoc, 1, glm::value_ptr(textureScale));
-
-    GLuint multipleTexturesLoc = glGetUniformLocation(objectProgramId, "multipleTextures"); // initialize boolean for extra textures
-    glUniform1i(multipleTexturesLoc, true); // set multipleTextures to true
-
-    // BOTTLE: draw bottle
-    //----------------
-    glBindTexture(GL_TEXTURE_2D, glassTextureId); // bind texture that was created
-
-    glActiveTexture(GL_TEXTURE1); // set active texture for extra texture
-    glBindTexture(GL_TEXTURE_2D, labelTextureId); // bind texture that was created
-
-    // scales the object by 1.25
-    glm::mat4 scale = glm::scale(glm::vec3(1.25f, 1.25f, 1.25f));
-    // rotates the shape by 90 degrees on the x axis
-    glm::mat4 rotation = glm::rotate(PI / 2, glm::vec3(1.0f, 0.0f, 0.0f));
-    // places object lower than the origin on the y-axis and forward on z-axis
-    glm::mat4 translation = glm::translate(glm::vec3(0.0f, -0.75f, -1.5f));
-    // Model matrix: Transformations are applied right-to-left.
-    model = translation * rotation * scale;
-
-    // retrieves and passes transform matrices to the Shader program
-    modelLoc = glGetUniformLocation(objectProgramId, "model");
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-    glBindVertexArray(meshBottleBottomCylinder.vao);
+    glBindVertexArray(meshLight->vao);
 
-    glDrawElements(GL_TRIANGLES, bottleBottomCylinder.getIndexCount(), GL_UNSIGNED_INT, (void*)0); // draw triangles
-
-    glUniform1i(multipleTexturesLoc, false);// turn off the extra texture
+    // transform the cube to be used as a visual representation of each light
+    const SceneLight* lights = gScene.getLights();
+    for (unsigned int i = 0; i < gScene.getLightCount(); ++i)
+    {
+        glm::mat4 model = glm::translate(glm::make_vec3(lights[i].position)) * glm::scale(glm::vec3(lights[i].scale));
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
 
-    // scales the object by 1.25
-    scale = glm::scale(glm::vec3(1.25f, 1.25f, 1.25f));
-    // rotates the shape by 90 degrees on the x axis
-    rotation = glm::rotate(PI / 2, glm::vec3(1.0f, 0.0f, 0.0f));
-    // places object higher than the origin on the y-axis and forward on z-axis
-    translation = glm::translate(glm::vec3(0.0f, 1.5f, -1.5f));
-    // Model matrix: Transformations are applied right-to-left.
-    model = translation * rotation * scale;
+        glDrawArrays(GL_TRIANGLES, 0, meshLight->nIndices);
+    }
 
-    // retrieves and passes transform matrices to the Shader program
-    modelLoc = glGetUniformLocation(objectProgramId, "model");
+    // the depth of this frame is what the next cull tests occlusion against
+    if (GPU_OCCLUSION_CULLING && gGpuCuller.getBatchCount() > 0)
+    {
+        int width, height;
+        glfwGetFramebufferSize(window, &width, &height);
+        gGpuCuller.updateDepthPyramid(width, height);
+    }
 
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    glfwSwapBuffers(window);
+}
 
-    glBindVertexArray(meshBottleTopCylinder.vao);
+// function to draw the triangle edges of every scene object over the shaded objects. the edges come from the triangles already on the GPU, so no line geometry is buffered
+void renderWireframe(const glm::mat4& view, const glm::mat4& projection)
+{
+    GLuint programId = *wireframeProgram;
+    glUseProgram(programId);
+    glUniformMatrix4fv(glGetUniformLocation(programId, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(programId, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
+    glUniform4fv(glGetUniformLocation(programId, "lineColor"), 1, WIREFRAME_COLOR);
+    glUniform1f(glGetUniformLocation(programId, "lineWidth"), WIREFRAME_LINE_WIDTH);
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    glUniform2f(glGetUniformLocation(programId, "viewportSize"), (float)viewport[2], (float)viewport[3]);
+
+    GLint modelLoc = glGetUniformLocation(programId, "model");
+    GLint positionScaleLoc = glGetUniformLocation(programId, "positionScale");
+    GLint positionBiasLoc = glGetUniformLocation(programId, "positionBias");
+    GLint useInstancesLoc = glGetUniformLocation(programId, "useInstances");
+
+    // the edges lie on the shaded surfaces: equal depths pass, and the overlay leaves the depth buffer alone
+    glDepthFunc(GL_LEQUAL);
+    glDepthMask(GL_FALSE);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    const unsigned int* objectMeshes = gScene.getObjectMeshes();
+    const GLMesh* boundMesh = nullptr;
+    int useInstances = -1;
+    for (unsigned int k = 0; k < gScene.getObjectCount(); ++k)
+    {
+        unsigned int i = gObjectOrder[k];
+        const GLMesh& mesh = *gSceneMeshes[objectMeshes[i]];
+        if (&mesh != boundMesh)
+        {
+            boundMesh = &mesh;
+            glBindVertexArray(mesh.vao);
+            glUniform3fv(positionScaleLoc, 1, mesh.positionScale);
+            glUniform3fv(positionBiasLoc, 1, mesh.positionBias);
+        }
 
-    glDrawElements(GL_TRIANGLES, bottleTopCylinder.getIndexCount(), GL_UNSIGNED_INT, (void*)0); // draw triangles
+        // GPU culled batches draw the instances the scene pass drew
+        unsigned int batch = gObjectBatches[i];
+        int objectUseInstances = batch != NO_GPU_BATCH ? 1 : 0;
+        if (objectUseInstances != useInstances)
+        {
+            useInstances = objectUseInstances;
+            glUniform1i(useInstancesLoc, useInstances);
+        }
+        if (batch != NO_GPU_BATCH)
+        {
+            gGpuCuller.drawBatch(batch, mesh.primitive, mesh.indexType);
+            k += gGpuCuller.getBatchInstanceCount(batch) - 1;
+            continue;
+        }
 
-    // scales the object by 1.25
-    scale = glm::scale(glm::vec3(1.25f, 1.25f, 1.25f));
-    // rotates the shape by 90 degrees on the x axis
-    rotation = glm::rotate(PI / 2, glm::vec3(1.0f, 0.0f, 0.0f));
-    // places object slightly higher than the origin on the y-axis and back on z-axis
-    translation = glm::translate(glm::vec3(0.0f, 0.5f, -1.5f));
-    // Model matrix: Transformations are applied right-to-left.
-    model = translation * rotation * scale;
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(gObjectModels[i]));
+        drawObject(mesh, gObjectDraws[i]);
+    }
 
-    // retrieves and passes transform matrices to the Shader program
-    modelLoc = glGetUniformLocation(objectProgramId, "model");
+    glDisable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LESS);
+}
 
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+// function to pick the LOD of every object and cull the meshlets of those that have them, in the object space of each: the camera position and the frustum planes
+// of its model view projection. the commands of all objects are buffered at once. the batches of the GPU culler are skipped whole
+void prepareObjectDraws(const glm::mat4& view, const glm::mat4& projection)
+{
+    const unsigned int* objectMeshes = gScene.getObjectMeshes();
+    glm::mat4 viewProjection = projection * view;
+    gObjectDraws.resize(gScene.getObjectCount());
+    gIndirectCommands.clear();
+    for (unsigned int k = 0; k < gScene.getObjectCount(); ++k)
+    {
+        unsigned int i = gObjectOrder[k];
+        if (gObjectBatches[i] != NO_GPU_BATCH)
+        {
+            k += gGpuCuller.getBatchInstanceCount(gObjectBatches[i]) - 1;
+            continue;
+        }
 
-    glBindVertexArray(meshBottleSphere.vao);
+        const GLMesh& mesh = *gSceneMeshes[objectMeshes[i]];
+        ObjectDraw& draw = gObjectDraws[i];
+        draw.lod = selectMeshLod(mesh, gObjectModels[i]);
+        draw.indirect = gObjectCulling == OBJECT_CULLING_MESHLETS && !mesh.meshlets.empty();
+        draw.firstCommand = (unsigned int)gIndirectCommands.size();
+        draw.commandCount = 0;
+        if (!draw.indirect)
+            continue;
+
+        float planes[6][4];
+        getFrustumPlanes(glm::value_ptr(viewProjection * gObjectModels[i]), planes);
+        glm::vec3 camera = glm::vec3(glm::inverse(gObjectModels[i]) * glm::vec4(gCamera.Position, 1.0f));
+        unsigned int first = mesh.lodFirstMeshlet[draw.lod];
+        cullMeshlets(&mesh.meshlets[first], mesh.lodFirstMeshlet[draw.lod + 1] - first, planes, glm::value_ptr(camera), gIndirectCommands);
+        draw.commandCount = (unsigned int)gIndirectCommands.size() - draw.firstCommand;
+    }
 
-    glDrawElements(GL_TRIANGLES, bottleSphere.getIndexCount(), GL_UNSIGNED_INT, (void*)0); // draw triangles
+    if (gIndirectCommands.empty())
+        return;
+    if (!gIndirectBuffer)
+        glGenBuffers(1, &gIndirectBuffer);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, gIndirectBuffer);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, gIndirectCommands.size() * sizeof(DrawElementsIndirectCommand), gIndirectCommands.data(), GL_STREAM_DRAW);
+}
 
-    // PEN: draw pen
-    //----------------
+// function to pick the coarsest LOD of a mesh whose error covers at most MESH_LOD_PIXEL_ERROR pixels at the distance of an object's origin from the camera
+unsigned int selectMeshLod(const GLMesh& mesh, const glm::mat4& model)
+{
+    if (mesh.lodCount <= 1)
+        return 0;
+
+    // the longest axis of the model matrix turns the object-space errors into world units
+    float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    float distance = glm::length(glm::vec3(model[3]) - gCamera.Position);
+    float maxError = getPixelWorldSize(MESH_LOD_PIXEL_ERROR, distance, glm::radians(gCamera.Zoom), SCR_HEIGHT);
+
+    unsigned int lod = 0;
+    while (lod + 1 < mesh.lodCount && mesh.lodError[lod + 1] * scale <= maxError)
+        ++lod;
+    return lod;
+}
 
-    glActiveTexture(GL_TEXTURE0); // set active texture
-    glBindTexture(GL_TEXTURE_2D, penTextureId); // bind texture that was created
+// function to draw an object with the bound mesh as prepareObjectDraws() decided. an object whose meshlets are all culled draws nothing
+void drawObject(const GLMesh& mesh, const ObjectDraw& draw)
+{
+    if (!draw.indirect)
+        drawMesh(mesh, draw.lod);
+    else if (draw.commandCount > 0)
+        glMultiDrawElementsIndirect(mesh.primitive, mesh.indexType, (void*)(draw.firstCommand * sizeof(DrawElementsIndirectCommand)), draw.commandCount, 0);
+}
 
-    // scales the object by 1.25
-    scale = glm::scale(glm::vec3(1.25f, 1.25f, 1.25f));
-    // rotates the shape by 90 degrees on the x axis
-    rotation = glm::rotate(0.0f, glm::vec3(1.0f, 0.0f, 0.0f));
-    // places object lower than the origin on the y-axis and to the left on x-axis
-    translation = glm::translate(glm::vec3(-0.470f, -1.95f, 0.0f));
-    // Model matrix: Transformations are applied right-to-left.
-    model = translation * rotation * scale;
+// function to draw a LOD of the bound mesh (0 for meshes without LODs)
+void drawMesh(const GLMesh& mesh, unsigned int lod)
+{
+    if (mesh.ebo && lod < mesh.lodCount)
+    {
+        // the LODs are consecutive ranges of the index buffer
+        std::size_t indexSize = mesh.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+        glDrawElements(mesh.primitive, mesh.lodIndexCount[lod], mesh.indexType, (void*)(mesh.lodFirstIndex[lod] * indexSize));
+    }
+    else if (mesh.ebo)
+        glDrawElements(mesh.primitive, mesh.nIndices, mesh.indexType, (void*)0); // draw triangles or triangle strips
+    else
+        glDrawArrays(GL_TRIANGLES, 0, mesh.nIndices);
+}
 
+// function to pass the camera, color and light data that is the same for every object to a shader program
+void setFrameUniforms(GLuint programId, const glm::mat4& view, const glm::mat4& projection)
+{
     // retrieves and passes transform matrices to the Shader program
-    modelLoc = glGetUniformLocation(objectProgramId, "model");
+    glUniformMatrix4fv(glGetUniformLocation(programId, "view"), 1, GL_FALSE, glm::value_ptr(view));
+    glUniformMatrix4fv(glGetUniformLocation(programId, "projection"), 1, GL_FALSE, glm::value_ptr(projection));
 
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+    // pass color and camera data to the shader program's corresponding uniforms
+    glUniform3f(glGetUniformLocation(programId, "objectColor"), gObjectColor.r, gObjectColor.g, gObjectColor.b);
+    const glm::vec3 cameraPosition = gCamera.Position;
+    glUniform3f(glGetUniformLocation(programId, "viewPosition"), cameraPosition.x, cameraPosition.y, cameraPosition.z);
 
-    glBindVertexArray(meshPenSphere.vao);
-
-    glDrawElements(GL_TRIANGLES, penSphere.getIndexCount(), GL_UNSIGNED_INT, (void*)0); // draw triangles
-
-    // scales the object by 1.25
-    scale = glm::scale(glm::vec3(1.25f, 1.25f, 1.25f));
-    // rotates the shape by 90 degrees on the x axis
-    rotation = glm::rotate(PI / 2, glm::vec3(0.0f, 1.0f, 0.0f));
-    // places object lower than the origin on the y-axis
-    translation = glm::translate(glm::vec3(0.0f, -1.95f, 0.0f));
-    // Model matrix: Transformations are applied right-to-left.
-    model = translation * rotation * scale;
-
-    // retrieves and passes transform matrices to the Shader program
-    modelLoc = glGetUniformLocation(objectProgramId, "model");
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-    glBindVertexArray(meshPenCylinder.vao);
-
-    glDrawElements(GL_TRIANGLES, penCylinder.getIndexCount(), GL_UNSIGNED_INT, (void*)0); // draw triangles
-
-    // scales the object by 1.25
-    scale = glm::scale(glm::vec3(1.25f, 1.25f, 1.25f));
-    // rotates the shape by 90 degrees on the x axis
-    rotation = glm::rotate(PI / 2, glm::vec3(0.0f, 1.0f, 0.0f));
-    // places object lower than the origin on the y-axis and to the right on the x-axis
-    translation = glm::translate(glm::vec3(0.530f, -1.95f, 0.0f));
-    // Model matrix: Transformations are applied right-to-left.
-    model = translation * rotation * scale;
-
-    // retrieves and passes transform matrices to the Shader program
-    modelLoc = glGetUniformLocation(objectProgramId, "model");
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-    glBindVertexArray(meshPenCone.vao);
-
-    glDrawElements(GL_TRIANGLES, penCone.getIndexCount(), GL_UNSIGNED_INT, (void*)0); // draw triangles
-    
-    // BOX: draw box
-    //----------------
-
-    glBindTexture(GL_TEXTURE_2D, boxTextureId); // bind texture that was created
-
-    // scales the object by 1.25
-    scale = glm::scale(glm::vec3(1.25f, 1.25f, 1.25f));
-    // rotates the shape by 90 degrees on the x axis
-    rotation = glm::rotate(PI / 4, glm::vec3(0.0f, 1.0f, 0.0f));
-    // places object lower than the origin on the y-axis, left on the x-axis, and back on the z-axis
-    translation = glm::translate(glm::vec3(-2.0f, -1.05f, -1.0f));
-    // Model matrix: Transformations are applied right-to-left.
-    model = translation * rotation * scale;
-
-    // retrieves and passes transform matrices to the Shader program
-    modelLoc = glGetUniformLocation(objectProgramId, "model");
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-    glBindVertexArray(meshBox.vao);
-
-    glDrawArrays(GL_TRIANGLES, 0, meshBox.nIndices);
-
-    // PERFUME: draw perfume
-    //----------------
-
-    glBindTexture(GL_TEXTURE_2D, perfumeTextureId); // bind texture that was created
-
-    // scales the object by 1.25
-    scale = glm::scale(glm::vec3(1.25f, 1.25f, 1.25f));
-    // rotates the shape by 90 degrees on the x axis
-    rotation = glm::rotate(PI / 2, glm::vec3(1.0f, 0.0f, 0.0f));
-    // places object lower than the origin on the y-axis, right on the x-axis, and back on the z-axis
-    translation = glm::translate(glm::vec3(1.5f, -0.75f, -1.0f));
-    // Model matrix: Transformations are applied right-to-left.
-    model = translation * rotation * scale;
-
-    // retrieves and passes transform matrices to the Shader program
-    modelLoc = glGetUniformLocation(objectProgramId, "model");
-
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-
-    glBindVertexArray(meshPerfume.vao);
-
-    glDrawElements(GL_TRIANGLES, perfumeCylinder.getIndexCount(), GL_UNSIGNED_INT, (void*)0); // draw triangles
-
-    // LIGHTS: draw lights
-    //----------------
-    glUseProgram(lightProgramId);
-
-    // transform the cube to be used as a visual representation of the second light
-    model = glm::translate(lightPosition1) * glm::scale(lightScale);
-
-    // reference matrix uniforms from the light shader program
-    modelLoc = glGetUniformLocation(lightProgramId, "model");
-    viewLoc = glGetUniformLocation(lightProgramId, "view");
-    projLoc = glGetUniformLocation(lightProgramId, "projection");
-
-    // pass matrix data to the light shader program's matrix uniforms
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
-    glUniformMatrix4fv(viewLoc, 1, GL_FALSE, glm::value_ptr(view));
-    glUniformMatrix4fv(projLoc, 1, GL_FALSE, glm::value_ptr(projection));
-
-    glBindVertexArray(meshLight.vao);
-
-    glDrawArrays(GL_TRIANGLES, 0, meshLight.nIndices);
-
-    // transform the cube to be used as a visual representation of the second light
-    model = glm::translate(lightPosition2) * glm::scale(lightScale);
+    // pass the scene lights to lightColor1/lightPos1 and lightColor2/lightPos2. missing lights are black
+    const SceneLight* lights = gScene.getLights();
+    for (unsigned int i = 0; i < MAX_LIGHTS; ++i)
+    {
+        std::string index = std::to_string(i + 1);
+        GLint lightColorLoc = glGetUniformLocation(programId, ("lightColor" + index).c_str());
+        GLint lightPositionLoc = glGetUniformLocation(programId, ("lightPos" + index).c_str());
+        if (i < gScene.getLightCount())
+        {
+            glUniform3fv(lightColorLoc, 1, lights[i].color);
+            glUniform3fv(lightPositionLoc, 1, lights[i].position);
+        }
+        else
+        {
+            glUniform3f(lightColorLoc, 0.0f, 0.0f, 0.0f);
+            glUniform3f(lightPositionLoc, 0.0f, 0.0f, 0.0f);
+        }
+    }
+}
 
-    // reference matrix uniforms from the light shader program
-    modelLoc = glGetUniformLocation(lightProgramId, "model");
-    // pass matrix data to the light shader program's matrix uniforms
-    glUniformMatrix4fv(modelLoc, 1, GL_FALSE, glm::value_ptr(model));
+// function to bind the textures of a material and pass its texture settings to the shader program
+void bindMaterial(GLuint programId, const SceneMaterial& material)
+{
+    glUniform2fv(glGetUniformLocation(programId, "textureScale"), 1, material.textureScale);
 
-    glDrawArrays(GL_TRIANGLES, 0, meshLight.nIndices);
+    if (material.program == SCENE_PROGRAM_PLANE)
+    {
+        glActiveTexture(GL_TEXTURE0); // set active texture
+        glBindTexture(GL_TEXTURE_2D, *gSceneTextures[material.texture]); // bind texture that was created
+        return;
+    }
 
-    glfwSwapBuffers(window);
+    bindObjectTexture(programId, material.texture); // bind texture that was created
+    if (material.overlay >= 0)
+    {
+        bindOverlayTexture(programId, material.overlay); // bind extra texture that was created
+    }
+    glUniform1i(glGetUniformLocation(programId, "multipleTextures"), material.overlay >= 0); // turn the extra texture on or off
 }
 
 // function to create mesh to buffer vertex and index data to GPU
@@ -932,102 +1260,10 @@ void createPlaneMesh(GLMesh& mesh)
         1, 2, 3
     };
 
-    mesh.nIndices = sizeof(indices) / sizeof(indices[0]);
-
-    glGenVertexArrays(1, &mesh.vao); // generate vertex array
-    glGenBuffers(1, &mesh.vbo); // generate vertex buffer object
-    glGenBuffers(1, &mesh.ebo); // generate element buffer object
-
-    glBindVertexArray(mesh.vao); // bind the created vertex array
-
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo); // bind vertex buffer object
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // buffer vertex data to GPU
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo); // bind element buffer object
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW); // buffer index data to GPU
-
-    // variables that indicate the amount of floats for each vertex and color attribute
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-    const GLuint floatsPerTex = 2;
-
-    // variable to indicate the stride for vertex and color attributes 
-    GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerTex);
-
-    // 
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
-
-    // 
-    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (char*)(sizeof(float) * floatsPerVertex));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, floatsPerTex, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-    glEnableVertexAttribArray(2);
-}
-
-// create a mesh using the vertices of a Sphere object
-void createSphereMesh(GLMesh& mesh, Sphere sphere) {
-    glGenVertexArrays(1, &mesh.vao); // generate vertex array
-    glGenBuffers(1, &mesh.vbo); // generate vertex buffer object
-    glGenBuffers(1, &mesh.ebo); // generate element buffer object
-
-    glBindVertexArray(mesh.vao); // bind the created vertex array
-
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo); // bind vertex buffer object
-    glBufferData(GL_ARRAY_BUFFER, sphere.getInterleavedVertexSize(), sphere.getInterleavedVertices(), GL_STATIC_DRAW); // buffer vertex data to GPU
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo); // bind element buffer object
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sphere.getIndexSize(), sphere.getIndices(), GL_STATIC_DRAW);
-
-    // variables that indicate the amount of floats for each vertex and color attribute
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-    const GLuint floatsPerTex = 2;
-
-    int stride = sphere.getInterleavedStride();   // should be 32 bytes
-
-    // initialize vertex attributes
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (char*)(sizeof(float) * floatsPerVertex));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, floatsPerTex, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-    glEnableVertexAttribArray(2);
-}
-
-// create a mesh using the vertices of a Cylinder object
-void createCylinderMesh(GLMesh& mesh, Cylinder cylinder) {
-    glGenVertexArrays(1, &mesh.vao); // generate vertex array
-    glGenBuffers(1, &mesh.vbo); // generate vertex buffer object
-    glGenBuffers(1, &mesh.ebo); // generate element buffer object
-
-    glBindVertexArray(mesh.vao); // bind the created vertex array
-
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo); // bind vertex buffer object
-    glBufferData(GL_ARRAY_BUFFER, cylinder.getInterleavedVertexSize(), cylinder.getInterleavedVertices(), GL_STATIC_DRAW); // buffer vertex data to GPU
-
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo); // bind element buffer object
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, cylinder.getIndexSize(), cylinder.getIndices(), GL_STATIC_DRAW);
-
-    // variables that indicate the amount of floats for each vertex and color attribute
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-    const GLuint floatsPerTex = 2;
-
-    int stride = cylinder.getInterleavedStride();   // should be 32 bytes
-
-    // initialize vertex attributes
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (char*)(sizeof(float) * floatsPerVertex));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, floatsPerTex, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-    glEnableVertexAttribArray(2);
+    // buffer the vertex and index data to GPU from the arrays above, packed first with VERTEX_FORMAT_PACKED
+    const unsigned int vertexCount = sizeof(vertices) / MESH_VERTEX_STRIDE;
+    const unsigned int indexCount = sizeof(indices) / sizeof(indices[0]);
+    uploadMesh(mesh, MeshView(vertices, vertexCount, indices, indexCount), MESH_VERTEX_FORMAT);
 }
 
 // function to create mesh to buffer vertex and index data to GPU
@@ -1086,35 +1322,9 @@ void createLightMesh(GLMesh& mesh)
    -0.5f,  0.5f, -0.5f,  0.0f,  1.0f,  0.0f,  0.0f, 1.0f
     };
 
-    // variables that indicate the amount of floats for each vertex and color attribute
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-    const GLuint floatsPerTex = 2;
-
-
-    mesh.nIndices = sizeof(vertices) / (sizeof(vertices[0]) * (floatsPerVertex + floatsPerNormal + floatsPerTex));
-
-    glGenVertexArrays(1, &mesh.vao); // generate vertex array
-    glGenBuffers(1, &mesh.vbo); // generate vertex buffer object
-
-    glBindVertexArray(mesh.vao); // bind the created vertex array
-
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo); // bind vertex buffer object
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // buffer vertex data to GPU
-
-
-    // variable to indicate the stride for vertex and color attributes 
-    GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerTex);
-
-    // create vertex attribute pointers
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
-
-    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (char*)(sizeof(float) * floatsPerVertex));
-    glEnableVertexAttribArray(1);
-
-    glVertexAttribPointer(2, floatsPerTex, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-    glEnableVertexAttribArray(2);
+    // buffer the vertex data to GPU straight from the array above. there are no indices, the vertices are drawn in order
+    // the light shader has no position scale/bias, so the light cube always uses float vertices
+    uploadMesh(mesh, MeshView(vertices, sizeof(vertices) / MESH_VERTEX_STRIDE));
 }
 
 void createBoxMesh(GLMesh& mesh)
@@ -1173,144 +1383,835 @@ void createBoxMesh(GLMesh& mesh)
     };
 
 
-    // variables that indicate the amount of floats for each vertex and color attribute
-    const GLuint floatsPerVertex = 3;
-    const GLuint floatsPerNormal = 3;
-    const GLuint floatsPerTex = 2;
+    // buffer the vertex data to GPU from the array above, packed first with VERTEX_FORMAT_PACKED. there are no indices, the vertices are drawn in order
+    uploadMesh(mesh, MeshView(vertices, sizeof(vertices) / MESH_VERTEX_STRIDE), MESH_VERTEX_FORMAT);
+}
 
+// function to get the unit shape of a sphere or cylinder and the scale that turns it back into the mesh. spheres become radius 1, cylinders and cones
+// height 1 with the larger radius 1, so only the radius ratio of a cone makes a different shape. the model matrix scale keeps normals right, since
+// the shaders transform them by the inverse transpose of the model matrix
+SceneMesh getUnitMesh(const SceneMesh& mesh, glm::vec3& scale)
+{
+    SceneMesh unit = mesh;
+    scale = glm::vec3(1.0f);
+    if (mesh.type == SCENE_MESH_SPHERE && mesh.params[0] > 0.0f)
+    {
+        scale = glm::vec3(mesh.params[0]);
+        unit.params[0] = 1.0f;
+    }
+    else if (mesh.type == SCENE_MESH_CYLINDER)
+    {
+        float radius = std::max(mesh.params[0], mesh.params[1]);
+        float height = mesh.params[2];
+        if (radius > 0.0f && height > 0.0f)
+        {
+            scale = glm::vec3(radius, radius, height);
+            unit.params[0] = mesh.params[0] / radius;
+            unit.params[1] = mesh.params[1] / radius;
+            unit.params[2] = 1.0f;
+        }
+    }
+    return unit;
+}
 
-    mesh.nIndices = sizeof(vertices) / (sizeof(vertices[0]) * (floatsPerVertex + floatsPerNormal + floatsPerTex));
+// function to get the asset name of a sphere or cylinder mesh. scene meshes with the same name share one GPU mesh
+std::string getGeneratedMeshName(const SceneMesh& mesh)
+{
+    std::ostringstream key;
+    key.precision(9);
+    if (mesh.type == SCENE_MESH_SPHERE)
+        key << "sphere " << mesh.params[0];
+    else
+        key << "cylinder " << mesh.params[0] << " " << mesh.params[1] << " " << mesh.params[2];
+    key << " " << mesh.sectors << " " << mesh.stacks << " " << (mesh.smooth != 0) << " " << MESH_VERTEX_FORMAT << " " << USE_TRIANGLE_STRIPS
+        << " " << (isSubdividedSphere(mesh) ? SPHERE_TOPOLOGY : SPHERE_TOPOLOGY_UV);
+    return key.str();
+}
 
-    glGenVertexArrays(1, &mesh.vao); // generate vertex array
-    glGenBuffers(1, &mesh.vbo); // generate vertex buffer object
+// function to tell whether a sphere or cylinder is written to memory first (for strips or the optimizer) or straight into the mapped GPU buffers
+bool isGeneratedInMemory(const SceneMesh& mesh)
+{
+    return (USE_TRIANGLE_STRIPS && mesh.smooth != 0 && !isSubdividedSphere(mesh)) || OPTIMIZE_MESHES;
+}
 
-    glBindVertexArray(mesh.vao); // bind the created vertex array
+// function to tell whether a sphere or cylinder has the tessellation of the compile-time generators
+bool isStaticMesh(const SceneMesh& mesh)
+{
+    return mesh.smooth != 0 && mesh.sectors == STATIC_MESH_SECTORS && mesh.stacks == STATIC_MESH_STACKS && !isSubdividedSphere(mesh);
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo); // bind vertex buffer object
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW); // buffer vertex data to GPU
+// function to tell whether a sphere is built by the SPHERE_TOPOLOGY generator instead of Sphere
+bool isSubdividedSphere(const SceneMesh& mesh)
+{
+    return SPHERE_TOPOLOGY != SPHERE_TOPOLOGY_UV && mesh.type == SCENE_MESH_SPHERE && mesh.smooth != 0;
+}
 
+// function to build a sphere with the SPHERE_TOPOLOGY generator, as fine as needed for the chord error of its sectors and stacks as a UV sphere, and pass its arrays to use
+void buildSubdividedSphere(const SceneMesh& mesh, const std::function<void(const MeshView&)>& use)
+{
+    float maxError = getUVSphereChordError(mesh.sectors, mesh.stacks);
+    if (SPHERE_TOPOLOGY == SPHERE_TOPOLOGY_ICO)
+    {
+        const Icosphere sphere(mesh.params[0], Icosphere::getFrequencyForError(maxError), MESH_OUTPUT_INTERLEAVED);
+        use(sphere.getMeshView());
+    }
+    else
+    {
+        const Cubesphere sphere(mesh.params[0], Cubesphere::getSegmentCountForError(maxError), MESH_OUTPUT_INTERLEAVED);
+        use(sphere.getMeshView());
+    }
+}
 
-    // variable to indicate the stride for vertex and color attributes 
-    GLint stride = sizeof(float) * (floatsPerVertex + floatsPerNormal + floatsPerTex);
+// function to size the arrays of a mesh for generateMesh(), with room for its strips or LODs. the arena is not thread-safe, so only the loading thread allocates
+// subdivided spheres are built here: their vertex count depends on the vertices split at the tex coord seam
+void sizeGeneratedMesh(GeneratedMesh& generated)
+{
+    const SceneMesh& mesh = *generated.source;
+    if (isSubdividedSphere(mesh))
+    {
+        buildSubdividedSphere(mesh, [&generated](const MeshView& view)
+        {
+            generated.vertices.assign(view.vertices, view.vertices + view.vertexCount * MESH_VERTEX_FLOATS);
+            generated.indices.reserve(getGeneratedIndexCapacity(view.indexCount));
+            generated.indices.assign(view.indices, view.indices + view.indexCount);
+        });
+        return;
+    }
+
+    bool smooth = mesh.smooth != 0;
+    unsigned int vertexCount, indexCount, stripIndexCount = 0;
+    if (mesh.type == SCENE_MESH_SPHERE)
+        Sphere::getInterleavedCounts(mesh.sectors, mesh.stacks, smooth, vertexCount, indexCount);
+    else
+        Cylinder::getInterleavedCounts(mesh.sectors, mesh.stacks, smooth, vertexCount, indexCount);
+    if (USE_TRIANGLE_STRIPS && smooth)
+        stripIndexCount = mesh.type == SCENE_MESH_SPHERE ? Sphere::getStripIndexCount(mesh.sectors, mesh.stacks)
+                                                         : Cylinder::getStripIndexCount(mesh.sectors, mesh.stacks);
+
+    generated.vertices.resize(vertexCount * MESH_VERTEX_FLOATS);
+    generated.indices.reserve(std::max(getGeneratedIndexCapacity(indexCount), stripIndexCount));
+    generated.indices.resize(indexCount);
+}
+
+// function to write the vertices and indices of a sphere or cylinder to memory, and make strips or optimize them. it makes no GL calls, so it can run on a worker thread
+// the arrays are sized by sizeGeneratedMesh() first and only shrink (or grow within their capacity) here
+void generateMesh(GeneratedMesh& generated, ThreadPool* pool)
+{
+    const SceneMesh& mesh = *generated.source;
+    bool smooth = mesh.smooth != 0;
+    unsigned int vertexCount = (unsigned int)(generated.vertices.size() / MESH_VERTEX_FLOATS);
+    unsigned int indexCount = (unsigned int)generated.indices.size();
+
+    if (isSubdividedSphere(mesh))
+    {
+        // built by sizeGeneratedMesh(), only optimized here
+    }
+    else if (isStaticMesh(mesh) && mesh.type == SCENE_MESH_SPHERE)
+    {
+        // the trig tables and indices were computed by the compiler, only the vertices are scaled here
+        const StaticSphere<STATIC_MESH_SECTORS, STATIC_MESH_STACKS> sphere(mesh.params[0]);
+        std::copy(sphere.getInterleavedVertices(), sphere.getInterleavedVertices() + generated.vertices.size(), generated.vertices.begin());
+        std::copy(sphere.getIndices(), sphere.getIndices() + generated.indices.size(), generated.indices.begin());
+    }
+    else if (isStaticMesh(mesh))
+    {
+        const StaticCylinder<STATIC_MESH_SECTORS, STATIC_MESH_STACKS> cylinder(mesh.params[0], mesh.params[1], mesh.params[2]);
+        std::copy(cylinder.getInterleavedVertices(), cylinder.getInterleavedVertices() + generated.vertices.size(), generated.vertices.begin());
+        std::copy(cylinder.getIndices(), cylinder.getIndices() + generated.indices.size(), generated.indices.begin());
+    }
+    else if (mesh.type == SCENE_MESH_SPHERE)
+        Sphere::writeInterleaved(mesh.params[0], mesh.sectors, mesh.stacks, smooth, generated.vertices.data(), generated.indices.data(), pool);
+    else
+        Cylinder::writeInterleaved(mesh.params[0], mesh.params[1], mesh.params[2], mesh.sectors, mesh.stacks, smooth,
+                                   generated.vertices.data(), generated.indices.data(), pool);
+
+    generated.strips = USE_TRIANGLE_STRIPS && smooth && !isSubdividedSphere(mesh);
+    generated.optimized = !generated.strips;
+    if (generated.strips)
+    {
+        // the vertices are shared with the list form; its indices are replaced by the strips
+        if (mesh.type == SCENE_MESH_SPHERE)
+        {
+            generated.indices.resize(Sphere::getStripIndexCount(mesh.sectors, mesh.stacks));
+            Sphere::writeStripIndices(mesh.sectors, mesh.stacks, generated.indices.data());
+        }
+        else
+        {
+            generated.indices.resize(Cylinder::getStripIndexCount(mesh.sectors, mesh.stacks));
+            Cylinder::writeStripIndices(mesh.sectors, mesh.stacks, generated.indices.data());
+        }
+        return;
+    }
+
+    // remove degenerate triangles and reorder for the vertex cache and vertex fetch
+    optimizeMesh(generated.vertices.data(), vertexCount, MESH_VERTEX_STRIDE, generated.indices.data(), indexCount, &generated.stats);
+    generated.vertices.resize(vertexCount * MESH_VERTEX_FLOATS);
+    generated.indices.resize(indexCount);
+}
 
-    // create vertex attribute pointers
-    glVertexAttribPointer(0, floatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-    glEnableVertexAttribArray(0);
+// function to generate meshes on all hardware threads. large meshes split their rows over the threads one mesh at a time, small ones are built one mesh per thread
+void generateMeshes(std::vector<GeneratedMesh>& meshes)
+{
+    if (meshes.empty())
+        return;
+
+    std::vector<GeneratedMesh*> large, small;
+    for (std::size_t i = 0; i < meshes.size(); ++i)
+    {
+        sizeGeneratedMesh(meshes[i]);
+        unsigned int vertexCount = (unsigned int)(meshes[i].vertices.size() / MESH_VERTEX_FLOATS);
+        (vertexCount >= MESH_ROW_SPLIT_VERTICES ? large : small).push_back(&meshes[i]);
+    }
+
+    ThreadPool pool;
+    for (std::size_t i = 0; i < large.size(); ++i)
+    {
+        generateMesh(*large[i], &pool);
+    }
+
+    // the pool runs these meshes itself, so they may not split their rows over it too
+    pool.parallelFor(small.size(), 1, [&](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            generateMesh(*small[i], 0);
+        }
+    });
+
+    if (BUILD_MESH_LODS && OPTIMIZE_MESHES)
+        buildGeneratedMeshLods(meshes, pool);
+    if (gObjectCulling == OBJECT_CULLING_MESHLETS && OPTIMIZE_MESHES)
+        buildGeneratedMeshlets(meshes, pool);
+
+    std::cout << "Generated " << meshes.size() << " meshes on " << pool.getThreadCount() + 1 << " threads ("
+              << large.size() << " split by rows, " << getRingKernelName() << " ring kernel)" << std::endl;
+}
+
+// function to get the room the index array of a generated mesh needs for its LODs after it
+unsigned int getGeneratedIndexCapacity(unsigned int indexCount)
+{
+    if (BUILD_MESH_LODS && OPTIMIZE_MESHES)
+        return getLodChainIndexCapacity(indexCount, std::min(MESH_LOD_COUNT, MAX_MESH_LODS), MESH_LOD_RATIO);
+    return indexCount;
+}
+
+// function to build the LODs of the optimized meshes, one mesh per thread. the LODs go after LOD 0 in the index arrays, within the capacity sizeGeneratedMesh() reserved
+void buildGeneratedMeshLods(std::vector<GeneratedMesh>& meshes, ThreadPool& pool)
+{
+    std::vector<GeneratedMesh*> sources;
+    std::vector<LodChainJob> jobs;
+    for (std::size_t i = 0; i < meshes.size(); ++i)
+    {
+        if (!meshes[i].optimized)
+            continue;
+        LodChainJob job;
+        job.vertices = meshes[i].vertices.data();
+        job.vertexCount = (unsigned int)(meshes[i].vertices.size() / MESH_VERTEX_FLOATS);
+        job.stride = MESH_VERTEX_STRIDE;
+        job.indices = meshes[i].indices.data();
+        job.indexCount = (unsigned int)meshes[i].indices.size();
+        jobs.push_back(job);
+        sources.push_back(&meshes[i]);
+    }
 
-    glVertexAttribPointer(1, floatsPerNormal, GL_FLOAT, GL_FALSE, stride, (char*)(sizeof(float) * floatsPerVertex));
-    glEnableVertexAttribArray(1);
+    buildLodChains(jobs.data(), jobs.size(), std::min(MESH_LOD_COUNT, MAX_MESH_LODS), MESH_LOD_RATIO, 0.0f, SimplifyOptions(), &pool);
 
-    glVertexAttribPointer(2, floatsPerTex, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (floatsPerVertex + floatsPerNormal)));
-    glEnableVertexAttribArray(2);
+    for (std::size_t i = 0; i < jobs.size(); ++i)
+    {
+        sources[i]->indices.assign(jobs[i].lodIndices.begin(), jobs[i].lodIndices.end());
+        sources[i]->lods = jobs[i].lods;
+    }
 }
 
-// function to get rid of the mesh prior to ending the software
-void deleteMesh(GLMesh& mesh)
+// function to reorder the triangles of each LOD of the optimized meshes into meshlets, one mesh per thread. the LOD ranges stay where they are
+void buildGeneratedMeshlets(std::vector<GeneratedMesh>& meshes, ThreadPool& pool)
 {
-    glDeleteVertexArrays(1, &mesh.vao);
-    glDeleteBuffers(1, &mesh.vbo);
-    glDeleteBuffers(1, &mesh.ebo);
+    pool.parallelFor(meshes.size(), 1, [&meshes](std::size_t begin, std::size_t end)
+    {
+        for (std::size_t i = begin; i < end; ++i)
+        {
+            GeneratedMesh& generated = meshes[i];
+            if (!generated.optimized)
+                continue;
+
+            std::vector<MeshLod> ranges = generated.lods;
+            if (ranges.empty())
+            {
+                MeshLod whole = { 0, (unsigned int)generated.indices.size(), 0.0f };
+                ranges.push_back(whole);
+            }
+
+            std::vector<unsigned int> ordered(generated.indices.size());
+            unsigned int vertexCount = (unsigned int)(generated.vertices.size() / MESH_VERTEX_FLOATS);
+            for (std::size_t lod = 0; lod < ranges.size(); ++lod)
+            {
+                generated.lodFirstMeshlet.push_back((unsigned int)generated.meshlets.size());
+                buildMeshlets(ordered.data() + ranges[lod].firstIndex, generated.indices.data() + ranges[lod].firstIndex, ranges[lod].indexCount,
+                              generated.vertices.data(), vertexCount, MESH_VERTEX_STRIDE, generated.meshlets, ranges[lod].firstIndex);
+            }
+            generated.lodFirstMeshlet.push_back((unsigned int)generated.meshlets.size());
+            std::copy(ordered.begin(), ordered.end(), generated.indices.begin());
+        }
+    });
 }
 
-// function to flip the image to match the correct axis
-void flipImageVertically(unsigned char* image, int width, int height, int channels)
+// function to buffer a mesh from generateMesh() to GPU
+void uploadGeneratedMesh(GLMesh& mesh, const GeneratedMesh& generated)
 {
-    for (int j = 0; j < height / 2; ++j)
+    unsigned int vertexCount = (unsigned int)(generated.vertices.size() / MESH_VERTEX_FLOATS);
+    if (generated.optimized)
     {
-        int index1 = j * width * channels;
-        int index2 = (height - 1 - j) * width * channels;
+        // report the post-transform cache efficiency before and after
+        const MeshOptimizeStats& stats = generated.stats;
+        std::cout << generated.name << ": " << stats.trianglesBefore << " -> " << stats.trianglesAfter << " triangles, "
+                  << stats.verticesBefore << " -> " << stats.verticesAfter << " vertices, ACMR "
+                  << stats.acmrBefore << " -> " << stats.acmrAfter << ", ATVR "
+                  << stats.atvrBefore << " -> " << stats.atvrAfter
+                  << (canUse16BitIndices(vertexCount) ? ", 16-bit indices" : ", 32-bit indices") << std::endl;
+    }
 
-        for (int i = width * channels; i > 0; --i)
+    // uploadMesh() narrows the indices to 16 bits when the vertex count allows it
+    MeshView view(generated.vertices.data(), vertexCount, generated.indices.data(), (unsigned int)generated.indices.size());
+    view.strips = generated.strips;
+    uploadMesh(mesh, view, MESH_VERTEX_FORMAT);
+
+    // all LODs share the vertices; LOD 0 is drawn unless selectMeshLod() picks another
+    if (generated.lods.size() > 1)
+    {
+        mesh.lodCount = (unsigned int)generated.lods.size();
+        mesh.nIndices = generated.lods[0].indexCount;
+        std::cout << generated.name << ": LODs";
+        for (unsigned int i = 0; i < mesh.lodCount; ++i)
         {
-            unsigned char tmp = image[index1];
-            image[index1] = image[index2];
-            image[index2] = tmp;
-            ++index1;
-            ++index2;
+            mesh.lodFirstIndex[i] = generated.lods[i].firstIndex;
+            mesh.lodIndexCount[i] = generated.lods[i].indexCount;
+            mesh.lodError[i] = generated.lods[i].error;
+            std::cout << (i ? ", " : " ") << mesh.lodIndexCount[i] / 3 << " triangles (error " << mesh.lodError[i] << ")";
         }
+        std::cout << std::endl;
+    }
+
+    // meshlets are culled per LOD; without LODs, LOD 0 has them all
+    if (!generated.meshlets.empty())
+    {
+        mesh.meshlets.assign(generated.meshlets.begin(), generated.meshlets.end());
+        std::copy(generated.lodFirstMeshlet.begin(), generated.lodFirstMeshlet.end(), mesh.lodFirstMeshlet);
+        std::cout << generated.name << ": " << mesh.meshlets.size() << " meshlets, " << getMeshletKernelName() << " culling" << std::endl;
     }
 }
 
-// function to create the textures to be put on object
-bool createTexture(const char* filename, GLuint& textureId)
+// function to get a shared sphere or cylinder mesh written straight into the mapped GPU buffers. it is only built the first time the name is used
+MeshHandle getMappedMesh(const std::string& name, const SceneMesh& source)
 {
-    int width, height, channels;
-    unsigned char* image = stbi_load(filename, &width, &height, &channels, 0); // load image
-    if (image)
-    {
-        flipImageVertically(image, width, height, channels); // flip image
-
-        // generate and bind textures
-        glGenTextures(1, &textureId);
-        glBindTexture(GL_TEXTURE_2D, textureId);
-
-        // set the texture wrapping parameters.
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        // set texture filtering parameters.
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        if (channels == 3)
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-        else if (channels == 4)
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
+    const SceneMesh mesh = source;
+    return gAssets.getMesh(name, [mesh](GLMesh& glMesh)
+    {
+        // compile-time tessellations are generated on the stack and buffered from there
+        if (isStaticMesh(mesh) && mesh.type == SCENE_MESH_SPHERE)
+        {
+            const StaticSphere<STATIC_MESH_SECTORS, STATIC_MESH_STACKS> sphere(mesh.params[0]);
+            uploadMesh(glMesh, sphere.getMeshView(), MESH_VERTEX_FORMAT);
+            return;
+        }
+        if (isStaticMesh(mesh))
+        {
+            const StaticCylinder<STATIC_MESH_SECTORS, STATIC_MESH_STACKS> cylinder(mesh.params[0], mesh.params[1], mesh.params[2]);
+            uploadMesh(glMesh, cylinder.getMeshView(), MESH_VERTEX_FORMAT);
+            return;
+        }
+        if (isSubdividedSphere(mesh))
+        {
+            buildSubdividedSphere(mesh, [&glMesh](const MeshView& view) { uploadMesh(glMesh, view, MESH_VERTEX_FORMAT); });
+            return;
+        }
+
+        bool smooth = mesh.smooth != 0;
+        unsigned int vertexCount, indexCount;
+        if (mesh.type == SCENE_MESH_SPHERE)
+            Sphere::getInterleavedCounts(mesh.sectors, mesh.stacks, smooth, vertexCount, indexCount);
         else
+            Cylinder::getInterleavedCounts(mesh.sectors, mesh.stacks, smooth, vertexCount, indexCount);
+
+        if (MESH_VERTEX_FORMAT == VERTEX_FORMAT_PACKED)
+        {
+            uploadPackedMesh(glMesh, vertexCount, indexCount, [&](PackedVertex* vertices, unsigned int* indices, VertexQuantization& quantization)
+            {
+                if (mesh.type == SCENE_MESH_SPHERE)
+                    Sphere::writeInterleavedPacked(mesh.params[0], mesh.sectors, mesh.stacks, smooth, vertices, indices, quantization);
+                else
+                    Cylinder::writeInterleavedPacked(mesh.params[0], mesh.params[1], mesh.params[2], mesh.sectors, mesh.stacks, smooth, vertices, indices, quantization);
+            });
+            return;
+        }
+        uploadMesh(glMesh, vertexCount, indexCount, [&](float* vertices, unsigned int* indices)
         {
-            std::cout << "Not implemented to handle image with " << channels << " channels" << std::endl;
+            if (mesh.type == SCENE_MESH_SPHERE)
+                Sphere::writeInterleaved(mesh.params[0], mesh.sectors, mesh.stacks, smooth, vertices, indices);
+            else
+                Cylinder::writeInterleaved(mesh.params[0], mesh.params[1], mesh.params[2], mesh.sectors, mesh.stacks, smooth, vertices, indices);
+        });
+    });
+}
+
+// function to check whether the compiled scene is at least as new as the text scene it was compiled from
+bool isSceneBinaryCurrent()
+{
+    std::error_code binaryError, textError;
+    std::filesystem::file_time_type binaryTime = std::filesystem::last_write_time(SCENE_BINARY_FILE, binaryError);
+    std::filesystem::file_time_type textTime = std::filesystem::last_write_time(SCENE_TEXT_FILE, textError);
+    if (binaryError)
+        return false;
+    return textError || binaryTime >= textTime;
+}
+
+// function to load the scene description and get the meshes and textures it uses. returns a boolean to show whether the process was successful or not
+bool loadScene()
+{
+    bool binaryCurrent = isSceneBinaryCurrent();
+    if (!binaryCurrent && std::filesystem::exists(SCENE_BINARY_FILE))
+        std::cout << SCENE_BINARY_FILE << " is older than " << SCENE_TEXT_FILE << ", run SceneCompile to update it" << std::endl;
+
+    const char* sceneFile = SCENE_BINARY_FILE;
+    if (!binaryCurrent || !gScene.load(SCENE_BINARY_FILE))
+    {
+        sceneFile = SCENE_TEXT_FILE;
+        if (!gScene.load(SCENE_TEXT_FILE))
+        {
+            std::cout << "Failed to load scene " << SCENE_TEXT_FILE << std::endl;
             return false;
         }
+    }
+    std::cout << "Loaded scene " << sceneFile << std::endl;
 
-        glGenerateMipmap(GL_TEXTURE_2D); // generate mipmap
+    // the culling path decides whether meshlets are built
+    selectObjectCulling();
 
-        stbi_image_free(image);
-        glBindTexture(GL_TEXTURE_2D, 0); // unbind the texture.
+    if (gScene.getLightCount() > MAX_LIGHTS)
+    {
+        std::cout << "Only the first " << MAX_LIGHTS << " of " << gScene.getLightCount() << " lights light the scene" << std::endl;
+    }
+
+    // plan the tessellations for the world size of the meshes, before their size moves into the model matrices
+    std::vector<SceneMesh> meshes(gScene.getMeshes(), gScene.getMeshes() + gScene.getMeshCount());
+    if (PLAN_TESSELLATION)
+    {
+        TessellationTolerance tolerance;
+        tolerance.maxChordError = TESSELLATION_MAX_CHORD_ERROR;
+        if (TESSELLATION_REFERENCE_DISTANCE > 0.0f)
+            tolerance.maxChordError = getPixelWorldSize(TESSELLATION_MAX_CHORD_ERROR, TESSELLATION_REFERENCE_DISTANCE, glm::radians(gCamera.Zoom), SCR_HEIGHT);
+        tolerance.maxNormalError = glm::radians(TESSELLATION_MAX_NORMAL_ERROR);
+
+        TessellationQuantization quantization;
+        quantization.roundCounts = TESSELLATION_ROUND_COUNTS;
+        quantization.preferredSectors = TESSELLATION_SNAP_TO_STATIC ? STATIC_MESH_SECTORS : 0;
+        quantization.preferredStacks = TESSELLATION_SNAP_TO_STATIC ? STATIC_MESH_STACKS : 0;
+
+        TessellationStats stats;
+        planSceneTessellation(gScene, tolerance, meshes.data(), &stats, &quantization, SPHERE_TOPOLOGY);
+        for (unsigned int i = 0; i < gScene.getMeshCount(); ++i)
+        {
+            const SceneMesh& before = gScene.getMeshes()[i];
+            if (meshes[i].sectors != before.sectors || meshes[i].stacks != before.stacks)
+            {
+                std::cout << "Mesh " << i << ": " << before.sectors << "x" << before.stacks << " -> " << meshes[i].sectors << "x" << meshes[i].stacks
+                          << " (" << getSceneMeshTriangleCount(before, SPHERE_TOPOLOGY) << " -> " << getSceneMeshTriangleCount(meshes[i], SPHERE_TOPOLOGY) << " triangles)" << std::endl;
+            }
+        }
+        std::cout << "Planned " << stats.meshesPlanned << " meshes within " << tolerance.maxChordError << " chord error: " << stats.trianglesBefore << " -> "
+                  << stats.trianglesAfter << " triangles drawn, " << (long long)stats.trianglesBefore - (long long)stats.trianglesAfter << " saved" << std::endl;
+    }
 
-        return true;
+    // replace spheres and cylinders by unit shapes, which scene meshes of any size share, and move their size into the model matrices
+    std::vector<glm::vec3> meshScales(gScene.getMeshCount(), glm::vec3(1.0f));
+    if (SHARE_UNIT_PRIMITIVES)
+    {
+        for (unsigned int i = 0; i < gScene.getMeshCount(); ++i)
+        {
+            meshes[i] = getUnitMesh(meshes[i], meshScales[i]);
+        }
     }
 
-    // error loading the image
-    return false;
+    const float* models = gScene.getModelMatrices();
+    const unsigned int* objectMeshes = gScene.getObjectMeshes();
+    gObjectModels.resize(gScene.getObjectCount());
+    for (unsigned int i = 0; i < gScene.getObjectCount(); ++i)
+    {
+        gObjectModels[i] = glm::make_mat4(models + i * 16) * glm::scale(meshScales[objectMeshes[i]]);
+    }
+
+    // flat meshes share the vertices of the smooth ones and are shaded flat by the fragment shader
+    gSceneMeshFlatShading.assign(gScene.getMeshCount(), false);
+    for (unsigned int i = 0; i < gScene.getMeshCount(); ++i)
+    {
+        bool generated = meshes[i].type == SCENE_MESH_SPHERE || meshes[i].type == SCENE_MESH_CYLINDER;
+        if (SHADER_FLAT_SHADING && generated && meshes[i].smooth == 0)
+        {
+            gSceneMeshFlatShading[i] = true;
+            meshes[i].smooth = 1;
+        }
+    }
+
+    // generate each distinct sphere and cylinder that is built in memory on the worker threads first; only buffering them to GPU needs this thread
+    std::vector<std::string> names(gScene.getMeshCount());
+    std::map<std::string, std::size_t> generatedIndex;
+    std::pmr::monotonic_buffer_resource arena;
+    std::pmr::memory_resource* resource = USE_MESH_ARENA ? &arena : std::pmr::get_default_resource();
+    std::vector<GeneratedMesh> generated;
+    for (unsigned int i = 0; i < gScene.getMeshCount(); ++i)
+    {
+        const SceneMesh& mesh = meshes[i];
+        if (mesh.type != SCENE_MESH_SPHERE && mesh.type != SCENE_MESH_CYLINDER)
+            continue;
+
+        names[i] = getGeneratedMeshName(mesh);
+        if (isGeneratedInMemory(mesh) && generatedIndex.find(names[i]) == generatedIndex.end())
+        {
+            generatedIndex[names[i]] = generated.size();
+            generated.push_back(GeneratedMesh(resource));
+            generated.back().source = &mesh;
+            generated.back().name = names[i];
+        }
+    }
+    generateMeshes(generated);
+
+    // get a shared mesh for each scene mesh, buffered to GPU on first use
+    gSceneMeshes.resize(gScene.getMeshCount());
+    for (unsigned int i = 0; i < gScene.getMeshCount(); ++i)
+    {
+        const SceneMesh& mesh = meshes[i];
+        switch (mesh.type)
+        {
+        case SCENE_MESH_SPHERE:
+        case SCENE_MESH_CYLINDER:
+            if (isGeneratedInMemory(mesh))
+            {
+                const GeneratedMesh& source = generated[generatedIndex[names[i]]];
+                gSceneMeshes[i] = gAssets.getMesh(names[i], [&source](GLMesh& glMesh) { uploadGeneratedMesh(glMesh, source); });
+            }
+            else
+            {
+                gSceneMeshes[i] = getMappedMesh(names[i], mesh);
+            }
+            break;
+        case SCENE_MESH_PLANE:
+            gSceneMeshes[i] = gAssets.getMesh("plane", createPlaneMesh); // call the createPlaneMesh() function to initialize our data and buffer it to GPU
+            break;
+        default:
+            gSceneMeshes[i] = gAssets.getMesh("box", createBoxMesh); // call the createBoxMesh() function to initialize our data and buffer it to GPU
+            break;
+        }
+    }
+
+    // every generated mesh is on the GPU now; the arena frees all of their arrays at once
+    generated.clear();
+    arena.release();
+
+    std::vector<const GLMesh*> distinct;
+    gSceneMeshGpuMeshes.resize(gSceneMeshes.size());
+    for (unsigned int i = 0; i < gSceneMeshes.size(); ++i)
+    {
+        std::vector<const GLMesh*>::iterator found = std::find(distinct.begin(), distinct.end(), gSceneMeshes[i].get());
+        gSceneMeshGpuMeshes[i] = (unsigned int)(found - distinct.begin());
+        if (found == distinct.end())
+            distinct.push_back(gSceneMeshes[i].get());
+    }
+    std::cout << gScene.getMeshCount() << " scene meshes share " << distinct.size() << " GPU meshes" << std::endl;
+
+    sortObjects();
+    createGpuCulling();
+
+    // queue the scene textures. they are loaded together by gAssets.loadTextures(). with texture arrays the textures
+    // of object materials become array layers, and only the ones other materials use as well are loaded as 2D textures too
+    std::vector<bool> objectTextures(gScene.getTextureCount(), false);
+    std::vector<bool> otherTextures(gScene.getTextureCount(), false);
+    const SceneMaterial* materials = gScene.getMaterials();
+    for (unsigned int i = 0; i < gScene.getMaterialCount(); ++i)
+    {
+        std::vector<bool>& used = (materials[i].program == SCENE_PROGRAM_OBJECT) ? objectTextures : otherTextures;
+        if (materials[i].texture >= 0)
+            used[materials[i].texture] = true;
+        if (materials[i].overlay >= 0)
+            used[materials[i].overlay] = true;
+    }
+
+    gSceneTextures.resize(gScene.getTextureCount());
+    gSceneTextureLayers.resize(gScene.getTextureCount());
+    for (unsigned int i = 0; i < gScene.getTextureCount(); ++i)
+    {
+        bool arrayLayer = USE_TEXTURE_ARRAYS && objectTextures[i];
+        if (arrayLayer)
+            gAssets.getTextureLayer(gScene.getTexturePath(i), gTextureArrays, gSceneTextureLayers[i]);
+        if (!arrayLayer || otherTextures[i])
+            gSceneTextures[i] = gAssets.getTexture(gScene.getTexturePath(i));
+    }
+
+    return true;
 }
 
-// function to create shader program. returns a boolean to show whether the process was successful or not
-bool createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource, GLuint& programId)
+// function to pick the culling path of this run: OBJECT_CULLING, or the meshlets when the GPU path needs what the context does not have
+void selectObjectCulling()
 {
-    int successful;
-    char errorLog[512];
+    gObjectCulling = OBJECT_CULLING;
+    if (gObjectCulling == OBJECT_CULLING_GPU && !GpuCuller::isSupported())
+    {
+        std::cout << "GPU culling needs OpenGL 4.3 with vertex shader SSBOs, culling meshlets on the CPU instead" << std::endl;
+        gObjectCulling = OBJECT_CULLING_MESHLETS;
+    }
 
-    unsigned int vertexShader; // declare variable for vertex shader
-    vertexShader = glCreateShader(GL_VERTEX_SHADER); // create vertex shader and assign it to vertexShader
-    glShaderSource(vertexShader, 1, &vertexShaderSource, NULL); // specify the source for the vertex shader
-    glCompileShader(vertexShader); // compile the vertex shader
+    const char* names[] = { "none (objects drawn whole)", "meshlets on the CPU", "objects on the GPU (no meshlets)" };
+    std::cout << "Culling: " << names[gObjectCulling] << std::endl;
+}
 
-    // ensure that the vertex shader was compiled correctly
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &successful);
-    if (!successful)
+// function to get the vertex shader of the object, plane and wireframe programs. only the GPU path declares the instance SSBO, so the others
+// link where the vertex stage has no SSBOs
+const char* getObjectVertexShaderSource()
+{
+    return gObjectCulling == OBJECT_CULLING_GPU ? objectInstancedVertexShaderSource : objectVertexShaderSource;
+}
+
+// function to set the draw order of the objects: by material as in the scene, then by GPU mesh and flat shading, so the objects of a material that share
+// a unit mesh are drawn one after the other (and make one batch of the GPU culler)
+void sortObjects()
+{
+    const unsigned int* objectMeshes = gScene.getObjectMeshes();
+    const unsigned int* objectMaterials = gScene.getObjectMaterials();
+    gObjectOrder.resize(gScene.getObjectCount());
+    for (unsigned int i = 0; i < gScene.getObjectCount(); ++i)
+        gObjectOrder[i] = i;
+
+    std::stable_sort(gObjectOrder.begin(), gObjectOrder.end(), [objectMeshes, objectMaterials](unsigned int a, unsigned int b)
+    {
+        if (objectMaterials[a] != objectMaterials[b])
+            return objectMaterials[a] < objectMaterials[b];
+        if (gSceneMeshGpuMeshes[objectMeshes[a]] != gSceneMeshGpuMeshes[objectMeshes[b]])
+            return gSceneMeshGpuMeshes[objectMeshes[a]] < gSceneMeshGpuMeshes[objectMeshes[b]];
+        return gSceneMeshFlatShading[objectMeshes[a]] < gSceneMeshFlatShading[objectMeshes[b]];
+    });
+}
+
+// function to hand the objects with indexed meshes to the GPU culler, in batches of objects next in gObjectOrder with one material, GPU mesh and flat
+// shading, and to source the instance index of their VAOs from its visible lists. the other objects, and all of them without OpenGL 4.3, are drawn one by one
+void createGpuCulling()
+{
+    gObjectBatches.assign(gScene.getObjectCount(), NO_GPU_BATCH);
+    if (gObjectCulling != OBJECT_CULLING_GPU)
+        return;
+
+    // the LODs of every GPU mesh, or one range of all of its indices. scene meshes sharing a unit mesh share its entry
+    std::vector<const GLMesh*> gpuMeshes;
+    for (unsigned int i = 0; i < gScene.getMeshCount(); ++i)
+    {
+        if (gSceneMeshGpuMeshes[i] == gpuMeshes.size())
+            gpuMeshes.push_back(gSceneMeshes[i].get());
+    }
+    std::vector<GpuMeshLods> meshes(gpuMeshes.size());
+    for (unsigned int i = 0; i < gpuMeshes.size(); ++i)
+    {
+        const GLMesh& mesh = *gpuMeshes[i];
+        GpuMeshLods& lods = meshes[i];
+        lods = GpuMeshLods();
+        lods.lodCount = 1;
+        lods.indexCount[0] = mesh.nIndices;
+        for (unsigned int k = 0; k < mesh.lodCount; ++k)
+        {
+            lods.firstIndex[k] = mesh.lodFirstIndex[k];
+            lods.indexCount[k] = mesh.lodIndexCount[k];
+            lods.error[k] = mesh.lodError[k];
+        }
+        lods.lodCount = std::max(mesh.lodCount, 1u);
+    }
+
+    // objects are drawn by material and then GPU mesh, so a batch is a run of them in gObjectOrder; meshes without indices are drawn with glDrawArrays()
+    const unsigned int* objectMeshes = gScene.getObjectMeshes();
+    const unsigned int* objectMaterials = gScene.getObjectMaterials();
+    std::vector<GpuInstance> instances;
+    unsigned int batchCount = 0;
+    for (unsigned int k = 0; k < gScene.getObjectCount(); ++k)
+    {
+        unsigned int i = gObjectOrder[k];
+        const GLMesh& mesh = *gSceneMeshes[objectMeshes[i]];
+        if (!mesh.ebo)
+            continue;
+        unsigned int previous = k > 0 ? gObjectOrder[k - 1] : 0;
+        if (k == 0 || gObjectBatches[previous] == NO_GPU_BATCH || objectMaterials[i] != objectMaterials[previous] ||
+            gSceneMeshGpuMeshes[objectMeshes[i]] != gSceneMeshGpuMeshes[objectMeshes[previous]] ||
+            gSceneMeshFlatShading[objectMeshes[i]] != gSceneMeshFlatShading[objectMeshes[previous]])
+            ++batchCount;
+        gObjectBatches[i] = batchCount - 1;
+
+        GpuInstance instance;
+        const float* model = glm::value_ptr(gObjectModels[i]);
+        std::copy(model, model + 16, instance.model);
+        std::copy(mesh.boundingSphere, mesh.boundingSphere + 4, instance.boundingSphere);
+        instance.batch = batchCount - 1;
+        instance.mesh = gSceneMeshGpuMeshes[objectMeshes[i]];
+        instance.material = objectMaterials[i];
+        instance.padding = 0;
+        instances.push_back(instance);
+    }
+    if (instances.empty())
+        return;
+
+    if (!gGpuCuller.create(meshes.data(), (unsigned int)meshes.size(), instances.data(), (unsigned int)instances.size()))
     {
-        glGetShaderInfoLog(vertexShader, 512, NULL, errorLog);
-        std::cout << "Failed to compile vertex shader\n" << errorLog << std::endl;
+        std::cout << "Failed to create the GPU culling, objects are drawn whole without culling" << std::endl;
+        gObjectBatches.assign(gScene.getObjectCount(), NO_GPU_BATCH);
+        return;
+    }
+    gGpuCuller.setOcclusionCulling(GPU_OCCLUSION_CULLING);
+    for (unsigned int i = 0; i < gpuMeshes.size(); ++i)
+    {
+        if (gpuMeshes[i]->ebo)
+            gGpuCuller.bindInstanceAttribute(gpuMeshes[i]->vao);
+    }
+
+    std::cout << "GPU culling " << instances.size() << " objects in " << batchCount << " batches, "
+              << (gGpuCuller.hasDrawCount() ? "one indirect count draw per batch" : "every LOD of a batch drawn (no indirect draw count)") << std::endl;
+}
 
+// function to drop the last references to the meshes, textures and shader programs, which deletes them
+void releaseAssets()
+{
+    gGpuCuller.release();
+    gObjectBatches.clear();
+    gSceneMeshes.clear();
+    gObjectModels.clear();
+    gSceneMeshFlatShading.clear();
+    gSceneMeshGpuMeshes.clear();
+    gObjectOrder.clear();
+    gObjectDraws.clear();
+    gIndirectCommands.clear();
+    if (gIndirectBuffer)
+    {
+        glDeleteBuffers(1, &gIndirectBuffer);
+        gIndirectBuffer = 0;
+    }
+    meshLight.reset();
+
+    gSceneTextures.clear();
+
+    objectProgram.reset();
+    objectArrayProgram.reset();
+    planeProgram.reset();
+    lightProgram.reset();
+    wireframeProgram.reset();
+
+    gAssets.removeExpired();
+}
+
+// function to create the texture arrays of the object textures (their layers were loaded by gAssets.loadTextures()), bind them once and create the matching shader program
+bool createObjectTextureArrays()
+{
+    if (gTextureArrays.getArrayCount() > MAX_TEXTURE_ARRAYS)
+    {
+        std::cout << "Too many texture size classes: " << gTextureArrays.getArrayCount() << std::endl;
         return false;
     }
 
-    unsigned int fragmentShader; // declare variable for fragment shader
-    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER); // create fragment shader and assign it to fragmentShader
-    glShaderSource(fragmentShader, 1, &fragmentShaderSource, NULL); // specify the source for the fragment shader
-    glCompileShader(fragmentShader); // compile the fragment shader
+    if (!gTextureArrays.upload())
+    {
+        return false;
+    }
+
+    objectArrayProgram = gAssets.getProgram(getObjectVertexShaderSource(), objectArrayFragmentShaderSource, createShaderProgram);
+    if (!objectArrayProgram)
+    {
+        return false;
+    }
+
+    // bind every array to its own texture unit. they stay bound for the whole run
+    for (int i = 0; i < gTextureArrays.getArrayCount(); ++i)
+    {
+        glActiveTexture(GL_TEXTURE0 + TEXTURE_ARRAY_UNIT + i);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, gTextureArrays.getTextureId(i));
+    }
+    glActiveTexture(GL_TEXTURE0);
+
+    // point each sampler of the uTextureArrays array at its unit
+    GLint units[MAX_TEXTURE_ARRAYS];
+    for (int i = 0; i < MAX_TEXTURE_ARRAYS; ++i)
+        units[i] = TEXTURE_ARRAY_UNIT + i;
+    glUseProgram(*objectArrayProgram);
+    glUniform1iv(glGetUniformLocation(*objectArrayProgram, "uTextureArrays"), MAX_TEXTURE_ARRAYS, units);
 
-    // ensure that the fragment shader was compiled correctly
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &successful);
+    return true;
+}
+
+// bind the scene texture of the next object. with texture arrays only the layer uniform changes
+void bindObjectTexture(GLuint programId, int texture)
+{
+    if (USE_TEXTURE_ARRAYS)
+    {
+        const TextureLayer& layer = gSceneTextureLayers[texture];
+        glUniform2i(glGetUniformLocation(programId, "textureLayer"), layer.array, layer.layer);
+        return;
+    }
+
+    glActiveTexture(GL_TEXTURE0); // set active texture
+    glBindTexture(GL_TEXTURE_2D, *gSceneTextures[texture]);
+}
+
+// bind the extra scene texture drawn over the object texture (texture unit 1)
+void bindOverlayTexture(GLuint programId, int texture)
+{
+    if (USE_TEXTURE_ARRAYS)
+    {
+        const TextureLayer& layer = gSceneTextureLayers[texture];
+        glUniform2i(glGetUniformLocation(programId, "textureLayer2"), layer.array, layer.layer);
+        return;
+    }
+
+    glActiveTexture(GL_TEXTURE1); // set active texture for extra texture
+    glBindTexture(GL_TEXTURE_2D, *gSceneTextures[texture]);
+}
+
+// function to compile one shader stage. returns a boolean to show whether the process was successful or not
+bool compileShader(GLenum type, const char* source, const char* name, GLuint& shader)
+{
+    int successful;
+    char errorLog[512];
+
+    shader = glCreateShader(type); // create the shader and assign it to shader
+    glShaderSource(shader, 1, &source, NULL); // specify the source for the shader
+    glCompileShader(shader); // compile the shader
+
+    // ensure that the shader was compiled correctly
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &successful);
     if (!successful)
     {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, errorLog);
-        std::cout << "Failed to compile fragment shader\n" << errorLog << std::endl;
+        glGetShaderInfoLog(shader, 512, NULL, errorLog);
+        std::cout << "Failed to compile " << name << " shader\n" << errorLog << std::endl;
 
         return false;
     }
 
+    return true;
+}
+
+// function to create shader program. returns a boolean to show whether the process was successful or not
+bool createShaderProgram(const char* vertexShaderSource, const char* fragmentShaderSource, GLuint& programId)
+{
+    return createShaderProgram(vertexShaderSource, nullptr, fragmentShaderSource, programId);
+}
+
+// function to create a shader program with an optional geometry shader (null to leave it out). returns a boolean to show whether the process was successful or not
+bool createShaderProgram(const char* vertexShaderSource, const char* geometryShaderSource, const char* fragmentShaderSource, GLuint& programId)
+{
+    int successful;
+    char errorLog[512];
+
+    GLuint vertexShader, geometryShader = 0, fragmentShader;
+    if (!compileShader(GL_VERTEX_SHADER, vertexShaderSource, "vertex", vertexShader))
+        return false;
+    if (geometryShaderSource && !compileShader(GL_GEOMETRY_SHADER, geometryShaderSource, "geometry", geometryShader))
+        return false;
+    if (!compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource, "fragment", fragmentShader))
+        return false;
+
     programId = glCreateProgram(); // create shader program and assign it to programId
     glAttachShader(programId, vertexShader); // attach vertex shader to shader program
+    if (geometryShader)
+        glAttachShader(programId, geometryShader); // attach geometry shader to shader program
     glAttachShader(programId, fragmentShader); // attach fragment shader to shader program
     glLinkProgram(programId); // link shader program
 
@@ -1327,11 +2228,4 @@ bool createShaderProgram(const char* vertexShaderSource, const char* fragmentSha
     glUseProgram(programId);
 
     return true;
-}
-
-
-// function to delete shader program prior to ending the software
-void deleteShaderProgram(GLuint programId)
-{
-    glDeleteProgram(programId);
 }
\ No newline at end of file
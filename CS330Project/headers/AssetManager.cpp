@@ -0,0 +1,283 @@
+///////////////////////////////////////////////////////////////////////////////
+// AssetManager.cpp
+// ================
+// Reference counted texture, mesh and program caches.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include "MappedFile.h"
+#include "AssetManager.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// deleters, run when the last handle is released
+///////////////////////////////////////////////////////////////////////////////
+static void deleteTexture(GLuint* textureId)
+{
+    if(*textureId)
+        glDeleteTextures(1, textureId);
+    delete textureId;
+}
+
+static void deleteMesh(GLMesh* mesh)
+{
+    glDeleteVertexArrays(1, &mesh->vao);
+    glDeleteBuffers(1, &mesh->vbo);
+    glDeleteBuffers(1, &mesh->ebo);
+    delete mesh;
+}
+
+static void deleteProgram(GLuint* programId)
+{
+    glDeleteProgram(*programId);
+    delete programId;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// 64-bit FNV-1a
+///////////////////////////////////////////////////////////////////////////////
+unsigned long long hashAssetData(const void* data, std::size_t size, unsigned long long seed)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    unsigned long long hash = seed;
+    for(std::size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// "textures\box.jpg", "./textures/box.jpg" -> "textures/box.jpg"
+///////////////////////////////////////////////////////////////////////////////
+std::string AssetManager::normalizePath(const char* filename)
+{
+    std::string path(filename);
+    for(std::size_t i = 0; i < path.size(); ++i)
+    {
+        if(path[i] == '\\')
+            path[i] = '/';
+    }
+
+    std::string::size_type dot;
+    while((dot = path.find("/./")) != std::string::npos)
+        path.erase(dot, 2);
+    while(path.compare(0, 2, "./") == 0)
+        path.erase(0, 2);
+    return path;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// queue a texture or return the shared one
+///////////////////////////////////////////////////////////////////////////////
+TextureHandle AssetManager::getTexture(const char* filename)
+{
+    ++textureRequests;
+
+    std::string path = normalizePath(filename);
+    TextureHandle texture = texturesByPath[path].lock();
+    if(texture)
+        return texture;
+
+    // same contents under another path: share it, once the bytes match (not just the hash)
+    unsigned long long hash = 0;
+    MappedFile file;
+    if(file.open(path.c_str()))
+    {
+        hash = hashAssetData(file.getData(), file.getSize());
+
+        std::pair<std::string, std::weak_ptr<GLuint> >& entry = texturesByHash[hash];
+        texture = entry.second.lock();
+        MappedFile other;
+        if(texture && other.open(entry.first.c_str()) && other.getSize() == file.getSize() &&
+           memcmp(other.getData(), file.getData(), file.getSize()) == 0)
+        {
+            texturesByPath[path] = texture;
+            return texture;
+        }
+        if(texture)
+            hash = 0;   // a collision: keep the first file's entry
+        texture.reset();
+    }
+    file.close();
+
+    // new texture; a missing file is still queued so loadTextures() reports it
+    texture = TextureHandle(new GLuint(0), deleteTexture);
+    textureLoader.add(path.c_str(), *texture);
+    pendingTextures.push_back(texture);
+    ++textureLoads;
+
+    texturesByPath[path] = texture;
+    if(hash)
+        texturesByHash[hash] = std::make_pair(path, std::weak_ptr<GLuint>(texture));
+    return texture;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// queue a texture array layer
+///////////////////////////////////////////////////////////////////////////////
+void AssetManager::getTextureLayer(const char* filename, TextureArraySet& arrays, TextureLayer& layer)
+{
+    ++textureRequests;
+    ++textureLoads;
+    textureLoader.add(normalizePath(filename).c_str(), arrays, layer);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// load the queued textures
+///////////////////////////////////////////////////////////////////////////////
+bool AssetManager::loadTextures()
+{
+    bool ok = textureLoader.loadAll();
+    pendingTextures.clear();
+    return ok;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// shared mesh for a geometry key
+///////////////////////////////////////////////////////////////////////////////
+MeshHandle AssetManager::getMesh(const std::string& key, const MeshBuilder& build)
+{
+    MeshHandle mesh = meshes[key].lock();
+    if(mesh)
+        return mesh;
+
+    GLMesh* newMesh = new GLMesh();
+    build(*newMesh);
+    mesh = MeshHandle(newMesh, deleteMesh);
+    meshes[key] = mesh;
+    return mesh;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// shared program for a pair of shader sources
+///////////////////////////////////////////////////////////////////////////////
+ProgramHandle AssetManager::getProgram(const char* vertexShaderSource, const char* fragmentShaderSource,
+                                       ProgramBuilder build)
+{
+    // both sources with a separator so the split point matters
+    std::string sources(vertexShaderSource);
+    sources.append(1, '\0').append(fragmentShaderSource).append(1, '\0');
+    unsigned long long hash = hashAssetData(sources.data(), sources.size());
+
+    ProgramHandle program = findProgram(hash, sources);
+    if(program)
+        return program;
+
+    GLuint programId = 0;
+    bool built = build(vertexShaderSource, fragmentShaderSource, programId);
+    return addProgram(hash, sources, programId, built);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// shared program for a vertex, geometry and fragment shader
+///////////////////////////////////////////////////////////////////////////////
+ProgramHandle AssetManager::getProgram(const char* vertexShaderSource, const char* geometryShaderSource,
+                                       const char* fragmentShaderSource, GeometryProgramBuilder build)
+{
+    std::string sources(vertexShaderSource);
+    sources.append(1, '\0').append(geometryShaderSource).append(1, '\0');
+    sources.append(fragmentShaderSource).append(1, '\0');
+    unsigned long long hash = hashAssetData(sources.data(), sources.size());
+
+    ProgramHandle program = findProgram(hash, sources);
+    if(program)
+        return program;
+
+    GLuint programId = 0;
+    bool built = build(vertexShaderSource, geometryShaderSource, fragmentShaderSource, programId);
+    return addProgram(hash, sources, programId, built);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the live program with a source hash, once its sources match (not just the hash)
+///////////////////////////////////////////////////////////////////////////////
+ProgramHandle AssetManager::findProgram(unsigned long long hash, const std::string& sources)
+{
+    std::map<unsigned long long, std::pair<std::string, std::weak_ptr<GLuint> > >::iterator it = programs.find(hash);
+    if(it == programs.end() || it->second.first != sources)
+        return ProgramHandle();
+    return it->second.second.lock();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// cache a program a builder made, or delete what is left of a failed one
+///////////////////////////////////////////////////////////////////////////////
+ProgramHandle AssetManager::addProgram(unsigned long long hash, const std::string& sources, GLuint programId, bool built)
+{
+    if(!built)
+    {
+        if(programId)
+            glDeleteProgram(programId);
+        return ProgramHandle();
+    }
+
+    ProgramHandle program(new GLuint(programId), deleteProgram);
+
+    // a collision with a live program of other sources: keep the first one's entry
+    std::pair<std::string, std::weak_ptr<GLuint> >& entry = programs[hash];
+    if(entry.second.expired())
+        entry = std::make_pair(sources, std::weak_ptr<GLuint>(program));
+    return program;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// drop expired cache entries
+///////////////////////////////////////////////////////////////////////////////
+template<class Key, class T>
+static void removeExpiredEntries(std::map<Key, std::weak_ptr<T> >& cache)
+{
+    typename std::map<Key, std::weak_ptr<T> >::iterator it = cache.begin();
+    while(it != cache.end())
+    {
+        if(it->second.expired())
+            cache.erase(it++);
+        else
+            ++it;
+    }
+}
+
+template<class Key, class T>
+static void removeExpiredEntries(std::map<Key, std::pair<std::string, std::weak_ptr<T> > >& cache)
+{
+    typename std::map<Key, std::pair<std::string, std::weak_ptr<T> > >::iterator it = cache.begin();
+    while(it != cache.end())
+    {
+        if(it->second.second.expired())
+            cache.erase(it++);
+        else
+            ++it;
+    }
+}
+
+void AssetManager::removeExpired()
+{
+    removeExpiredEntries(texturesByPath);
+    removeExpiredEntries(texturesByHash);
+    removeExpiredEntries(meshes);
+    removeExpiredEntries(programs);
+}
@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+// AssetManager.h
+// ==============
+// Shared, reference counted GPU assets. Every asset is created once and
+// handed out as a shared_ptr; the GL object is deleted when the last handle
+// is released, so all handles must be released while the RC is current.
+//
+// - textures: resolved by normalized path, then by an FNV-1a hash of the file
+//             contents (confirmed by comparing the bytes), so identical files
+//             under different paths share one texture. Queued textures are decoded in one TextureLoader batch
+//             by loadTextures(); until then the handle holds 0. Texture array
+//             layers are queued in the same batch (not shared).
+// - meshes  : resolved by a key that describes the geometry (primitive type
+//             and parameters); the create callback only runs for a new key
+// - programs: resolved by a hash of the vertex (geometry) and fragment source
+//             (confirmed by comparing the sources)
+//
+// The caches hold weak references only; they never keep an asset alive.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef ASSET_MANAGER_H
+#define ASSET_MANAGER_H
+
+#include <GL/glew.h>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "Meshlets.h"
+#include "TextureLoader.h"
+
+const unsigned int MAX_MESH_LODS = 8;      // LOD ranges a GLMesh can hold
+
+// mesh struct to contain the vertex array object and buffer objects
+struct GLMesh
+{
+    GLuint vao;         // variable for the vertex array object
+    GLuint vbo;         // variable for the vertex buffer object
+    GLuint ebo;         // variable for the element buffer object
+    GLuint nIndices;    // number of indices for the mesh
+    GLenum indexType;   // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    GLenum primitive;   // GL_TRIANGLES or GL_TRIANGLE_STRIP (with primitive restart)
+    float positionScale[3];     // packed vertices: position * positionScale + positionBias
+    float positionBias[3];      // (1 and 0 for float vertices)
+    float boundingSphere[4];    // center and radius around the positions, in object units (radius < 0 when unknown)
+    unsigned int lodCount;                  // index ranges of the LODs, finest first (0 for none)
+    GLuint lodFirstIndex[MAX_MESH_LODS];
+    GLuint lodIndexCount[MAX_MESH_LODS];
+    float lodError[MAX_MESH_LODS];          // largest distance from LOD 0, in object units
+    std::vector<Meshlet> meshlets;          // clusters of the triangles for culling, LOD by LOD (empty for none)
+    unsigned int lodFirstMeshlet[MAX_MESH_LODS + 1];    // LOD i has meshlets [lodFirstMeshlet[i], lodFirstMeshlet[i + 1])
+};
+
+typedef std::shared_ptr<GLuint> TextureHandle;     // *handle is the texture id
+typedef std::shared_ptr<GLuint> ProgramHandle;     // *handle is the program id
+typedef std::shared_ptr<GLMesh> MeshHandle;
+
+// builds the GL objects of a new mesh
+typedef std::function<void(GLMesh&)> MeshBuilder;
+// compiles and links a new program, returns false on failure
+typedef bool (*ProgramBuilder)(const char* vertexShaderSource, const char* fragmentShaderSource, GLuint& programId);
+// same with a geometry shader between the two
+typedef bool (*GeometryProgramBuilder)(const char* vertexShaderSource, const char* geometryShaderSource,
+                                       const char* fragmentShaderSource, GLuint& programId);
+
+// 64-bit FNV-1a
+unsigned long long hashAssetData(const void* data, std::size_t size,
+                                 unsigned long long seed=14695981039346656037ULL);
+
+class AssetManager
+{
+public:
+    // ctor/dtor
+    AssetManager() : textureRequests(0), textureLoads(0) {}
+    ~AssetManager() {}
+
+    // queue a texture, or share the one already loaded from the same path or with the same contents
+    TextureHandle getTexture(const char* filename);
+
+    // queue a texture as a layer of a texture array (in the same batch as the 2D textures)
+    // layer is written by loadTextures(); the arrays are created by arrays.upload() after it
+    void getTextureLayer(const char* filename, TextureArraySet& arrays, TextureLayer& layer);
+
+    // decode and upload all queued textures
+    // OpenGL RC must be set before calling it
+    bool loadTextures();
+
+    // shared mesh for a geometry key; build() runs only if no live mesh has that key
+    MeshHandle getMesh(const std::string& key, const MeshBuilder& build);
+
+    // shared program for a pair of shader sources; null if the builder fails
+    ProgramHandle getProgram(const char* vertexShaderSource, const char* fragmentShaderSource,
+                             ProgramBuilder build);
+    // shared program for a vertex, geometry and fragment shader
+    ProgramHandle getProgram(const char* vertexShaderSource, const char* geometryShaderSource,
+                             const char* fragmentShaderSource, GeometryProgramBuilder build);
+
+    // drop cache entries of assets that have been released
+    void removeExpired();
+
+    // number of getTexture() calls and of textures actually loaded
+    unsigned int getTextureRequestCount() const { return textureRequests; }
+    unsigned int getTextureLoadCount() const    { return textureLoads; }
+
+private:
+    static std::string normalizePath(const char* filename);
+    ProgramHandle findProgram(unsigned long long hash, const std::string& sources);
+    ProgramHandle addProgram(unsigned long long hash, const std::string& sources, GLuint programId, bool built);
+
+    std::map<std::string, std::weak_ptr<GLuint> > texturesByPath;
+    std::map<unsigned long long, std::pair<std::string, std::weak_ptr<GLuint> > > texturesByHash; // path it was loaded from
+    std::map<std::string, std::weak_ptr<GLMesh> > meshes;
+    std::map<unsigned long long, std::pair<std::string, std::weak_ptr<GLuint> > > programs;    // sources it was built from
+
+    TextureLoader textureLoader;
+    std::vector<TextureHandle> pendingTextures; // keeps queued ids alive until loadTextures()
+
+    unsigned int textureRequests;
+    unsigned int textureLoads;
+};
+
+#endif
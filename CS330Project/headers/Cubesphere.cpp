@@ -0,0 +1,410 @@
+///////////////////////////////////////////////////////////////////////////////
+// Cubesphere.cpp
+// =============
+// Sphere for OpenGL with (radius, segments)
+// A cube projected onto the sphere; the min number of segments is 2.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+#include <windows.h>    // include windows.h to avoid thousands of compile errors even though this class is not depending on Windows
+#endif
+
+#ifdef __APPLE__
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+#include <iostream>
+#include <cmath>
+#include "Cubesphere.h"
+#include "SphereTopology.h"
+
+
+
+// constants //////////////////////////////////////////////////////////////////
+const int MIN_SEGMENT_COUNT = 2;
+const int MAX_SEGMENT_COUNT = 512;  // 3145728 triangles
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+Cubesphere::Cubesphere(float radius, int segmentCount, unsigned int outputs, std::pmr::memory_resource* resource)
+    : vertices(resource), normals(resource), texCoords(resource), indices(resource), lineIndices(resource),
+      interleavedVertices(resource), interleavedStride(32)
+{
+    set(radius, segmentCount, outputs);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// setters
+///////////////////////////////////////////////////////////////////////////////
+void Cubesphere::set(float radius, int segmentCount, unsigned int outputs)
+{
+    this->radius = radius;
+    this->segmentCount = segmentCount + (segmentCount & 1);   // even, so the poles are vertices
+    if(segmentCount < MIN_SEGMENT_COUNT)
+        this->segmentCount = MIN_SEGMENT_COUNT;
+    if(segmentCount > MAX_SEGMENT_COUNT)
+        this->segmentCount = MAX_SEGMENT_COUNT;
+    this->outputs = outputs;
+
+    buildVertices();
+}
+
+void Cubesphere::setRadius(float radius)
+{
+    if(radius == this->radius)
+        return;
+
+    // the topology does not depend on the radius, so the arrays are rewritten in place
+    this->radius = radius;
+    if(interleavedVertices.empty())
+        set(radius, segmentCount, outputs);
+    else
+        updateVertices();
+}
+
+void Cubesphere::setSegmentCount(int segmentCount)
+{
+    if(segmentCount != this->segmentCount)
+        set(radius, segmentCount, outputs);
+}
+
+void Cubesphere::setOutputs(unsigned int outputs)
+{
+    if(this->outputs != outputs)
+        set(radius, segmentCount, outputs);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// print itself
+///////////////////////////////////////////////////////////////////////////////
+void Cubesphere::printSelf() const
+{
+    std::cout << "===== Cubesphere =====\n"
+              << "        Radius: " << radius << "\n"
+              << " Segment Count: " << segmentCount << "\n"
+              << "   Chord Error: " << getChordError(segmentCount) * radius << "\n"
+              << "Triangle Count: " << getTriangleCount() << "\n"
+              << "   Index Count: " << getIndexCount() << "\n"
+              << "  Vertex Count: " << getVertexCount() << "\n"
+              << "  Normal Count: " << getNormalCount() << "\n"
+              << "TexCoord Count: " << getTexCoordCount() << std::endl;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// draw an cubesphere in VertexArray mode
+// OpenGL RC must be set before calling it
+///////////////////////////////////////////////////////////////////////////////
+void Cubesphere::draw() const
+{
+    // interleaved array
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(3, GL_FLOAT, interleavedStride, &interleavedVertices[0]);
+    glNormalPointer(GL_FLOAT, interleavedStride, &interleavedVertices[3]);
+    glTexCoordPointer(2, GL_FLOAT, interleavedStride, &interleavedVertices[6]);
+
+    glDrawElements(GL_TRIANGLES, (unsigned int)indices.size(), GL_UNSIGNED_INT, indices.data());
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// draw lines only
+// the caller must set the line width before call this
+///////////////////////////////////////////////////////////////////////////////
+void Cubesphere::drawLines(const float lineColor[4]) const
+{
+    // set line colour
+    glColor4fv(lineColor);
+    glMaterialfv(GL_FRONT, GL_DIFFUSE,   lineColor);
+
+    // draw lines with VA
+    glDisable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, vertices.data());
+
+    glDrawElements(GL_LINES, (unsigned int)lineIndices.size(), GL_UNSIGNED_INT, lineIndices.data());
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_TEXTURE_2D);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// draw an cubesphere surfaces and lines on top of it
+// the caller must set the line width before call this
+///////////////////////////////////////////////////////////////////////////////
+void Cubesphere::drawWithLines(const float lineColor[4]) const
+{
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(1.0, 1.0f); // move polygon backward
+    this->draw();
+    glDisable(GL_POLYGON_OFFSET_FILL);
+
+    // draw lines with VA
+    drawLines(lineColor);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// rewrite the positions of the existing arrays after a radius change
+///////////////////////////////////////////////////////////////////////////////
+void Cubesphere::updateVertices()
+{
+    scaleSphereVertices(radius, vertexCount, &interleavedVertices[0]);
+
+    if(outputs & MESH_OUTPUT_SEPARATE)
+        buildSeparateVertices();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// dealloc vectors
+///////////////////////////////////////////////////////////////////////////////
+void Cubesphere::clearArrays()
+{
+    // swap with empty arrays of the same memory resource
+    std::pmr::vector<float>(vertices.get_allocator()).swap(vertices);
+    std::pmr::vector<float>(normals.get_allocator()).swap(normals);
+    std::pmr::vector<float>(texCoords.get_allocator()).swap(texCoords);
+    std::pmr::vector<unsigned int>(indices.get_allocator()).swap(indices);
+    std::pmr::vector<unsigned int>(lineIndices.get_allocator()).swap(lineIndices);
+    std::pmr::vector<float>(interleavedVertices.get_allocator()).swap(interleavedVertices);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// non-owning view of the interleaved vertices and indices
+///////////////////////////////////////////////////////////////////////////////
+MeshView Cubesphere::getMeshView() const
+{
+    return MeshView(interleavedVertices.data(), getInterleavedVertexCount(),
+                    indices.data(), getIndexCount(), interleavedStride);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// 6 faces of segments x segments quads, 2 triangles each
+///////////////////////////////////////////////////////////////////////////////
+unsigned int Cubesphere::getTriangleCount(int segmentCount)
+{
+    return 12u * segmentCount * segmentCount;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// chord error of a unit cubesphere, measured on its triangles
+// the largest error is in the quads at the middle of the faces
+///////////////////////////////////////////////////////////////////////////////
+float Cubesphere::getChordError(int segmentCount)
+{
+    std::vector<Vec3> positions;
+    std::vector<unsigned int> indices;
+    buildUnitMesh(segmentCount, positions, indices);
+    return computeChordError(&positions[0].x, sizeof(Vec3), indices.data(), (unsigned int)indices.size());
+}
+
+int Cubesphere::getSegmentCountForError(float maxError)
+{
+    // the error drops about 4x per doubling, so search the power of 2 first,
+    // then the even counts below it
+    int high = MIN_SEGMENT_COUNT;
+    while(high < MAX_SEGMENT_COUNT && getChordError(high) > maxError)
+        high *= 2;
+    if(high > MAX_SEGMENT_COUNT)
+        high = MAX_SEGMENT_COUNT;
+
+    int low = high / 2;                 // too coarse, unless high is the min
+    while(high - low > 2 && low >= MIN_SEGMENT_COUNT)
+    {
+        int middle = (low + high) / 2 / 2 * 2;
+        if(getChordError(middle) > maxError)
+            low = middle;
+        else
+            high = middle;
+    }
+    return high;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// each face is a grid on the cube face facing axis n, with u x v = n so the
+// triangles are counter-clockwise from outside. a grid point at (a, b) in
+// [-1, 1] is n + u * tan(pi/4 * a) + v * tan(pi/4 * b), normalized
+// the faces do not share vertices, so the cube edges have 2 copies of theirs
+///////////////////////////////////////////////////////////////////////////////
+void Cubesphere::buildUnitMesh(int segmentCount, std::vector<Vec3>& positions, std::vector<unsigned int>& indices)
+{
+    const float PI = acos(-1);
+    const Vec3 FACES[6][3] = { { { 1, 0, 0}, {0, 1, 0}, {0, 0, 1} },    // n, u, v
+                               { {-1, 0, 0}, {0, 0, 1}, {0, 1, 0} },
+                               { { 0, 1, 0}, {0, 0, 1}, {1, 0, 0} },
+                               { { 0,-1, 0}, {1, 0, 0}, {0, 0, 1} },
+                               { { 0, 0, 1}, {1, 0, 0}, {0, 1, 0} },
+                               { { 0, 0,-1}, {0, 1, 0}, {1, 0, 0} } };
+    int rowSize = segmentCount + 1;
+
+    // equal-angle grid coords, the same for both directions of every face
+    std::vector<float> grid(rowSize);
+    for(int i = 0; i <= segmentCount; ++i)
+        grid[i] = tanf(PI / 4 * (2.0f * i / segmentCount - 1));
+
+    positions.resize((std::size_t)6 * rowSize * rowSize);
+    indices.resize((std::size_t)6 * segmentCount * segmentCount * 6);
+    Vec3* position = &positions[0];
+    unsigned int* index = &indices[0];
+    for(int f = 0; f < 6; ++f)
+    {
+        const Vec3& n = FACES[f][0];
+        const Vec3& u = FACES[f][1];
+        const Vec3& v = FACES[f][2];
+        for(int j = 0; j <= segmentCount; ++j)
+        {
+            for(int i = 0; i <= segmentCount; ++i, ++position)
+            {
+                Vec3 p = { n.x + u.x * grid[i] + v.x * grid[j],
+                           n.y + u.y * grid[i] + v.y * grid[j],
+                           n.z + u.z * grid[i] + v.z * grid[j] };
+                float lengthInv = 1.0f / length(p);
+                position->x = p.x * lengthInv;
+                position->y = p.y * lengthInv;
+                position->z = p.z * lengthInv;
+            }
+        }
+
+        //  k2--k2+1    v
+        //  |  / |      ^
+        //  | /  |      |
+        //  k1--k1+1    +--> u
+        // the quads toward the cube corners are rhombi; splitting them along
+        // the shorter diagonal keeps the triangles closer to the sphere
+        unsigned int base = f * rowSize * rowSize;
+        for(int j = 0; j < segmentCount; ++j)
+        {
+            unsigned int k1 = base + j * rowSize;
+            unsigned int k2 = k1 + rowSize;
+            for(int i = 0; i < segmentCount; ++i, ++k1, ++k2)
+            {
+                Vec3 d1 = positions[k2+1] - positions[k1];
+                Vec3 d2 = positions[k2] - positions[k1+1];
+                if(dot(d1, d1) <= dot(d2, d2))
+                {
+                    *index++ = k1;      *index++ = k1 + 1;  *index++ = k2 + 1;
+                    *index++ = k1;      *index++ = k2 + 1;  *index++ = k2;
+                }
+                else
+                {
+                    *index++ = k1;      *index++ = k1 + 1;  *index++ = k2;
+                    *index++ = k1 + 1;  *index++ = k2 + 1;  *index++ = k2;
+                }
+            }
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// build the interleaved vertices from the unit mesh, split the tex coord seam,
+// then make the other outputs from them
+///////////////////////////////////////////////////////////////////////////////
+void Cubesphere::buildVertices()
+{
+    // clear memory of prev arrays
+    clearArrays();
+
+    std::vector<Vec3> positions;
+    std::vector<unsigned int> unitIndices;
+    buildUnitMesh(segmentCount, positions, unitIndices);
+
+    interleavedVertices.resize(positions.size() * MESH_VERTEX_FLOATS);
+    writeSphereVertices(positions.data(), (unsigned int)positions.size(), radius, &interleavedVertices[0]);
+    indices.assign(unitIndices.begin(), unitIndices.end());
+    fixSphereSeams(interleavedVertices, indices);
+
+    vertexCount = (unsigned int)(interleavedVertices.size() / MESH_VERTEX_FLOATS);
+    indexCount = (unsigned int)indices.size();
+    buildOutputs();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// build the arrays selected by the output mask from the interleaved array,
+// then drop the interleaved array if it was not selected
+///////////////////////////////////////////////////////////////////////////////
+void Cubesphere::buildOutputs()
+{
+    if(outputs & MESH_OUTPUT_SEPARATE)
+        buildSeparateVertices();
+    if(!(outputs & MESH_OUTPUT_INTERLEAVED))
+        std::pmr::vector<float>(interleavedVertices.get_allocator()).swap(interleavedVertices);
+    if(outputs & MESH_OUTPUT_LINES)
+        buildEdgeIndices(indices.data(), indexCount, lineIndices);
+    lineIndexCount = (unsigned int)lineIndices.size();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// free the arrays after upload; counts and bounds are kept
+///////////////////////////////////////////////////////////////////////////////
+void Cubesphere::releaseCpuData()
+{
+    clearArrays();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// bounds of the cubesphere: all vertices are on the sphere, so its bounds
+// contain the mesh
+///////////////////////////////////////////////////////////////////////////////
+void Cubesphere::getBounds(float min[3], float max[3]) const
+{
+    for(int i = 0; i < 3; ++i)
+    {
+        min[i] = -radius;
+        max[i] = radius;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// split interleaved vertices: V/N/T into separate arrays
+///////////////////////////////////////////////////////////////////////////////
+void Cubesphere::buildSeparateVertices()
+{
+    std::size_t count = interleavedVertices.size() / 8;
+    vertices.resize(count * 3);
+    normals.resize(count * 3);
+    texCoords.resize(count * 2);
+    if(count > 0)
+        splitInterleaved(&interleavedVertices[0], count, &vertices[0], &normals[0], &texCoords[0]);
+}
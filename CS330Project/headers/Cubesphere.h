@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+// Cubesphere.h
+// ============
+// Sphere for OpenGL with (radius, segments)
+// A cube whose faces are grids of segments x segments quads, projected onto
+// the sphere. The grid lines are spaced by equal angles rather than equal
+// lengths before the projection, which keeps the quads close to the same size
+// from the middle of a face to its corners.
+//
+// 12 * segments^2 triangles; the min number of segments is 2 and it is kept
+// even, so the poles are grid vertices. Smooth shading only; the accessors
+// are those of Sphere.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef GEOMETRY_CUBESPHERE_H
+#define GEOMETRY_CUBESPHERE_H
+
+#include <memory_resource>
+#include <vector>
+#include "GeometryKernel.h"
+#include "MeshView.h"
+
+class Cubesphere
+{
+public:
+    // ctor/dtor
+    Cubesphere(float radius=1.0f, int segmentCount=16, unsigned int outputs=MESH_OUTPUT_ALL,
+              std::pmr::memory_resource* resource=std::pmr::get_default_resource());
+    ~Cubesphere() {}
+
+    // getters/setters
+    float getRadius() const                 { return radius; }
+    int getSegmentCount() const             { return segmentCount; }
+    void set(float radius, int segmentCount, unsigned int outputs=MESH_OUTPUT_ALL);
+    void setRadius(float radius);           // rewrites positions in place, keeps the indices
+    void setSegmentCount(int segmentCount);
+    void setOutputs(unsigned int outputs);  // MeshOutput flags
+    unsigned int getOutputs() const         { return outputs; }
+
+    // arrays are allocated from this resource, like Sphere
+    std::pmr::memory_resource* getMemoryResource() const { return interleavedVertices.get_allocator().resource(); }
+
+    // for vertex data
+    // counts include the vertices duplicated at the tex coord seam and the poles
+    unsigned int getVertexCount() const     { return vertexCount; }
+    unsigned int getNormalCount() const     { return vertexCount; }
+    unsigned int getTexCoordCount() const   { return vertexCount; }
+    unsigned int getIndexCount() const      { return indexCount; }
+    unsigned int getLineIndexCount() const  { return lineIndexCount; }
+    unsigned int getTriangleCount() const   { return getIndexCount() / 3; }
+    unsigned int getVertexSize() const      { return (unsigned int)vertices.size() * sizeof(float); }
+    unsigned int getNormalSize() const      { return (unsigned int)normals.size() * sizeof(float); }
+    unsigned int getTexCoordSize() const    { return (unsigned int)texCoords.size() * sizeof(float); }
+    unsigned int getIndexSize() const       { return (unsigned int)indices.size() * sizeof(unsigned int); }
+    unsigned int getLineIndexSize() const   { return (unsigned int)lineIndices.size() * sizeof(unsigned int); }
+    const float* getVertices() const        { return vertices.data(); }
+    const float* getNormals() const         { return normals.data(); }
+    const float* getTexCoords() const       { return texCoords.data(); }
+    const unsigned int* getIndices() const  { return indices.data(); }
+    const unsigned int* getLineIndices() const  { return lineIndices.data(); }
+
+    // for interleaved vertices: V/N/T
+    unsigned int getInterleavedVertexCount() const  { return getVertexCount(); }    // # of vertices
+    unsigned int getInterleavedVertexSize() const   { return (unsigned int)interleavedVertices.size() * sizeof(float); }    // # of bytes
+    int getInterleavedStride() const                { return interleavedStride; }   // should be 32 bytes
+    const float* getInterleavedVertices() const     { return interleavedVertices.data(); }
+
+    // non-owning view of the interleaved vertices and indices, for uploading without a copy
+    MeshView getMeshView() const;
+
+    // chord error of a unit cubesphere, and the fewest segments within maxError
+    static unsigned int getTriangleCount(int segmentCount);
+    static float getChordError(int segmentCount);
+    static int getSegmentCountForError(float maxError);
+
+    // unit sphere positions (also the normals) and triangle indices, before
+    // the seam is split; each face has its own grid of vertices
+    static void buildUnitMesh(int segmentCount, std::vector<Vec3>& positions, std::vector<unsigned int>& indices);
+
+    // axis-aligned bounds in object space, kept after releaseCpuData()
+    void getBounds(float min[3], float max[3]) const;
+
+    // free all vertex and index arrays once they are uploaded; counts and bounds remain
+    void releaseCpuData();
+
+    // draw in VertexArray mode, like Sphere (compatibility profile only)
+    void draw() const;                                  // draw surface
+    void drawLines(const float lineColor[4]) const;     // draw lines only
+    void drawWithLines(const float lineColor[4]) const; // draw surface and lines
+
+    // debug
+    void printSelf() const;
+
+protected:
+
+private:
+    // member functions
+    void buildVertices();
+    void buildOutputs();
+    void buildSeparateVertices();
+    void updateVertices();
+    void clearArrays();
+
+    // memeber vars
+    float radius;
+    int segmentCount;                       // # of quads along each edge of a cube face, even
+    unsigned int outputs;                   // MeshOutput flags
+    unsigned int vertexCount;
+    unsigned int indexCount;
+    unsigned int lineIndexCount;
+    std::pmr::vector<float> vertices;
+    std::pmr::vector<float> normals;
+    std::pmr::vector<float> texCoords;
+    std::pmr::vector<unsigned int> indices;
+    std::pmr::vector<unsigned int> lineIndices;
+
+    // interleaved
+    std::pmr::vector<float> interleavedVertices;
+    int interleavedStride;                  // # of bytes to hop to the next vertex (should be 32 bytes)
+
+};
+
+#endif
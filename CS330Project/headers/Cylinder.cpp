@@ -28,7 +28,11 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <vector>
 #include "Cylinder.h"
+#include "GeometryKernel.h"
+#include "MeshKernels.h"
+#include "ThreadPool.h"
 
 
 
@@ -42,9 +46,11 @@ const int MIN_STACK_COUNT  = 1;
 // ctor
 ///////////////////////////////////////////////////////////////////////////////
 Cylinder::Cylinder(float baseRadius, float topRadius, float height, int sectors,
-                   int stacks, bool smooth) : interleavedStride(32)
+                   int stacks, bool smooth, unsigned int outputs, std::pmr::memory_resource* resource)
+    : vertices(resource), normals(resource), texCoords(resource), indices(resource), lineIndices(resource),
+      interleavedVertices(resource), interleavedStride(32)
 {
-    set(baseRadius, topRadius, height, sectors, stacks, smooth);
+    set(baseRadius, topRadius, height, sectors, stacks, smooth, outputs);
 }
 
 
@@ -53,7 +59,7 @@ Cylinder::Cylinder(float baseRadius, float topRadius, float height, int sectors,
 // setters
 ///////////////////////////////////////////////////////////////////////////////
 void Cylinder::set(float baseRadius, float topRadius, float height, int sectors,
-                   int stacks, bool smooth)
+                   int stacks, bool smooth, unsigned int outputs)
 {
     this->baseRadius = baseRadius;
     this->topRadius = topRadius;
@@ -65,9 +71,7 @@ void Cylinder::set(float baseRadius, float topRadius, float height, int sectors,
     if(stacks < MIN_STACK_COUNT)
         this->stackCount = MIN_STACK_COUNT;
     this->smooth = smooth;
-
-    // generate unit circle vertices first
-    buildUnitCircleVertices();
+    this->outputs = outputs;
 
     if(smooth)
         buildVerticesSmooth();
@@ -75,34 +79,53 @@ void Cylinder::set(float baseRadius, float topRadius, float height, int sectors,
         buildVerticesFlat();
 }
 
+// the topology does not depend on the radii and height, so the arrays are rewritten in place
 void Cylinder::setBaseRadius(float radius)
 {
-    if(this->baseRadius != radius)
-        set(radius, topRadius, height, sectorCount, stackCount, smooth);
+    if(this->baseRadius == radius)
+        return;
+
+    this->baseRadius = radius;
+    if(interleavedVertices.empty())
+        set(radius, topRadius, height, sectorCount, stackCount, smooth, outputs);
+    else
+        updateVertices();
 }
 
 void Cylinder::setTopRadius(float radius)
 {
-    if(this->topRadius != radius)
-        set(baseRadius, radius, height, sectorCount, stackCount, smooth);
+    if(this->topRadius == radius)
+        return;
+
+    this->topRadius = radius;
+    if(interleavedVertices.empty())
+        set(baseRadius, radius, height, sectorCount, stackCount, smooth, outputs);
+    else
+        updateVertices();
 }
 
 void Cylinder::setHeight(float height)
 {
-    if(this->height != height)
-        set(baseRadius, topRadius, height, sectorCount, stackCount, smooth);
+    if(this->height == height)
+        return;
+
+    this->height = height;
+    if(interleavedVertices.empty())
+        set(baseRadius, topRadius, height, sectorCount, stackCount, smooth, outputs);
+    else
+        updateVertices();
 }
 
 void Cylinder::setSectorCount(int sectors)
 {
     if(this->sectorCount != sectors)
-        set(baseRadius, topRadius, height, sectors, stackCount, smooth);
+        set(baseRadius, topRadius, height, sectors, stackCount, smooth, outputs);
 }
 
 void Cylinder::setStackCount(int stacks)
 {
     if(this->stackCount != stacks)
-        set(baseRadius, topRadius, height, sectorCount, stacks, smooth);
+        set(baseRadius, topRadius, height, sectorCount, stacks, smooth, outputs);
 }
 
 void Cylinder::setSmooth(bool smooth)
@@ -117,6 +140,12 @@ void Cylinder::setSmooth(bool smooth)
         buildVerticesFlat();
 }
 
+void Cylinder::setOutputs(unsigned int outputs)
+{
+    if(this->outputs != outputs)
+        set(baseRadius, topRadius, height, sectorCount, stackCount, smooth, outputs);
+}
+
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -198,8 +227,7 @@ void Cylinder::drawBase() const
     glNormalPointer(GL_FLOAT, interleavedStride, &interleavedVertices[3]);
     glTexCoordPointer(2, GL_FLOAT, interleavedStride, &interleavedVertices[6]);
 
-    unsigned int indexCount = ((unsigned int)indices.size() - baseIndex) / 2;
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, &indices[baseIndex]);
+    glDrawElements(GL_TRIANGLES, getBaseIndexCount(), GL_UNSIGNED_INT, &indices[baseIndex]);
 
     glDisableClientState(GL_VERTEX_ARRAY);
     glDisableClientState(GL_NORMAL_ARRAY);
@@ -216,8 +244,7 @@ void Cylinder::drawTop() const
     glNormalPointer(GL_FLOAT, interleavedStride, &interleavedVertices[3]);
     glTexCoordPointer(2, GL_FLOAT, interleavedStride, &interleavedVertices[6]);
 
-    unsigned int indexCount = ((unsigned int)indices.size() - baseIndex) / 2;
-    glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, &indices[topIndex]);
+    glDrawElements(GL_TRIANGLES, getTopIndexCount(), GL_UNSIGNED_INT, &indices[topIndex]);
 
     glDisableClientState(GL_VERTEX_ARRAY);
     glDisableClientState(GL_NORMAL_ARRAY);
@@ -268,90 +295,303 @@ void Cylinder::drawWithLines(const float lineColor[4]) const
 
 
 
+///////////////////////////////////////////////////////////////////////////////
+// rewrite the positions and normals of the existing arrays after a radius or
+// height change; tex coords and indices stay as they are
+// the writers get no index pointer, so only the vertices are written
+///////////////////////////////////////////////////////////////////////////////
+void Cylinder::updateVertices()
+{
+    if(smooth)
+        writeSmooth(baseRadius, topRadius, height, sectorCount, stackCount, &interleavedVertices[0], 0);
+    else
+        writeFlat(baseRadius, topRadius, height, sectorCount, stackCount, &interleavedVertices[0], 0);
+
+    if(outputs & MESH_OUTPUT_SEPARATE)
+        buildSeparateVertices();
+}
+
+
+
 ///////////////////////////////////////////////////////////////////////////////
 // dealloc vectors
 ///////////////////////////////////////////////////////////////////////////////
 void Cylinder::clearArrays()
 {
-    std::vector<float>().swap(vertices);
-    std::vector<float>().swap(normals);
-    std::vector<float>().swap(texCoords);
-    std::vector<unsigned int>().swap(indices);
-    std::vector<unsigned int>().swap(lineIndices);
+    // swap with empty arrays of the same memory resource
+    std::pmr::vector<float>(vertices.get_allocator()).swap(vertices);
+    std::pmr::vector<float>(normals.get_allocator()).swap(normals);
+    std::pmr::vector<float>(texCoords.get_allocator()).swap(texCoords);
+    std::pmr::vector<unsigned int>(indices.get_allocator()).swap(indices);
+    std::pmr::vector<unsigned int>(lineIndices.get_allocator()).swap(lineIndices);
+    std::pmr::vector<float>(interleavedVertices.get_allocator()).swap(interleavedVertices);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// non-owning view of the interleaved vertices and indices
+///////////////////////////////////////////////////////////////////////////////
+MeshView Cylinder::getMeshView() const
+{
+    return MeshView(interleavedVertices.data(), getInterleavedVertexCount(),
+                    indices.data(), getIndexCount(), interleavedStride);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// # of interleaved vertices and indices written by writeInterleaved()
+// side: (stacks+1)*(sectors+1) shared vertices if smooth, 4 per quad if flat
+// base/top: a center vertex and sectors vertices each
+///////////////////////////////////////////////////////////////////////////////
+void Cylinder::getInterleavedCounts(int sectors, int stacks, bool smooth,
+                                    unsigned int& vertexCount, unsigned int& indexCount)
+{
+    if(sectors < MIN_SECTOR_COUNT)
+        sectors = MIN_SECTOR_COUNT;
+    if(stacks < MIN_STACK_COUNT)
+        stacks = MIN_STACK_COUNT;
+
+    if(smooth)
+        vertexCount = (stacks + 1) * (sectors + 1);
+    else
+        vertexCount = stacks * sectors * 4;
+    vertexCount += 2 * (sectors + 1);
+    indexCount = stacks * sectors * 6 + 2 * sectors * 3;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// write interleaved vertices (32-byte stride) and indices into caller memory
+// sized by getInterleavedCounts()
+///////////////////////////////////////////////////////////////////////////////
+void Cylinder::writeInterleaved(float baseRadius, float topRadius, float height,
+                                int sectors, int stacks, bool smooth,
+                                float* vertices, unsigned int* indices, ThreadPool* pool)
+{
+    if(sectors < MIN_SECTOR_COUNT)
+        sectors = MIN_SECTOR_COUNT;
+    if(stacks < MIN_STACK_COUNT)
+        stacks = MIN_STACK_COUNT;
+
+    if(smooth)
+        writeSmooth(baseRadius, topRadius, height, sectors, stacks, vertices, indices, pool);
+    else
+        writeFlat(baseRadius, topRadius, height, sectors, stacks, vertices, indices);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// builder mode with packed vertices
+// the float vertices are written to a temporary array and packed from there;
+// the quantization comes from the cylinder bounds, so it is known up front
+///////////////////////////////////////////////////////////////////////////////
+void Cylinder::writeInterleavedPacked(float baseRadius, float topRadius, float height,
+                                      int sectors, int stacks, bool smooth,
+                                      PackedVertex* vertices, unsigned int* indices,
+                                      VertexQuantization& quantization)
+{
+    unsigned int vertexCount, indexCount;
+    getInterleavedCounts(sectors, stacks, smooth, vertexCount, indexCount);
+    std::vector<float> floats((std::size_t)vertexCount * MESH_VERTEX_FLOATS);
+    writeInterleaved(baseRadius, topRadius, height, sectors, stacks, smooth, floats.data(), indices);
+
+    float radius = baseRadius > topRadius ? baseRadius : topRadius;
+    float min[3] = { -radius, -radius, -height * 0.5f };
+    float max[3] = { radius, radius, height * 0.5f };
+    quantization = makeVertexQuantization(min, max);
+    packVertices(floats.data(), vertexCount, MESH_VERTEX_STRIDE, quantization, vertices);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// one strip per side stack, zigzagging k2, k1, k2+1, k1+1, ... (the other
+// diagonal of each quad; the quads are planar, so the surface is the same),
+// then one strip per cap zigzagging across the ring without the center vertex
+///////////////////////////////////////////////////////////////////////////////
+unsigned int Cylinder::getStripIndexCount(int sectors, int stacks)
+{
+    if(sectors < MIN_SECTOR_COUNT)
+        sectors = MIN_SECTOR_COUNT;
+    if(stacks < MIN_STACK_COUNT)
+        stacks = MIN_STACK_COUNT;
+
+    return stacks * (sectors + 1) * 2 + 2 * sectors + (stacks + 1);    // + a restart between strips
+}
+
+void Cylinder::writeStripIndices(int sectors, int stacks, unsigned int* indices)
+{
+    if(sectors < MIN_SECTOR_COUNT)
+        sectors = MIN_SECTOR_COUNT;
+    if(stacks < MIN_STACK_COUNT)
+        stacks = MIN_STACK_COUNT;
+
+    // sides
+    for(int i = 0; i < stacks; ++i)
+    {
+        if(i > 0)
+            *indices++ = MESH_RESTART_INDEX;
+
+        unsigned int k1 = i * (sectors + 1);    // beginning of current stack
+        unsigned int k2 = k1 + sectors + 1;     // beginning of next stack
+        for(int j = 0; j <= sectors; ++j)
+        {
+            *indices++ = k2 + j;
+            *indices++ = k1 + j;
+        }
+    }
+
+    // caps: r0, r1, r(n-1), r2, r(n-2), ... for the top (counterclockwise seen
+    // from above), and r0, r(n-1), r1, r(n-2), ... for the base (clockwise)
+    unsigned int baseVertexIndex = (stacks + 1) * (sectors + 1);
+    for(int cap = 0; cap < 2; ++cap)
+    {
+        *indices++ = MESH_RESTART_INDEX;
+
+        unsigned int ring = baseVertexIndex + cap * (sectors + 1) + 1;     // skip the center vertex
+        unsigned int low = 1, high = sectors - 1;
+        *indices++ = ring;
+        for(int n = 1; n < sectors; ++n)
+        {
+            bool fromLow = (n % 2 == 1) == (cap == 1);
+            *indices++ = ring + (fromLow ? low++ : high--);
+        }
+    }
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
 // build vertices of cylinder with smooth shading
-// where v: sector angle (0 <= v <= 360)
+// the interleaved array is written first, the other outputs are made from it
 ///////////////////////////////////////////////////////////////////////////////
 void Cylinder::buildVerticesSmooth()
 {
     // clear memory of prev arrays
     clearArrays();
 
-    float x, y, z;                                  // vertex position
-    //float s, t;                                     // texCoord
-    float radius;                                   // radius for each stack
+    getInterleavedCounts(sectorCount, stackCount, true, vertexCount, indexCount);
+    interleavedVertices.resize(vertexCount * 8);
+    indices.resize(indexCount);
+    writeSmooth(baseRadius, topRadius, height, sectorCount, stackCount, &interleavedVertices[0], &indices[0]);
+    buildOutputs();
+
+    // remember where the base and top indices start
+    baseIndex = stackCount * sectorCount * 6;
+    topIndex = baseIndex + sectorCount * 3;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// generate vertices with flat shading
+// each triangle is independent (no shared vertices)
+///////////////////////////////////////////////////////////////////////////////
+void Cylinder::buildVerticesFlat()
+{
+    // clear memory of prev arrays
+    clearArrays();
+
+    getInterleavedCounts(sectorCount, stackCount, false, vertexCount, indexCount);
+    interleavedVertices.resize(vertexCount * 8);
+    indices.resize(indexCount);
+    writeFlat(baseRadius, topRadius, height, sectorCount, stackCount, &interleavedVertices[0], &indices[0]);
+    buildOutputs();
+
+    // remember where the base and top indices start
+    baseIndex = stackCount * sectorCount * 6;
+    topIndex = baseIndex + sectorCount * 3;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// write vertices of cylinder with smooth shading
+// where v: sector angle (0 <= v <= 360)
+// side rows and stacks are independent and are split over the pool if one is
+// given; the caps follow on the calling thread
+// indices may be null to rewrite the vertices only
+///////////////////////////////////////////////////////////////////////////////
+void Cylinder::writeSmooth(float baseRadius, float topRadius, float height, int sectorCount, int stackCount,
+                           float* vertices, unsigned int* indices, ThreadPool* pool)
+{
+    // unit circle and side normals as the cos/sin tables of writeRing(), in one allocation
+    std::vector<float> tables((sectorCount + 1) * 4);
+    float* cosTable = &tables[0];
+    float* sinTable = cosTable + sectorCount + 1;
+    float* normalX = sinTable + sectorCount + 1;
+    float* normalY = normalX + sectorCount + 1;
+    getUnitCircle(sectorCount, cosTable, sinTable);
+    float nz = getSideNormals(baseRadius, topRadius, height, sectorCount, normalX, normalY);
+
+    if(pool)
+    {
+        pool->parallelFor(stackCount + 1, getRowChunk(sectorCount), [&](std::size_t begin, std::size_t end)
+        {
+            writeSmoothRows(baseRadius, topRadius, height, sectorCount, stackCount,
+                            cosTable, sinTable, normalX, normalY, nz, (int)begin, (int)end, vertices);
+            if(indices)
+                writeSmoothIndices(sectorCount, (int)begin, (int)end < stackCount ? (int)end : stackCount, indices);
+        });
+    }
+    else
+    {
+        writeSmoothRows(baseRadius, topRadius, height, sectorCount, stackCount,
+                        cosTable, sinTable, normalX, normalY, nz, 0, stackCount + 1, vertices);
+        if(indices)
+            writeSmoothIndices(sectorCount, 0, stackCount, indices);
+    }
+
+    // base and top start after the side vertices
+    unsigned int sideVertexCount = (stackCount + 1) * (sectorCount + 1);
+    writeCaps(baseRadius, topRadius, height, sectorCount, cosTable, sinTable, sideVertexCount,
+              vertices + (std::size_t)sideVertexCount * 8, indices ? indices + (std::size_t)stackCount * sectorCount * 6 : 0);
+}
 
-    // get normals for cylinder sides
-    std::vector<float> sideNormals = getSideNormals();
+
+
+///////////////////////////////////////////////////////////////////////////////
+// write side vertex rows [rowBegin, rowEnd), (sectorCount+1) vertices per row
+// vertices points at the first vertex of the mesh
+///////////////////////////////////////////////////////////////////////////////
+void Cylinder::writeSmoothRows(float baseRadius, float topRadius, float height, int sectorCount, int stackCount,
+                               const float* cosTable, const float* sinTable,
+                               const float* normalX, const float* normalY, float nz,
+                               int rowBegin, int rowEnd, float* vertices)
+{
+    float z;                                        // vertex position z
+    float radius;                                   // radius for each stack
 
     // put vertices of side cylinder to array by scaling unit circle
-    for(int i = 0; i <= stackCount; ++i)
+    vertices += (std::size_t)rowBegin * (sectorCount + 1) * 8;
+    for(int i = rowBegin; i < rowEnd; ++i)
     {
         z = -(height * 0.5f) + (float)i / stackCount * height;      // vertex position z
         radius = baseRadius + (float)i / stackCount * (topRadius - baseRadius);     // lerp
         float t = 1.0f - (float)i / stackCount;   // top-to-bottom
 
-        for(int j = 0, k = 0; j <= sectorCount; ++j, k += 3)
-        {
-            x = unitCircleVertices[k];
-            y = unitCircleVertices[k+1];
-            addVertex(x * radius, y * radius, z);   // position
-            addNormal(sideNormals[k], sideNormals[k+1], sideNormals[k+2]); // normal
-            addTexCoord((float)j / sectorCount, t); // tex coord
-        }
+        writeRing(cosTable, sinTable, normalX, normalY, sectorCount + 1, sectorCount,
+                  radius, z, 1.0f, 1.0f, nz, t, vertices);
+        vertices += (sectorCount + 1) * 8;
     }
+}
 
-    // remember where the base.top vertices start
-    unsigned int baseVertexIndex = (unsigned int)vertices.size() / 3;
-
-    // put vertices of base of cylinder
-    z = -height * 0.5f;
-    addVertex(0, 0, z);
-    addNormal(0, 0, -1);
-    addTexCoord(0.5f, 0.5f);
-    for(int i = 0, j = 0; i < sectorCount; ++i, j += 3)
-    {
-        x = unitCircleVertices[j];
-        y = unitCircleVertices[j+1];
-        addVertex(x * baseRadius, y * baseRadius, z);
-        addNormal(0, 0, -1);
-        addTexCoord(-x * 0.5f + 0.5f, -y * 0.5f + 0.5f);    // flip horizontal
-    }
 
-    // remember where the base vertices start
-    unsigned int topVertexIndex = (unsigned int)vertices.size() / 3;
 
-    // put vertices of top of cylinder
-    z = height * 0.5f;
-    addVertex(0, 0, z);
-    addNormal(0, 0, 1);
-    addTexCoord(0.5f, 0.5f);
-    for(int i = 0, j = 0; i < sectorCount; ++i, j += 3)
-    {
-        x = unitCircleVertices[j];
-        y = unitCircleVertices[j+1];
-        addVertex(x * topRadius, y * topRadius, z);
-        addNormal(0, 0, 1);
-        addTexCoord(x * 0.5f + 0.5f, -y * 0.5f + 0.5f);
-    }
+///////////////////////////////////////////////////////////////////////////////
+// write the side indices of stacks [stackBegin, stackEnd), 2 triangles per sector
+// indices points at the first index of the mesh
+///////////////////////////////////////////////////////////////////////////////
+void Cylinder::writeSmoothIndices(int sectorCount, int stackBegin, int stackEnd, unsigned int* indices)
+{
+    indices += (std::size_t)stackBegin * sectorCount * 6;
 
-    // put indices for sides
     unsigned int k1, k2;
-    for(int i = 0; i < stackCount; ++i)
+    for(int i = stackBegin; i < stackEnd; ++i)
     {
         k1 = i * (sectorCount + 1);     // bebinning of current stack
         k2 = k1 + sectorCount + 1;      // beginning of next stack
@@ -359,67 +599,38 @@ void Cylinder::buildVerticesSmooth()
         for(int j = 0; j < sectorCount; ++j, ++k1, ++k2)
         {
             // 2 trianles per sector
-            addIndices(k1, k1 + 1, k2);
-            addIndices(k2, k1 + 1, k2 + 1);
-
-            // vertical lines for all stacks
-            lineIndices.push_back(k1);
-            lineIndices.push_back(k2);
-            // horizontal lines
-            lineIndices.push_back(k2);
-            lineIndices.push_back(k2 + 1);
-            if(i == 0)
-            {
-                lineIndices.push_back(k1);
-                lineIndices.push_back(k1 + 1);
-            }
-        }
-    }
+            *indices++ = k1;
+            *indices++ = k1 + 1;
+            *indices++ = k2;
 
-    // remember where the base indices start
-    baseIndex = (unsigned int)indices.size();
-
-    // put indices for base
-    for(int i = 0, k = baseVertexIndex + 1; i < sectorCount; ++i, ++k)
-    {
-        if(i < (sectorCount - 1))
-            addIndices(baseVertexIndex, k + 1, k);
-        else    // last triangle
-            addIndices(baseVertexIndex, baseVertexIndex + 1, k);
-    }
-
-    // remember where the base indices start
-    topIndex = (unsigned int)indices.size();
-
-    for(int i = 0, k = topVertexIndex + 1; i < sectorCount; ++i, ++k)
-    {
-        if(i < (sectorCount - 1))
-            addIndices(topVertexIndex, k, k + 1);
-        else
-            addIndices(topVertexIndex, k, topVertexIndex + 1);
+            *indices++ = k2;
+            *indices++ = k1 + 1;
+            *indices++ = k2 + 1;
+        }
     }
-
-    // generate interleaved vertex array as well
-    buildInterleavedVertices();
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// generate vertices with flat shading
+// write vertices with flat shading
 // each triangle is independent (no shared vertices)
+// indices may be null to rewrite the vertices only
 ///////////////////////////////////////////////////////////////////////////////
-void Cylinder::buildVerticesFlat()
+void Cylinder::writeFlat(float baseRadius, float topRadius, float height, int sectorCount, int stackCount,
+                         float* vertices, unsigned int* indices)
 {
-    // tmp vertex definition (x,y,z,s,t)
-    struct Vertex
-    {
-        float x, y, z, s, t;
-    };
-    std::vector<Vertex> tmpVertices;
-
-    int i, j, k;    // indices
-    float x, y, z, s, t, radius;
+    // all scratch arrays are sized once: the (x,y,z,s,t) grid of the side,
+    // the unit circle and one row of face normals
+    std::vector<GridVertex> grid((stackCount + 1) * (sectorCount + 1));
+    std::vector<float> unitCircle((sectorCount + 1) * 2);
+    std::vector<Vec3> faceNormals(sectorCount);
+    float* cosTable = &unitCircle[0];
+    float* sinTable = cosTable + sectorCount + 1;
+    getUnitCircle(sectorCount, cosTable, sinTable);
+
+    int i, j;       // indices
+    float z, t, radius;
 
     // put tmp vertices of cylinder side to array by scaling unit circle
     //NOTE: start and end vertex positions are same, but texcoords are different
@@ -429,248 +640,242 @@ void Cylinder::buildVerticesFlat()
         z = -(height * 0.5f) + (float)i / stackCount * height;      // vertex position z
         radius = baseRadius + (float)i / stackCount * (topRadius - baseRadius);     // lerp
         t = 1.0f - (float)i / stackCount;   // top-to-bottom
-
-        for(j = 0, k = 0; j <= sectorCount; ++j, k += 3)
-        {
-            x = unitCircleVertices[k];
-            y = unitCircleVertices[k+1];
-            s = (float)j / sectorCount;
-
-            Vertex vertex;
-            vertex.x = x * radius;
-            vertex.y = y * radius;
-            vertex.z = z;
-            vertex.s = s;
-            vertex.t = t;
-            tmpVertices.push_back(vertex);
-        }
+        writeGridRing(cosTable, sinTable, sectorCount + 1, sectorCount, radius, z, t, &grid[i * (sectorCount + 1)]);
     }
 
-    // clear memory of prev arrays
-    clearArrays();
-
-    Vertex v1, v2, v3, v4;      // 4 vertex positions v1, v2, v3, v4
-    std::vector<float> n;       // 1 face normal
-    int vi1, vi2;               // indices
-    int index = 0;
+    GridVertex v[4];            // 4 vertex positions v1, v2, v3, v4
+    unsigned int index = 0;
 
     // v2-v4 <== stack at i+1
     // | \ |
     // v1-v3 <== stack at i
     for(i = 0; i < stackCount; ++i)
     {
-        vi1 = i * (sectorCount + 1);            // index of tmpVertices
-        vi2 = (i + 1) * (sectorCount + 1);
+        const GridVertex* row1 = &grid[i * (sectorCount + 1)];
+        const GridVertex* row2 = row1 + sectorCount + 1;
+
+        // compute the face normals of v1-v3-v2 for the whole stack
+        computeFaceNormals(row1, row1 + 1, row2, sectorCount, &faceNormals[0]);
 
-        for(j = 0; j < sectorCount; ++j, ++vi1, ++vi2)
+        for(j = 0; j < sectorCount; ++j)
         {
-            v1 = tmpVertices[vi1];
-            v2 = tmpVertices[vi2];
-            v3 = tmpVertices[vi1 + 1];
-            v4 = tmpVertices[vi2 + 1];
-
-            // compute a face normal of v1-v3-v2
-            n = computeFaceNormal(v1.x,v1.y,v1.z, v3.x,v3.y,v3.z, v2.x,v2.y,v2.z);
-
-            // put quad vertices: v1-v2-v3-v4
-            addVertex(v1.x, v1.y, v1.z);
-            addVertex(v2.x, v2.y, v2.z);
-            addVertex(v3.x, v3.y, v3.z);
-            addVertex(v4.x, v4.y, v4.z);
-
-            // put tex coords of quad
-            addTexCoord(v1.s, v1.t);
-            addTexCoord(v2.s, v2.t);
-            addTexCoord(v3.s, v3.t);
-            addTexCoord(v4.s, v4.t);
-
-            // put normal
-            for(k = 0; k < 4; ++k)  // same normals for all 4 vertices
-            {
-                addNormal(n[0], n[1], n[2]);
-            }
+            v[0] = row1[j];
+            v[1] = row2[j];
+            v[2] = row1[j + 1];
+            v[3] = row2[j + 1];
+
+            // put quad vertices: v1-v2-v3-v4, same normals for all 4 vertices
+            vertices = writeFlatFace(vertices, v, 4, faceNormals[j]);
 
             // put indices of a quad
-            addIndices(index,   index+2, index+1);    // v1-v3-v2
-            addIndices(index+1, index+2, index+3);    // v2-v3-v4
-
-            // vertical line per quad: v1-v2
-            lineIndices.push_back(index);
-            lineIndices.push_back(index+1);
-            // horizontal line per quad: v2-v4
-            lineIndices.push_back(index+1);
-            lineIndices.push_back(index+3);
-            if(i == 0)
+            if(indices)
             {
-                lineIndices.push_back(index);
-                lineIndices.push_back(index+2);
+                *indices++ = index;       // v1-v3-v2
+                *indices++ = index+2;
+                *indices++ = index+1;
+                *indices++ = index+1;     // v2-v3-v4
+                *indices++ = index+2;
+                *indices++ = index+3;
             }
 
             index += 4;     // for next
         }
     }
 
-    // remember where the base index starts
-    baseIndex = (unsigned int)indices.size();
-    unsigned int baseVertexIndex = (unsigned int)vertices.size() / 3;
+    // base and top start after the side quads
+    writeCaps(baseRadius, topRadius, height, sectorCount, cosTable, sinTable, index, vertices, indices);
+}
 
-    // put vertices of base of cylinder
-    z = -height * 0.5f;
-    addVertex(0, 0, z);
-    addNormal(0, 0, -1);
-    addTexCoord(0.5f, 0.5f);
-    for(i = 0, j = 0; i < sectorCount; ++i, j += 3)
-    {
-        x = unitCircleVertices[j];
-        y = unitCircleVertices[j+1];
-        addVertex(x * baseRadius, y * baseRadius, z);
-        addNormal(0, 0, -1);
-        addTexCoord(-x * 0.5f + 0.5f, -y * 0.5f + 0.5f); // flip horizontal
-    }
 
-    // put indices for base
-    for(i = 0, k = baseVertexIndex + 1; i < sectorCount; ++i, ++k)
-    {
-        if(i < sectorCount - 1)
-            addIndices(baseVertexIndex, k + 1, k);
-        else
-            addIndices(baseVertexIndex, baseVertexIndex + 1, k);
-    }
 
-    // remember where the top index starts
-    topIndex = (unsigned int)indices.size();
-    unsigned int topVertexIndex = (unsigned int)vertices.size() / 3;
+///////////////////////////////////////////////////////////////////////////////
+// write vertices and indices of base and top of cylinder
+///////////////////////////////////////////////////////////////////////////////
+void Cylinder::writeCaps(float baseRadius, float topRadius, float height, int sectorCount,
+                         const float* cosTable, const float* sinTable, unsigned int baseVertexIndex,
+                         float* vertices, unsigned int* indices)
+{
+    int i;
+    unsigned int k;
+    float x, y;
 
-    // put vertices of top of cylinder
-    z = height * 0.5f;
-    addVertex(0, 0, z);
-    addNormal(0, 0, 1);
-    addTexCoord(0.5f, 0.5f);
-    for(i = 0, j = 0; i < sectorCount; ++i, j += 3)
+    for(int cap = 0; cap < 2; ++cap)
     {
-        x = unitCircleVertices[j];
-        y = unitCircleVertices[j+1];
-        addVertex(x * topRadius, y * topRadius, z);
-        addNormal(0, 0, 1);
-        addTexCoord(x * 0.5f + 0.5f, -y * 0.5f + 0.5f);
-    }
+        // base faces down and its tex coords are flipped horizontally
+        float radius = cap == 0 ? baseRadius : topRadius;
+        float z = cap == 0 ? -height * 0.5f : height * 0.5f;
+        float nz = cap == 0 ? -1.0f : 1.0f;
+        unsigned int centerIndex = baseVertexIndex + cap * (sectorCount + 1);
+
+        // center vertex
+        *vertices++ = 0;
+        *vertices++ = 0;
+        *vertices++ = z;
+        *vertices++ = 0;
+        *vertices++ = 0;
+        *vertices++ = nz;
+        *vertices++ = 0.5f;
+        *vertices++ = 0.5f;
+
+        for(i = 0; i < sectorCount; ++i)
+        {
+            x = cosTable[i];
+            y = sinTable[i];
+            *vertices++ = x * radius;
+            *vertices++ = y * radius;
+            *vertices++ = z;
+            *vertices++ = 0;
+            *vertices++ = 0;
+            *vertices++ = nz;
+            *vertices++ = cap == 0 ? -x * 0.5f + 0.5f : x * 0.5f + 0.5f;
+            *vertices++ = -y * 0.5f + 0.5f;
+        }
 
-    for(i = 0, k = topVertexIndex + 1; i < sectorCount; ++i, ++k)
-    {
-        if(i < sectorCount - 1)
-            addIndices(topVertexIndex, k, k + 1);
-        else
-            addIndices(topVertexIndex, k, topVertexIndex + 1);
+        // base triangles wind clockwise seen from the top so both caps face outwards
+        for(i = 0, k = centerIndex + 1; indices && i < sectorCount; ++i, ++k)
+        {
+            unsigned int next = (i < sectorCount - 1) ? k + 1 : centerIndex + 1;    // last triangle wraps around
+            *indices++ = centerIndex;
+            *indices++ = cap == 0 ? next : k;
+            *indices++ = cap == 0 ? k : next;
+        }
     }
-
-    // generate interleaved vertex array as well
-    buildInterleavedVertices();
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// generate interleaved vertices: V/N/T
-// stride must be 32 bytes
+// build the arrays selected by the output mask from the interleaved array,
+// then drop the interleaved array if it was not selected
 ///////////////////////////////////////////////////////////////////////////////
-void Cylinder::buildInterleavedVertices()
+void Cylinder::buildOutputs()
 {
-    std::vector<float>().swap(interleavedVertices);
-
-    std::size_t i, j;
-    std::size_t count = vertices.size();
-    for(i = 0, j = 0; i < count; i += 3, j += 2)
-    {
-        //interleavedVertices.push_back(vertices[i]);
-        //interleavedVertices.push_back(vertices[i+1]);
-        //interleavedVertices.push_back(vertices[i+2]);
-        interleavedVertices.insert(interleavedVertices.end(), &vertices[i], &vertices[i] + 3);
-
-        //interleavedVertices.push_back(normals[i]);
-        //interleavedVertices.push_back(normals[i+1]);
-        //interleavedVertices.push_back(normals[i+2]);
-        interleavedVertices.insert(interleavedVertices.end(), &normals[i], &normals[i] + 3);
-
-        //interleavedVertices.push_back(texCoords[j]);
-        //interleavedVertices.push_back(texCoords[j+1]);
-        interleavedVertices.insert(interleavedVertices.end(), &texCoords[j], &texCoords[j] + 2);
-    }
+    if(outputs & MESH_OUTPUT_SEPARATE)
+        buildSeparateVertices();
+    if(!(outputs & MESH_OUTPUT_INTERLEAVED))
+        std::pmr::vector<float>(interleavedVertices.get_allocator()).swap(interleavedVertices);
+    if(outputs & MESH_OUTPUT_LINES)
+        buildLineIndices();
+    lineIndexCount = (unsigned int)lineIndices.size();
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// generate 3D vertices of a unit circle on XY plance
+// free the arrays after upload; counts, bounds and base/top index ranges are kept
 ///////////////////////////////////////////////////////////////////////////////
-void Cylinder::buildUnitCircleVertices()
+void Cylinder::releaseCpuData()
 {
-    const float PI = acos(-1);
-    float sectorStep = 2 * PI / sectorCount;
-    float sectorAngle;  // radian
-
-    std::vector<float>().swap(unitCircleVertices);
-    for(int i = 0; i <= sectorCount; ++i)
-    {
-        sectorAngle = i * sectorStep;
-        unitCircleVertices.push_back(cos(sectorAngle)); // x
-        unitCircleVertices.push_back(sin(sectorAngle)); // y
-        unitCircleVertices.push_back(0);                // z
-    }
+    clearArrays();
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// add single vertex to array
+// bounds of the cylinder: the larger radius in XY, the height along Z
 ///////////////////////////////////////////////////////////////////////////////
-void Cylinder::addVertex(float x, float y, float z)
+void Cylinder::getBounds(float min[3], float max[3]) const
 {
-    vertices.push_back(x);
-    vertices.push_back(y);
-    vertices.push_back(z);
+    float radius = baseRadius > topRadius ? baseRadius : topRadius;
+    min[0] = min[1] = -radius;
+    max[0] = max[1] = radius;
+    min[2] = -height * 0.5f;
+    max[2] = height * 0.5f;
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// add single normal to array
+// split interleaved vertices: V/N/T into separate arrays
 ///////////////////////////////////////////////////////////////////////////////
-void Cylinder::addNormal(float nx, float ny, float nz)
+void Cylinder::buildSeparateVertices()
 {
-    normals.push_back(nx);
-    normals.push_back(ny);
-    normals.push_back(nz);
+    std::size_t count = interleavedVertices.size() / 8;
+    vertices.resize(count * 3);
+    normals.resize(count * 3);
+    texCoords.resize(count * 2);
+    if(count > 0)
+        splitInterleaved(&interleavedVertices[0], count, &vertices[0], &normals[0], &texCoords[0]);
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// add single texture coord to array
+// build line indices of the side, following the vertex order of writeSmooth()
+// or writeFlat()
 ///////////////////////////////////////////////////////////////////////////////
-void Cylinder::addTexCoord(float s, float t)
+void Cylinder::buildLineIndices()
 {
-    texCoords.push_back(s);
-    texCoords.push_back(t);
+    // 2 lines per sector of every stack, plus the bottom ring of the 1st stack
+    lineIndices.reserve(stackCount * sectorCount * 4 + sectorCount * 2);
+
+    unsigned int k1, k2, index = 0;
+    for(int i = 0; i < stackCount; ++i)
+    {
+        k1 = i * (sectorCount + 1);     // bebinning of current stack
+        k2 = k1 + sectorCount + 1;      // beginning of next stack
+
+        for(int j = 0; j < sectorCount; ++j, ++k1, ++k2, index += 4)
+        {
+            if(smooth)
+            {
+                // vertical lines for all stacks
+                lineIndices.push_back(k1);
+                lineIndices.push_back(k2);
+                // horizontal lines
+                lineIndices.push_back(k2);
+                lineIndices.push_back(k2 + 1);
+                if(i == 0)
+                {
+                    lineIndices.push_back(k1);
+                    lineIndices.push_back(k1 + 1);
+                }
+            }
+            else
+            {
+                // vertical line per quad: v1-v2
+                lineIndices.push_back(index);
+                lineIndices.push_back(index+1);
+                // horizontal line per quad: v2-v4
+                lineIndices.push_back(index+1);
+                lineIndices.push_back(index+3);
+                if(i == 0)
+                {
+                    lineIndices.push_back(index);
+                    lineIndices.push_back(index+2);
+                }
+            }
+        }
+    }
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// add 3 indices to array
+// generate the unit circle on XY plane as cos/sin tables of (sectorCount+1)
 ///////////////////////////////////////////////////////////////////////////////
-void Cylinder::addIndices(unsigned int i1, unsigned int i2, unsigned int i3)
+void Cylinder::getUnitCircle(int sectorCount, float* cosTable, float* sinTable)
 {
-    indices.push_back(i1);
-    indices.push_back(i2);
-    indices.push_back(i3);
+    const float PI = acos(-1);
+    float sectorStep = 2 * PI / sectorCount;
+    float sectorAngle;  // radian
+
+    for(int i = 0; i <= sectorCount; ++i)
+    {
+        sectorAngle = i * sectorStep;
+        cosTable[i] = cos(sectorAngle); // x
+        sinTable[i] = sin(sectorAngle); // y
+    }
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// generate shared normal vectors of the side of cylinder
+// generate shared normal vectors of the side of cylinder into (sectorCount+1)
+// nx/ny tables and return nz, which is the same for all sectors
 ///////////////////////////////////////////////////////////////////////////////
-std::vector<float> Cylinder::getSideNormals()
+float Cylinder::getSideNormals(float baseRadius, float topRadius, float height, int sectorCount,
+                               float* normalX, float* normalY)
 {
     const float PI = acos(-1);
     float sectorStep = 2 * PI / sectorCount;
@@ -684,63 +889,12 @@ std::vector<float> Cylinder::getSideNormals()
     float z0 = sin(zAngle);     // nz
 
     // rotate (x0,y0,z0) per sector angle
-    std::vector<float> normals;
     for(int i = 0; i <= sectorCount; ++i)
     {
         sectorAngle = i * sectorStep;
-        normals.push_back(cos(sectorAngle)*x0 - sin(sectorAngle)*y0);   // nx
-        normals.push_back(sin(sectorAngle)*x0 + cos(sectorAngle)*y0);   // ny
-        normals.push_back(z0);  // nz
-        /*
-        //debug
-        float nx = cos(sectorAngle)*x0 - sin(sectorAngle)*y0;
-        float ny = sin(sectorAngle)*x0 + cos(sectorAngle)*y0;
-        std::cout << "normal=(" << nx << ", " << ny << ", " << z0
-                  << "), length=" << sqrtf(nx*nx + ny*ny + z0*z0) << std::endl;
-        */
-    }
-
-    return normals;
-}
-
-
-
-///////////////////////////////////////////////////////////////////////////////
-// return face normal of a triangle v1-v2-v3
-// if a triangle has no surface (normal length = 0), then return a zero vector
-///////////////////////////////////////////////////////////////////////////////
-std::vector<float> Cylinder::computeFaceNormal(float x1, float y1, float z1,  // v1
-                                               float x2, float y2, float z2,  // v2
-                                               float x3, float y3, float z3)  // v3
-{
-    const float EPSILON = 0.000001f;
-
-    std::vector<float> normal(3, 0.0f);     // default return value (0,0,0)
-    float nx, ny, nz;
-
-    // find 2 edge vectors: v1-v2, v1-v3
-    float ex1 = x2 - x1;
-    float ey1 = y2 - y1;
-    float ez1 = z2 - z1;
-    float ex2 = x3 - x1;
-    float ey2 = y3 - y1;
-    float ez2 = z3 - z1;
-
-    // cross product: e1 x e2
-    nx = ey1 * ez2 - ez1 * ey2;
-    ny = ez1 * ex2 - ex1 * ez2;
-    nz = ex1 * ey2 - ey1 * ex2;
-
-    // normalize only if the length is > 0
-    float length = sqrtf(nx * nx + ny * ny + nz * nz);
-    if(length > EPSILON)
-    {
-        // normalize
-        float lengthInv = 1.0f / length;
-        normal[0] = nx * lengthInv;
-        normal[1] = ny * lengthInv;
-        normal[2] = nz * lengthInv;
+        normalX[i] = cos(sectorAngle)*x0 - sin(sectorAngle)*y0;   // nx
+        normalY[i] = sin(sectorAngle)*x0 + cos(sectorAngle)*y0;   // ny
     }
 
-    return normal;
+    return z0;
 }
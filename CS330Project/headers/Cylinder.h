@@ -17,14 +17,21 @@
 #ifndef GEOMETRY_CYLINDER_H
 #define GEOMETRY_CYLINDER_H
 
+#include <memory_resource>
 #include <vector>
+#include "MeshView.h"
+#include "VertexFormat.h"
+
+class ThreadPool;
 
 class Cylinder
 {
 public:
     // ctor/dtor
     Cylinder(float baseRadius=1.0f, float topRadius=1.0f, float height=1.0f,
-             int sectorCount=36, int stackCount=1, bool smooth=true);
+             int sectorCount=36, int stackCount=1, bool smooth=true,
+             unsigned int outputs=MESH_OUTPUT_ALL,
+             std::pmr::memory_resource* resource=std::pmr::get_default_resource());
     ~Cylinder() {}
 
     // getters/setters
@@ -34,20 +41,31 @@ public:
     int getSectorCount() const              { return sectorCount; }
     int getStackCount() const               { return stackCount; }
     void set(float baseRadius, float topRadius, float height,
-             int sectorCount, int stackCount, bool smooth=true);
+             int sectorCount, int stackCount, bool smooth=true,
+             unsigned int outputs=MESH_OUTPUT_ALL);
+    // radius and height changes rewrite positions/normals in place and keep the indices
     void setBaseRadius(float radius);
     void setTopRadius(float radius);
     void setHeight(float radius);
     void setSectorCount(int sectorCount);
     void setStackCount(int stackCount);
     void setSmooth(bool smooth);
+    void setOutputs(unsigned int outputs);  // MeshOutput flags
+    unsigned int getOutputs() const         { return outputs; }
+
+    // the arrays are allocated from the memory resource given to the ctor, e.g. a
+    // std::pmr::monotonic_buffer_resource freed in one go after upload; the resource
+    // must outlive the object. copies use the default resource, like std::pmr containers
+    std::pmr::memory_resource* getMemoryResource() const { return interleavedVertices.get_allocator().resource(); }
 
     // for vertex data
-    unsigned int getVertexCount() const     { return (unsigned int)vertices.size() / 3; }
-    unsigned int getNormalCount() const     { return (unsigned int)normals.size() / 3; }
-    unsigned int getTexCoordCount() const   { return (unsigned int)texCoords.size() / 2; }
-    unsigned int getIndexCount() const      { return (unsigned int)indices.size(); }
-    unsigned int getLineIndexCount() const  { return (unsigned int)lineIndices.size(); }
+    // counts describe the mesh and survive releaseCpuData(); sizes and pointers
+    // are those of the arrays held, 0/null if an array was not built or released
+    unsigned int getVertexCount() const     { return vertexCount; }
+    unsigned int getNormalCount() const     { return vertexCount; }
+    unsigned int getTexCoordCount() const   { return vertexCount; }
+    unsigned int getIndexCount() const      { return indexCount; }
+    unsigned int getLineIndexCount() const  { return lineIndexCount; }
     unsigned int getTriangleCount() const   { return getIndexCount() / 3; }
     unsigned int getVertexSize() const      { return (unsigned int)vertices.size() * sizeof(float); }
     unsigned int getNormalSize() const      { return (unsigned int)normals.size() * sizeof(float); }
@@ -62,19 +80,50 @@ public:
 
     // for interleaved vertices: V/N/T
     unsigned int getInterleavedVertexCount() const  { return getVertexCount(); }    // # of vertices
-    unsigned int getInterleavedVertexSize() const   { return (unsigned int)interleavedVertices.size() * sizeof(unsigned int); }    // # of bytes
+    unsigned int getInterleavedVertexSize() const   { return (unsigned int)interleavedVertices.size() * sizeof(float); }    // # of bytes
     int getInterleavedStride() const                { return interleavedStride; }   // should be 32 bytes
-    const float* getInterleavedVertices() const     { return &interleavedVertices[0]; }
+    const float* getInterleavedVertices() const     { return interleavedVertices.data(); }
+
+    // non-owning view of the interleaved vertices and indices, for uploading without a copy
+    MeshView getMeshView() const;
+
+    // builder mode: write interleaved V/N/T vertices and triangle indices straight into
+    // caller memory (e.g. a mapped GPU buffer) without building the arrays of a Cylinder
+    static void getInterleavedCounts(int sectorCount, int stackCount, bool smooth,
+                                     unsigned int& vertexCount, unsigned int& indexCount);
+    // smooth side rows are split over pool when one is given (not from inside one of its tasks)
+    static void writeInterleaved(float baseRadius, float topRadius, float height,
+                                 int sectorCount, int stackCount, bool smooth,
+                                 float* vertices, unsigned int* indices, ThreadPool* pool=0);
+    // same with 16-byte PackedVertex; quantization receives the position scale/bias
+    static void writeInterleavedPacked(float baseRadius, float topRadius, float height,
+                                       int sectorCount, int stackCount, bool smooth,
+                                       PackedVertex* vertices, unsigned int* indices,
+                                       VertexQuantization& quantization);
+
+    // triangle strips over the smooth vertices of writeInterleaved(), separated
+    // by MESH_RESTART_INDEX; draw with GL_TRIANGLE_STRIP and primitive restart
+    // flat shading shares no vertices, so it has no strip form
+    static unsigned int getStripIndexCount(int sectorCount, int stackCount);
+    static void writeStripIndices(int sectorCount, int stackCount, unsigned int* indices);
 
     // for indices of base/top/side parts
-    unsigned int getBaseIndexCount() const  { return ((unsigned int)indices.size() - baseIndex) / 2; }
-    unsigned int getTopIndexCount() const   { return ((unsigned int)indices.size() - baseIndex) / 2; }
+    unsigned int getBaseIndexCount() const  { return (indexCount - baseIndex) / 2; }
+    unsigned int getTopIndexCount() const   { return (indexCount - baseIndex) / 2; }
     unsigned int getSideIndexCount() const  { return baseIndex; }
     unsigned int getBaseStartIndex() const  { return baseIndex; }
     unsigned int getTopStartIndex() const   { return topIndex; }
     unsigned int getSideStartIndex() const  { return 0; }   // side starts from the begining
 
-    // draw in VertexArray mode
+    // axis-aligned bounds in object space, kept after releaseCpuData()
+    void getBounds(float min[3], float max[3]) const;
+
+    // free all vertex and index arrays once they are uploaded; counts and bounds remain
+    void releaseCpuData();
+
+    // draw in VertexArray mode (needs MESH_OUTPUT_INTERLEAVED, lines need MESH_OUTPUT_SEPARATE and MESH_OUTPUT_LINES)
+    // these use client-side arrays, which a core profile context does not have; there, upload
+    // getMeshView() once (MeshUpload.h) and draw the edges with a wireframe shader instead
     void draw() const;          // draw all
     void drawBase() const;      // draw base cap only
     void drawTop() const;       // draw top cap only
@@ -92,16 +141,25 @@ private:
     void clearArrays();
     void buildVerticesSmooth();
     void buildVerticesFlat();
-    void buildInterleavedVertices();
-    void buildUnitCircleVertices();
-    void addVertex(float x, float y, float z);
-    void addNormal(float x, float y, float z);
-    void addTexCoord(float s, float t);
-    void addIndices(unsigned int i1, unsigned int i2, unsigned int i3);
-    std::vector<float> getSideNormals();
-    std::vector<float> computeFaceNormal(float x1, float y1, float z1,
-                                         float x2, float y2, float z2,
-                                         float x3, float y3, float z3);
+    void buildOutputs();
+    void buildSeparateVertices();
+    void buildLineIndices();
+    void updateVertices();
+    static void writeSmooth(float baseRadius, float topRadius, float height, int sectorCount, int stackCount,
+                            float* vertices, unsigned int* indices, ThreadPool* pool=0);
+    static void writeSmoothRows(float baseRadius, float topRadius, float height, int sectorCount, int stackCount,
+                                const float* cosTable, const float* sinTable,
+                                const float* normalX, const float* normalY, float nz,
+                                int rowBegin, int rowEnd, float* vertices);
+    static void writeSmoothIndices(int sectorCount, int stackBegin, int stackEnd, unsigned int* indices);
+    static void writeFlat(float baseRadius, float topRadius, float height, int sectorCount, int stackCount,
+                          float* vertices, unsigned int* indices);
+    static void writeCaps(float baseRadius, float topRadius, float height, int sectorCount,
+                          const float* cosTable, const float* sinTable, unsigned int baseVertexIndex,
+                          float* vertices, unsigned int* indices);
+    static void getUnitCircle(int sectorCount, float* cosTable, float* sinTable);
+    static float getSideNormals(float baseRadius, float topRadius, float height, int sectorCount,
+                                float* normalX, float* normalY);
 
     // memeber vars
     float baseRadius;
@@ -112,15 +170,18 @@ private:
     unsigned int baseIndex;                 // starting index of base
     unsigned int topIndex;                  // starting index of top
     bool smooth;
-    std::vector<float> unitCircleVertices;
-    std::vector<float> vertices;
-    std::vector<float> normals;
-    std::vector<float> texCoords;
-    std::vector<unsigned int> indices;
-    std::vector<unsigned int> lineIndices;
+    unsigned int outputs;                   // MeshOutput flags
+    unsigned int vertexCount;
+    unsigned int indexCount;
+    unsigned int lineIndexCount;
+    std::pmr::vector<float> vertices;
+    std::pmr::vector<float> normals;
+    std::pmr::vector<float> texCoords;
+    std::pmr::vector<unsigned int> indices;
+    std::pmr::vector<unsigned int> lineIndices;
 
     // interleaved
-    std::vector<float> interleavedVertices;
+    std::pmr::vector<float> interleavedVertices;
     int interleavedStride;                  // # of bytes to hop to the next vertex (should be 32 bytes)
 
 };
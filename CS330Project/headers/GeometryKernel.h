@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////////////
+// GeometryKernel.h
+// ================
+// Header-only building blocks of the Sphere and Cylinder writers.
+//
+// Everything works on values and on output ranges sized by the caller once
+// per mesh: Vec3 is a plain struct returned by value, and the batch routines
+// write into pointers the caller has already sized. Nothing here allocates,
+// so the per-triangle loops of the flat writers make no heap allocations.
+//
+// The arithmetic is that of the functions it replaces (the per-class
+// computeFaceNormal(), the tmpVertices grids, buildSeparateVertices()), so
+// the generated meshes are bit-identical.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef GEOMETRY_KERNEL_H
+#define GEOMETRY_KERNEL_H
+
+#include <cmath>
+#include <cstddef>
+
+struct Vec3
+{
+    float x, y, z;
+};
+
+inline Vec3 operator-(const Vec3& a, const Vec3& b)
+{
+    Vec3 v = { a.x - b.x, a.y - b.y, a.z - b.z };
+    return v;
+}
+
+inline Vec3 cross(const Vec3& a, const Vec3& b)
+{
+    Vec3 v = { a.y * b.z - a.z * b.y,
+               a.z * b.x - a.x * b.z,
+               a.x * b.y - a.y * b.x };
+    return v;
+}
+
+inline float dot(const Vec3& a, const Vec3& b)
+{
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+inline float length(const Vec3& v)
+{
+    return sqrtf(dot(v, v));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// unit normal of the triangle v1-v2-v3 (counter-clockwise front face)
+// a triangle without surface (normal length = 0) gets a zero vector
+///////////////////////////////////////////////////////////////////////////////
+inline Vec3 computeFaceNormal(const Vec3& v1, const Vec3& v2, const Vec3& v3)
+{
+    const float EPSILON = 0.000001f;
+
+    Vec3 normal = { 0, 0, 0 };
+    Vec3 n = cross(v2 - v1, v3 - v1);
+    float len = length(n);
+    if(len > EPSILON)
+    {
+        float lengthInv = 1.0f / len;
+        normal.x = n.x * lengthInv;
+        normal.y = n.y * lengthInv;
+        normal.z = n.z * lengthInv;
+    }
+    return normal;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// position and tex coords of a surface grid vertex, before a normal is known
+///////////////////////////////////////////////////////////////////////////////
+struct GridVertex
+{
+    Vec3 position;
+    float s, t;
+};
+
+// write count grid vertices of one ring: (radius * cos[j], radius * sin[j], z),
+// tex coords (j / sectorCount, t)
+inline void writeGridRing(const float* cosTable, const float* sinTable, int count, int sectorCount,
+                          float radius, float z, float t, GridVertex* vertices)
+{
+    for(int j = 0; j < count; ++j)
+    {
+        GridVertex& v = vertices[j];
+        v.position.x = radius * cosTable[j];
+        v.position.y = radius * sinTable[j];
+        v.position.z = z;
+        v.s = (float)j / sectorCount;
+        v.t = t;
+    }
+}
+
+// normals[i] = face normal of the triangle (v1[i], v2[i], v3[i]) for i in [0, count)
+// the three inputs are usually the same grid rows at different offsets
+inline void computeFaceNormals(const GridVertex* v1, const GridVertex* v2, const GridVertex* v3,
+                               int count, Vec3* normals)
+{
+    for(int i = 0; i < count; ++i)
+        normals[i] = computeFaceNormal(v1[i].position, v2[i].position, v3[i].position);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// interleave: write one V/N/T vertex (8 floats) and return the next position
+///////////////////////////////////////////////////////////////////////////////
+inline float* writeVertex(float* vertices, const GridVertex& v, const Vec3& n)
+{
+    vertices[0] = v.position.x;
+    vertices[1] = v.position.y;
+    vertices[2] = v.position.z;
+    vertices[3] = n.x;
+    vertices[4] = n.y;
+    vertices[5] = n.z;
+    vertices[6] = v.s;
+    vertices[7] = v.t;
+    return vertices + 8;
+}
+
+// write count vertices sharing one face normal (a flat triangle or quad)
+inline float* writeFlatFace(float* vertices, const GridVertex* corners, int count, const Vec3& n)
+{
+    for(int k = 0; k < count; ++k)
+        vertices = writeVertex(vertices, corners[k], n);
+    return vertices;
+}
+
+// split count interleaved V/N/T vertices into position (3), normal (3) and
+// tex coord (2) arrays of at least count elements each
+inline void splitInterleaved(const float* interleaved, std::size_t count,
+                             float* positions, float* normals, float* texCoords)
+{
+    for(std::size_t i = 0; i < count; ++i, interleaved += 8)
+    {
+        positions[i*3]   = interleaved[0];
+        positions[i*3+1] = interleaved[1];
+        positions[i*3+2] = interleaved[2];
+
+        normals[i*3]     = interleaved[3];
+        normals[i*3+1]   = interleaved[4];
+        normals[i*3+2]   = interleaved[5];
+
+        texCoords[i*2]   = interleaved[6];
+        texCoords[i*2+1] = interleaved[7];
+    }
+}
+
+#endif
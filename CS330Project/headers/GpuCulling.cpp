@@ -0,0 +1,624 @@
+///////////////////////////////////////////////////////////////////////////////
+// GpuCulling.cpp
+// ==============
+// Compute shaders of the GPU culling: instance culling and LOD selection,
+// indirect command building and the max-depth pyramid.
+//
+// Every batch has a list of visible instances per LOD of its mesh, sized for
+// all of its instances, so the cull pass only needs one atomic counter per
+// list and no prefix sum. One thread per batch then turns the non-empty lists
+// into commands, at most MAX_MESH_LODS per batch.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+#include "GpuCulling.h"
+#include "Meshlets.h"
+
+#ifndef GLSL
+#define GLSL(Version, Source) "#version " #Version " core \n" #Source
+#endif
+
+// the shaders size the LOD arrays of GpuMeshLods with a literal
+static_assert(MAX_MESH_LODS == 8, "update the LOD arrays of the GPU culling shaders");
+static_assert(sizeof(GpuInstance) == 96, "GpuInstance must match the std430 layout of the shaders");
+static_assert(sizeof(GpuMeshLods) == 100, "GpuMeshLods must match the std430 layout of the shaders");
+
+const unsigned int CULL_GROUP_SIZE = 64;        // local_size_x of the cull and command shaders
+const unsigned int PYRAMID_GROUP_SIZE = 8;      // local_size_x and y of the pyramid shader
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// shader sources
+///////////////////////////////////////////////////////////////////////////////
+// one thread per instance: frustum and occlusion test, LOD selection and
+// appending to the visible list of its batch and LOD
+static const char* cullShaderSource = GLSL(440,
+layout(local_size_x = 64) in;
+
+struct Instance
+{
+    mat4 model;
+    vec4 boundingSphere;
+    uvec4 ids; // batch, mesh, material
+};
+
+struct MeshLods
+{
+    uint lodCount;
+    uint firstIndex[8];
+    uint indexCount[8];
+    float error[8];
+};
+
+struct Batch
+{
+    uint firstInstance;
+    uint instanceCount;
+    uint mesh;
+    uint firstSlot;
+};
+
+layout(std430, binding = 0) readonly buffer Instances { Instance instances[]; };
+layout(std430, binding = 1) readonly buffer Meshes { MeshLods meshes[]; };
+layout(std430, binding = 2) readonly buffer Batches { Batch batches[]; };
+layout(std430, binding = 3) buffer Counters { uint counters[]; };
+layout(std430, binding = 4) writeonly buffer Visible { uint visible[]; };
+
+uniform uint instanceCount;
+uniform vec4 frustumPlanes[6]; // world space, unit normals, inside >= 0
+uniform vec3 cameraPosition;
+uniform float lodScale; // largest LOD error at a distance of 1
+uniform bool occlusionCulling;
+uniform mat4 pyramidViewProjection; // of the frame in the pyramid
+layout(binding = 0) uniform sampler2D depthPyramid; // farthest depth of each texel, halved per level
+
+// the sphere is behind the farthest depth of the pyramid texels its screen box covers
+bool isOccluded(vec3 center, float radius)
+{
+    vec2 low = vec2(1.0f);
+    vec2 high = vec2(-1.0f);
+    float nearest = 1.0f;
+    for (int i = 0; i < 8; ++i)
+    {
+        vec3 corner = center + radius * vec3((i & 1) != 0 ? 1.0f : -1.0f, (i & 2) != 0 ? 1.0f : -1.0f, (i & 4) != 0 ? 1.0f : -1.0f);
+        vec4 clip = pyramidViewProjection * vec4(corner, 1.0f);
+        if (clip.w <= 0.0f)
+            return false; // reaches behind the camera
+        vec3 ndc = clip.xyz / clip.w;
+        low = min(low, ndc.xy);
+        high = max(high, ndc.xy);
+        nearest = min(nearest, ndc.z * 0.5f + 0.5f);
+    }
+    low = clamp(low * 0.5f + 0.5f, 0.0f, 1.0f);
+    high = clamp(high * 0.5f + 0.5f, 0.0f, 1.0f);
+
+    // the first level where the box spans at most 2 x 2 texels; each level halves the one above, rounding down
+    ivec2 baseSize = textureSize(depthPyramid, 0);
+    vec2 size = (high - low) * vec2(baseSize);
+    int level = min(int(ceil(log2(max(max(size.x, size.y), 1.0f)))), textureQueryLevels(depthPyramid) - 1);
+    ivec2 levelSize = max(baseSize >> level, ivec2(1));
+    ivec2 first = min(ivec2(low * vec2(levelSize)), levelSize - 1);
+    ivec2 last = min(ivec2(high * vec2(levelSize)), levelSize - 1);
+    float farthest = max(max(texelFetch(depthPyramid, first, level).r, texelFetch(depthPyramid, ivec2(last.x, first.y), level).r),
+                         max(texelFetch(depthPyramid, ivec2(first.x, last.y), level).r, texelFetch(depthPyramid, last, level).r));
+    return nearest > farthest;
+}
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= instanceCount)
+        return;
+
+    Instance instance = instances[index];
+    float scale = max(length(instance.model[0].xyz), max(length(instance.model[1].xyz), length(instance.model[2].xyz)));
+
+    // instances without bounds are always drawn
+    if (instance.boundingSphere.w >= 0.0f)
+    {
+        vec3 center = vec3(instance.model * vec4(instance.boundingSphere.xyz, 1.0f));
+        float radius = instance.boundingSphere.w * scale;
+        for (int i = 0; i < 6; ++i)
+        {
+            if (dot(frustumPlanes[i].xyz, center) + frustumPlanes[i].w < -radius)
+                return;
+        }
+        if (occlusionCulling && isOccluded(center, radius))
+            return;
+    }
+
+    // the coarsest LOD whose error is allowed at the distance of the origin from the camera
+    uint mesh = instance.ids.y;
+    float maxError = lodScale * length(instance.model[3].xyz - cameraPosition);
+    uint lod = 0u;
+    while (lod + 1u < meshes[mesh].lodCount && meshes[mesh].error[lod + 1u] * scale <= maxError)
+        ++lod;
+
+    Batch batch = batches[instance.ids.x];
+    uint slot = atomicAdd(counters[instance.ids.x * 8u + lod], 1u);
+    visible[batch.firstSlot + lod * batch.instanceCount + slot] = index;
+}
+);
+
+// one thread per batch: a command per non-empty visible list, packed to the
+// front of the batch's commands, and their count
+static const char* commandShaderSource = GLSL(440,
+layout(local_size_x = 64) in;
+
+struct MeshLods
+{
+    uint lodCount;
+    uint firstIndex[8];
+    uint indexCount[8];
+    float error[8];
+};
+
+struct Batch
+{
+    uint firstInstance;
+    uint instanceCount;
+    uint mesh;
+    uint firstSlot;
+};
+
+struct DrawCommand
+{
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+layout(std430, binding = 1) readonly buffer Meshes { MeshLods meshes[]; };
+layout(std430, binding = 2) readonly buffer Batches { Batch batches[]; };
+layout(std430, binding = 3) readonly buffer Counters { uint counters[]; };
+layout(std430, binding = 5) writeonly buffer Commands { DrawCommand commands[]; };
+layout(std430, binding = 6) writeonly buffer DrawCounts { uint drawCounts[]; };
+
+uniform uint batchCount;
+
+void main()
+{
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= batchCount)
+        return;
+
+    Batch batch = batches[index];
+    uint lodCount = meshes[batch.mesh].lodCount;
+    uint drawCount = 0u;
+    for (uint lod = 0u; lod < lodCount; ++lod)
+    {
+        uint visibleCount = counters[index * 8u + lod];
+        if (visibleCount == 0u)
+            continue;
+
+        // baseInstance points the instance attribute at the visible list of the LOD
+        DrawCommand command;
+        command.count = meshes[batch.mesh].indexCount[lod];
+        command.instanceCount = visibleCount;
+        command.firstIndex = meshes[batch.mesh].firstIndex[lod];
+        command.baseVertex = 0;
+        command.baseInstance = batch.firstSlot + lod * batch.instanceCount;
+        commands[index * 8u + drawCount] = command;
+        ++drawCount;
+    }
+
+    // without a draw count every slot up to lodCount is drawn, so the rest draw no instances
+    for (uint slot = drawCount; slot < lodCount; ++slot)
+        commands[index * 8u + slot].instanceCount = 0u;
+    drawCounts[index] = drawCount;
+}
+);
+
+// one thread per texel of a pyramid level: the farthest depth of the texels
+// of the level above (or of the depth copy) that it overlaps
+static const char* pyramidShaderSource = GLSL(440,
+layout(local_size_x = 8, local_size_y = 8) in;
+
+layout(binding = 0) uniform sampler2D source; // the depth copy for level 0, then the pyramid
+uniform int sourceLevel;
+layout(r32f, binding = 0) writeonly uniform image2D destination;
+
+void main()
+{
+    ivec2 texel = ivec2(gl_GlobalInvocationID.xy);
+    ivec2 size = imageSize(destination);
+    if (texel.x >= size.x || texel.y >= size.y)
+        return;
+
+    // 1 texel per axis for the copy, 2 when halving, 3 when halving an odd size
+    ivec2 sourceSize = max(textureSize(source, 0) >> sourceLevel, ivec2(1));
+    ivec2 first = texel * sourceSize / size;
+    ivec2 last = ((texel + 1) * sourceSize + size - 1) / size;
+    float depth = 0.0f;
+    for (int y = first.y; y < last.y; ++y)
+    {
+        for (int x = first.x; x < last.x; ++x)
+            depth = max(depth, texelFetch(source, ivec2(x, y), sourceLevel).r);
+    }
+    imageStore(destination, texel, vec4(depth));
+}
+);
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// helpers
+///////////////////////////////////////////////////////////////////////////////
+static bool createComputeProgram(const char* source, const char* name, GLuint& program)
+{
+    int successful;
+    char errorLog[512];
+
+    GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &successful);
+    if(!successful)
+    {
+        glGetShaderInfoLog(shader, 512, NULL, errorLog);
+        std::cout << "Failed to compile " << name << " shader\n" << errorLog << std::endl;
+        glDeleteShader(shader);
+        return false;
+    }
+
+    program = glCreateProgram();
+    glAttachShader(program, shader);
+    glLinkProgram(program);
+    glDeleteShader(shader);
+    glGetProgramiv(program, GL_LINK_STATUS, &successful);
+    if(!successful)
+    {
+        glGetProgramInfoLog(program, 512, NULL, errorLog);
+        std::cout << "Failed to link " << name << " program\n" << errorLog << std::endl;
+        glDeleteProgram(program);
+        program = 0;
+        return false;
+    }
+    return true;
+}
+
+// a shader storage buffer with data, or zeroed when data is null
+static GLuint createStorageBuffer(std::size_t size, const void* data, GLenum usage)
+{
+    GLuint buffer;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, (GLsizeiptr)std::max(size, sizeof(GLuint)), data, usage);
+    if(!data)
+    {
+        const GLuint zero = 0;
+        glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+    }
+    return buffer;
+}
+
+static void deleteBuffer(GLuint& buffer)
+{
+    if(buffer)
+        glDeleteBuffers(1, &buffer);
+    buffer = 0;
+}
+
+static void deleteTexture(GLuint& texture)
+{
+    if(texture)
+        glDeleteTextures(1, &texture);
+    texture = 0;
+}
+
+static void deleteProgram(GLuint& program)
+{
+    if(program)
+        glDeleteProgram(program);
+    program = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+GpuCuller::GpuCuller()
+    : instanceCount(0), drawCountMode(DRAW_COUNT_NONE), cullProgram(0), commandProgram(0), pyramidProgram(0),
+      instanceBuffer(0), meshBuffer(0), batchBuffer(0), counterBuffer(0), visibleBuffer(0), commandBuffer(0),
+      drawCountBuffer(0), occlusionCulling(false), pyramidValid(false), pyramidWidth(0), pyramidHeight(0),
+      pyramidLevels(0), depthTexture(0), pyramidTexture(0)
+{
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// compute shaders, SSBOs, image load/store and multi-draw indirect are all
+// core in OpenGL 4.3, but the vertex stage may have no SSBOs at all
+// (GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS can be 0), and the compute shaders
+// use 5 of the 8 compute SSBO bindings 4.3 guarantees
+///////////////////////////////////////////////////////////////////////////////
+bool GpuCuller::isSupported()
+{
+    if(!GLEW_VERSION_4_3)
+        return false;
+
+    GLint vertexBlocks = 0, computeBlocks = 0;
+    glGetIntegerv(GL_MAX_VERTEX_SHADER_STORAGE_BLOCKS, &vertexBlocks);
+    glGetIntegerv(GL_MAX_COMPUTE_SHADER_STORAGE_BLOCKS, &computeBlocks);
+    return vertexBlocks >= 1 && computeBlocks >= 5;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// split the instances into batches and buffer everything the shaders read
+///////////////////////////////////////////////////////////////////////////////
+bool GpuCuller::create(const GpuMeshLods* meshes, unsigned int meshCount, const GpuInstance* instances,
+                       unsigned int instanceCount)
+{
+    release();
+
+    // a batch is a run of instances with one batch number; its lists hold every instance once per LOD
+    unsigned int slotCount = 0;
+    for(unsigned int i = 0; i < instanceCount; ++i)
+    {
+        const GpuInstance& instance = instances[i];
+        if(instance.mesh >= meshCount || meshes[instance.mesh].lodCount == 0 || meshes[instance.mesh].lodCount > MAX_MESH_LODS)
+        {
+            std::cout << "GPU culling: instance " << i << " has no valid mesh" << std::endl;
+            release();
+            return false;
+        }
+        bool first = i == 0 || instance.batch != instances[i - 1].batch;
+        if(first ? instance.batch != batches.size() : instance.mesh != batches.back().mesh)
+        {
+            std::cout << "GPU culling: instances are not sorted into batches of one mesh" << std::endl;
+            release();
+            return false;
+        }
+        if(first)
+        {
+            Batch batch = { i, 0, instance.mesh, slotCount };
+            batches.push_back(batch);
+            batchLodCounts.push_back(meshes[instance.mesh].lodCount);
+        }
+        ++batches.back().instanceCount;
+        slotCount += batchLodCounts.back();
+    }
+    this->instanceCount = instanceCount;
+
+    if(!createComputeProgram(cullShaderSource, "instance cull", cullProgram) ||
+       !createComputeProgram(commandShaderSource, "indirect command", commandProgram) ||
+       !createComputeProgram(pyramidShaderSource, "depth pyramid", pyramidProgram))
+    {
+        release();
+        return false;
+    }
+
+    // every buffer is bound whole as an SSBO, so none may be larger than a block (at least 2^24 bytes)
+    std::size_t batchCount = batches.size();
+    std::size_t largestSize = std::max(std::max(instanceCount * sizeof(GpuInstance), meshCount * sizeof(GpuMeshLods)),
+                                       std::max(slotCount * sizeof(GLuint), batchCount * MAX_MESH_LODS * sizeof(DrawElementsIndirectCommand)));
+    GLint64 maxBlockSize = 0;
+    glGetInteger64v(GL_MAX_SHADER_STORAGE_BLOCK_SIZE, &maxBlockSize);
+    if((GLint64)largestSize > maxBlockSize)
+    {
+        std::cout << "GPU culling: " << largestSize << " bytes of instance data exceed the SSBO size limit of " << maxBlockSize << std::endl;
+        release();
+        return false;
+    }
+
+    instanceBuffer = createStorageBuffer(instanceCount * sizeof(GpuInstance), instances, GL_STATIC_DRAW);
+    meshBuffer = createStorageBuffer(meshCount * sizeof(GpuMeshLods), meshes, GL_STATIC_DRAW);
+    batchBuffer = createStorageBuffer(batchCount * sizeof(Batch), batches.data(), GL_STATIC_DRAW);
+    counterBuffer = createStorageBuffer(batchCount * MAX_MESH_LODS * sizeof(GLuint), 0, GL_DYNAMIC_COPY);
+    visibleBuffer = createStorageBuffer(slotCount * sizeof(GLuint), 0, GL_DYNAMIC_COPY);
+    commandBuffer = createStorageBuffer(batchCount * MAX_MESH_LODS * sizeof(DrawElementsIndirectCommand), 0, GL_DYNAMIC_COPY);
+    drawCountBuffer = createStorageBuffer(batchCount * sizeof(GLuint), 0, GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    if(GLEW_VERSION_4_6)
+        drawCountMode = DRAW_COUNT_CORE;
+    else if(GLEW_ARB_indirect_parameters)
+        drawCountMode = DRAW_COUNT_ARB;
+    else
+        drawCountMode = DRAW_COUNT_NONE;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the visible list entry of each instance drawn, offset by baseInstance
+///////////////////////////////////////////////////////////////////////////////
+void GpuCuller::bindInstanceAttribute(GLuint vao) const
+{
+    glBindVertexArray(vao);
+    glBindBuffer(GL_ARRAY_BUFFER, visibleBuffer);
+    glVertexAttribIPointer(GPU_INSTANCE_ATTRIBUTE, 1, GL_UNSIGNED_INT, 0, 0);
+    glVertexAttribDivisor(GPU_INSTANCE_ATTRIBUTE, 1);
+    glEnableVertexAttribArray(GPU_INSTANCE_ATTRIBUTE);
+    glBindVertexArray(0);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// clear the counters, cull and build the commands. nothing is read back, so
+// the CPU cost is the same for any number of instances
+///////////////////////////////////////////////////////////////////////////////
+void GpuCuller::cull(const float viewProjection[16], const float camera[3], float lodScale)
+{
+    if(batches.empty())
+        return;
+    std::copy(viewProjection, viewProjection + 16, cullViewProjection);
+    bool occlusion = occlusionCulling && pyramidValid;
+
+    const GLuint zero = 0;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, counterBuffer);
+    glClearBufferData(GL_SHADER_STORAGE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &zero);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, instanceBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, meshBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, batchBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, counterBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, visibleBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, drawCountBuffer);
+
+    float planes[6][4];
+    getFrustumPlanes(viewProjection, planes);
+    glUseProgram(cullProgram);
+    glUniform1ui(glGetUniformLocation(cullProgram, "instanceCount"), instanceCount);
+    glUniform4fv(glGetUniformLocation(cullProgram, "frustumPlanes"), 6, &planes[0][0]);
+    glUniform3fv(glGetUniformLocation(cullProgram, "cameraPosition"), 1, camera);
+    glUniform1f(glGetUniformLocation(cullProgram, "lodScale"), lodScale);
+    glUniform1i(glGetUniformLocation(cullProgram, "occlusionCulling"), occlusion ? 1 : 0);
+    if(occlusion)
+    {
+        glUniformMatrix4fv(glGetUniformLocation(cullProgram, "pyramidViewProjection"), 1, GL_FALSE, pyramidViewProjection);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, pyramidTexture);
+    }
+    glDispatchCompute((instanceCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    // every instance is counted before the commands are built from the counts
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+    glUseProgram(commandProgram);
+    glUniform1ui(glGetUniformLocation(commandProgram, "batchCount"), (GLuint)batches.size());
+    glDispatchCompute(((GLuint)batches.size() + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+
+    // the draws read the commands and counts, and the visible lists as a vertex attribute
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    if(drawCountMode != DRAW_COUNT_NONE)
+        glBindBuffer(GL_PARAMETER_BUFFER_ARB, drawCountBuffer);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// one multi-draw over the LOD commands of a batch. without a draw count every
+// LOD slot is drawn with a glDrawElementsIndirect() of its own: a plain
+// multi-draw over them dropped pixels on Mesa (llvmpipe) while the same
+// commands drawn one by one were right, and the empty slots draw nothing
+///////////////////////////////////////////////////////////////////////////////
+void GpuCuller::drawBatch(unsigned int batch, GLenum primitive, GLenum indexType) const
+{
+    const std::size_t firstCommand = (std::size_t)batch * MAX_MESH_LODS * sizeof(DrawElementsIndirectCommand);
+    GLintptr drawCount = (GLintptr)(batch * sizeof(GLuint));
+    GLsizei maxDrawCount = (GLsizei)batchLodCounts[batch];
+    switch(drawCountMode)
+    {
+    case DRAW_COUNT_CORE:
+        glMultiDrawElementsIndirectCount(primitive, indexType, (const void*)firstCommand, drawCount, maxDrawCount, 0);
+        break;
+    case DRAW_COUNT_ARB:
+        glMultiDrawElementsIndirectCountARB(primitive, indexType, (const void*)firstCommand, drawCount, maxDrawCount, 0);
+        break;
+    default:
+        for(GLsizei i = 0; i < maxDrawCount; ++i)
+            glDrawElementsIndirect(primitive, indexType, (const void*)(firstCommand + i * sizeof(DrawElementsIndirectCommand)));
+        break;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// copy the depth buffer of the read framebuffer and reduce it level by level
+///////////////////////////////////////////////////////////////////////////////
+void GpuCuller::updateDepthPyramid(int width, int height)
+{
+    if(!occlusionCulling || batches.empty() || width <= 0 || height <= 0)
+        return;
+    if(width != pyramidWidth || height != pyramidHeight)
+        createPyramid(width, height);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, 0, 0, width, height);
+
+    glUseProgram(pyramidProgram);
+    GLint sourceLevelLoc = glGetUniformLocation(pyramidProgram, "sourceLevel");
+    int levelWidth = width;
+    int levelHeight = height;
+    for(int level = 0; level < pyramidLevels; ++level)
+    {
+        // level 0 from the copy, every other level from the one above it
+        glBindTexture(GL_TEXTURE_2D, level == 0 ? depthTexture : pyramidTexture);
+        glUniform1i(sourceLevelLoc, level == 0 ? 0 : level - 1);
+        glBindImageTexture(0, pyramidTexture, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute((levelWidth + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE,
+                          (levelHeight + PYRAMID_GROUP_SIZE - 1) / PYRAMID_GROUP_SIZE, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        levelWidth = std::max(levelWidth / 2, 1);
+        levelHeight = std::max(levelHeight / 2, 1);
+    }
+
+    std::copy(cullViewProjection, cullViewProjection + 16, pyramidViewProjection);
+    pyramidValid = true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// depth copy and R32F pyramid with a level per halving down to 1 x 1
+///////////////////////////////////////////////////////////////////////////////
+void GpuCuller::createPyramid(int width, int height)
+{
+    deleteTexture(depthTexture);
+    deleteTexture(pyramidTexture);
+
+    pyramidLevels = 1;
+    while((std::max(width, height) >> pyramidLevels) > 0)
+        ++pyramidLevels;
+
+    glGenTextures(1, &depthTexture);
+    glBindTexture(GL_TEXTURE_2D, depthTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT32F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenTextures(1, &pyramidTexture);
+    glBindTexture(GL_TEXTURE_2D, pyramidTexture);
+    glTexStorage2D(GL_TEXTURE_2D, pyramidLevels, GL_R32F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    pyramidWidth = width;
+    pyramidHeight = height;
+    pyramidValid = false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// delete the GL objects
+///////////////////////////////////////////////////////////////////////////////
+void GpuCuller::release()
+{
+    deleteProgram(cullProgram);
+    deleteProgram(commandProgram);
+    deleteProgram(pyramidProgram);
+    deleteBuffer(instanceBuffer);
+    deleteBuffer(meshBuffer);
+    deleteBuffer(batchBuffer);
+    deleteBuffer(counterBuffer);
+    deleteBuffer(visibleBuffer);
+    deleteBuffer(commandBuffer);
+    deleteBuffer(drawCountBuffer);
+    deleteTexture(depthTexture);
+    deleteTexture(pyramidTexture);
+
+    batches.clear();
+    batchLodCounts.clear();
+    instanceCount = 0;
+    pyramidValid = false;
+    pyramidWidth = 0;
+    pyramidHeight = 0;
+    pyramidLevels = 0;
+}
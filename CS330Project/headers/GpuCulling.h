@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////////
+// GpuCulling.h
+// ============
+// Culls the instances of a scene and builds their indirect draws in compute
+// shaders, so the CPU work per frame does not grow with the instance count.
+//
+// The instances are grouped into batches: runs of instances drawn with one
+// mesh, material and program. Every frame cull()
+// - tests each instance's bounding sphere against the frustum, and with
+//   occlusion culling against a max-depth pyramid of the previous frame
+// - picks its LOD like selectMeshLod() in Source.cpp
+// - appends its index to the visible list of its batch and LOD (atomically)
+// - writes one DrawElementsIndirectCommand per batch and non-empty LOD, and
+//   the number of them per batch
+// drawBatch() then draws a batch with one glMultiDrawElementsIndirectCount()
+// (a glDrawElementsIndirect() per LOD slot without it, where an empty LOD
+// draws no instances).
+//
+// The visible indices are an instanced vertex attribute (bindInstanceAttribute)
+// and baseInstance points each command at its list, so the vertex shader gets
+// the index of its instance as an input and reads the model matrix from the
+// instances at SSBO binding 0.
+//
+// Needs OpenGL 4.3 (compute shaders, SSBOs, multi-draw indirect) with at
+// least one SSBO in the vertex stage, which 4.3 does not guarantee.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef GPU_CULLING_H
+#define GPU_CULLING_H
+
+#include <GL/glew.h>
+#include <vector>
+#include "AssetManager.h"
+
+const GLuint GPU_INSTANCE_ATTRIBUTE = 3;    // vertex attribute of the visible instance index
+
+// one instance, as the shaders read it (std430)
+struct GpuInstance
+{
+    float model[16];            // column-major
+    float boundingSphere[4];    // object space center and radius (radius < 0: never culled)
+    unsigned int batch;         // batches are numbered from 0 in instance order
+    unsigned int mesh;          // in the mesh table
+    unsigned int material;
+    unsigned int padding;
+};
+
+// index ranges of the LODs of a mesh, finest first (a mesh without LODs has one: all of its indices)
+struct GpuMeshLods
+{
+    unsigned int lodCount;
+    unsigned int firstIndex[MAX_MESH_LODS];
+    unsigned int indexCount[MAX_MESH_LODS];
+    float error[MAX_MESH_LODS];             // in object units
+};
+
+class GpuCuller
+{
+public:
+    // ctor/dtor
+    GpuCuller();
+    ~GpuCuller() {}
+
+    // compute shaders, SSBOs (in the vertex stage too) and multi-draw indirect are available
+    static bool isSupported();
+
+    // compile the compute programs and buffer the meshes and instances, which must be sorted by batch.
+    // fails when a buffer is larger than GL_MAX_SHADER_STORAGE_BLOCK_SIZE
+    bool create(const GpuMeshLods* meshes, unsigned int meshCount, const GpuInstance* instances, unsigned int instanceCount);
+
+    // source the visible instance index of the attribute GPU_INSTANCE_ATTRIBUTE of a VAO, one per instance
+    void bindInstanceAttribute(GLuint vao) const;
+
+    // cull the instances for a view projection and write the draws of every batch. lodScale is the
+    // largest LOD error allowed at a distance of 1 from camera (it grows with the distance).
+    // leaves the instances bound to SSBO binding 0 and the draw buffers bound for drawBatch()
+    void cull(const float viewProjection[16], const float camera[3], float lodScale);
+
+    // draw the visible instances of a batch with the bound VAO and program
+    void drawBatch(unsigned int batch, GLenum primitive, GLenum indexType) const;
+
+    // reduce the depth buffer of the frame into the pyramid the next cull() tests against
+    // (with occlusion culling), before the buffers are swapped
+    void updateDepthPyramid(int width, int height);
+
+    // delete the GL objects
+    void release();
+
+    void setOcclusionCulling(bool enabled)                  { occlusionCulling = enabled; }
+    bool getOcclusionCulling() const                        { return occlusionCulling; }
+    unsigned int getBatchCount() const                      { return (unsigned int)batches.size(); }
+    unsigned int getBatchInstanceCount(unsigned int batch) const { return batches[batch].instanceCount; }
+    bool hasDrawCount() const                               { return drawCountMode != DRAW_COUNT_NONE; }
+
+private:
+    // instances [firstInstance, firstInstance + instanceCount) and their visible lists, one per LOD of mesh from firstSlot
+    struct Batch
+    {
+        unsigned int firstInstance;
+        unsigned int instanceCount;
+        unsigned int mesh;
+        unsigned int firstSlot;
+    };
+
+    enum DrawCountMode
+    {
+        DRAW_COUNT_NONE,        // all LOD slots of a batch are drawn, one call each
+        DRAW_COUNT_CORE,        // OpenGL 4.6
+        DRAW_COUNT_ARB          // GL_ARB_indirect_parameters
+    };
+
+    void createPyramid(int width, int height);
+
+    std::vector<Batch> batches;
+    std::vector<unsigned int> batchLodCounts;
+    unsigned int instanceCount;
+    DrawCountMode drawCountMode;
+
+    GLuint cullProgram;
+    GLuint commandProgram;
+    GLuint pyramidProgram;
+    GLuint instanceBuffer;      // GpuInstance per instance
+    GLuint meshBuffer;          // GpuMeshLods per mesh
+    GLuint batchBuffer;         // Batch per batch
+    GLuint counterBuffer;       // visible instances per batch and LOD slot
+    GLuint visibleBuffer;       // visible instance indices, per batch and LOD
+    GLuint commandBuffer;       // MAX_MESH_LODS commands per batch
+    GLuint drawCountBuffer;     // commands per batch
+
+    // occlusion culling: a copy of the depth buffer and its max-depth mip chain
+    bool occlusionCulling;
+    bool pyramidValid;          // the pyramid holds the frame of pyramidViewProjection
+    int pyramidWidth;
+    int pyramidHeight;
+    int pyramidLevels;
+    GLuint depthTexture;
+    GLuint pyramidTexture;
+    float cullViewProjection[16];       // of the last cull()
+    float pyramidViewProjection[16];    // of the frame in the pyramid
+};
+
+#endif
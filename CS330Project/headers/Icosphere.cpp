@@ -0,0 +1,481 @@
+///////////////////////////////////////////////////////////////////////////////
+// Icosphere.cpp
+// =============
+// Sphere for OpenGL with (radius, frequency)
+// A geodesic sphere; the min frequency is 1 (the icosahedron itself).
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+#include <windows.h>    // include windows.h to avoid thousands of compile errors even though this class is not depending on Windows
+#endif
+
+#ifdef __APPLE__
+#include <OpenGL/gl.h>
+#else
+#include <GL/gl.h>
+#endif
+
+#include <iostream>
+#include <cmath>
+#include "Icosphere.h"
+#include "SphereTopology.h"
+
+
+
+// constants //////////////////////////////////////////////////////////////////
+const int MIN_FREQUENCY = 1;
+const int MAX_FREQUENCY = 256;      // 1310720 triangles
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+Icosphere::Icosphere(float radius, int frequency, unsigned int outputs, std::pmr::memory_resource* resource)
+    : vertices(resource), normals(resource), texCoords(resource), indices(resource), lineIndices(resource),
+      interleavedVertices(resource), interleavedStride(32)
+{
+    set(radius, frequency, outputs);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// setters
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::set(float radius, int frequency, unsigned int outputs)
+{
+    this->radius = radius;
+    this->frequency = frequency;
+    if(frequency < MIN_FREQUENCY)
+        this->frequency = MIN_FREQUENCY;
+    if(frequency > MAX_FREQUENCY)
+        this->frequency = MAX_FREQUENCY;
+    this->outputs = outputs;
+
+    buildVertices();
+}
+
+void Icosphere::setRadius(float radius)
+{
+    if(radius == this->radius)
+        return;
+
+    // the topology does not depend on the radius, so the arrays are rewritten in place
+    this->radius = radius;
+    if(interleavedVertices.empty())
+        set(radius, frequency, outputs);
+    else
+        updateVertices();
+}
+
+void Icosphere::setFrequency(int frequency)
+{
+    if(frequency != this->frequency)
+        set(radius, frequency, outputs);
+}
+
+void Icosphere::setOutputs(unsigned int outputs)
+{
+    if(this->outputs != outputs)
+        set(radius, frequency, outputs);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// print itself
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::printSelf() const
+{
+    std::cout << "===== Icosphere =====\n"
+              << "        Radius: " << radius << "\n"
+              << "     Frequency: " << frequency << "\n"
+              << "   Chord Error: " << getChordError(frequency) * radius << "\n"
+              << "Triangle Count: " << getTriangleCount() << "\n"
+              << "   Index Count: " << getIndexCount() << "\n"
+              << "  Vertex Count: " << getVertexCount() << "\n"
+              << "  Normal Count: " << getNormalCount() << "\n"
+              << "TexCoord Count: " << getTexCoordCount() << std::endl;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// draw an icosphere in VertexArray mode
+// OpenGL RC must be set before calling it
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::draw() const
+{
+    // interleaved array
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glEnableClientState(GL_NORMAL_ARRAY);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glVertexPointer(3, GL_FLOAT, interleavedStride, &interleavedVertices[0]);
+    glNormalPointer(GL_FLOAT, interleavedStride, &interleavedVertices[3]);
+    glTexCoordPointer(2, GL_FLOAT, interleavedStride, &interleavedVertices[6]);
+
+    glDrawElements(GL_TRIANGLES, (unsigned int)indices.size(), GL_UNSIGNED_INT, indices.data());
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// draw lines only
+// the caller must set the line width before call this
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::drawLines(const float lineColor[4]) const
+{
+    // set line colour
+    glColor4fv(lineColor);
+    glMaterialfv(GL_FRONT, GL_DIFFUSE,   lineColor);
+
+    // draw lines with VA
+    glDisable(GL_LIGHTING);
+    glDisable(GL_TEXTURE_2D);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, 0, vertices.data());
+
+    glDrawElements(GL_LINES, (unsigned int)lineIndices.size(), GL_UNSIGNED_INT, lineIndices.data());
+
+    glDisableClientState(GL_VERTEX_ARRAY);
+    glEnable(GL_LIGHTING);
+    glEnable(GL_TEXTURE_2D);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// draw an icosphere surfaces and lines on top of it
+// the caller must set the line width before call this
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::drawWithLines(const float lineColor[4]) const
+{
+    glEnable(GL_POLYGON_OFFSET_FILL);
+    glPolygonOffset(1.0, 1.0f); // move polygon backward
+    this->draw();
+    glDisable(GL_POLYGON_OFFSET_FILL);
+
+    // draw lines with VA
+    drawLines(lineColor);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// rewrite the positions of the existing arrays after a radius change
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::updateVertices()
+{
+    scaleSphereVertices(radius, vertexCount, &interleavedVertices[0]);
+
+    if(outputs & MESH_OUTPUT_SEPARATE)
+        buildSeparateVertices();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// dealloc vectors
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::clearArrays()
+{
+    // swap with empty arrays of the same memory resource
+    std::pmr::vector<float>(vertices.get_allocator()).swap(vertices);
+    std::pmr::vector<float>(normals.get_allocator()).swap(normals);
+    std::pmr::vector<float>(texCoords.get_allocator()).swap(texCoords);
+    std::pmr::vector<unsigned int>(indices.get_allocator()).swap(indices);
+    std::pmr::vector<unsigned int>(lineIndices.get_allocator()).swap(lineIndices);
+    std::pmr::vector<float>(interleavedVertices.get_allocator()).swap(interleavedVertices);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// non-owning view of the interleaved vertices and indices
+///////////////////////////////////////////////////////////////////////////////
+MeshView Icosphere::getMeshView() const
+{
+    return MeshView(interleavedVertices.data(), getInterleavedVertexCount(),
+                    indices.data(), getIndexCount(), interleavedStride);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// each face is a grid of frequency^2 triangles
+///////////////////////////////////////////////////////////////////////////////
+unsigned int Icosphere::getTriangleCount(int frequency)
+{
+    return 20u * frequency * frequency;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// chord error of a unit icosphere, measured on its triangles
+// the projection stretches the grid unevenly, so there is no closed form
+///////////////////////////////////////////////////////////////////////////////
+float Icosphere::getChordError(int frequency)
+{
+    std::vector<Vec3> positions;
+    std::vector<unsigned int> indices;
+    buildUnitMesh(frequency, positions, indices);
+    return computeChordError(&positions[0].x, sizeof(Vec3), indices.data(), (unsigned int)indices.size());
+}
+
+int Icosphere::getFrequencyForError(float maxError)
+{
+    // the error drops about 4x per doubling, so search the power of 2 first,
+    // then the frequencies below it
+    int high = MIN_FREQUENCY;
+    while(high < MAX_FREQUENCY && getChordError(high) > maxError)
+        high *= 2;
+    if(high > MAX_FREQUENCY)
+        high = MAX_FREQUENCY;
+
+    int low = high / 2;                 // too coarse, unless high is the min
+    while(high - low > 1 && low >= MIN_FREQUENCY)
+    {
+        int middle = (low + high) / 2;
+        if(getChordError(middle) > maxError)
+            low = middle;
+        else
+            high = middle;
+    }
+    return high;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// point (i, j) of the grid on the face a-b-c, pushed out onto the sphere:
+// a + (b - a) * i/n + (c - a) * j/n, normalized
+///////////////////////////////////////////////////////////////////////////////
+static Vec3 getGridPoint(const Vec3& a, const Vec3& b, const Vec3& c, int i, int j, int n)
+{
+    float u = (float)i / n, v = (float)j / n, w = 1 - u - v;
+    Vec3 p = { a.x * w + b.x * u + c.x * v, a.y * w + b.y * u + c.y * v, a.z * w + b.z * u + c.z * v };
+    float lengthInv = 1.0f / length(p);
+    p.x *= lengthInv;
+    p.y *= lengthInv;
+    p.z *= lengthInv;
+    return p;
+}
+
+// index of point k (0..n) on the edge from corner a to corner b; the points
+// of an edge are stored from its smaller corner, starting at edgeStart
+static unsigned int getEdgePoint(const std::vector<unsigned int>& edgeStart, unsigned int a, unsigned int b, int k, int n)
+{
+    if(k == 0) return a;
+    if(k == n) return b;
+    unsigned int start = edgeStart[a * 12 + b];
+    return a < b ? start + k - 1 : start + (n - k) - 1;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// icosahedron with a vertex at each pole, so the poles of the tex coords are
+// vertices: the north pole, 5 vertices at elevation atan(1/2), 5 at -atan(1/2)
+// rotated by 36 degrees, and the south pole
+// the vertices are stored as the 12 corners, then frequency-1 points on each
+// of the 30 edges, then the points inside each of the 20 faces, so the points
+// on a shared edge are made once
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::buildUnitMesh(int frequency, std::vector<Vec3>& positions, std::vector<unsigned int>& indices)
+{
+    const float PI = acos(-1);
+    const float H_ANGLE = PI / 180 * 72;    // 72 degree = 360 / 5
+    const float V_ANGLE = atanf(0.5f);      // elevation = 26.565 degree
+
+    std::vector<Vec3> corners;
+    corners.reserve(12);
+    Vec3 pole = { 0, 0, 1 };
+    corners.push_back(pole);
+    for(int i = 0; i < 5; ++i)
+    {
+        Vec3 upper = { cosf(V_ANGLE) * cosf(H_ANGLE * i), cosf(V_ANGLE) * sinf(H_ANGLE * i), sinf(V_ANGLE) };
+        corners.push_back(upper);
+    }
+    for(int i = 0; i < 5; ++i)
+    {
+        float angle = H_ANGLE * i + H_ANGLE / 2;
+        Vec3 lower = { cosf(V_ANGLE) * cosf(angle), cosf(V_ANGLE) * sinf(angle), -sinf(V_ANGLE) };
+        corners.push_back(lower);
+    }
+    pole.z = -1;
+    corners.push_back(pole);
+
+    // 20 faces, counter-clockwise from outside
+    //   upper ring: 1..5, lower ring: 6..10, poles: 0 and 11
+    std::vector<unsigned int> faces;
+    faces.reserve(60);
+    for(unsigned int i = 0; i < 5; ++i)
+    {
+        unsigned int u1 = 1 + i, u2 = 1 + (i + 1) % 5;
+        unsigned int l1 = 6 + i, l2 = 6 + (i + 1) % 5;
+        unsigned int face[12] = { 0, u1, u2,            // top
+                                  u1, l1, u2,           // middle, pointing down
+                                  u2, l1, l2,           // middle, pointing up
+                                  11, l2, l1 };         // bottom
+        faces.insert(faces.end(), face, face + 12);
+    }
+
+    int n = frequency;
+    std::size_t edgePoints = (std::size_t)(n - 1);
+    std::size_t facePoints = (std::size_t)(n - 1) * (n - 2) / 2;
+    positions.clear();
+    positions.reserve(12 + 30 * edgePoints + 20 * facePoints);
+    positions.insert(positions.end(), corners.begin(), corners.end());
+
+    // first point of each edge, made from the smaller corner to the larger one
+    std::vector<unsigned int> edgeStart(12 * 12, 0);
+    for(std::size_t f = 0; f < faces.size(); f += 3)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            unsigned int a = faces[f+k], b = faces[f + (k + 1) % 3];
+            if(a > b || edgePoints == 0)
+                continue;       // made from the other face, or no points
+            edgeStart[a * 12 + b] = edgeStart[b * 12 + a] = (unsigned int)positions.size();
+            for(int i = 1; i < n; ++i)
+                positions.push_back(getGridPoint(corners[a], corners[b], corners[b], i, 0, n));
+        }
+    }
+
+    // grid of face a-b-c: i goes from a (0) to b (n), j from a to c; row j has
+    // a triangle pointing up at every i, and one pointing down between them
+    //  (i,j+1)               (i,j+1)--(i+1,j+1)
+    //    |   \                   \      |
+    //  (i,j)--(i+1,j)              (i+1,j)
+    indices.clear();
+    indices.reserve((std::size_t)getTriangleCount(n) * 3);
+    std::vector<unsigned int> grid((std::size_t)(n + 1) * (n + 1));
+    for(std::size_t f = 0; f < faces.size(); f += 3)
+    {
+        unsigned int a = faces[f], b = faces[f+1], c = faces[f+2];
+        for(int j = 0; j <= n; ++j)
+        {
+            for(int i = 0; i + j <= n; ++i)
+            {
+                unsigned int& index = grid[j * (n + 1) + i];
+                if(j == 0)
+                    index = getEdgePoint(edgeStart, a, b, i, n);
+                else if(i == 0)
+                    index = getEdgePoint(edgeStart, a, c, j, n);
+                else if(i + j == n)
+                    index = getEdgePoint(edgeStart, b, c, j, n);
+                else
+                {
+                    index = (unsigned int)positions.size();
+                    positions.push_back(getGridPoint(corners[a], corners[b], corners[c], i, j, n));
+                }
+            }
+        }
+
+        for(int j = 0; j < n; ++j)
+        {
+            for(int i = 0; i + j < n; ++i)
+            {
+                unsigned int k1 = grid[j * (n + 1) + i];
+                unsigned int k2 = grid[(j + 1) * (n + 1) + i];
+                indices.push_back(k1);
+                indices.push_back(grid[j * (n + 1) + i + 1]);
+                indices.push_back(k2);
+                if(i + j + 1 < n)
+                {
+                    indices.push_back(grid[j * (n + 1) + i + 1]);
+                    indices.push_back(grid[(j + 1) * (n + 1) + i + 1]);
+                    indices.push_back(k2);
+                }
+            }
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// build the interleaved vertices from the unit mesh, split the tex coord seam,
+// then make the other outputs from them
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::buildVertices()
+{
+    // clear memory of prev arrays
+    clearArrays();
+
+    std::vector<Vec3> positions;
+    std::vector<unsigned int> unitIndices;
+    buildUnitMesh(frequency, positions, unitIndices);
+
+    interleavedVertices.resize(positions.size() * MESH_VERTEX_FLOATS);
+    writeSphereVertices(positions.data(), (unsigned int)positions.size(), radius, &interleavedVertices[0]);
+    indices.assign(unitIndices.begin(), unitIndices.end());
+    fixSphereSeams(interleavedVertices, indices);
+
+    vertexCount = (unsigned int)(interleavedVertices.size() / MESH_VERTEX_FLOATS);
+    indexCount = (unsigned int)indices.size();
+    buildOutputs();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// build the arrays selected by the output mask from the interleaved array,
+// then drop the interleaved array if it was not selected
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::buildOutputs()
+{
+    if(outputs & MESH_OUTPUT_SEPARATE)
+        buildSeparateVertices();
+    if(!(outputs & MESH_OUTPUT_INTERLEAVED))
+        std::pmr::vector<float>(interleavedVertices.get_allocator()).swap(interleavedVertices);
+    if(outputs & MESH_OUTPUT_LINES)
+        buildEdgeIndices(indices.data(), indexCount, lineIndices);
+    lineIndexCount = (unsigned int)lineIndices.size();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// free the arrays after upload; counts and bounds are kept
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::releaseCpuData()
+{
+    clearArrays();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// bounds of the icosphere: all vertices are on the sphere, so its bounds
+// contain the mesh
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::getBounds(float min[3], float max[3]) const
+{
+    for(int i = 0; i < 3; ++i)
+    {
+        min[i] = -radius;
+        max[i] = radius;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// split interleaved vertices: V/N/T into separate arrays
+///////////////////////////////////////////////////////////////////////////////
+void Icosphere::buildSeparateVertices()
+{
+    std::size_t count = interleavedVertices.size() / 8;
+    vertices.resize(count * 3);
+    normals.resize(count * 3);
+    texCoords.resize(count * 2);
+    if(count > 0)
+        splitInterleaved(&interleavedVertices[0], count, &vertices[0], &normals[0], &texCoords[0]);
+}
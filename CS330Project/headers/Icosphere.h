@@ -0,0 +1,125 @@
+///////////////////////////////////////////////////////////////////////////////
+// Icosphere.h
+// ===========
+// Sphere for OpenGL with (radius, frequency)
+// A geodesic sphere: each edge of an icosahedron is split into frequency
+// segments, each face into a grid of frequency^2 triangles, and the grid is
+// pushed out onto the sphere. The triangles are close to equilateral and to
+// the same size everywhere, where the UV Sphere crowds thin ones at the poles
+// (see SphereTopology.h and tools/SphereBudget).
+//
+// 20 * frequency^2 triangles, so any budget can be met closely (frequency 2^n
+// has the triangles of an icosahedron subdivided n times). Smooth shading only
+// (flat shading comes from the fragment shader); the accessors are those of
+// Sphere.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef GEOMETRY_ICOSPHERE_H
+#define GEOMETRY_ICOSPHERE_H
+
+#include <memory_resource>
+#include <vector>
+#include "GeometryKernel.h"
+#include "MeshView.h"
+
+class Icosphere
+{
+public:
+    // ctor/dtor
+    Icosphere(float radius=1.0f, int frequency=8, unsigned int outputs=MESH_OUTPUT_ALL,
+              std::pmr::memory_resource* resource=std::pmr::get_default_resource());
+    ~Icosphere() {}
+
+    // getters/setters
+    float getRadius() const                 { return radius; }
+    int getFrequency() const                { return frequency; }
+    void set(float radius, int frequency, unsigned int outputs=MESH_OUTPUT_ALL);
+    void setRadius(float radius);           // rewrites positions in place, keeps the indices
+    void setFrequency(int frequency);
+    void setOutputs(unsigned int outputs);  // MeshOutput flags
+    unsigned int getOutputs() const         { return outputs; }
+
+    // arrays are allocated from this resource, like Sphere
+    std::pmr::memory_resource* getMemoryResource() const { return interleavedVertices.get_allocator().resource(); }
+
+    // for vertex data
+    // counts include the vertices duplicated at the tex coord seam and the poles
+    unsigned int getVertexCount() const     { return vertexCount; }
+    unsigned int getNormalCount() const     { return vertexCount; }
+    unsigned int getTexCoordCount() const   { return vertexCount; }
+    unsigned int getIndexCount() const      { return indexCount; }
+    unsigned int getLineIndexCount() const  { return lineIndexCount; }
+    unsigned int getTriangleCount() const   { return getIndexCount() / 3; }
+    unsigned int getVertexSize() const      { return (unsigned int)vertices.size() * sizeof(float); }
+    unsigned int getNormalSize() const      { return (unsigned int)normals.size() * sizeof(float); }
+    unsigned int getTexCoordSize() const    { return (unsigned int)texCoords.size() * sizeof(float); }
+    unsigned int getIndexSize() const       { return (unsigned int)indices.size() * sizeof(unsigned int); }
+    unsigned int getLineIndexSize() const   { return (unsigned int)lineIndices.size() * sizeof(unsigned int); }
+    const float* getVertices() const        { return vertices.data(); }
+    const float* getNormals() const         { return normals.data(); }
+    const float* getTexCoords() const       { return texCoords.data(); }
+    const unsigned int* getIndices() const  { return indices.data(); }
+    const unsigned int* getLineIndices() const  { return lineIndices.data(); }
+
+    // for interleaved vertices: V/N/T
+    unsigned int getInterleavedVertexCount() const  { return getVertexCount(); }    // # of vertices
+    unsigned int getInterleavedVertexSize() const   { return (unsigned int)interleavedVertices.size() * sizeof(float); }    // # of bytes
+    int getInterleavedStride() const                { return interleavedStride; }   // should be 32 bytes
+    const float* getInterleavedVertices() const     { return interleavedVertices.data(); }
+
+    // non-owning view of the interleaved vertices and indices, for uploading without a copy
+    MeshView getMeshView() const;
+
+    // chord error of a unit icosphere, and the lowest frequency within maxError
+    static unsigned int getTriangleCount(int frequency);
+    static float getChordError(int frequency);
+    static int getFrequencyForError(float maxError);
+
+    // unit sphere positions (also the normals) and triangle indices, before
+    // the seam is split; shared vertices only
+    static void buildUnitMesh(int frequency, std::vector<Vec3>& positions, std::vector<unsigned int>& indices);
+
+    // axis-aligned bounds in object space, kept after releaseCpuData()
+    void getBounds(float min[3], float max[3]) const;
+
+    // free all vertex and index arrays once they are uploaded; counts and bounds remain
+    void releaseCpuData();
+
+    // draw in VertexArray mode, like Sphere (compatibility profile only)
+    void draw() const;                                  // draw surface
+    void drawLines(const float lineColor[4]) const;     // draw lines only
+    void drawWithLines(const float lineColor[4]) const; // draw surface and lines
+
+    // debug
+    void printSelf() const;
+
+protected:
+
+private:
+    // member functions
+    void buildVertices();
+    void buildOutputs();
+    void buildSeparateVertices();
+    void updateVertices();
+    void clearArrays();
+
+    // memeber vars
+    float radius;
+    int frequency;                          // # of segments per icosahedron edge
+    unsigned int outputs;                   // MeshOutput flags
+    unsigned int vertexCount;
+    unsigned int indexCount;
+    unsigned int lineIndexCount;
+    std::pmr::vector<float> vertices;
+    std::pmr::vector<float> normals;
+    std::pmr::vector<float> texCoords;
+    std::pmr::vector<unsigned int> indices;
+    std::pmr::vector<unsigned int> lineIndices;
+
+    // interleaved
+    std::pmr::vector<float> interleavedVertices;
+    int interleavedStride;                  // # of bytes to hop to the next vertex (should be 32 bytes)
+
+};
+
+#endif
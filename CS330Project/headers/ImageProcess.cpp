@@ -0,0 +1,390 @@
+///////////////////////////////////////////////////////////////////////////////
+// ImageProcess.cpp
+// ================
+// CPU preprocessing of decoded 8-bit images before they are uploaded.
+//
+// SIMD paths are selected at compile time:
+// - SSE2 : always on x64 (MSVC and GCC), and on x86 with /arch:SSE2 or -msse2
+// - SSSE3: with -mssse3 or when AVX2 is enabled (byte shuffles for RGB->RGBA)
+// - AVX2 : with /arch:AVX2 or -mavx2
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include "ImageProcess.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define IMAGE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__SSSE3__) || defined(__AVX2__)
+#define IMAGE_SSSE3 1
+#include <tmmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define IMAGE_AVX2 1
+#include <immintrin.h>
+#endif
+
+
+
+// constants //////////////////////////////////////////////////////////////////
+const std::size_t IMAGE_ALIGNMENT = 32;
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// swap two rows of n bytes
+///////////////////////////////////////////////////////////////////////////////
+static void swapRows(unsigned char* a, unsigned char* b, std::size_t n)
+{
+    std::size_t i = 0;
+
+#if IMAGE_AVX2
+    for(; i + 32 <= n; i += 32)
+    {
+        __m256i va = _mm256_loadu_si256((const __m256i*)(a + i));
+        __m256i vb = _mm256_loadu_si256((const __m256i*)(b + i));
+        _mm256_storeu_si256((__m256i*)(a + i), vb);
+        _mm256_storeu_si256((__m256i*)(b + i), va);
+    }
+#endif
+
+#if IMAGE_SSE2
+    for(; i + 16 <= n; i += 16)
+    {
+        __m128i va = _mm_loadu_si128((const __m128i*)(a + i));
+        __m128i vb = _mm_loadu_si128((const __m128i*)(b + i));
+        _mm_storeu_si128((__m128i*)(a + i), vb);
+        _mm_storeu_si128((__m128i*)(b + i), va);
+    }
+#endif
+
+    for(; i < n; ++i)
+    {
+        unsigned char tmp = a[i];
+        a[i] = b[i];
+        b[i] = tmp;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// flip the image vertically by swapping whole rows
+///////////////////////////////////////////////////////////////////////////////
+void flipImageRows(unsigned char* image, std::size_t rowBytes, int height)
+{
+    for(int j = 0; j < height / 2; ++j)
+        swapRows(image + j * rowBytes, image + (height - 1 - j) * rowBytes, rowBytes);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// expand tightly packed RGB to RGBA with alpha = 255
+// the SSSE3 path converts 4 pixels per shuffle; a 16 byte load reads 12 bytes
+// of the 4 pixels plus 4 bytes ahead, so it stops 2 pixels before the end
+///////////////////////////////////////////////////////////////////////////////
+void expandRGBToRGBA(const unsigned char* rgb, unsigned char* rgba, std::size_t pixelCount)
+{
+    std::size_t i = 0;
+
+#if IMAGE_SSSE3
+    const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+    const __m128i alpha = _mm_set1_epi32((int)0xff000000);
+    for(; i + 6 <= pixelCount; i += 4)
+    {
+        __m128i in = _mm_loadu_si128((const __m128i*)(rgb + i * 3));
+        __m128i out = _mm_or_si128(_mm_shuffle_epi8(in, shuffle), alpha);
+        _mm_storeu_si128((__m128i*)(rgba + i * 4), out);
+    }
+#endif
+
+    for(; i < pixelCount; ++i)
+    {
+        rgba[i*4]   = rgb[i*3];
+        rgba[i*4+1] = rgb[i*3+1];
+        rgba[i*4+2] = rgb[i*3+2];
+        rgba[i*4+3] = 255;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// premultiply colour by alpha: c = round(c * a / 255)
+///////////////////////////////////////////////////////////////////////////////
+void premultiplyAlpha(unsigned char* rgba, std::size_t pixelCount)
+{
+    std::size_t i = 0;
+
+#if IMAGE_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i half = _mm_set1_epi16(128);
+    const __m128i alphaMask = _mm_set1_epi32((int)0xff000000);
+    for(; i + 4 <= pixelCount; i += 4)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i*)(rgba + i * 4));
+
+        // widen to 16 bits, 2 pixels per register
+        __m128i lo = _mm_unpacklo_epi8(pixels, zero);
+        __m128i hi = _mm_unpackhi_epi8(pixels, zero);
+
+        // broadcast each pixel's alpha over its 4 lanes
+        __m128i alphaLo = _mm_shufflehi_epi16(_mm_shufflelo_epi16(lo, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3));
+        __m128i alphaHi = _mm_shufflehi_epi16(_mm_shufflelo_epi16(hi, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3));
+
+        // t = c * a + 128; c = (t + (t >> 8)) >> 8   (exact rounding of c * a / 255)
+        lo = _mm_add_epi16(_mm_mullo_epi16(lo, alphaLo), half);
+        hi = _mm_add_epi16(_mm_mullo_epi16(hi, alphaHi), half);
+        lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+        hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+        // keep the original alpha bytes
+        __m128i result = _mm_packus_epi16(lo, hi);
+        result = _mm_or_si128(_mm_andnot_si128(alphaMask, result), _mm_and_si128(alphaMask, pixels));
+        _mm_storeu_si128((__m128i*)(rgba + i * 4), result);
+    }
+#endif
+
+    for(; i < pixelCount; ++i)
+    {
+        unsigned int a = rgba[i*4+3];
+        for(int c = 0; c < 3; ++c)
+        {
+            unsigned int t = rgba[i*4+c] * a + 128;
+            rgba[i*4+c] = (unsigned char)((t + (t >> 8)) >> 8);
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// halve an RGBA image with a separable [1 3 3 1] / 8 filter
+// (the 2x downsampling tent filter; smoother than a 2x2 box and still cheap)
+// taps outside of the image are clamped to the border
+// the loops are written over whole rows of bytes so the compiler can vectorise them
+///////////////////////////////////////////////////////////////////////////////
+void downsampleRGBA(const unsigned char* src, int width, int height,
+                    unsigned char* dst, int dstWidth, int dstHeight)
+{
+    std::size_t rowBytes = (std::size_t)dstWidth * 4;
+    std::vector<unsigned short> rows[4];
+    for(int r = 0; r < 4; ++r)
+        rows[r].resize(rowBytes);
+
+    for(int y = 0; y < dstHeight; ++y)
+    {
+        // horizontal pass of the 4 source rows under this output row
+        for(int r = 0; r < 4; ++r)
+        {
+            int sy = y * 2 - 1 + r;
+            if(sy < 0) sy = 0;
+            if(sy >= height) sy = height - 1;
+            const unsigned char* row = src + (std::size_t)sy * width * 4;
+            unsigned short* out = rows[r].data();
+
+            for(int x = 0; x < dstWidth; ++x)
+            {
+                int x0 = x * 2 - 1, x1 = x * 2, x2 = x * 2 + 1, x3 = x * 2 + 2;
+                if(x0 < 0) x0 = 0;
+                if(x1 >= width) x1 = width - 1;
+                if(x2 >= width) x2 = width - 1;
+                if(x3 >= width) x3 = width - 1;
+                for(int c = 0; c < 4; ++c)
+                {
+                    out[x*4+c] = (unsigned short)(row[x0*4+c] + 3 * (row[x1*4+c] + row[x2*4+c]) + row[x3*4+c]);
+                }
+            }
+        }
+
+        // vertical pass; the 2D weights sum to 64
+        const unsigned short* r0 = rows[0].data();
+        const unsigned short* r1 = rows[1].data();
+        const unsigned short* r2 = rows[2].data();
+        const unsigned short* r3 = rows[3].data();
+        unsigned char* out = dst + (std::size_t)y * rowBytes;
+        for(std::size_t i = 0; i < rowBytes; ++i)
+        {
+            unsigned int value = r0[i] + 3u * (r1[i] + r2[i]) + r3[i];
+            out[i] = (unsigned char)((value + 32) >> 6);
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// resample an RGBA image to any size. each output texel averages a grid of
+// bilinear taps spread over its footprint in the source, so shrinking by more
+// than 2x does not skip texels (and alias) the way a single bilinear tap does
+///////////////////////////////////////////////////////////////////////////////
+void resampleRGBA(const unsigned char* src, int width, int height,
+                  unsigned char* dst, int dstWidth, int dstHeight)
+{
+    float scaleX = (float)width / dstWidth;
+    float scaleY = (float)height / dstHeight;
+    int tapsX = (width + dstWidth - 1) / dstWidth;
+    int tapsY = (height + dstHeight - 1) / dstHeight;
+    float tapWeight = 1.0f / (tapsX * tapsY);
+
+    for(int y = 0; y < dstHeight; ++y)
+    {
+        for(int x = 0; x < dstWidth; ++x)
+        {
+            float sum[4] = { 0, 0, 0, 0 };
+            for(int ty = 0; ty < tapsY; ++ty)
+            {
+                // sample at the centre of each tap
+                float sy = (y + (ty + 0.5f) / tapsY) * scaleY - 0.5f;
+                if(sy < 0) sy = 0;
+                int y0 = (int)sy;
+                int y1 = (y0 + 1 < height) ? y0 + 1 : y0;
+                float fy = sy - y0;
+
+                for(int tx = 0; tx < tapsX; ++tx)
+                {
+                    float sx = (x + (tx + 0.5f) / tapsX) * scaleX - 0.5f;
+                    if(sx < 0) sx = 0;
+                    int x0 = (int)sx;
+                    int x1 = (x0 + 1 < width) ? x0 + 1 : x0;
+                    float fx = sx - x0;
+
+                    const unsigned char* p00 = src + ((std::size_t)y0 * width + x0) * 4;
+                    const unsigned char* p01 = src + ((std::size_t)y0 * width + x1) * 4;
+                    const unsigned char* p10 = src + ((std::size_t)y1 * width + x0) * 4;
+                    const unsigned char* p11 = src + ((std::size_t)y1 * width + x1) * 4;
+                    for(int c = 0; c < 4; ++c)
+                    {
+                        float top = p00[c] + (p01[c] - p00[c]) * fx;
+                        float bottom = p10[c] + (p11[c] - p10[c]) * fx;
+                        sum[c] += top + (bottom - top) * fy;
+                    }
+                }
+            }
+
+            for(int c = 0; c < 4; ++c)
+                dst[c] = (unsigned char)(sum[c] * tapWeight + 0.5f);
+            dst += 4;
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// round to the nearest power of two, clamped to [1, maxSize]
+///////////////////////////////////////////////////////////////////////////////
+int nearestPowerOfTwo(int size, int maxSize)
+{
+    int pot = 1;
+    while(pot < size && pot < maxSize)
+        pot *= 2;
+
+    // pick the lower power of two when it is closer
+    if(pot > 1 && pot - size > size - pot / 2)
+        pot /= 2;
+    return pot;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// convert a decoded image into upload-ready RGBA8 levels
+///////////////////////////////////////////////////////////////////////////////
+bool PreparedImage::prepare(const unsigned char* image, int width, int height, int channels,
+                            unsigned int flags)
+{
+    clear();
+    if(!image || width <= 0 || height <= 0 || (channels != 3 && channels != 4))
+        return false;
+
+    alpha = (channels == 4);
+
+    // lay out all levels first so the whole chain is one allocation
+    std::size_t size = 0;
+    int w = width, h = height;
+    while(true)
+    {
+        ImageLevel level;
+        level.width = w;
+        level.height = h;
+        level.offset = size;
+        levels.push_back(level);
+
+        std::size_t levelSize = (std::size_t)w * h * 4;
+        size += (levelSize + IMAGE_ALIGNMENT - 1) & ~(IMAGE_ALIGNMENT - 1);
+
+        if(!(flags & IMAGE_BUILD_MIPS) || (w == 1 && h == 1))
+            break;
+        w = w > 1 ? w / 2 : 1;
+        h = h > 1 ? h / 2 : 1;
+    }
+
+    storage.resize(size + IMAGE_ALIGNMENT);
+    base = (IMAGE_ALIGNMENT - ((std::size_t)storage.data() & (IMAGE_ALIGNMENT - 1))) & (IMAGE_ALIGNMENT - 1);
+
+    // level 0
+    unsigned char* pixels = levelPixels(0);
+    std::size_t pixelCount = (std::size_t)width * height;
+    if(channels == 3)
+        expandRGBToRGBA(image, pixels, pixelCount);
+    else
+        memcpy(pixels, image, pixelCount * 4);
+
+    if(flags & IMAGE_FLIP_VERTICAL)
+        flipImageRows(pixels, (std::size_t)width * 4, height);
+
+    if(alpha && (flags & IMAGE_PREMULTIPLY_ALPHA))
+        premultiplyAlpha(pixels, pixelCount);
+
+    // mip chain, each level filtered from the previous one
+    for(std::size_t i = 1; i < levels.size(); ++i)
+    {
+        downsampleRGBA(levelPixels((int)i - 1), levels[i-1].width, levels[i-1].height,
+                       levelPixels((int)i), levels[i].width, levels[i].height);
+    }
+
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// replace the levels with a chain that starts at width x height, resampled
+// from the smallest level that is not smaller than it
+///////////////////////////////////////////////////////////////////////////////
+bool PreparedImage::resize(int width, int height, unsigned int flags)
+{
+    if(levels.empty() || width <= 0 || height <= 0)
+        return false;
+
+    int level = 0;
+    while(level + 1 < getLevelCount() && getWidth(level + 1) >= width && getHeight(level + 1) >= height)
+        ++level;
+
+    std::vector<unsigned char> resized((std::size_t)width * height * 4);
+    resampleRGBA(getPixels(level), getWidth(level), getHeight(level), resized.data(), width, height);
+
+    // the pixels are already flipped and premultiplied
+    bool hadAlpha = alpha;
+    prepare(resized.data(), width, height, 4, flags & IMAGE_BUILD_MIPS);
+    alpha = hadAlpha;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// dealloc
+///////////////////////////////////////////////////////////////////////////////
+void PreparedImage::clear()
+{
+    std::vector<ImageLevel>().swap(levels);
+    std::vector<unsigned char>().swap(storage);
+    base = 0;
+    alpha = false;
+}
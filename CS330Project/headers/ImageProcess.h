@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+// ImageProcess.h
+// ==============
+// CPU preprocessing of decoded 8-bit images before they are uploaded.
+// The kernels use SSE2 (and AVX2/SSSE3 when the compiler targets them) with
+// scalar fallbacks, and are safe to call from loader worker threads.
+// - flipImageRows()     : vertical flip by swapping whole rows
+// - expandRGBToRGBA()   : tightly packed RGB -> RGBA with opaque alpha
+// - premultiplyAlpha()  : rgb *= a / 255
+// - downsampleRGBA()    : half-size mip level with a separable [1 3 3 1] filter
+// - resampleRGBA()      : any size, bilinear taps averaged over each output
+//                         texel's footprint (a box prefilter when shrinking)
+//
+// PreparedImage chains them and stores every mip level as RGBA8 in one
+// 32-byte aligned allocation, ready for glTexImage2D with the default
+// GL_UNPACK_ALIGNMENT of 4.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef IMAGE_PROCESS_H
+#define IMAGE_PROCESS_H
+
+#include <cstddef>
+#include <vector>
+
+// flags for PreparedImage::prepare()
+const unsigned int IMAGE_FLIP_VERTICAL     = 0x1;  // flip to the OpenGL texture origin
+const unsigned int IMAGE_PREMULTIPLY_ALPHA = 0x2;  // premultiply images that have an alpha channel
+const unsigned int IMAGE_BUILD_MIPS        = 0x4;  // build the full mip chain down to 1x1
+
+// kernels
+void flipImageRows(unsigned char* image, std::size_t rowBytes, int height);
+void expandRGBToRGBA(const unsigned char* rgb, unsigned char* rgba, std::size_t pixelCount);
+void premultiplyAlpha(unsigned char* rgba, std::size_t pixelCount);
+void downsampleRGBA(const unsigned char* src, int width, int height,
+                    unsigned char* dst, int dstWidth, int dstHeight);
+void resampleRGBA(const unsigned char* src, int width, int height,
+                  unsigned char* dst, int dstWidth, int dstHeight);
+
+// nearest power of two, clamped to [1, maxSize] (maxSize a power of two)
+int nearestPowerOfTwo(int size, int maxSize);
+
+// one mip level inside a PreparedImage
+struct ImageLevel
+{
+    int width;
+    int height;
+    std::size_t offset;     // byte offset from PreparedImage::getPixels(0)
+};
+
+class PreparedImage
+{
+public:
+    // ctor/dtor
+    PreparedImage() : base(0), alpha(false) {}
+    ~PreparedImage() {}
+
+    // convert a decoded image with 3 or 4 channels into upload-ready RGBA8 levels
+    bool prepare(const unsigned char* image, int width, int height, int channels, unsigned int flags);
+    // resample to a new level 0 from the smallest level that covers it; flags: IMAGE_BUILD_MIPS
+    bool resize(int width, int height, unsigned int flags);
+    void clear();
+
+    int getLevelCount() const                   { return (int)levels.size(); }
+    int getWidth(int level) const               { return levels[level].width; }
+    int getHeight(int level) const              { return levels[level].height; }
+    std::size_t getLevelSize(int level) const   { return (std::size_t)levels[level].width * levels[level].height * 4; }
+    bool hasAlpha() const                       { return alpha; }
+    const unsigned char* getPixels(int level) const { return &storage[base + levels[level].offset]; }
+
+private:
+    unsigned char* levelPixels(int level)       { return &storage[base + levels[level].offset]; }
+
+    std::vector<ImageLevel> levels;
+    std::vector<unsigned char> storage;
+    std::size_t base;                           // offset of the first 32-byte aligned byte
+    bool alpha;
+};
+
+#endif
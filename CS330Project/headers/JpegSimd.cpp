@@ -0,0 +1,707 @@
+///////////////////////////////////////////////////////////////////////////////
+// JpegSimd.cpp
+// ============
+// IDCT and YCbCr->RGB kernels for the stb_image_aug.c hooks.
+//
+// IDCT: the decoder's integer IDCT (jidctint, 12-bit constants), dequantizing
+//       on the fly.
+//       SSE2 works on 8 x 16-bit lanes and widens to 32 bits through
+//       _mm_madd_epi16 (same scheme as stb_image 2.x). It is exact as long
+//       as the dequantized coefficients fit in 16 bits, which holds for
+//       baseline JPEG (11-bit coefficients).
+//       AVX2 keeps a whole row of 8 x 32-bit values per register and
+//       repeats the C arithmetic exactly.
+// YCbCr: the decoder's 16.16 fixed point conversion. Multipliers larger than
+//       1 are split into a shift and a 16-bit remainder so _mm_madd_epi16
+//       does the cb/cr products in 32 bits with no loss.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cstring>
+#include "JpegSimd.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JPEG_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define JPEG_AVX2 1
+#include <immintrin.h>
+#endif
+
+
+
+// constants //////////////////////////////////////////////////////////////////
+// same rounding as the decoder's f2f() and float2fixed() macros
+#define JPEG_F2F(x)        ((int)((x) * 4096 + 0.5))
+#define JPEG_FLOAT2FIXED(x) ((int)((x) * 65536 + 0.5))
+
+// rounding added before the final shifts; the row pass also folds in the +128
+// level shift that the decoder's clamp() applies
+const int IDCT_COLUMN_BIAS = 512;
+const int IDCT_ROW_BIAS = 65536 + (128 << 17);
+const int IDCT_COLUMN_SHIFT = 10;
+const int IDCT_ROW_SHIFT = 17;
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// clamp to a byte
+///////////////////////////////////////////////////////////////////////////////
+static inline unsigned char clampByte(int x)
+{
+    if((unsigned int)x > 255)
+        return x < 0 ? 0 : 255;
+    return (unsigned char)x;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// 1D integer IDCT of 8 samples (IDCT_1D in stb_image_aug.c)
+///////////////////////////////////////////////////////////////////////////////
+static inline void idct1D(const int s[8], int bias, int shift, int out[8])
+{
+    // even part
+    int p1 = (s[2] + s[6]) * JPEG_F2F(0.5411961f);
+    int t2 = p1 + s[6] * JPEG_F2F(-1.847759065f);
+    int t3 = p1 + s[2] * JPEG_F2F(0.765366865f);
+    int t0 = (s[0] + s[4]) << 12;
+    int t1 = (s[0] - s[4]) << 12;
+    int x0 = t0 + t3 + bias;
+    int x3 = t0 - t3 + bias;
+    int x1 = t1 + t2 + bias;
+    int x2 = t1 - t2 + bias;
+
+    // odd part
+    t0 = s[7];
+    t1 = s[5];
+    t2 = s[3];
+    t3 = s[1];
+    int p3 = t0 + t2;
+    int p4 = t1 + t3;
+    p1 = t0 + t3;
+    int p2 = t1 + t2;
+    int p5 = (p3 + p4) * JPEG_F2F(1.175875602f);
+    t0 *= JPEG_F2F(0.298631336f);
+    t1 *= JPEG_F2F(2.053119869f);
+    t2 *= JPEG_F2F(3.072711026f);
+    t3 *= JPEG_F2F(1.501321110f);
+    p1 = p5 + p1 * JPEG_F2F(-0.899976223f);
+    p2 = p5 + p2 * JPEG_F2F(-2.562915447f);
+    p3 *= JPEG_F2F(-1.961570560f);
+    p4 *= JPEG_F2F(-0.390180644f);
+    t3 += p1 + p4;
+    t2 += p2 + p3;
+    t1 += p2 + p4;
+    t0 += p1 + p3;
+
+    out[0] = (x0 + t3) >> shift;
+    out[7] = (x0 - t3) >> shift;
+    out[1] = (x1 + t2) >> shift;
+    out[6] = (x1 - t2) >> shift;
+    out[2] = (x2 + t1) >> shift;
+    out[5] = (x2 - t1) >> shift;
+    out[3] = (x3 + t0) >> shift;
+    out[4] = (x3 - t0) >> shift;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// scalar IDCT, a copy of the decoder's idct_block() for the STBI_SIMD build
+///////////////////////////////////////////////////////////////////////////////
+static void idctScalar(unsigned char* out, int out_stride, short data[64], unsigned short* dequantize)
+{
+    int val[64];
+
+    // columns
+    for(int i = 0; i < 8; ++i)
+    {
+        const short* d = data + i;
+        const unsigned short* dq = dequantize + i;
+
+        // all AC terms zero: the column is flat
+        if(d[8] == 0 && d[16] == 0 && d[24] == 0 && d[32] == 0 && d[40] == 0 && d[48] == 0 && d[56] == 0)
+        {
+            int dcterm = d[0] * dq[0] << 2;
+            for(int j = 0; j < 8; ++j)
+                val[j*8+i] = dcterm;
+            continue;
+        }
+
+        int s[8], v[8];
+        for(int j = 0; j < 8; ++j)
+            s[j] = d[j*8] * dq[j*8];
+        idct1D(s, IDCT_COLUMN_BIAS, IDCT_COLUMN_SHIFT, v);
+        for(int j = 0; j < 8; ++j)
+            val[j*8+i] = v[j];
+    }
+
+    // rows
+    for(int i = 0; i < 8; ++i, out += out_stride)
+    {
+        int v[8];
+        idct1D(val + i * 8, IDCT_ROW_BIAS, IDCT_ROW_SHIFT, v);
+        for(int j = 0; j < 8; ++j)
+            out[j] = clampByte(v[j]);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// scalar colour conversion, a copy of the decoder's YCbCr_to_RGB_row()
+///////////////////////////////////////////////////////////////////////////////
+static void yCbCrToRGBScalar(unsigned char* out, unsigned char const* y, unsigned char const* pcb,
+                             unsigned char const* pcr, int count, int step)
+{
+    for(int i = 0; i < count; ++i)
+    {
+        int yFixed = (y[i] << 16) + 32768; // rounding
+        int cr = pcr[i] - 128;
+        int cb = pcb[i] - 128;
+        int r = yFixed + cr * JPEG_FLOAT2FIXED(1.40200f);
+        int g = yFixed - cr * JPEG_FLOAT2FIXED(0.71414f) - cb * JPEG_FLOAT2FIXED(0.34414f);
+        int b = yFixed + cb * JPEG_FLOAT2FIXED(1.77200f);
+        out[0] = clampByte(r >> 16);
+        out[1] = clampByte(g >> 16);
+        out[2] = clampByte(b >> 16);
+        if(step == 4)
+            out[3] = 255;
+        out += step;
+    }
+}
+
+
+
+#if JPEG_SSE2
+///////////////////////////////////////////////////////////////////////////////
+// SSE2 helpers for the IDCT; a Wide holds 8 x 32-bit values
+///////////////////////////////////////////////////////////////////////////////
+struct Wide
+{
+    __m128i lo, hi;
+};
+
+// dot product constant: even lanes = x, odd lanes = y
+static inline __m128i dctConst(int x, int y)
+{
+    return _mm_setr_epi16((short)x, (short)y, (short)x, (short)y, (short)x, (short)y, (short)x, (short)y);
+}
+
+// out0 = x * c0[even] + y * c0[odd], out1 likewise with c1 (32-bit results)
+static inline void dctRotate(__m128i x, __m128i y, __m128i c0, __m128i c1, Wide& out0, Wide& out1)
+{
+    __m128i lo = _mm_unpacklo_epi16(x, y);
+    __m128i hi = _mm_unpackhi_epi16(x, y);
+    out0.lo = _mm_madd_epi16(lo, c0);
+    out0.hi = _mm_madd_epi16(hi, c0);
+    out1.lo = _mm_madd_epi16(lo, c1);
+    out1.hi = _mm_madd_epi16(hi, c1);
+}
+
+// in << 12, widened to 32 bits
+static inline Wide dctWiden(__m128i in)
+{
+    Wide out;
+    out.lo = _mm_srai_epi32(_mm_unpacklo_epi16(_mm_setzero_si128(), in), 4);
+    out.hi = _mm_srai_epi32(_mm_unpackhi_epi16(_mm_setzero_si128(), in), 4);
+    return out;
+}
+
+static inline Wide dctAdd(const Wide& a, const Wide& b)
+{
+    Wide out;
+    out.lo = _mm_add_epi32(a.lo, b.lo);
+    out.hi = _mm_add_epi32(a.hi, b.hi);
+    return out;
+}
+
+static inline Wide dctSub(const Wide& a, const Wide& b)
+{
+    Wide out;
+    out.lo = _mm_sub_epi32(a.lo, b.lo);
+    out.hi = _mm_sub_epi32(a.hi, b.hi);
+    return out;
+}
+
+// out0 = (a + bias + b) >> shift, out1 = (a + bias - b) >> shift, packed to 16 bits
+static inline void dctButterfly(const Wide& a, const Wide& b, __m128i bias, __m128i shift,
+                                __m128i& out0, __m128i& out1)
+{
+    __m128i lo = _mm_add_epi32(a.lo, bias);
+    __m128i hi = _mm_add_epi32(a.hi, bias);
+    out0 = _mm_packs_epi32(_mm_sra_epi32(_mm_add_epi32(lo, b.lo), shift), _mm_sra_epi32(_mm_add_epi32(hi, b.hi), shift));
+    out1 = _mm_packs_epi32(_mm_sra_epi32(_mm_sub_epi32(lo, b.lo), shift), _mm_sra_epi32(_mm_sub_epi32(hi, b.hi), shift));
+}
+
+static inline void interleave16(__m128i& a, __m128i& b)
+{
+    __m128i tmp = a;
+    a = _mm_unpacklo_epi16(a, b);
+    b = _mm_unpackhi_epi16(tmp, b);
+}
+
+static inline void interleave8(__m128i& a, __m128i& b)
+{
+    __m128i tmp = a;
+    a = _mm_unpacklo_epi8(a, b);
+    b = _mm_unpackhi_epi8(tmp, b);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// one 1D pass over the 8 rows; every lane is an independent column
+///////////////////////////////////////////////////////////////////////////////
+static inline void idctPassSSE2(__m128i row[8], __m128i bias, __m128i shift)
+{
+    const __m128i rot0_0 = dctConst(JPEG_F2F(0.5411961f), JPEG_F2F(0.5411961f) + JPEG_F2F(-1.847759065f));
+    const __m128i rot0_1 = dctConst(JPEG_F2F(0.5411961f) + JPEG_F2F(0.765366865f), JPEG_F2F(0.5411961f));
+    const __m128i rot1_0 = dctConst(JPEG_F2F(1.175875602f) + JPEG_F2F(-0.899976223f), JPEG_F2F(1.175875602f));
+    const __m128i rot1_1 = dctConst(JPEG_F2F(1.175875602f), JPEG_F2F(1.175875602f) + JPEG_F2F(-2.562915447f));
+    const __m128i rot2_0 = dctConst(JPEG_F2F(-1.961570560f) + JPEG_F2F(0.298631336f), JPEG_F2F(-1.961570560f));
+    const __m128i rot2_1 = dctConst(JPEG_F2F(-1.961570560f), JPEG_F2F(-1.961570560f) + JPEG_F2F(3.072711026f));
+    const __m128i rot3_0 = dctConst(JPEG_F2F(-0.390180644f) + JPEG_F2F(2.053119869f), JPEG_F2F(-0.390180644f));
+    const __m128i rot3_1 = dctConst(JPEG_F2F(-0.390180644f), JPEG_F2F(-0.390180644f) + JPEG_F2F(1.501321110f));
+
+    // even part
+    Wide t2e, t3e;
+    dctRotate(row[2], row[6], rot0_0, rot0_1, t2e, t3e);
+    Wide t0e = dctWiden(_mm_add_epi16(row[0], row[4]));
+    Wide t1e = dctWiden(_mm_sub_epi16(row[0], row[4]));
+    Wide x0 = dctAdd(t0e, t3e);
+    Wide x3 = dctSub(t0e, t3e);
+    Wide x1 = dctAdd(t1e, t2e);
+    Wide x2 = dctSub(t1e, t2e);
+
+    // odd part
+    Wide y0o, y1o, y2o, y3o, y4o, y5o;
+    dctRotate(row[7], row[3], rot2_0, rot2_1, y0o, y2o);
+    dctRotate(row[5], row[1], rot3_0, rot3_1, y1o, y3o);
+    dctRotate(_mm_add_epi16(row[1], row[7]), _mm_add_epi16(row[3], row[5]), rot1_0, rot1_1, y4o, y5o);
+    Wide x4 = dctAdd(y0o, y4o);
+    Wide x5 = dctAdd(y1o, y5o);
+    Wide x6 = dctAdd(y2o, y5o);
+    Wide x7 = dctAdd(y3o, y4o);
+
+    dctButterfly(x0, x7, bias, shift, row[0], row[7]);
+    dctButterfly(x1, x6, bias, shift, row[1], row[6]);
+    dctButterfly(x2, x5, bias, shift, row[2], row[5]);
+    dctButterfly(x3, x4, bias, shift, row[3], row[4]);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SSE2 IDCT: dequantize, column pass, 16-bit transpose, row pass, then pack
+// to bytes and transpose back while storing
+///////////////////////////////////////////////////////////////////////////////
+static void idctSSE2(unsigned char* out, int out_stride, short data[64], unsigned short* dequantize)
+{
+    __m128i row[8];
+    for(int i = 0; i < 8; ++i)
+    {
+        row[i] = _mm_mullo_epi16(_mm_loadu_si128((const __m128i*)(data + i * 8)),
+                                 _mm_loadu_si128((const __m128i*)(dequantize + i * 8)));
+    }
+
+    idctPassSSE2(row, _mm_set1_epi32(IDCT_COLUMN_BIAS), _mm_cvtsi32_si128(IDCT_COLUMN_SHIFT));
+
+    // 8x8 16-bit transpose
+    interleave16(row[0], row[4]);
+    interleave16(row[1], row[5]);
+    interleave16(row[2], row[6]);
+    interleave16(row[3], row[7]);
+    interleave16(row[0], row[2]);
+    interleave16(row[1], row[3]);
+    interleave16(row[4], row[6]);
+    interleave16(row[5], row[7]);
+    interleave16(row[0], row[1]);
+    interleave16(row[2], row[3]);
+    interleave16(row[4], row[5]);
+    interleave16(row[6], row[7]);
+
+    idctPassSSE2(row, _mm_set1_epi32(IDCT_ROW_BIAS), _mm_cvtsi32_si128(IDCT_ROW_SHIFT));
+
+    // packus clamps to 0..255; the results are transposed, so transpose the bytes back
+    __m128i p0 = _mm_packus_epi16(row[0], row[1]);
+    __m128i p1 = _mm_packus_epi16(row[2], row[3]);
+    __m128i p2 = _mm_packus_epi16(row[4], row[5]);
+    __m128i p3 = _mm_packus_epi16(row[6], row[7]);
+    interleave8(p0, p2);
+    interleave8(p1, p3);
+    interleave8(p0, p1);
+    interleave8(p2, p3);
+    interleave8(p0, p2);
+    interleave8(p1, p3);
+
+    _mm_storel_epi64((__m128i*)out, p0);                              out += out_stride;
+    _mm_storel_epi64((__m128i*)out, _mm_shuffle_epi32(p0, 0x4e));     out += out_stride;
+    _mm_storel_epi64((__m128i*)out, p2);                              out += out_stride;
+    _mm_storel_epi64((__m128i*)out, _mm_shuffle_epi32(p2, 0x4e));     out += out_stride;
+    _mm_storel_epi64((__m128i*)out, p1);                              out += out_stride;
+    _mm_storel_epi64((__m128i*)out, _mm_shuffle_epi32(p1, 0x4e));     out += out_stride;
+    _mm_storel_epi64((__m128i*)out, p3);                              out += out_stride;
+    _mm_storel_epi64((__m128i*)out, _mm_shuffle_epi32(p3, 0x4e));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// write 4 RGBA pixels as RGB. every pixel is stored with 4 bytes and the next
+// one overwrites the extra byte, so the caller must have at least one more
+// pixel to write after these 4
+///////////////////////////////////////////////////////////////////////////////
+static inline void storeRGBOverlapped(unsigned char* out, __m128i rgba)
+{
+    for(int i = 0; i < 4; ++i)
+    {
+        int pixel = _mm_cvtsi128_si32(rgba);
+        memcpy(out + i * 3, &pixel, 4);
+        rgba = _mm_srli_si128(rgba, 4);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// SSE2 colour conversion, 8 pixels per iteration
+///////////////////////////////////////////////////////////////////////////////
+static void yCbCrToRGBSSE2(unsigned char* out, unsigned char const* y, unsigned char const* pcb,
+                           unsigned char const* pcr, int count, int step)
+{
+    // r = y + 1.402 cr              = (y + cr)  + cr * (1.402 - 1)
+    // g = y - 0.714 cr - 0.344 cb   = (y - cr)  + cr * (1 - 0.714) - cb * 0.344
+    // b = y + 1.772 cb              = (y + 2cb) - cb * (2 - 1.772)
+    const __m128i rConst = _mm_setr_epi16(JPEG_FLOAT2FIXED(1.40200f) - 65536, 0, JPEG_FLOAT2FIXED(1.40200f) - 65536, 0,
+                                          JPEG_FLOAT2FIXED(1.40200f) - 65536, 0, JPEG_FLOAT2FIXED(1.40200f) - 65536, 0);
+    const __m128i gConst = _mm_setr_epi16(65536 - JPEG_FLOAT2FIXED(0.71414f), -JPEG_FLOAT2FIXED(0.34414f),
+                                          65536 - JPEG_FLOAT2FIXED(0.71414f), -JPEG_FLOAT2FIXED(0.34414f),
+                                          65536 - JPEG_FLOAT2FIXED(0.71414f), -JPEG_FLOAT2FIXED(0.34414f),
+                                          65536 - JPEG_FLOAT2FIXED(0.71414f), -JPEG_FLOAT2FIXED(0.34414f));
+    const __m128i bConst = _mm_setr_epi16(0, JPEG_FLOAT2FIXED(1.77200f) - 131072, 0, JPEG_FLOAT2FIXED(1.77200f) - 131072,
+                                          0, JPEG_FLOAT2FIXED(1.77200f) - 131072, 0, JPEG_FLOAT2FIXED(1.77200f) - 131072);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bias128 = _mm_set1_epi16(128);
+    const __m128i rounding = _mm_set1_epi32(32768);
+    const __m128i alpha = _mm_set1_epi8((char)255);
+
+    int i = 0;
+    int end = (step == 4) ? count - 7 : count - 8; // RGB stores need one pixel to spare
+    for(; i < end; i += 8)
+    {
+        __m128i yw  = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(y + i)), zero);
+        __m128i cbw = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(pcb + i)), zero), bias128);
+        __m128i crw = _mm_sub_epi16(_mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(pcr + i)), zero), bias128);
+
+        // cr/cb pairs for the products; unpacking a word over zero gives it << 16
+        __m128i crcbLo = _mm_unpacklo_epi16(crw, cbw);
+        __m128i crcbHi = _mm_unpackhi_epi16(crw, cbw);
+        __m128i rBase = _mm_add_epi16(yw, crw);
+        __m128i gBase = _mm_sub_epi16(yw, crw);
+        __m128i bBase = _mm_add_epi16(yw, _mm_add_epi16(cbw, cbw));
+
+        __m128i rLo = _mm_add_epi32(_mm_add_epi32(_mm_unpacklo_epi16(zero, rBase), rounding), _mm_madd_epi16(crcbLo, rConst));
+        __m128i rHi = _mm_add_epi32(_mm_add_epi32(_mm_unpackhi_epi16(zero, rBase), rounding), _mm_madd_epi16(crcbHi, rConst));
+        __m128i gLo = _mm_add_epi32(_mm_add_epi32(_mm_unpacklo_epi16(zero, gBase), rounding), _mm_madd_epi16(crcbLo, gConst));
+        __m128i gHi = _mm_add_epi32(_mm_add_epi32(_mm_unpackhi_epi16(zero, gBase), rounding), _mm_madd_epi16(crcbHi, gConst));
+        __m128i bLo = _mm_add_epi32(_mm_add_epi32(_mm_unpacklo_epi16(zero, bBase), rounding), _mm_madd_epi16(crcbLo, bConst));
+        __m128i bHi = _mm_add_epi32(_mm_add_epi32(_mm_unpackhi_epi16(zero, bBase), rounding), _mm_madd_epi16(crcbHi, bConst));
+
+        // >> 16, then the saturating packs clamp to 0..255
+        __m128i r = _mm_packs_epi32(_mm_srai_epi32(rLo, 16), _mm_srai_epi32(rHi, 16));
+        __m128i g = _mm_packs_epi32(_mm_srai_epi32(gLo, 16), _mm_srai_epi32(gHi, 16));
+        __m128i b = _mm_packs_epi32(_mm_srai_epi32(bLo, 16), _mm_srai_epi32(bHi, 16));
+        __m128i rg = _mm_unpacklo_epi8(_mm_packus_epi16(r, r), _mm_packus_epi16(g, g));
+        __m128i ba = _mm_unpacklo_epi8(_mm_packus_epi16(b, b), alpha);
+        __m128i rgba0 = _mm_unpacklo_epi16(rg, ba);
+        __m128i rgba1 = _mm_unpackhi_epi16(rg, ba);
+
+        if(step == 4)
+        {
+            _mm_storeu_si128((__m128i*)(out + i * 4), rgba0);
+            _mm_storeu_si128((__m128i*)(out + i * 4 + 16), rgba1);
+        }
+        else
+        {
+            storeRGBOverlapped(out + i * 3, rgba0);
+            storeRGBOverlapped(out + i * 3 + 12, rgba1);
+        }
+    }
+
+    yCbCrToRGBScalar(out + i * step, y + i, pcb + i, pcr + i, count - i, step);
+}
+#endif // JPEG_SSE2
+
+
+
+#if JPEG_AVX2
+///////////////////////////////////////////////////////////////////////////////
+// transpose 8 rows of 8 x 32-bit values
+///////////////////////////////////////////////////////////////////////////////
+static inline void transpose8x8(__m256i r[8])
+{
+    __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// idct1D() on 8 columns at once, in place
+///////////////////////////////////////////////////////////////////////////////
+static inline void idctPassAVX2(__m256i s[8], __m256i bias, __m128i shift)
+{
+#define JPEG_MUL(a, c) _mm256_mullo_epi32((a), _mm256_set1_epi32(JPEG_F2F(c)))
+
+    // even part
+    __m256i p1 = JPEG_MUL(_mm256_add_epi32(s[2], s[6]), 0.5411961f);
+    __m256i t2 = _mm256_add_epi32(p1, JPEG_MUL(s[6], -1.847759065f));
+    __m256i t3 = _mm256_add_epi32(p1, JPEG_MUL(s[2], 0.765366865f));
+    __m256i t0 = _mm256_slli_epi32(_mm256_add_epi32(s[0], s[4]), 12);
+    __m256i t1 = _mm256_slli_epi32(_mm256_sub_epi32(s[0], s[4]), 12);
+    __m256i x0 = _mm256_add_epi32(_mm256_add_epi32(t0, t3), bias);
+    __m256i x3 = _mm256_add_epi32(_mm256_sub_epi32(t0, t3), bias);
+    __m256i x1 = _mm256_add_epi32(_mm256_add_epi32(t1, t2), bias);
+    __m256i x2 = _mm256_add_epi32(_mm256_sub_epi32(t1, t2), bias);
+
+    // odd part
+    t0 = s[7];
+    t1 = s[5];
+    t2 = s[3];
+    t3 = s[1];
+    __m256i p3 = _mm256_add_epi32(t0, t2);
+    __m256i p4 = _mm256_add_epi32(t1, t3);
+    p1 = _mm256_add_epi32(t0, t3);
+    __m256i p2 = _mm256_add_epi32(t1, t2);
+    __m256i p5 = JPEG_MUL(_mm256_add_epi32(p3, p4), 1.175875602f);
+    t0 = JPEG_MUL(t0, 0.298631336f);
+    t1 = JPEG_MUL(t1, 2.053119869f);
+    t2 = JPEG_MUL(t2, 3.072711026f);
+    t3 = JPEG_MUL(t3, 1.501321110f);
+    p1 = _mm256_add_epi32(p5, JPEG_MUL(p1, -0.899976223f));
+    p2 = _mm256_add_epi32(p5, JPEG_MUL(p2, -2.562915447f));
+    p3 = JPEG_MUL(p3, -1.961570560f);
+    p4 = JPEG_MUL(p4, -0.390180644f);
+    t3 = _mm256_add_epi32(t3, _mm256_add_epi32(p1, p4));
+    t2 = _mm256_add_epi32(t2, _mm256_add_epi32(p2, p3));
+    t1 = _mm256_add_epi32(t1, _mm256_add_epi32(p2, p4));
+    t0 = _mm256_add_epi32(t0, _mm256_add_epi32(p1, p3));
+
+#undef JPEG_MUL
+
+    s[0] = _mm256_sra_epi32(_mm256_add_epi32(x0, t3), shift);
+    s[7] = _mm256_sra_epi32(_mm256_sub_epi32(x0, t3), shift);
+    s[1] = _mm256_sra_epi32(_mm256_add_epi32(x1, t2), shift);
+    s[6] = _mm256_sra_epi32(_mm256_sub_epi32(x1, t2), shift);
+    s[2] = _mm256_sra_epi32(_mm256_add_epi32(x2, t1), shift);
+    s[5] = _mm256_sra_epi32(_mm256_sub_epi32(x2, t1), shift);
+    s[3] = _mm256_sra_epi32(_mm256_add_epi32(x3, t0), shift);
+    s[4] = _mm256_sra_epi32(_mm256_sub_epi32(x3, t0), shift);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AVX2 IDCT: one row of 8 x 32-bit values per register, so both passes run
+// with the full precision of the C version
+///////////////////////////////////////////////////////////////////////////////
+static void idctAVX2(unsigned char* out, int out_stride, short data[64], unsigned short* dequantize)
+{
+    __m256i row[8];
+    for(int i = 0; i < 8; ++i)
+    {
+        __m256i coefficients = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(data + i * 8)));
+        __m256i quantizer = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i*)(dequantize + i * 8)));
+        row[i] = _mm256_mullo_epi32(coefficients, quantizer);
+    }
+
+    idctPassAVX2(row, _mm256_set1_epi32(IDCT_COLUMN_BIAS), _mm_cvtsi32_si128(IDCT_COLUMN_SHIFT));
+    transpose8x8(row);
+    idctPassAVX2(row, _mm256_set1_epi32(IDCT_ROW_BIAS), _mm_cvtsi32_si128(IDCT_ROW_SHIFT));
+    transpose8x8(row);
+
+    // pack 4 rows at a time; the saturating packs clamp to 0..255
+    for(int i = 0; i < 8; i += 4)
+    {
+        __m256i p01 = _mm256_permute4x64_epi64(_mm256_packs_epi32(row[i], row[i+1]), 0xd8);
+        __m256i p23 = _mm256_permute4x64_epi64(_mm256_packs_epi32(row[i+2], row[i+3]), 0xd8);
+        __m256i bytes = _mm256_packus_epi16(p01, p23);       // rows 0,2 | rows 1,3
+        __m128i rows02 = _mm256_castsi256_si128(bytes);
+        __m128i rows13 = _mm256_extracti128_si256(bytes, 1);
+
+        _mm_storel_epi64((__m128i*)out, rows02);                      out += out_stride;
+        _mm_storel_epi64((__m128i*)out, rows13);                      out += out_stride;
+        _mm_storel_epi64((__m128i*)out, _mm_srli_si128(rows02, 8));   out += out_stride;
+        _mm_storel_epi64((__m128i*)out, _mm_srli_si128(rows13, 8));   out += out_stride;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// AVX2 colour conversion, 16 pixels per iteration (see yCbCrToRGBSSE2)
+///////////////////////////////////////////////////////////////////////////////
+static void yCbCrToRGBAVX2(unsigned char* out, unsigned char const* y, unsigned char const* pcb,
+                           unsigned char const* pcr, int count, int step)
+{
+    const __m256i rConst = _mm256_set1_epi32((JPEG_FLOAT2FIXED(1.40200f) - 65536) & 0xffff);
+    const __m256i gConst = _mm256_set1_epi32(((65536 - JPEG_FLOAT2FIXED(0.71414f)) & 0xffff) |
+                                             (-JPEG_FLOAT2FIXED(0.34414f) * 65536));
+    const __m256i bConst = _mm256_set1_epi32((JPEG_FLOAT2FIXED(1.77200f) - 131072) * 65536);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i bias128 = _mm256_set1_epi16(128);
+    const __m256i rounding = _mm256_set1_epi32(32768);
+    const __m256i alpha = _mm256_set1_epi16(255);
+
+    int i = 0;
+    int end = (step == 4) ? count - 15 : count - 16; // RGB stores need one pixel to spare
+    for(; i < end; i += 16)
+    {
+        __m256i yw  = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(y + i)));
+        __m256i cbw = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(pcb + i))), bias128);
+        __m256i crw = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(pcr + i))), bias128);
+
+        // unpacks work per 128-bit lane: lo = pixels 0-3, 8-11, hi = 4-7, 12-15
+        __m256i crcbLo = _mm256_unpacklo_epi16(crw, cbw);
+        __m256i crcbHi = _mm256_unpackhi_epi16(crw, cbw);
+        __m256i rBase = _mm256_add_epi16(yw, crw);
+        __m256i gBase = _mm256_sub_epi16(yw, crw);
+        __m256i bBase = _mm256_add_epi16(yw, _mm256_add_epi16(cbw, cbw));
+
+        __m256i rLo = _mm256_add_epi32(_mm256_add_epi32(_mm256_unpacklo_epi16(zero, rBase), rounding), _mm256_madd_epi16(crcbLo, rConst));
+        __m256i rHi = _mm256_add_epi32(_mm256_add_epi32(_mm256_unpackhi_epi16(zero, rBase), rounding), _mm256_madd_epi16(crcbHi, rConst));
+        __m256i gLo = _mm256_add_epi32(_mm256_add_epi32(_mm256_unpacklo_epi16(zero, gBase), rounding), _mm256_madd_epi16(crcbLo, gConst));
+        __m256i gHi = _mm256_add_epi32(_mm256_add_epi32(_mm256_unpackhi_epi16(zero, gBase), rounding), _mm256_madd_epi16(crcbHi, gConst));
+        __m256i bLo = _mm256_add_epi32(_mm256_add_epi32(_mm256_unpacklo_epi16(zero, bBase), rounding), _mm256_madd_epi16(crcbLo, bConst));
+        __m256i bHi = _mm256_add_epi32(_mm256_add_epi32(_mm256_unpackhi_epi16(zero, bBase), rounding), _mm256_madd_epi16(crcbHi, bConst));
+
+        // packs undo the lane split: 16 words in pixel order
+        __m256i r = _mm256_packs_epi32(_mm256_srai_epi32(rLo, 16), _mm256_srai_epi32(rHi, 16));
+        __m256i g = _mm256_packs_epi32(_mm256_srai_epi32(gLo, 16), _mm256_srai_epi32(gHi, 16));
+        __m256i b = _mm256_packs_epi32(_mm256_srai_epi32(bLo, 16), _mm256_srai_epi32(bHi, 16));
+
+        // per lane: r0-7 g0-7 and b0-7 a0-7 (lane 1 holds pixels 8-15)
+        __m256i rg = _mm256_packus_epi16(r, g);
+        __m256i ba = _mm256_packus_epi16(b, alpha);
+        rg = _mm256_unpacklo_epi8(rg, _mm256_srli_si256(rg, 8));
+        ba = _mm256_unpacklo_epi8(ba, _mm256_srli_si256(ba, 8));
+        __m256i lo = _mm256_unpacklo_epi16(rg, ba);             // pixels 0-3 | 8-11
+        __m256i hi = _mm256_unpackhi_epi16(rg, ba);             // pixels 4-7 | 12-15
+        __m256i rgba0 = _mm256_permute2x128_si256(lo, hi, 0x20);
+        __m256i rgba1 = _mm256_permute2x128_si256(lo, hi, 0x31);
+
+        if(step == 4)
+        {
+            _mm256_storeu_si256((__m256i*)(out + i * 4), rgba0);
+            _mm256_storeu_si256((__m256i*)(out + i * 4 + 32), rgba1);
+        }
+        else
+        {
+            storeRGBOverlapped(out + i * 3,      _mm256_castsi256_si128(rgba0));
+            storeRGBOverlapped(out + i * 3 + 12, _mm256_extracti128_si256(rgba0, 1));
+            storeRGBOverlapped(out + i * 3 + 24, _mm256_castsi256_si128(rgba1));
+            storeRGBOverlapped(out + i * 3 + 36, _mm256_extracti128_si256(rgba1, 1));
+        }
+    }
+
+    yCbCrToRGBScalar(out + i * step, y + i, pcb + i, pcr + i, count - i, step);
+}
+#endif // JPEG_AVX2
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// kernel selection
+///////////////////////////////////////////////////////////////////////////////
+bool hasJpegKernel(JpegKernel kernel)
+{
+    switch(kernel)
+    {
+    case JPEG_KERNEL_SCALAR:
+        return true;
+#if JPEG_SSE2
+    case JPEG_KERNEL_SSE2:
+        return true;
+#endif
+#if JPEG_AVX2
+    case JPEG_KERNEL_AVX2:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+bool installJpegKernel(JpegKernel kernel)
+{
+    switch(kernel)
+    {
+    case JPEG_KERNEL_SCALAR:
+        stbi_install_idct(idctScalar);
+        stbi_install_YCbCr_to_RGB(yCbCrToRGBScalar);
+        return true;
+#if JPEG_SSE2
+    case JPEG_KERNEL_SSE2:
+        stbi_install_idct(idctSSE2);
+        stbi_install_YCbCr_to_RGB(yCbCrToRGBSSE2);
+        return true;
+#endif
+#if JPEG_AVX2
+    case JPEG_KERNEL_AVX2:
+        stbi_install_idct(idctAVX2);
+        stbi_install_YCbCr_to_RGB(yCbCrToRGBAVX2);
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+JpegKernel installJpegSimd()
+{
+    JpegKernel kernel = JPEG_KERNEL_SCALAR;
+    if(hasJpegKernel(JPEG_KERNEL_AVX2))
+        kernel = JPEG_KERNEL_AVX2;
+    else if(hasJpegKernel(JPEG_KERNEL_SSE2))
+        kernel = JPEG_KERNEL_SSE2;
+
+    installJpegKernel(kernel);
+    return kernel;
+}
+
+const char* getJpegKernelName(JpegKernel kernel)
+{
+    switch(kernel)
+    {
+    case JPEG_KERNEL_SSE2: return "SSE2";
+    case JPEG_KERNEL_AVX2: return "AVX2";
+    default:               return "scalar";
+    }
+}
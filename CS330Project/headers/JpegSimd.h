@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////
+// JpegSimd.h
+// ==========
+// SSE2/AVX2 kernels for the installable hooks of the augmented stb_image
+// decoder (stb_image_aug.c, stbi-1.16): the dequantizing 8x8 IDCT and the
+// YCbCr->RGB row conversion. All kernels give bit-identical output to the
+// decoder's own C versions.
+//
+// stb_image_aug.c must be compiled with STBI_SIMD=1 (and STBI_NO_DDS, the DDS
+// add-on is not shipped) for the hooks to exist. It defines the same stbi_*
+// symbols as stb_image.h, so it cannot be linked into the same program as a
+// STB_IMAGE_IMPLEMENTATION; see tools/DecodeBench.cpp.
+//
+// Kernels are selected at compile time like ImageProcess.cpp: SSE2 is always
+// on for x64, AVX2 needs /arch:AVX2 or -mavx2.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef JPEG_SIMD_H
+#define JPEG_SIMD_H
+
+#ifndef STBI_SIMD
+#define STBI_SIMD 1
+#endif
+#include "stb_image_aug.h"
+
+enum JpegKernel
+{
+    JPEG_KERNEL_SCALAR,
+    JPEG_KERNEL_SSE2,
+    JPEG_KERNEL_AVX2
+};
+
+// true if the kernel set was compiled in
+bool hasJpegKernel(JpegKernel kernel);
+
+// install the IDCT and colour conversion of a kernel set into the decoder
+// JPEG_KERNEL_SCALAR installs C copies of the decoder's own functions
+// NOT THREADSAFE (the hooks are globals of the decoder)
+bool installJpegKernel(JpegKernel kernel);
+
+// install the widest kernel set that was compiled in and return it
+JpegKernel installJpegSimd();
+
+const char* getJpegKernelName(JpegKernel kernel);
+
+#endif
@@ -0,0 +1,192 @@
+///////////////////////////////////////////////////////////////////////////////
+// MappedFile.cpp
+// ==============
+// Win32: CreateFileMapping/MapViewOfFile, PrefetchVirtualMemory (Windows 8+)
+// POSIX: mmap/madvise
+///////////////////////////////////////////////////////////////////////////////
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+MappedFile::MappedFile() : data(0), size(0)
+#ifdef _WIN32
+    , fileHandle(INVALID_HANDLE_VALUE), mappingHandle(0)
+#endif
+{
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// dtor
+///////////////////////////////////////////////////////////////////////////////
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+
+
+#ifdef _WIN32
+///////////////////////////////////////////////////////////////////////////////
+// map the whole file read-only
+///////////////////////////////////////////////////////////////////////////////
+bool MappedFile::open(const char* filename)
+{
+    close();
+
+    // FILE_FLAG_SEQUENTIAL_SCAN turns on aggressive read-ahead in the cache manager
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+    if(file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0 || (unsigned long long)fileSize.QuadPart > (std::size_t)-1)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if(!mapping)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if(!view)
+    {
+        CloseHandle(mapping);
+        CloseHandle(file);
+        return false;
+    }
+
+    fileHandle = file;
+    mappingHandle = mapping;
+    data = (const unsigned char*)view;
+    size = (std::size_t)fileSize.QuadPart;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// unmap
+///////////////////////////////////////////////////////////////////////////////
+void MappedFile::close()
+{
+    if(data)
+        UnmapViewOfFile(data);
+    if(mappingHandle)
+        CloseHandle((HANDLE)mappingHandle);
+    if(fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle((HANDLE)fileHandle);
+
+    data = 0;
+    size = 0;
+    mappingHandle = 0;
+    fileHandle = INVALID_HANDLE_VALUE;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// hints; the sequential flag is already set when the file is opened
+///////////////////////////////////////////////////////////////////////////////
+void MappedFile::adviseSequential() const
+{
+}
+
+void MappedFile::prefetch() const
+{
+#if _WIN32_WINNT >= 0x0602
+    if(!data)
+        return;
+    WIN32_MEMORY_RANGE_ENTRY range;
+    range.VirtualAddress = (PVOID)data;
+    range.NumberOfBytes = size;
+    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#endif
+}
+
+#else
+///////////////////////////////////////////////////////////////////////////////
+// map the whole file read-only
+///////////////////////////////////////////////////////////////////////////////
+bool MappedFile::open(const char* filename)
+{
+    close();
+
+    int fd = ::open(filename, O_RDONLY);
+    if(fd < 0)
+        return false;
+
+    struct stat status;
+    if(fstat(fd, &status) != 0 || status.st_size <= 0)
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // the mapping keeps its own reference to the file
+    void* view = mmap(0, (std::size_t)status.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if(view == MAP_FAILED)
+        return false;
+
+    data = (const unsigned char*)view;
+    size = (std::size_t)status.st_size;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// unmap
+///////////////////////////////////////////////////////////////////////////////
+void MappedFile::close()
+{
+    if(data)
+        munmap((void*)data, size);
+    data = 0;
+    size = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// hints
+///////////////////////////////////////////////////////////////////////////////
+void MappedFile::adviseSequential() const
+{
+    if(data)
+        madvise((void*)data, size, MADV_SEQUENTIAL);
+}
+
+void MappedFile::prefetch() const
+{
+    if(data)
+        madvise((void*)data, size, MADV_WILLNEED);
+}
+#endif
@@ -0,0 +1,50 @@
+///////////////////////////////////////////////////////////////////////////////
+// MappedFile.h
+// ============
+// Read-only memory mapping of a whole file, so decoders can read straight
+// from the page cache instead of going through stdio buffers.
+// - adviseSequential(): the file will be read front to back once
+// - prefetch()        : start reading the file in the background
+//                       (MADV_WILLNEED / PrefetchVirtualMemory), so a file
+//                       queued for later is resident by the time it is used
+// The hints are only hints; they do nothing where the OS lacks them.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+class MappedFile
+{
+public:
+    // ctor/dtor
+    MappedFile();
+    ~MappedFile();
+
+    // map a file; closes the previous mapping. empty files are not mapped
+    bool open(const char* filename);
+    void close();
+
+    bool isOpen() const                     { return data != 0; }
+    const unsigned char* getData() const    { return data; }
+    std::size_t getSize() const             { return size; }
+
+    // access pattern hints for the whole mapping
+    void adviseSequential() const;
+    void prefetch() const;
+
+private:
+    // a mapping is owned by one object
+    MappedFile(const MappedFile&);
+    MappedFile& operator=(const MappedFile&);
+
+    const unsigned char* data;
+    std::size_t size;
+#ifdef _WIN32
+    void* fileHandle;                       // HANDLE
+    void* mappingHandle;                    // HANDLE
+#endif
+};
+
+#endif
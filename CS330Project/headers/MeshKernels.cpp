@@ -0,0 +1,213 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshKernels.cpp
+// ===============
+// Sector tables and the SIMD ring writer.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include "MeshKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define MESH_AVX2 1
+#include <immintrin.h>
+#endif
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// same angles and precision as the sphere's original per-vertex cosf/sinf
+///////////////////////////////////////////////////////////////////////////////
+void getSectorTable(int sectorCount, float* cosTable, float* sinTable)
+{
+    const float PI = acos(-1);
+    float sectorStep = 2 * PI / sectorCount;
+    for(int j = 0; j <= sectorCount; ++j)
+    {
+        float sectorAngle = j * sectorStep;
+        cosTable[j] = cosf(sectorAngle);
+        sinTable[j] = sinf(sectorAngle);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// scalar ring, also the tail of the SIMD versions
+///////////////////////////////////////////////////////////////////////////////
+static void writeRingScalar(const float* cosTable, const float* sinTable,
+                            const float* normalCos, const float* normalSin, int begin, int count, int sectorCount,
+                            float radius, float z, float normalRadius, float normalScale, float nz, float t,
+                            float* vertices)
+{
+    vertices += begin * 8;
+    for(int j = begin; j < count; ++j)
+    {
+        *vertices++ = radius * cosTable[j];
+        *vertices++ = radius * sinTable[j];
+        *vertices++ = z;
+        *vertices++ = (normalRadius * normalCos[j]) * normalScale;
+        *vertices++ = (normalRadius * normalSin[j]) * normalScale;
+        *vertices++ = nz;
+        *vertices++ = (float)j / sectorCount;
+        *vertices++ = t;
+    }
+}
+
+
+
+#if MESH_AVX2
+///////////////////////////////////////////////////////////////////////////////
+// 8 vertices per step: the 8 attributes are computed as 8 lane vectors, then
+// an 8x8 transpose turns them into 8 interleaved 32-byte vertices
+///////////////////////////////////////////////////////////////////////////////
+static int writeRingAVX2(const float* cosTable, const float* sinTable,
+                         const float* normalCos, const float* normalSin, int count, int sectorCount,
+                         float radius, float z, float normalRadius, float normalScale, float nz, float t,
+                         float* vertices)
+{
+    const __m256 vRadius = _mm256_set1_ps(radius);
+    const __m256 vZ = _mm256_set1_ps(z);
+    const __m256 vNormalRadius = _mm256_set1_ps(normalRadius);
+    const __m256 vNormalScale = _mm256_set1_ps(normalScale);
+    const __m256 vNz = _mm256_set1_ps(nz);
+    const __m256 vSectors = _mm256_set1_ps((float)sectorCount);
+    const __m256 vT = _mm256_set1_ps(t);
+    __m256i index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i step = _mm256_set1_epi32(8);
+
+    int j = 0;
+    for(; j + 8 <= count; j += 8, vertices += 64)
+    {
+        __m256 c = _mm256_loadu_ps(cosTable + j);
+        __m256 s = _mm256_loadu_ps(sinTable + j);
+        __m256 nc = _mm256_loadu_ps(normalCos + j);
+        __m256 ns = _mm256_loadu_ps(normalSin + j);
+
+        __m256 r0 = _mm256_mul_ps(vRadius, c);
+        __m256 r1 = _mm256_mul_ps(vRadius, s);
+        __m256 r2 = vZ;
+        __m256 r3 = _mm256_mul_ps(_mm256_mul_ps(vNormalRadius, nc), vNormalScale);
+        __m256 r4 = _mm256_mul_ps(_mm256_mul_ps(vNormalRadius, ns), vNormalScale);
+        __m256 r5 = vNz;
+        __m256 r6 = _mm256_div_ps(_mm256_cvtepi32_ps(index), vSectors);
+        __m256 r7 = vT;
+        index = _mm256_add_epi32(index, step);
+
+        __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+        __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+        __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+        __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+        __m256 t4 = _mm256_unpacklo_ps(r4, r5);
+        __m256 t5 = _mm256_unpackhi_ps(r4, r5);
+        __m256 t6 = _mm256_unpacklo_ps(r6, r7);
+        __m256 t7 = _mm256_unpackhi_ps(r6, r7);
+
+        __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+        __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+        __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+        _mm256_storeu_ps(vertices,      _mm256_permute2f128_ps(s0, s4, 0x20));
+        _mm256_storeu_ps(vertices + 8,  _mm256_permute2f128_ps(s1, s5, 0x20));
+        _mm256_storeu_ps(vertices + 16, _mm256_permute2f128_ps(s2, s6, 0x20));
+        _mm256_storeu_ps(vertices + 24, _mm256_permute2f128_ps(s3, s7, 0x20));
+        _mm256_storeu_ps(vertices + 32, _mm256_permute2f128_ps(s0, s4, 0x31));
+        _mm256_storeu_ps(vertices + 40, _mm256_permute2f128_ps(s1, s5, 0x31));
+        _mm256_storeu_ps(vertices + 48, _mm256_permute2f128_ps(s2, s6, 0x31));
+        _mm256_storeu_ps(vertices + 56, _mm256_permute2f128_ps(s3, s7, 0x31));
+    }
+    return j;
+}
+#endif // MESH_AVX2
+
+
+
+#if MESH_SSE2 && !MESH_AVX2
+///////////////////////////////////////////////////////////////////////////////
+// 4 vertices per step: two 4x4 transposes give the position/nx halves and the
+// ny/nz/tex coord halves of 4 vertices
+///////////////////////////////////////////////////////////////////////////////
+static int writeRingSSE2(const float* cosTable, const float* sinTable,
+                         const float* normalCos, const float* normalSin, int count, int sectorCount,
+                         float radius, float z, float normalRadius, float normalScale, float nz, float t,
+                         float* vertices)
+{
+    const __m128 vRadius = _mm_set1_ps(radius);
+    const __m128 vNormalRadius = _mm_set1_ps(normalRadius);
+    const __m128 vNormalScale = _mm_set1_ps(normalScale);
+    const __m128 vSectors = _mm_set1_ps((float)sectorCount);
+    __m128i index = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i step = _mm_set1_epi32(4);
+
+    int j = 0;
+    for(; j + 4 <= count; j += 4, vertices += 32)
+    {
+        __m128 c = _mm_loadu_ps(cosTable + j);
+        __m128 s = _mm_loadu_ps(sinTable + j);
+        __m128 nc = _mm_loadu_ps(normalCos + j);
+        __m128 ns = _mm_loadu_ps(normalSin + j);
+
+        __m128 a0 = _mm_mul_ps(vRadius, c);
+        __m128 a1 = _mm_mul_ps(vRadius, s);
+        __m128 a2 = _mm_set1_ps(z);
+        __m128 a3 = _mm_mul_ps(_mm_mul_ps(vNormalRadius, nc), vNormalScale);
+        __m128 b0 = _mm_mul_ps(_mm_mul_ps(vNormalRadius, ns), vNormalScale);
+        __m128 b1 = _mm_set1_ps(nz);
+        __m128 b2 = _mm_div_ps(_mm_cvtepi32_ps(index), vSectors);
+        __m128 b3 = _mm_set1_ps(t);
+        index = _mm_add_epi32(index, step);
+
+        _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+        _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+
+        _mm_storeu_ps(vertices,      a0);
+        _mm_storeu_ps(vertices + 4,  b0);
+        _mm_storeu_ps(vertices + 8,  a1);
+        _mm_storeu_ps(vertices + 12, b1);
+        _mm_storeu_ps(vertices + 16, a2);
+        _mm_storeu_ps(vertices + 20, b2);
+        _mm_storeu_ps(vertices + 24, a3);
+        _mm_storeu_ps(vertices + 28, b3);
+    }
+    return j;
+}
+#endif // MESH_SSE2 && !MESH_AVX2
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// widest kernel for the bulk of the ring, scalar for the rest
+///////////////////////////////////////////////////////////////////////////////
+void writeRing(const float* cosTable, const float* sinTable,
+               const float* normalCos, const float* normalSin, int count, int sectorCount,
+               float radius, float z, float normalRadius, float normalScale, float nz, float t,
+               float* vertices)
+{
+    int done = 0;
+#if MESH_AVX2
+    done = writeRingAVX2(cosTable, sinTable, normalCos, normalSin, count, sectorCount, radius, z, normalRadius, normalScale, nz, t, vertices);
+#elif MESH_SSE2
+    done = writeRingSSE2(cosTable, sinTable, normalCos, normalSin, count, sectorCount, radius, z, normalRadius, normalScale, nz, t, vertices);
+#endif
+    writeRingScalar(cosTable, sinTable, normalCos, normalSin, done, count, sectorCount, radius, z, normalRadius, normalScale, nz, t, vertices);
+}
+
+const char* getRingKernelName()
+{
+#if MESH_AVX2
+    return "avx2";
+#elif MESH_SSE2
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
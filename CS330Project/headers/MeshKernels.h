@@ -0,0 +1,46 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshKernels.h
+// =============
+// Inner loops of the parametric mesh writers (Sphere, Cylinder).
+//
+// Spheres and cylinders are surfaces of revolution: every vertex ring shares
+// the same sector angles, so cos/sin are evaluated once per sector into a
+// table and a ring is only multiplies. writeRing() turns one ring into
+// interleaved V/N/T vertices 8 (AVX2) or 4 (SSE2) at a time, with a scalar
+// tail, and gives bit-identical results to the scalar loop.
+//
+// Kernels are selected at compile time like ImageProcess.cpp: SSE2 is always
+// on for x64, AVX2 needs /arch:AVX2 or -mavx2.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MESH_KERNELS_H
+#define MESH_KERNELS_H
+
+#include <cstddef>
+
+// rows handed to one pool task at least; smaller tasks cost more to queue than they save
+const int MESH_TASK_MIN_VERTICES = 4096;
+
+inline std::size_t getRowChunk(int sectorCount)
+{
+    std::size_t rows = MESH_TASK_MIN_VERTICES / (sectorCount + 1);
+    return rows > 0 ? rows : 1;
+}
+
+// cos/sin of j * 2pi / sectorCount for j in [0, sectorCount], single precision
+void getSectorTable(int sectorCount, float* cosTable, float* sinTable);
+
+// write count vertices of one ring, for j in [0, count):
+//   position  (radius * cos[j], radius * sin[j], z)
+//   normal    ((normalRadius * normalCos[j]) * normalScale, (normalRadius * normalSin[j]) * normalScale, nz)
+//   tex coord (j / sectorCount, t)
+// a sphere passes the sector table as the normal table, a cylinder its side normals
+void writeRing(const float* cosTable, const float* sinTable,
+               const float* normalCos, const float* normalSin, int count, int sectorCount,
+               float radius, float z, float normalRadius, float normalScale, float nz, float t,
+               float* vertices);
+
+// name of the compiled writeRing() kernel: "avx2", "sse2" or "scalar"
+const char* getRingKernelName();
+
+#endif
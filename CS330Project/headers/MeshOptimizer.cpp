@@ -0,0 +1,299 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshOptimizer.cpp
+// =================
+// Degenerate removal, Tipsify vertex cache ordering, fetch ordering and
+// FIFO cache statistics.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+#include "MeshOptimizer.h"
+#include "MeshView.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// drop triangles that cover no pixels
+// the area test is relative to the longest edge, so it works at any scale
+///////////////////////////////////////////////////////////////////////////////
+unsigned int removeDegenerateTriangles(unsigned int* indices, unsigned int indexCount,
+                                       const float* vertices, unsigned int stride)
+{
+    const unsigned char* bytes = (const unsigned char*)vertices;
+    unsigned int count = 0;
+    for(unsigned int i = 0; i + 2 < indexCount; i += 3)
+    {
+        unsigned int a = indices[i], b = indices[i+1], c = indices[i+2];
+        if(a == b || b == c || c == a)
+            continue;
+
+        const float* p0 = (const float*)(bytes + (std::size_t)a * stride);
+        const float* p1 = (const float*)(bytes + (std::size_t)b * stride);
+        const float* p2 = (const float*)(bytes + (std::size_t)c * stride);
+        float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        float n[3] = { e1[1] * e2[2] - e1[2] * e2[1],
+                       e1[2] * e2[0] - e1[0] * e2[2],
+                       e1[0] * e2[1] - e1[1] * e2[0] };
+        float area2 = n[0] * n[0] + n[1] * n[1] + n[2] * n[2];        // (2 * area)^2
+        float edge2 = e1[0] * e1[0] + e1[1] * e1[1] + e1[2] * e1[2];
+        float edge2b = e2[0] * e2[0] + e2[1] * e2[1] + e2[2] * e2[2];
+        if(edge2b > edge2)
+            edge2 = edge2b;
+        if(area2 <= edge2 * edge2 * 1e-12f)
+            continue;
+
+        indices[count++] = a;
+        indices[count++] = b;
+        indices[count++] = c;
+    }
+    return count;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Tipsify: fan around the most recently used vertex that will still be in
+// the cache; when there is none, continue from a dead-end stack of recent
+// vertices, then from the lowest vertex with triangles left
+///////////////////////////////////////////////////////////////////////////////
+void optimizeVertexCache(unsigned int* dst, const unsigned int* indices, unsigned int indexCount,
+                         unsigned int vertexCount, unsigned int cacheSize)
+{
+    unsigned int triangleCount = indexCount / 3;
+
+    // vertex -> triangles adjacency, in CSR form
+    std::vector<unsigned int> liveCount(vertexCount, 0);
+    for(unsigned int i = 0; i < triangleCount * 3; ++i)
+        ++liveCount[indices[i]];
+
+    std::vector<unsigned int> offsets(vertexCount + 1, 0);
+    for(unsigned int v = 0; v < vertexCount; ++v)
+        offsets[v + 1] = offsets[v] + liveCount[v];
+
+    std::vector<unsigned int> adjacency(triangleCount * 3);
+    std::vector<unsigned int> fill(offsets.begin(), offsets.end() - 1);
+    for(unsigned int t = 0; t < triangleCount; ++t)
+    {
+        for(int k = 0; k < 3; ++k)
+            adjacency[fill[indices[t*3+k]]++] = t;
+    }
+
+    std::vector<unsigned int> cacheTime(vertexCount, 0);
+    std::vector<unsigned char> emitted(triangleCount, 0);
+    std::vector<unsigned int> deadEnd;
+    std::vector<unsigned int> candidates;
+    unsigned int time = cacheSize + 1;
+    unsigned int cursor = 0;
+    unsigned int count = 0;
+
+    int fan = vertexCount > 0 ? 0 : -1;
+    while(fan >= 0)
+    {
+        // emit every remaining triangle around the fanning vertex
+        candidates.clear();
+        for(unsigned int j = offsets[fan]; j < offsets[fan + 1]; ++j)
+        {
+            unsigned int t = adjacency[j];
+            if(emitted[t])
+                continue;
+
+            for(int k = 0; k < 3; ++k)
+            {
+                unsigned int v = indices[t*3+k];
+                dst[count++] = v;
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                --liveCount[v];
+                if(time - cacheTime[v] > cacheSize)
+                    cacheTime[v] = time++;
+            }
+            emitted[t] = 1;
+        }
+
+        // next fan: the candidate that stays in the cache longest, if any does
+        int next = -1;
+        int best = -1;
+        for(std::size_t j = 0; j < candidates.size(); ++j)
+        {
+            unsigned int v = candidates[j];
+            if(liveCount[v] == 0)
+                continue;
+
+            int priority = 0;
+            if(time - cacheTime[v] + 2 * liveCount[v] <= cacheSize)
+                priority = (int)(time - cacheTime[v]);
+            if(priority > best)
+            {
+                best = priority;
+                next = (int)v;
+            }
+        }
+
+        // dead end: the most recent vertex with triangles left, then the lowest one
+        while(next < 0 && !deadEnd.empty())
+        {
+            unsigned int v = deadEnd.back();
+            deadEnd.pop_back();
+            if(liveCount[v] > 0)
+                next = (int)v;
+        }
+        while(next < 0 && cursor < vertexCount)
+        {
+            if(liveCount[cursor] > 0)
+                next = (int)cursor;
+            ++cursor;
+        }
+        fan = next;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// renumber vertices in the order the indices first use them
+///////////////////////////////////////////////////////////////////////////////
+unsigned int optimizeVertexFetch(float* vertices, unsigned int vertexCount, unsigned int stride,
+                                 unsigned int* indices, unsigned int indexCount)
+{
+    const unsigned int UNUSED = 0xffffffff;
+    std::vector<unsigned int> remap(vertexCount, UNUSED);
+    std::vector<unsigned char> copy((std::size_t)vertexCount * stride);
+    std::memcpy(copy.data(), vertices, copy.size());
+
+    unsigned char* bytes = (unsigned char*)vertices;
+    unsigned int count = 0;
+    for(unsigned int i = 0; i < indexCount; ++i)
+    {
+        unsigned int v = indices[i];
+        if(remap[v] == UNUSED)
+        {
+            std::memcpy(bytes + (std::size_t)count * stride, &copy[(std::size_t)v * stride], stride);
+            remap[v] = count++;
+        }
+        indices[i] = remap[v];
+    }
+    return count;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// # of vertices a FIFO cache of cacheSize entries transforms
+// restart indices are skipped; a restart does not flush the cache
+///////////////////////////////////////////////////////////////////////////////
+static unsigned int countTransforms(const unsigned int* indices, unsigned int indexCount,
+                                    unsigned int vertexCount, unsigned int cacheSize)
+{
+    // a vertex is cached while fewer than cacheSize misses happened after its own
+    std::vector<unsigned int> missTime(vertexCount, 0);
+    unsigned int misses = 0;
+    for(unsigned int i = 0; i < indexCount; ++i)
+    {
+        unsigned int v = indices[i];
+        if(v == MESH_RESTART_INDEX)
+            continue;
+        if(missTime[v] == 0 || misses - missTime[v] >= cacheSize)
+            missTime[v] = ++misses;
+    }
+    return misses;
+}
+
+float computeACMR(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+                  unsigned int cacheSize)
+{
+    unsigned int triangleCount = indexCount / 3;
+    if(triangleCount == 0)
+        return 0.0f;
+    return (float)countTransforms(indices, indexCount, vertexCount, cacheSize) / triangleCount;
+}
+
+float computeStripACMR(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+                       unsigned int cacheSize)
+{
+    // a strip of n indices has n - 2 triangles
+    unsigned int triangleCount = 0;
+    unsigned int stripLength = 0;
+    for(unsigned int i = 0; i <= indexCount; ++i)
+    {
+        if(i == indexCount || indices[i] == MESH_RESTART_INDEX)
+        {
+            if(stripLength > 2)
+                triangleCount += stripLength - 2;
+            stripLength = 0;
+        }
+        else
+        {
+            ++stripLength;
+        }
+    }
+    if(triangleCount == 0)
+        return 0.0f;
+    return (float)countTransforms(indices, indexCount, vertexCount, cacheSize) / triangleCount;
+}
+
+float computeATVR(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+                  unsigned int cacheSize)
+{
+    std::vector<unsigned char> used(vertexCount, 0);
+    unsigned int uniqueCount = 0;
+    for(unsigned int i = 0; i < indexCount; ++i)
+    {
+        if(indices[i] == MESH_RESTART_INDEX)
+            continue;
+        if(!used[indices[i]])
+        {
+            used[indices[i]] = 1;
+            ++uniqueCount;
+        }
+    }
+    if(uniqueCount == 0)
+        return 0.0f;
+    return (float)countTransforms(indices, indexCount, vertexCount, cacheSize) / uniqueCount;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// 32 -> 16-bit indices; only valid when canUse16BitIndices(vertexCount)
+///////////////////////////////////////////////////////////////////////////////
+void narrowIndices(const unsigned int* indices, unsigned int indexCount, unsigned short* dst)
+{
+    for(unsigned int i = 0; i < indexCount; ++i)
+        dst[i] = (unsigned short)indices[i];
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the whole pipeline
+///////////////////////////////////////////////////////////////////////////////
+void optimizeMesh(float* vertices, unsigned int& vertexCount, unsigned int stride,
+                  unsigned int* indices, unsigned int& indexCount, MeshOptimizeStats* stats)
+{
+    if(stats)
+    {
+        stats->trianglesBefore = indexCount / 3;
+        stats->verticesBefore = vertexCount;
+        stats->acmrBefore = computeACMR(indices, indexCount, vertexCount);
+        stats->atvrBefore = computeATVR(indices, indexCount, vertexCount);
+    }
+
+    indexCount = removeDegenerateTriangles(indices, indexCount, vertices, stride);
+
+    std::vector<unsigned int> ordered(indexCount);
+    optimizeVertexCache(ordered.data(), indices, indexCount, vertexCount);
+    if(indexCount > 0)
+        std::memcpy(indices, ordered.data(), indexCount * sizeof(unsigned int));
+
+    vertexCount = optimizeVertexFetch(vertices, vertexCount, stride, indices, indexCount);
+
+    if(stats)
+    {
+        stats->trianglesAfter = indexCount / 3;
+        stats->verticesAfter = vertexCount;
+        stats->acmrAfter = computeACMR(indices, indexCount, vertexCount);
+        stats->atvrAfter = computeATVR(indices, indexCount, vertexCount);
+    }
+}
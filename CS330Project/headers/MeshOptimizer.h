@@ -0,0 +1,68 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshOptimizer.h
+// ===============
+// Post-generation optimisation of indexed triangle meshes with interleaved
+// vertices (any stride, position in the first 3 floats).
+// - removeDegenerateTriangles() : drops triangles with a repeated index or
+//                                 zero area (e.g. the apex ring of a cone)
+// - optimizeVertexCache()       : Tipsify triangle order for the post-transform
+//                                 vertex cache (Sander, Nehab, Barczak 2007)
+// - optimizeVertexFetch()       : vertices in first-use order, unused ones dropped
+// - narrowIndices()             : 32 -> 16-bit indices when every index fits
+//                                 (MESH_RESTART_INDEX becomes 0xffff)
+//
+// optimizeMesh() runs the first three in order and reports ACMR (transformed
+// vertices per triangle, lower is better, 0.5 is the ideal for a regular grid)
+// and ATVR (transformed vertices per unique vertex, 1.0 is ideal) of a FIFO
+// cache before and after.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+const unsigned int MESH_CACHE_SIZE = 16;    // FIFO entries assumed for ordering and stats
+
+struct MeshOptimizeStats
+{
+    unsigned int trianglesBefore;
+    unsigned int trianglesAfter;
+    unsigned int verticesBefore;
+    unsigned int verticesAfter;
+    float acmrBefore;
+    float acmrAfter;
+    float atvrBefore;
+    float atvrAfter;
+};
+
+// remove degenerate triangles in place, returns the new index count
+unsigned int removeDegenerateTriangles(unsigned int* indices, unsigned int indexCount,
+                                       const float* vertices, unsigned int stride);
+
+// reorder the triangles of indices into dst (may not alias indices)
+void optimizeVertexCache(unsigned int* dst, const unsigned int* indices, unsigned int indexCount,
+                         unsigned int vertexCount, unsigned int cacheSize=MESH_CACHE_SIZE);
+
+// reorder vertices in place by first use and remap indices, returns the new vertex count
+unsigned int optimizeVertexFetch(float* vertices, unsigned int vertexCount, unsigned int stride,
+                                 unsigned int* indices, unsigned int indexCount);
+
+// FIFO cache simulation
+float computeACMR(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+                  unsigned int cacheSize=MESH_CACHE_SIZE);
+float computeATVR(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+                  unsigned int cacheSize=MESH_CACHE_SIZE);
+// ACMR of triangle strips separated by MESH_RESTART_INDEX
+float computeStripACMR(const unsigned int* indices, unsigned int indexCount, unsigned int vertexCount,
+                       unsigned int cacheSize=MESH_CACHE_SIZE);
+
+// 16-bit indices are possible when every vertex can be addressed with them
+// 0xffff stays free for primitive restart
+inline bool canUse16BitIndices(unsigned int vertexCount) { return vertexCount <= 65535; }
+void narrowIndices(const unsigned int* indices, unsigned int indexCount, unsigned short* dst);
+
+// degenerate removal, cache order and fetch order; vertexCount and indexCount are updated
+// stats is optional
+void optimizeMesh(float* vertices, unsigned int& vertexCount, unsigned int stride,
+                  unsigned int* indices, unsigned int& indexCount, MeshOptimizeStats* stats=0);
+
+#endif
@@ -0,0 +1,728 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshSimplifier.cpp
+// ==================
+// Quadric error edge collapses and LOD chains.
+//
+// A pass sorts the collapses of every edge by cost and makes the cheapest
+// ones. A collapse locks the vertices of the triangles around it until the
+// next pass, so the quadrics and flip tests of a pass never see a vertex
+// that has moved. Passes repeat until the target or the error is reached.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <functional>
+#include "MeshSimplifier.h"
+#include "ThreadPool.h"
+
+const unsigned int ATTRIBUTE_COUNT = 8;         // position, normal, tex coord
+const double BORDER_WEIGHT = 10.0;              // stiffness of the planes holding open borders in place
+const double MIN_FLIP_COSINE = 0.25;            // a triangle may turn by up to about 75 degrees in a collapse
+const unsigned int MIN_LOD_TRIANGLES = 8;       // smallest LOD worth building
+const unsigned int NO_VERTEX = 0xffffffff;      // no open edge at a vertex
+const unsigned int MANY_VERTICES = 0xfffffffe;  // more than one
+
+enum VertexKind
+{
+    VERTEX_MANIFOLD,    // inside the surface, collapses onto any neighbour
+    VERTEX_BORDER,      // on an open border, collapses along it
+    VERTEX_SEAM,        // split in 2 at a seam, collapses along it with its twin
+    VERTEX_LOCKED       // end or crossing of borders and seams, never collapses
+};
+
+// x'Ax + 2b'x + c over N attributes; A is symmetric, its upper triangle is stored row by row
+template<unsigned int N>
+struct Quadric
+{
+    double a[N * (N + 1) / 2];
+    double b[N];
+    double c;
+};
+
+typedef Quadric<ATTRIBUTE_COUNT> AttributeQuadric;  // orders the collapses
+typedef Quadric<3> PositionQuadric;                 // measures their error
+
+// collapse of v0 onto v1
+struct Collapse
+{
+    unsigned int v0;
+    unsigned int v1;
+    double cost;
+    double error;       // squared, relative to the mesh size
+};
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// quadric arithmetic
+///////////////////////////////////////////////////////////////////////////////
+template<unsigned int N>
+static void addQuadric(Quadric<N>& q, const Quadric<N>& r)
+{
+    for(unsigned int i = 0; i < N * (N + 1) / 2; ++i)
+        q.a[i] += r.a[i];
+    for(unsigned int i = 0; i < N; ++i)
+        q.b[i] += r.b[i];
+    q.c += r.c;
+}
+
+template<unsigned int N>
+static double evaluateQuadric(const Quadric<N>& q, const double* x)
+{
+    double result = q.c;
+    const double* a = q.a;
+    for(unsigned int i = 0; i < N; ++i)
+    {
+        double row = *a++ * x[i];
+        for(unsigned int j = i + 1; j < N; ++j)
+            row += 2 * *a++ * x[j];
+        result += (row + 2 * q.b[i]) * x[i];
+    }
+    return result > 0 ? result : 0;     // rounding can take it below 0
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// squared distance to the plane through 3 points in N dimensions, spanned by
+// the orthonormal e1 and e2 (Garland, Heckbert 1998):
+// A = I - e1e1' - e2e2', b = (p0.e1)e1 + (p0.e2)e2 - p0, c = p0.p0 - (p0.e1)^2 - (p0.e2)^2
+///////////////////////////////////////////////////////////////////////////////
+template<unsigned int N>
+static void addTriangleQuadric(Quadric<N>& q, const double* p0, const double* p1, const double* p2, double weight)
+{
+    double e1[N], e2[N];
+    double length1 = 0, projection = 0, length2 = 0;
+    for(unsigned int i = 0; i < N; ++i)
+    {
+        e1[i] = p1[i] - p0[i];
+        length1 += e1[i] * e1[i];
+    }
+    if(length1 <= 0)
+        return;
+    length1 = sqrt(length1);
+    for(unsigned int i = 0; i < N; ++i)
+    {
+        e1[i] /= length1;
+        e2[i] = p2[i] - p0[i];
+        projection += e2[i] * e1[i];
+    }
+    for(unsigned int i = 0; i < N; ++i)
+    {
+        e2[i] -= projection * e1[i];
+        length2 += e2[i] * e2[i];
+    }
+    if(length2 <= 0)
+        return;
+    length2 = sqrt(length2);
+
+    double d1 = 0, d2 = 0, d0 = 0;
+    for(unsigned int i = 0; i < N; ++i)
+    {
+        e2[i] /= length2;
+        d1 += p0[i] * e1[i];
+        d2 += p0[i] * e2[i];
+        d0 += p0[i] * p0[i];
+    }
+
+    double* a = q.a;
+    for(unsigned int i = 0; i < N; ++i)
+    {
+        for(unsigned int j = i; j < N; ++j)
+            *a++ += weight * ((i == j ? 1.0 : 0.0) - e1[i] * e1[j] - e2[i] * e2[j]);
+        q.b[i] += weight * (d1 * e1[i] + d2 * e2[i] - p0[i]);
+    }
+    q.c += weight * (d0 - d1 * d1 - d2 * d2);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// squared distance to the plane n.x + d = 0 of the position, the first 3
+// attributes
+///////////////////////////////////////////////////////////////////////////////
+template<unsigned int N>
+static void addPlaneQuadric(Quadric<N>& q, const double normal[3], double distance, double weight)
+{
+    for(unsigned int i = 0; i < 3; ++i)
+    {
+        double* row = q.a + i * N - i * (i - 1) / 2;    // starts at (i, i)
+        for(unsigned int j = i; j < 3; ++j)
+            row[j - i] += weight * normal[i] * normal[j];
+        q.b[i] += weight * distance * normal[i];
+    }
+    q.c += weight * distance * distance;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// helpers
+///////////////////////////////////////////////////////////////////////////////
+static const float* getVertex(const float* vertices, unsigned int stride, unsigned int index)
+{
+    return (const float*)((const unsigned char*)vertices + (std::size_t)index * stride);
+}
+
+static unsigned long long getEdgeKey(unsigned int a, unsigned int b)
+{
+    return ((unsigned long long)a << 32) | b;
+}
+
+static bool hasEdge(const std::vector<unsigned long long>& edges, unsigned int a, unsigned int b)
+{
+    return std::binary_search(edges.begin(), edges.end(), getEdgeKey(a, b));
+}
+
+static void cross(const double* u, const double* v, double* n)
+{
+    n[0] = u[1] * v[2] - u[2] * v[1];
+    n[1] = u[2] * v[0] - u[0] * v[2];
+    n[2] = u[0] * v[1] - u[1] * v[0];
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// vertices at the same position: remap is the lowest of them, wedge the next
+// one around a circular list (the vertex itself when it is alone)
+///////////////////////////////////////////////////////////////////////////////
+static void buildPositionGroups(const float* vertices, unsigned int vertexCount, unsigned int stride,
+                                std::vector<unsigned int>& remap, std::vector<unsigned int>& wedge)
+{
+    std::vector<unsigned int> order(vertexCount);
+    for(unsigned int i = 0; i < vertexCount; ++i)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), [vertices, stride](unsigned int a, unsigned int b)
+    {
+        const float* p = getVertex(vertices, stride, a);
+        const float* q = getVertex(vertices, stride, b);
+        for(int i = 0; i < 3; ++i)
+        {
+            if(p[i] != q[i])
+                return p[i] < q[i];
+        }
+        return a < b;
+    });
+
+    remap.resize(vertexCount);
+    wedge.resize(vertexCount);
+    for(unsigned int i = 0; i < vertexCount; )
+    {
+        const float* p = getVertex(vertices, stride, order[i]);
+        unsigned int last = i;
+        while(last + 1 < vertexCount)
+        {
+            const float* q = getVertex(vertices, stride, order[last + 1]);
+            if(p[0] != q[0] || p[1] != q[1] || p[2] != q[2])
+                break;
+            ++last;
+        }
+        for(unsigned int k = i; k <= last; ++k)
+        {
+            remap[order[k]] = order[i];
+            wedge[order[k]] = order[k == last ? i : k + 1];
+        }
+        i = last + 1;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// an open edge has no triangle on its other side with the same vertices; it
+// is a border, or one side of a seam where the vertices are split.
+// a vertex with one open edge in and one out, to different positions, is on
+// a border when it is alone at its position, and on a seam when it has one
+// twin whose open edges run back along the same positions
+///////////////////////////////////////////////////////////////////////////////
+static void classifyVertices(const std::vector<unsigned int>& indices, const std::vector<unsigned long long>& edges,
+                             const std::vector<unsigned int>& remap, const std::vector<unsigned int>& wedge,
+                             std::vector<unsigned int>& openIn, std::vector<unsigned int>& openOut,
+                             std::vector<unsigned char>& kinds)
+{
+    std::size_t vertexCount = remap.size();
+    openIn.assign(vertexCount, NO_VERTEX);
+    openOut.assign(vertexCount, NO_VERTEX);
+    for(std::size_t i = 0; i < indices.size(); i += 3)
+    {
+        for(int e = 0; e < 3; ++e)
+        {
+            unsigned int a = indices[i + e], b = indices[i + (e + 1) % 3];
+            if(hasEdge(edges, b, a))
+                continue;
+            openOut[a] = (openOut[a] == NO_VERTEX || openOut[a] == b) ? b : MANY_VERTICES;
+            openIn[b] = (openIn[b] == NO_VERTEX || openIn[b] == a) ? a : MANY_VERTICES;
+        }
+    }
+
+    kinds.resize(vertexCount);
+    for(std::size_t v = 0; v < vertexCount; ++v)
+    {
+        unsigned int in = openIn[v], out = openOut[v];
+        bool single = in < MANY_VERTICES && out < MANY_VERTICES && remap[in] != remap[out];
+        unsigned char kind = VERTEX_LOCKED;
+        if(wedge[v] == v)
+        {
+            if(in == NO_VERTEX && out == NO_VERTEX)
+                kind = VERTEX_MANIFOLD;
+            else if(single)
+                kind = VERTEX_BORDER;
+        }
+        else if(wedge[wedge[v]] == v && single)
+        {
+            unsigned int twinIn = openIn[wedge[v]], twinOut = openOut[wedge[v]];
+            if(twinIn < MANY_VERTICES && twinOut < MANY_VERTICES &&
+               remap[twinIn] == remap[out] && remap[twinOut] == remap[in])
+                kind = VERTEX_SEAM;
+        }
+        kinds[v] = kind;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// after a pass, an open edge to a collapsed vertex leads to where it went;
+// when that is the vertex itself, the edge collapsed and the next one along
+// takes its place
+///////////////////////////////////////////////////////////////////////////////
+static void remapOpenEdges(std::vector<unsigned int>& open, const std::vector<unsigned int>& collapse)
+{
+    for(std::size_t i = 0; i < open.size(); ++i)
+    {
+        unsigned int v = open[i];
+        if(v >= MANY_VERTICES)
+            continue;
+        if(collapse[v] == i)
+            open[i] = open[v] < MANY_VERTICES ? collapse[open[v]] : open[v];
+        else
+            open[i] = collapse[v];
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// borders and seams only collapse along themselves, a seam with its twin
+///////////////////////////////////////////////////////////////////////////////
+static bool canCollapse(unsigned int v0, unsigned int v1, const std::vector<unsigned char>& kinds,
+                        const std::vector<unsigned int>& wedge,
+                        const std::vector<unsigned int>& openIn, const std::vector<unsigned int>& openOut)
+{
+    switch(kinds[v0])
+    {
+    case VERTEX_MANIFOLD:
+        return true;
+    case VERTEX_BORDER:
+        return kinds[v1] == VERTEX_BORDER && (openOut[v0] == v1 || openIn[v0] == v1);
+    case VERTEX_SEAM:
+    {
+        unsigned int w0 = wedge[v0], w1 = wedge[v1];
+        return kinds[v1] == VERTEX_SEAM && (openOut[v0] == v1 || openIn[v0] == v1) &&
+               (openOut[w0] == w1 || openIn[w0] == w1);
+    }
+    default:
+        return false;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// triangles of each vertex: those of v are triangles[offsets[v] .. offsets[v+1])
+///////////////////////////////////////////////////////////////////////////////
+static void buildTriangleAdjacency(const std::vector<unsigned int>& indices, unsigned int vertexCount,
+                                   std::vector<unsigned int>& offsets, std::vector<unsigned int>& triangles)
+{
+    offsets.assign(vertexCount + 1, 0);
+    for(std::size_t i = 0; i < indices.size(); ++i)
+        ++offsets[indices[i] + 1];
+    for(unsigned int v = 0; v < vertexCount; ++v)
+        offsets[v + 1] += offsets[v];
+
+    std::vector<unsigned int> next(offsets.begin(), offsets.end() - 1);
+    triangles.resize(indices.size());
+    for(std::size_t i = 0; i < indices.size(); ++i)
+        triangles[next[indices[i]]++] = (unsigned int)(i / 3);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// moving v0 onto v1 turns a triangle that survives it over, or by so much
+// that it is close to folding (a sliver along a line of the old surface)
+///////////////////////////////////////////////////////////////////////////////
+static bool flipsTriangle(unsigned int v0, unsigned int v1, const std::vector<unsigned int>& indices,
+                          const std::vector<unsigned int>& offsets, const std::vector<unsigned int>& triangles,
+                          const std::vector<double>& attributes)
+{
+    const double* p0 = &attributes[(std::size_t)v0 * ATTRIBUTE_COUNT];
+    const double* target = &attributes[(std::size_t)v1 * ATTRIBUTE_COUNT];
+    for(unsigned int k = offsets[v0]; k < offsets[v0 + 1]; ++k)
+    {
+        const unsigned int* triangle = &indices[(std::size_t)triangles[k] * 3];
+        if(triangle[0] == v1 || triangle[1] == v1 || triangle[2] == v1)
+            continue;
+
+        // the other corners, in winding order after v0
+        int corner = triangle[0] == v0 ? 0 : (triangle[1] == v0 ? 1 : 2);
+        const double* p1 = &attributes[(std::size_t)triangle[(corner + 1) % 3] * ATTRIBUTE_COUNT];
+        const double* p2 = &attributes[(std::size_t)triangle[(corner + 2) % 3] * ATTRIBUTE_COUNT];
+
+        double u[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+        double v[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+        double before[3], after[3];
+        cross(u, v, before);
+        for(int i = 0; i < 3; ++i)
+        {
+            u[i] = p1[i] - target[i];
+            v[i] = p2[i] - target[i];
+        }
+        cross(u, v, after);
+        double turn = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+        double lengths = (before[0] * before[0] + before[1] * before[1] + before[2] * before[2]) *
+                         (after[0] * after[0] + after[1] * after[1] + after[2] * after[2]);
+        if(turn <= 0 || turn * turn < MIN_FLIP_COSINE * MIN_FLIP_COSINE * lengths)
+            return true;
+    }
+    return false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// positions are scaled to the unit cube of the mesh bounds, so costs and
+// weights do not depend on its size
+///////////////////////////////////////////////////////////////////////////////
+unsigned int simplifyMesh(unsigned int* dst, const unsigned int* indices, unsigned int indexCount,
+                          const float* vertices, unsigned int vertexCount, unsigned int stride,
+                          unsigned int targetIndexCount, float maxError,
+                          const SimplifyOptions& options, float* error)
+{
+    std::vector<unsigned int> result(indices, indices + indexCount - indexCount % 3);
+    unsigned int triangleCount = (unsigned int)result.size() / 3;
+    unsigned int targetTriangleCount = targetIndexCount / 3;
+    if(error)
+        *error = 0.0f;
+
+    // bounds of the used vertices
+    float low[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, high[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for(std::size_t i = 0; i < result.size(); ++i)
+    {
+        const float* p = getVertex(vertices, stride, result[i]);
+        for(int k = 0; k < 3; ++k)
+        {
+            low[k] = std::min(low[k], p[k]);
+            high[k] = std::max(high[k], p[k]);
+        }
+    }
+    double extent = std::max(high[0] - low[0], std::max(high[1] - low[1], high[2] - low[2]));
+    if(triangleCount <= targetTriangleCount || extent <= 0)
+    {
+        std::copy(result.begin(), result.end(), dst);
+        return (unsigned int)result.size();
+    }
+
+    // position, weighted normal and weighted tex coord of every vertex
+    std::vector<double> attributes((std::size_t)vertexCount * ATTRIBUTE_COUNT);
+    for(unsigned int v = 0; v < vertexCount; ++v)
+    {
+        const float* source = getVertex(vertices, stride, v);
+        double* x = &attributes[(std::size_t)v * ATTRIBUTE_COUNT];
+        for(int k = 0; k < 3; ++k)
+        {
+            x[k] = (source[k] - low[k]) / extent;
+            x[3 + k] = source[3 + k] * options.normalWeight;
+        }
+        x[6] = source[6] * options.texCoordWeight;
+        x[7] = source[7] * options.texCoordWeight;
+    }
+
+    // directed edges by index and by position
+    std::vector<unsigned int> remap, wedge;
+    buildPositionGroups(vertices, vertexCount, stride, remap, wedge);
+    std::vector<unsigned long long> edges, positionEdges;
+    edges.reserve(result.size());
+    positionEdges.reserve(result.size());
+    for(std::size_t i = 0; i < result.size(); i += 3)
+    {
+        for(int e = 0; e < 3; ++e)
+        {
+            unsigned int a = result[i + e], b = result[i + (e + 1) % 3];
+            edges.push_back(getEdgeKey(a, b));
+            positionEdges.push_back(getEdgeKey(remap[a], remap[b]));
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    std::sort(positionEdges.begin(), positionEdges.end());
+
+    std::vector<unsigned int> openIn, openOut;
+    std::vector<unsigned char> kinds;
+    classifyVertices(result, edges, remap, wedge, openIn, openOut, kinds);
+
+    // triangle quadrics weighted by area, and planes through the open borders
+    // at right angles to their triangles, which keep the border from shrinking
+    std::vector<AttributeQuadric> quadrics(vertexCount);
+    std::vector<PositionQuadric> positionQuadrics(vertexCount);
+    for(std::size_t i = 0; i < result.size(); i += 3)
+    {
+        const double* p[3];
+        for(int k = 0; k < 3; ++k)
+            p[k] = &attributes[(std::size_t)result[i + k] * ATTRIBUTE_COUNT];
+        double u[3] = { p[1][0] - p[0][0], p[1][1] - p[0][1], p[1][2] - p[0][2] };
+        double v[3] = { p[2][0] - p[0][0], p[2][1] - p[0][1], p[2][2] - p[0][2] };
+        double normal[3];
+        cross(u, v, normal);
+        double length = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+        if(length <= 0)
+            continue;
+
+        AttributeQuadric triangle = {};
+        PositionQuadric plane = {};
+        addTriangleQuadric(triangle, p[0], p[1], p[2], length * 0.5);
+        addTriangleQuadric(plane, p[0], p[1], p[2], length * 0.5);
+        for(int k = 0; k < 3; ++k)
+        {
+            addQuadric(quadrics[result[i + k]], triangle);
+            addQuadric(positionQuadrics[result[i + k]], plane);
+        }
+
+        for(int e = 0; e < 3; ++e)
+        {
+            unsigned int a = result[i + e], b = result[i + (e + 1) % 3];
+            if(hasEdge(positionEdges, remap[b], remap[a]))
+                continue;
+
+            const double* pa = p[e];
+            const double* pb = p[(e + 1) % 3];
+            double edge[3] = { pb[0] - pa[0], pb[1] - pa[1], pb[2] - pa[2] };
+            double side[3];
+            cross(edge, normal, side);
+            double sideLength = sqrt(side[0] * side[0] + side[1] * side[1] + side[2] * side[2]);
+            if(sideLength <= 0)
+                continue;
+            for(int k = 0; k < 3; ++k)
+                side[k] /= sideLength;
+            double distance = -(side[0] * pa[0] + side[1] * pa[1] + side[2] * pa[2]);
+            double weight = BORDER_WEIGHT * (edge[0] * edge[0] + edge[1] * edge[1] + edge[2] * edge[2]);
+            addPlaneQuadric(quadrics[a], side, distance, weight);
+            addPlaneQuadric(quadrics[b], side, distance, weight);
+            addPlaneQuadric(positionQuadrics[a], side, distance, weight);
+            addPlaneQuadric(positionQuadrics[b], side, distance, weight);
+        }
+    }
+
+    double maxRelativeError = maxError > 0 ? (double)maxError / extent : DBL_MAX;
+    double maxSquaredError = maxError > 0 ? maxRelativeError * maxRelativeError : DBL_MAX;
+    double resultError = 0;
+
+    std::vector<unsigned int> offsets, triangles, collapse(vertexCount);
+    std::vector<unsigned char> locked(vertexCount);
+    std::vector<Collapse> candidates;
+    while(triangleCount > targetTriangleCount)
+    {
+        buildTriangleAdjacency(result, vertexCount, offsets, triangles);
+
+        // both directions of every edge, once per triangle
+        candidates.clear();
+        for(std::size_t i = 0; i < result.size(); i += 3)
+        {
+            for(int e = 0; e < 6; ++e)
+            {
+                unsigned int v0 = result[i + e % 3];
+                unsigned int v1 = result[i + (e < 3 ? (e + 1) % 3 : (e + 2) % 3)];
+                if(!canCollapse(v0, v1, kinds, wedge, openIn, openOut))
+                    continue;
+
+                const double* x1 = &attributes[(std::size_t)v1 * ATTRIBUTE_COUNT];
+                Collapse candidate = { v0, v1, evaluateQuadric(quadrics[v0], x1), evaluateQuadric(positionQuadrics[v0], x1) };
+                if(kinds[v0] == VERTEX_SEAM)
+                {
+                    const double* w1 = &attributes[(std::size_t)wedge[v1] * ATTRIBUTE_COUNT];
+                    candidate.cost += evaluateQuadric(quadrics[wedge[v0]], w1);
+                    candidate.error += evaluateQuadric(positionQuadrics[wedge[v0]], w1);
+                }
+                if(candidate.error <= maxSquaredError)
+                    candidates.push_back(candidate);
+            }
+        }
+        if(candidates.empty())
+            break;
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const Collapse& a, const Collapse& b) { return a.cost < b.cost; });
+
+        // most candidates are locked by cheaper collapses, and would cost more than the
+        // cheapest of the next pass: stop at 1.5 times the cost of the collapse that would
+        // reach the target if none were locked (about 4 candidates per edge collapse),
+        // once the pass has made a useful number
+        std::size_t goal = (std::size_t)(triangleCount - targetTriangleCount) * 2;
+        double maxPassCost = goal < candidates.size() ? candidates[goal].cost * 1.5 : DBL_MAX;
+        unsigned int minPassCollapses = triangleCount / 40;
+
+        for(unsigned int v = 0; v < vertexCount; ++v)
+            collapse[v] = v;
+        std::fill(locked.begin(), locked.end(), 0);
+        unsigned int collapses = 0;
+        for(std::size_t i = 0; i < candidates.size() && triangleCount > targetTriangleCount; ++i)
+        {
+            const Collapse& candidate = candidates[i];
+            if(candidate.cost > maxPassCost && collapses > minPassCollapses)
+                break;
+
+            unsigned int v0 = candidate.v0, v1 = candidate.v1;
+            if(locked[remap[v0]] || locked[remap[v1]])
+                continue;
+            bool seam = kinds[v0] == VERTEX_SEAM;
+            unsigned int w0 = wedge[v0], w1 = wedge[v1];
+            if(flipsTriangle(v0, v1, result, offsets, triangles, attributes) ||
+               (seam && flipsTriangle(w0, w1, result, offsets, triangles, attributes)))
+                continue;
+
+            // lock the triangles around v0 (and its twin) and count those that go
+            for(int side = 0; side < (seam ? 2 : 1); ++side)
+            {
+                unsigned int from = side ? w0 : v0, to = side ? w1 : v1;
+                collapse[from] = to;
+                addQuadric(quadrics[to], quadrics[from]);
+                addQuadric(positionQuadrics[to], positionQuadrics[from]);
+                for(unsigned int k = offsets[from]; k < offsets[from + 1]; ++k)
+                {
+                    const unsigned int* triangle = &result[(std::size_t)triangles[k] * 3];
+                    if(triangle[0] == to || triangle[1] == to || triangle[2] == to)
+                        --triangleCount;
+                    for(int corner = 0; corner < 3; ++corner)
+                        locked[remap[triangle[corner]]] = 1;
+                }
+            }
+            resultError = std::max(resultError, candidate.error);
+            ++collapses;
+        }
+        if(collapses == 0)
+            break;
+
+        // move the indices of collapsed vertices and drop the triangles that became edges
+        std::size_t count = 0;
+        for(std::size_t i = 0; i < result.size(); i += 3)
+        {
+            unsigned int a = collapse[result[i]], b = collapse[result[i + 1]], c = collapse[result[i + 2]];
+            if(a == b || b == c || c == a)
+                continue;
+            result[count++] = a;
+            result[count++] = b;
+            result[count++] = c;
+        }
+        result.resize(count);
+        triangleCount = (unsigned int)count / 3;
+
+        remapOpenEdges(openIn, collapse);
+        remapOpenEdges(openOut, collapse);
+    }
+
+    std::copy(result.begin(), result.end(), dst);
+    if(error)
+        *error = (float)(sqrt(resultError) * extent);
+    return (unsigned int)result.size();
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// whole triangles, rounded down
+///////////////////////////////////////////////////////////////////////////////
+unsigned int getLodIndexCount(unsigned int indexCount, float ratio)
+{
+    return (unsigned int)(indexCount / 3 * (double)ratio) * 3;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the index counts buildLodChain() aims for; a LOD never has more
+///////////////////////////////////////////////////////////////////////////////
+unsigned int getLodChainIndexCapacity(unsigned int indexCount, unsigned int maxLodCount, float ratio)
+{
+    unsigned int total = indexCount;
+    if(ratio <= 0 || ratio >= 1)
+        return total;
+    for(unsigned int lod = 1; lod < maxLodCount; ++lod)
+    {
+        indexCount = getLodIndexCount(indexCount, ratio);
+        if(indexCount < MIN_LOD_TRIANGLES * 3)
+            break;
+        total += indexCount;
+    }
+    return total;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// simplifying from the last LOD instead of LOD 0 keeps the LODs nested and
+// costs half as much; the error of a LOD is at most the sum of the steps
+///////////////////////////////////////////////////////////////////////////////
+void buildLodChain(const unsigned int* indices, unsigned int indexCount,
+                   const float* vertices, unsigned int vertexCount, unsigned int stride,
+                   unsigned int maxLodCount, float ratio, float maxError, const SimplifyOptions& options,
+                   std::vector<unsigned int>& lodIndices, std::vector<MeshLod>& lods)
+{
+    unsigned int count = indexCount - indexCount % 3;
+    lodIndices.assign(indices, indices + count);
+    lods.clear();
+    MeshLod first = { 0, count, 0.0f };
+    lods.push_back(first);
+    if(ratio <= 0 || ratio >= 1)
+        return;
+
+    std::vector<unsigned int> next;
+    while(lods.size() < maxLodCount)
+    {
+        const MeshLod last = lods.back();
+        unsigned int target = getLodIndexCount(last.indexCount, ratio);
+        if(target < MIN_LOD_TRIANGLES * 3)
+            break;
+        float maxStepError = 0.0f;
+        if(maxError > 0)
+        {
+            maxStepError = maxError - last.error;
+            if(maxStepError <= 0)
+                break;
+        }
+
+        float error = 0.0f;
+        next.resize(last.indexCount);
+        unsigned int nextCount = simplifyMesh(next.data(), &lodIndices[last.firstIndex], last.indexCount,
+                                              vertices, vertexCount, stride, target, maxStepError, options, &error);
+        if(nextCount > target)
+            break;      // locked topology or the error bound
+
+        MeshLod lod = { (unsigned int)lodIndices.size(), nextCount, last.error + error };
+        lodIndices.insert(lodIndices.end(), next.begin(), next.begin() + nextCount);
+        lods.push_back(lod);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the jobs share nothing, so they need no locks
+///////////////////////////////////////////////////////////////////////////////
+void buildLodChains(LodChainJob* jobs, std::size_t count, unsigned int maxLodCount, float ratio, float maxError,
+                    const SimplifyOptions& options, ThreadPool* pool)
+{
+    std::function<void(std::size_t, std::size_t)> build = [&](std::size_t begin, std::size_t end)
+    {
+        for(std::size_t i = begin; i < end; ++i)
+        {
+            LodChainJob& job = jobs[i];
+            buildLodChain(job.indices, job.indexCount, job.vertices, job.vertexCount, job.stride,
+                          maxLodCount, ratio, maxError, options, job.lodIndices, job.lods);
+        }
+    };
+
+    if(pool)
+        pool->parallelFor(count, 1, build);
+    else
+        build(0, count);
+}
@@ -0,0 +1,87 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshSimplifier.h
+// ================
+// Levels of detail of indexed triangle meshes with interleaved V/N/T vertices
+// (any stride, position, normal and tex coord in the first 8 floats).
+// - simplifyMesh()   : collapses edges in order of quadric error (Garland,
+//                      Heckbert 1997), with the normal and tex coord in the
+//                      quadrics (Garland, Heckbert 1998), down to a target
+//                      index count or error
+// - buildLodChain()  : LOD 0 and coarser LODs, each simplified from the last
+// - buildLodChains() : the same for many meshes, one mesh per thread
+//
+// An edge collapses onto one of its vertices, so the vertices never change
+// and every LOD indexes the same vertex buffer: a chain is one index array
+// with a range per LOD. Vertices split at a normal or tex coord seam only
+// collapse along the seam, both sides together; vertices of an open border
+// only along the border; vertices shared by 3+ splits stay where they are.
+//
+// Errors are distances in the units of the positions: the largest distance
+// between a collapsed vertex and the planes of the triangles merged into it.
+// The normal and tex coord only change the order of the collapses, at
+// normalWeight and texCoordWeight times the mesh size per unit of change.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+struct SimplifyOptions
+{
+    float normalWeight;         // cost of a unit normal change, as a fraction of the mesh size
+    float texCoordWeight;       // cost of a unit tex coord change, as a fraction of the mesh size
+
+    SimplifyOptions(float normalWeight=0.25f, float texCoordWeight=0.25f)
+        : normalWeight(normalWeight), texCoordWeight(texCoordWeight) {}
+};
+
+// index range of a LOD in the index array of a chain
+struct MeshLod
+{
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    float error;                // largest distance from LOD 0, in position units
+};
+
+// one mesh of buildLodChains(); the arrays must stay valid until it returns
+struct LodChainJob
+{
+    const float* vertices;
+    unsigned int vertexCount;
+    unsigned int stride;        // # of bytes between vertices
+    const unsigned int* indices;
+    unsigned int indexCount;
+    std::vector<unsigned int> lodIndices;   // results of buildLodChain()
+    std::vector<MeshLod> lods;
+};
+
+// simplify the triangles of indices into dst (may alias indices) until at most
+// targetIndexCount indices remain or every collapse left would exceed maxError
+// (0 for no limit); returns the new index count, error is optional
+unsigned int simplifyMesh(unsigned int* dst, const unsigned int* indices, unsigned int indexCount,
+                          const float* vertices, unsigned int vertexCount, unsigned int stride,
+                          unsigned int targetIndexCount, float maxError,
+                          const SimplifyOptions& options=SimplifyOptions(), float* error=0);
+
+// # of indices of the LOD after one of indexCount indices
+unsigned int getLodIndexCount(unsigned int indexCount, float ratio);
+// most indices a chain can have, for reserving its array up front
+unsigned int getLodChainIndexCapacity(unsigned int indexCount, unsigned int maxLodCount, float ratio);
+
+// LOD 0 is indices; each next LOD has getLodIndexCount() of the one before.
+// the chain ends at maxLodCount LODs, or at the first LOD that cannot reach
+// its index count within maxError (0 for no limit) from LOD 0
+void buildLodChain(const unsigned int* indices, unsigned int indexCount,
+                   const float* vertices, unsigned int vertexCount, unsigned int stride,
+                   unsigned int maxLodCount, float ratio, float maxError, const SimplifyOptions& options,
+                   std::vector<unsigned int>& lodIndices, std::vector<MeshLod>& lods);
+
+// buildLodChain() for each job, one job per thread of pool (null to run them here)
+void buildLodChains(LodChainJob* jobs, std::size_t count, unsigned int maxLodCount, float ratio, float maxError,
+                    const SimplifyOptions& options, ThreadPool* pool=0);
+
+#endif
@@ -0,0 +1,290 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshUpload.cpp
+// ==============
+// VAO/VBO/EBO creation from a MeshView or straight into mapped buffers.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+#include "MeshOptimizer.h"
+#include "MeshUpload.h"
+
+// writes the vertex bytes and indices of a mesh
+typedef std::function<void(void* vertices, unsigned int* indices)> BufferWriter;
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// create the VAO and buffers and leave them bound
+///////////////////////////////////////////////////////////////////////////////
+static void createBuffers(GLMesh& mesh, bool indexed)
+{
+    mesh.ebo = 0;
+    mesh.indexType = GL_UNSIGNED_INT;
+    mesh.primitive = GL_TRIANGLES;
+    for(int i = 0; i < 3; ++i)
+    {
+        mesh.positionScale[i] = 1.0f;
+        mesh.positionBias[i] = 0.0f;
+        mesh.boundingSphere[i] = 0.0f;
+    }
+    mesh.boundingSphere[3] = -1.0f;
+
+    glGenVertexArrays(1, &mesh.vao);
+    glBindVertexArray(mesh.vao);
+
+    glGenBuffers(1, &mesh.vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+
+    if(indexed)
+    {
+        glGenBuffers(1, &mesh.ebo);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// position, normal and tex coord attributes of the bound VBO
+///////////////////////////////////////////////////////////////////////////////
+static void setVertexAttributes(VertexFormat format, GLsizei stride)
+{
+    if(format == VERTEX_FORMAT_PACKED)
+    {
+        // all normalized: snorm16 position, snorm10 normal, unorm16 tex coord
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, position));
+        glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(PackedVertex, normal));
+        glVertexAttribPointer(2, 2, GL_UNSIGNED_SHORT, GL_TRUE, stride, (void*)offsetof(PackedVertex, texCoord));
+    }
+    else
+    {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, 0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * 3));
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * 6));
+    }
+
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// sphere around the positions of a view: the center of their box and the
+// distance to the farthest position from it
+///////////////////////////////////////////////////////////////////////////////
+static void setBoundingSphere(GLMesh& mesh, const MeshView& view)
+{
+    VertexQuantization box = makeVertexQuantization(view.vertices, view.vertexCount, view.stride);
+    float radius2 = 0.0f;
+    const unsigned char* bytes = (const unsigned char*)view.vertices;
+    for(unsigned int i = 0; i < view.vertexCount; ++i, bytes += view.stride)
+    {
+        const float* position = (const float*)bytes;
+        float dx = position[0] - box.bias[0];
+        float dy = position[1] - box.bias[1];
+        float dz = position[2] - box.bias[2];
+        radius2 = std::max(radius2, dx * dx + dy * dy + dz * dz);
+    }
+
+    for(int i = 0; i < 3; ++i)
+        mesh.boundingSphere[i] = box.bias[i];
+    mesh.boundingSphere[3] = std::sqrt(radius2);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// allocate the bound buffers, then let write() fill them through mappings
+// falls back to writing into memory and buffering a copy
+///////////////////////////////////////////////////////////////////////////////
+static void writeBuffers(GLsizeiptr vertexSize, GLsizeiptr indexSize, const BufferWriter& write)
+{
+    bool indexed = indexSize > 0;
+    glBufferData(GL_ARRAY_BUFFER, vertexSize, NULL, GL_STATIC_DRAW);
+    if(indexed)
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexSize, NULL, GL_STATIC_DRAW);
+
+    // the buffers are new, so nothing has to be synchronized or preserved
+    const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT;
+    void* vertices = glMapBufferRange(GL_ARRAY_BUFFER, 0, vertexSize, access);
+    unsigned int* indices = indexed ? (unsigned int*)glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, indexSize, access) : 0;
+
+    bool mapped = vertices && (indices || !indexed);
+    if(mapped)
+        write(vertices, indices);
+
+    // unmapping fails if the contents were lost while mapped (e.g. a mode switch)
+    bool ok = mapped;
+    if(vertices)
+        ok = (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE) && ok;
+    if(indices)
+        ok = (glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) == GL_TRUE) && ok;
+
+    if(!ok)
+    {
+        // float storage keeps the vertex memory aligned for either format
+        std::vector<float> vertexData((vertexSize + sizeof(float) - 1) / sizeof(float));
+        std::vector<unsigned int> indexData(indexSize / sizeof(unsigned int));
+        write(vertexData.data(), indexed ? indexData.data() : 0);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, vertexSize, vertexData.data());
+        if(indexed)
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, indexSize, indexData.data());
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// upload from a non-owning view
+///////////////////////////////////////////////////////////////////////////////
+void uploadMesh(GLMesh& mesh, const MeshView& view, VertexFormat format)
+{
+    bool indexed = view.indices != 0;
+    createBuffers(mesh, indexed);
+    setBoundingSphere(mesh, view);
+
+    if(format == VERTEX_FORMAT_PACKED)
+    {
+        VertexQuantization quantization = makeVertexQuantization(view.vertices, view.vertexCount, view.stride);
+        std::vector<PackedVertex> packed(view.vertexCount);
+        packVertices(view.vertices, view.vertexCount, view.stride, quantization, packed.data());
+        glBufferData(GL_ARRAY_BUFFER, packed.size() * PACKED_VERTEX_STRIDE, packed.data(), GL_STATIC_DRAW);
+
+        for(int i = 0; i < 3; ++i)
+        {
+            mesh.positionScale[i] = quantization.scale[i];
+            mesh.positionBias[i] = quantization.bias[i];
+        }
+        setVertexAttributes(format, PACKED_VERTEX_STRIDE);
+    }
+    else
+    {
+        glBufferData(GL_ARRAY_BUFFER, view.getVertexSize(), view.vertices, GL_STATIC_DRAW);
+        setVertexAttributes(format, view.stride);
+    }
+
+    if(indexed && canUse16BitIndices(view.vertexCount))
+    {
+        std::vector<unsigned short> narrowed(view.indexCount);
+        narrowIndices(view.indices, view.indexCount, narrowed.data());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, narrowed.size() * sizeof(unsigned short), narrowed.data(), GL_STATIC_DRAW);
+        mesh.indexType = GL_UNSIGNED_SHORT;
+    }
+    else if(indexed)
+    {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, view.getIndexSize(), view.indices, GL_STATIC_DRAW);
+    }
+
+    mesh.nIndices = indexed ? view.indexCount : view.vertexCount;
+    if(view.strips)
+        mesh.primitive = GL_TRIANGLE_STRIP;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// builder mode: write the mesh straight into mapped buffers
+///////////////////////////////////////////////////////////////////////////////
+void uploadMesh(GLMesh& mesh, unsigned int vertexCount, unsigned int indexCount, const MeshWriter& write)
+{
+    createBuffers(mesh, indexCount > 0);
+
+    writeBuffers((GLsizeiptr)vertexCount * MESH_VERTEX_STRIDE, (GLsizeiptr)indexCount * sizeof(unsigned int),
+                 [&](void* vertices, unsigned int* indices)
+    {
+        write((float*)vertices, indices);
+    });
+
+    // the write mapping cannot be read, so the vertices are mapped again for reading
+    // (or copied back if that fails) to bound them
+    GLsizeiptr vertexSize = (GLsizeiptr)vertexCount * MESH_VERTEX_STRIDE;
+    const float* vertices = vertexCount > 0 ? (const float*)glMapBufferRange(GL_ARRAY_BUFFER, 0, vertexSize, GL_MAP_READ_BIT) : 0;
+    if(vertices)
+    {
+        setBoundingSphere(mesh, MeshView(vertices, vertexCount));
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    else if(vertexCount > 0)
+    {
+        std::vector<float> vertexData((std::size_t)vertexCount * MESH_VERTEX_FLOATS);
+        glGetBufferSubData(GL_ARRAY_BUFFER, 0, vertexSize, vertexData.data());
+        setBoundingSphere(mesh, MeshView(vertexData.data(), vertexCount));
+    }
+
+    mesh.nIndices = indexCount > 0 ? indexCount : vertexCount;
+    setVertexAttributes(VERTEX_FORMAT_FLOAT, MESH_VERTEX_STRIDE);
+}
+
+void uploadPackedMesh(GLMesh& mesh, unsigned int vertexCount, unsigned int indexCount, const PackedMeshWriter& write)
+{
+    createBuffers(mesh, indexCount > 0);
+
+    VertexQuantization quantization = {};
+    writeBuffers((GLsizeiptr)vertexCount * PACKED_VERTEX_STRIDE, (GLsizeiptr)indexCount * sizeof(unsigned int),
+                 [&](void* vertices, unsigned int* indices)
+    {
+        write((PackedVertex*)vertices, indices, quantization);
+    });
+
+    // the packed positions lie in the box of the quantization; its corners bound them
+    float radius2 = 0.0f;
+    for(int i = 0; i < 3; ++i)
+    {
+        mesh.positionScale[i] = quantization.scale[i];
+        mesh.positionBias[i] = quantization.bias[i];
+        mesh.boundingSphere[i] = quantization.bias[i];
+        radius2 += quantization.scale[i] * quantization.scale[i];
+    }
+    mesh.boundingSphere[3] = std::sqrt(radius2);
+    mesh.nIndices = indexCount > 0 ? indexCount : vertexCount;
+    setVertexAttributes(VERTEX_FORMAT_PACKED, PACKED_VERTEX_STRIDE);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// rewrite a vertex range of an uploaded mesh
+///////////////////////////////////////////////////////////////////////////////
+void updateMeshVertices(GLMesh& mesh, const MeshView& view, VertexFormat format,
+                        unsigned int firstVertex, unsigned int vertexCount)
+{
+    if(firstVertex >= view.vertexCount)
+        return;
+    if(vertexCount == 0 || firstVertex + vertexCount > view.vertexCount)
+        vertexCount = view.vertexCount - firstVertex;
+
+    setBoundingSphere(mesh, view);
+    glBindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+    if(format != VERTEX_FORMAT_PACKED)
+    {
+        const char* src = (const char*)view.vertices + (std::size_t)firstVertex * view.stride;
+        glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)firstVertex * view.stride, (GLsizeiptr)vertexCount * view.stride, src);
+        return;
+    }
+
+    // the positions are quantized to the bounds of the whole mesh; if those
+    // moved, every vertex has to be packed again with the new scale and bias
+    VertexQuantization quantization = makeVertexQuantization(view.vertices, view.vertexCount, view.stride);
+    bool same = true;
+    for(int i = 0; i < 3; ++i)
+    {
+        same = same && quantization.scale[i] == mesh.positionScale[i] && quantization.bias[i] == mesh.positionBias[i];
+        mesh.positionScale[i] = quantization.scale[i];
+        mesh.positionBias[i] = quantization.bias[i];
+    }
+    if(!same)
+    {
+        firstVertex = 0;
+        vertexCount = view.vertexCount;
+    }
+
+    std::vector<PackedVertex> packed(vertexCount);
+    const float* src = (const float*)((const char*)view.vertices + (std::size_t)firstVertex * view.stride);
+    packVertices(src, vertexCount, view.stride, quantization, packed.data());
+    glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)firstVertex * PACKED_VERTEX_STRIDE, packed.size() * PACKED_VERTEX_STRIDE, packed.data());
+}
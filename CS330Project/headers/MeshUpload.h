@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshUpload.h
+// ============
+// Creates the VAO/VBO/EBO of a GLMesh with the V/N/T layout of the object
+// shaders (location 0 position, 1 normal, 2 tex coord), as float or packed
+// vertices (see VertexFormat.h).
+//
+// - uploadMesh(mesh, view)  : buffers the memory a MeshView points at; the
+//                             only copy is the driver's (packing a float
+//                             view or narrowing its indices to 16 bits makes
+//                             one temporary copy)
+// - uploadMesh(mesh, counts, write): builder mode; the buffers are allocated
+//                             and mapped, and write() fills them in place, so
+//                             no CPU-side copy of the mesh exists at all
+// - uploadPackedMesh(mesh, counts, write): builder mode with PackedVertex
+// - updateMeshVertices(mesh, view): rewrites a range of the VBO with
+//                             glBufferSubData after the vertices of the view
+//                             changed in place (e.g. Sphere::setRadius());
+//                             the VAO and index buffer are kept. Only for
+//                             standalone meshes whose generator stays alive:
+//                             the scene meshes of Source.cpp are reordered
+//                             and shared, and change size through their
+//                             model matrices instead
+//
+// Every variant sets the bounding sphere of the mesh; builder mode with float
+// vertices maps the vertex buffer again for reading once write() is done.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MESH_UPLOAD_H
+#define MESH_UPLOAD_H
+
+#include <functional>
+#include "AssetManager.h"
+#include "MeshView.h"
+#include "VertexFormat.h"
+
+// writes vertexCount interleaved V/N/T vertices and indexCount indices (null if 0)
+typedef std::function<void(float* vertices, unsigned int* indices)> MeshWriter;
+
+// writes vertexCount packed vertices and indexCount indices (null if 0), and
+// the quantization the positions were packed with
+typedef std::function<void(PackedVertex* vertices, unsigned int* indices,
+                           VertexQuantization& quantization)> PackedMeshWriter;
+
+// upload the data of a view, packed first with VERTEX_FORMAT_PACKED
+// indices are stored as 16 bits when the vertex count allows it
+// strip views are drawn as GL_TRIANGLE_STRIP with GL_PRIMITIVE_RESTART_FIXED_INDEX enabled
+// the view only has to live until the call returns
+// OpenGL RC must be set before calling it
+void uploadMesh(GLMesh& mesh, const MeshView& view, VertexFormat format=VERTEX_FORMAT_FLOAT);
+
+// allocate the buffers, map them and let write() fill them in place
+// OpenGL RC must be set before calling it
+void uploadMesh(GLMesh& mesh, unsigned int vertexCount, unsigned int indexCount, const MeshWriter& write);
+void uploadPackedMesh(GLMesh& mesh, unsigned int vertexCount, unsigned int indexCount, const PackedMeshWriter& write);
+
+// buffer vertices [firstVertex, firstVertex + vertexCount) of a view again, vertexCount 0 for the rest of the view
+// the mesh must come from uploadMesh(mesh, view, format) with the same vertex order and count, so
+// not from a reordered (optimized) copy. packed meshes whose bounds changed are packed again whole
+// OpenGL RC must be set before calling it
+void updateMeshVertices(GLMesh& mesh, const MeshView& view, VertexFormat format=VERTEX_FORMAT_FLOAT,
+                        unsigned int firstVertex=0, unsigned int vertexCount=0);
+
+#endif
@@ -0,0 +1,44 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshView.h
+// ==========
+// Non-owning view of mesh data ready to be uploaded: interleaved V/N/T
+// vertices (3 position, 3 normal, 2 tex coord floats) and optional triangle
+// indices. The memory stays owned by the caller (a Sphere, a Cylinder, a
+// static array); a view only has to live until the upload returns.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MESH_VIEW_H
+#define MESH_VIEW_H
+
+const unsigned int MESH_VERTEX_FLOATS = 8;                                  // V/N/T
+const unsigned int MESH_VERTEX_STRIDE = MESH_VERTEX_FLOATS * sizeof(float);  // 32 bytes
+const unsigned int MESH_RESTART_INDEX = 0xffffffff;     // ends a strip; 0xffff once narrowed to 16 bits
+
+// arrays built by Sphere and Cylinder; the triangle indices are always built
+enum MeshOutput
+{
+    MESH_OUTPUT_INTERLEAVED = 1,    // interleaved V/N/T, used for uploading and draw()
+    MESH_OUTPUT_SEPARATE    = 2,    // separate vertices, normals and tex coords
+    MESH_OUTPUT_LINES       = 4,    // line indices of the wireframe, used by drawLines()
+    MESH_OUTPUT_ALL         = MESH_OUTPUT_INTERLEAVED | MESH_OUTPUT_SEPARATE | MESH_OUTPUT_LINES
+};
+
+struct MeshView
+{
+    const float* vertices;          // interleaved V/N/T
+    unsigned int vertexCount;
+    unsigned int stride;            // # of bytes between vertices
+    const unsigned int* indices;    // triangle indices, null to draw the vertices in order
+    unsigned int indexCount;
+    bool strips;                    // indices are triangle strips separated by MESH_RESTART_INDEX
+
+    MeshView(const float* vertices=0, unsigned int vertexCount=0, const unsigned int* indices=0,
+             unsigned int indexCount=0, unsigned int stride=MESH_VERTEX_STRIDE)
+        : vertices(vertices), vertexCount(vertexCount), stride(stride), indices(indices), indexCount(indexCount),
+          strips(false) {}
+
+    unsigned int getVertexSize() const  { return vertexCount * stride; }                    // # of bytes
+    unsigned int getIndexSize() const   { return indexCount * sizeof(unsigned int); }       // # of bytes
+};
+
+#endif
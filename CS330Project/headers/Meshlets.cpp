@@ -0,0 +1,379 @@
+///////////////////////////////////////////////////////////////////////////////
+// Meshlets.cpp
+// ============
+// Greedy meshlet building, meshlet bounds and the SIMD culling kernel.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include "MeshOptimizer.h"
+#include "Meshlets.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESHLET_SSE2 1
+#include <emmintrin.h>
+#endif
+
+const unsigned int NO_TRIANGLE = 0xffffffff;
+const float MIN_CONE_DOT = 0.1f;    // a wider cone (about 84 degrees from the axis) is never culled
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// helpers
+///////////////////////////////////////////////////////////////////////////////
+static const float* getVertex(const float* vertices, unsigned int stride, unsigned int index)
+{
+    return (const float*)((const unsigned char*)vertices + (std::size_t)index * stride);
+}
+
+// unit normal of a triangle, 0 when it has no area
+static void getTriangleNormal(const float* p0, const float* p1, const float* p2, float normal[3])
+{
+    float u[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+    float v[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+    normal[0] = u[1] * v[2] - u[2] * v[1];
+    normal[1] = u[2] * v[0] - u[0] * v[2];
+    normal[2] = u[0] * v[1] - u[1] * v[0];
+    float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+    float scale = length > 0 ? 1.0f / length : 0.0f;
+    normal[0] *= scale;
+    normal[1] *= scale;
+    normal[2] *= scale;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the sphere is centred on the bounds of the vertices; the cone axis is the
+// mean of the unit triangle normals and the cutoff the sine of the widest
+// angle between the axis and a normal
+///////////////////////////////////////////////////////////////////////////////
+static void computeMeshletBounds(Meshlet& meshlet, const unsigned int* indices, const float* vertices,
+                                 unsigned int stride, const float* normals, const unsigned int* triangles)
+{
+    float low[3] = { FLT_MAX, FLT_MAX, FLT_MAX }, high[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    float axis[3] = { 0.0f, 0.0f, 0.0f };
+    unsigned int triangleCount = meshlet.indexCount / 3;
+    for(unsigned int i = 0; i < meshlet.indexCount; ++i)
+    {
+        const float* p = getVertex(vertices, stride, indices[i]);
+        for(int k = 0; k < 3; ++k)
+        {
+            low[k] = p[k] < low[k] ? p[k] : low[k];
+            high[k] = p[k] > high[k] ? p[k] : high[k];
+        }
+    }
+    for(unsigned int t = 0; t < triangleCount; ++t)
+    {
+        const float* n = normals + (std::size_t)triangles[t] * 3;
+        axis[0] += n[0];
+        axis[1] += n[1];
+        axis[2] += n[2];
+    }
+
+    float radius = 0.0f;
+    for(int k = 0; k < 3; ++k)
+        meshlet.center[k] = (low[k] + high[k]) * 0.5f;
+    for(unsigned int i = 0; i < meshlet.indexCount; ++i)
+    {
+        const float* p = getVertex(vertices, stride, indices[i]);
+        float dx = p[0] - meshlet.center[0], dy = p[1] - meshlet.center[1], dz = p[2] - meshlet.center[2];
+        float distance = dx * dx + dy * dy + dz * dz;
+        radius = distance > radius ? distance : radius;
+    }
+    meshlet.radius = sqrtf(radius);
+
+    float length = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+    float minDot = -1.0f;
+    if(length > 0)
+    {
+        for(int k = 0; k < 3; ++k)
+            axis[k] /= length;
+        minDot = 1.0f;
+        for(unsigned int t = 0; t < triangleCount; ++t)
+        {
+            const float* n = normals + (std::size_t)triangles[t] * 3;
+            float d = n[0] * axis[0] + n[1] * axis[1] + n[2] * axis[2];
+            if(n[0] != 0 || n[1] != 0 || n[2] != 0)
+                minDot = d < minDot ? d : minDot;
+        }
+    }
+    for(int k = 0; k < 3; ++k)
+        meshlet.coneAxis[k] = axis[k];
+    meshlet.coneCutoff = minDot < MIN_CONE_DOT ? 1.0f : sqrtf(1.0f - minDot * minDot);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// a meshlet grows by the triangle around its vertices that adds the fewest
+// new vertices, then the one closest to its mean normal (for a narrow cone).
+// it is closed when it is full or has no neighbour left, and the next one
+// starts from the first triangle not taken, in the order of indices.
+// growing by shared vertices breaks the vertex cache order of the input, so
+// the triangles of each closed meshlet are put in Tipsify order again, over
+// indices local to the meshlet
+///////////////////////////////////////////////////////////////////////////////
+void buildMeshlets(unsigned int* dst, const unsigned int* indices, unsigned int indexCount,
+                   const float* vertices, unsigned int vertexCount, unsigned int stride,
+                   std::vector<Meshlet>& meshlets, unsigned int baseIndex)
+{
+    unsigned int triangleCount = indexCount / 3;
+
+    // triangles around each vertex, and the normal of each triangle
+    std::vector<unsigned int> offsets(vertexCount + 1, 0), adjacency(triangleCount * 3);
+    for(unsigned int i = 0; i < triangleCount * 3; ++i)
+        ++offsets[indices[i] + 1];
+    for(unsigned int v = 0; v < vertexCount; ++v)
+        offsets[v + 1] += offsets[v];
+    std::vector<unsigned int> next(offsets.begin(), offsets.end() - 1);
+    for(unsigned int i = 0; i < triangleCount * 3; ++i)
+        adjacency[next[indices[i]]++] = i / 3;
+
+    std::vector<float> normals((std::size_t)triangleCount * 3);
+    for(unsigned int t = 0; t < triangleCount; ++t)
+    {
+        getTriangleNormal(getVertex(vertices, stride, indices[t * 3]), getVertex(vertices, stride, indices[t * 3 + 1]),
+                          getVertex(vertices, stride, indices[t * 3 + 2]), &normals[(std::size_t)t * 3]);
+    }
+
+    std::vector<unsigned char> taken(triangleCount, 0);
+    std::vector<unsigned int> owner(vertexCount, NO_TRIANGLE);    // meshlet # last using a vertex
+    std::vector<unsigned int> meshletVertices, meshletTriangles;
+    std::vector<unsigned int> localIndex(vertexCount);                 // # of a vertex in the open meshlet
+    std::vector<unsigned int> localIndices, localOrdered;
+    float normalSum[3] = { 0.0f, 0.0f, 0.0f };
+    unsigned int meshletId = 0, scan = 0, written = 0;
+
+    while(true)
+    {
+        // the best neighbour of the open meshlet
+        unsigned int best = NO_TRIANGLE, bestNew = 4;
+        float bestDot = -FLT_MAX;
+        for(std::size_t i = 0; i < meshletVertices.size(); ++i)
+        {
+            unsigned int v = meshletVertices[i];
+            for(unsigned int k = offsets[v]; k < offsets[v + 1]; ++k)
+            {
+                unsigned int t = adjacency[k];
+                if(taken[t])
+                    continue;
+                unsigned int newVertices = 0;
+                for(int corner = 0; corner < 3; ++corner)
+                    newVertices += owner[indices[t * 3 + corner]] != meshletId;
+                const float* n = &normals[(std::size_t)t * 3];
+                float d = n[0] * normalSum[0] + n[1] * normalSum[1] + n[2] * normalSum[2];
+                if(newVertices < bestNew || (newVertices == bestNew && d > bestDot))
+                {
+                    best = t;
+                    bestNew = newVertices;
+                    bestDot = d;
+                }
+            }
+        }
+
+        bool full = best != NO_TRIANGLE && (meshletVertices.size() + bestNew > MESHLET_MAX_VERTICES ||
+                                            meshletTriangles.size() == MESHLET_MAX_TRIANGLES);
+        if(best == NO_TRIANGLE || full)
+        {
+            // close the open meshlet
+            if(!meshletTriangles.empty())
+            {
+                Meshlet meshlet;
+                meshlet.firstIndex = baseIndex + written;
+                meshlet.indexCount = (unsigned int)meshletTriangles.size() * 3;
+                unsigned int* out = dst + written;
+                for(std::size_t i = 0; i < meshletTriangles.size(); ++i)
+                {
+                    for(int corner = 0; corner < 3; ++corner)
+                        out[i * 3 + corner] = indices[meshletTriangles[i] * 3 + corner];
+                }
+                computeMeshletBounds(meshlet, out, vertices, stride, normals.data(), meshletTriangles.data());
+
+                localIndices.resize(meshlet.indexCount);
+                localOrdered.resize(meshlet.indexCount);
+                for(unsigned int i = 0; i < meshlet.indexCount; ++i)
+                    localIndices[i] = localIndex[out[i]];
+                optimizeVertexCache(localOrdered.data(), localIndices.data(), meshlet.indexCount, (unsigned int)meshletVertices.size());
+                for(unsigned int i = 0; i < meshlet.indexCount; ++i)
+                    out[i] = meshletVertices[localOrdered[i]];
+
+                meshlets.push_back(meshlet);
+                written += meshlet.indexCount;
+                ++meshletId;
+                meshletVertices.clear();
+                meshletTriangles.clear();
+                normalSum[0] = normalSum[1] = normalSum[2] = 0.0f;
+            }
+
+            // a full meshlet is continued by its best neighbour, anything else by the next triangle left
+            if(!full)
+            {
+                while(scan < triangleCount && taken[scan])
+                    ++scan;
+                if(scan == triangleCount)
+                    break;
+                best = scan;
+            }
+        }
+
+        taken[best] = 1;
+        meshletTriangles.push_back(best);
+        for(int corner = 0; corner < 3; ++corner)
+        {
+            unsigned int v = indices[best * 3 + corner];
+            if(owner[v] != meshletId)
+            {
+                owner[v] = meshletId;
+                localIndex[v] = (unsigned int)meshletVertices.size();
+                meshletVertices.push_back(v);
+            }
+        }
+        const float* n = &normals[(std::size_t)best * 3];
+        normalSum[0] += n[0];
+        normalSum[1] += n[1];
+        normalSum[2] += n[2];
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// Gribb, Hartmann: each plane is the last row of the matrix plus or minus
+// another row
+///////////////////////////////////////////////////////////////////////////////
+void getFrustumPlanes(const float matrix[16], float planes[6][4])
+{
+    for(int i = 0; i < 6; ++i)
+    {
+        int row = i / 2;
+        float sign = (i % 2) ? -1.0f : 1.0f;
+        for(int k = 0; k < 4; ++k)
+            planes[i][k] = matrix[k * 4 + 3] + sign * matrix[k * 4 + row];
+
+        float length = sqrtf(planes[i][0] * planes[i][0] + planes[i][1] * planes[i][1] + planes[i][2] * planes[i][2]);
+        if(length > 0)
+        {
+            for(int k = 0; k < 4; ++k)
+                planes[i][k] /= length;
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// scalar test of one meshlet, also the tail of the SIMD version
+///////////////////////////////////////////////////////////////////////////////
+static bool isMeshletVisible(const Meshlet& meshlet, const float planes[6][4], const float camera[3])
+{
+    const float* c = meshlet.center;
+    for(int i = 0; i < 6; ++i)
+    {
+        if(planes[i][0] * c[0] + planes[i][1] * c[1] + planes[i][2] * c[2] + planes[i][3] < -meshlet.radius)
+            return false;
+    }
+
+    float v[3] = { c[0] - camera[0], c[1] - camera[1], c[2] - camera[2] };
+    float distance = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    float facing = v[0] * meshlet.coneAxis[0] + v[1] * meshlet.coneAxis[1] + v[2] * meshlet.coneAxis[2];
+    return facing < meshlet.coneCutoff * distance + meshlet.radius;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// visibility of each meshlet into visible, 4 at a time with SSE2
+///////////////////////////////////////////////////////////////////////////////
+static void testMeshlets(const Meshlet* meshlets, unsigned int count, const float planes[6][4], const float camera[3],
+                         unsigned char* visible)
+{
+    unsigned int i = 0;
+#if MESHLET_SSE2
+    for(; i + 4 <= count; i += 4)
+    {
+        const Meshlet* m = meshlets + i;
+        __m128 cx = _mm_setr_ps(m[0].center[0], m[1].center[0], m[2].center[0], m[3].center[0]);
+        __m128 cy = _mm_setr_ps(m[0].center[1], m[1].center[1], m[2].center[1], m[3].center[1]);
+        __m128 cz = _mm_setr_ps(m[0].center[2], m[1].center[2], m[2].center[2], m[3].center[2]);
+        __m128 r = _mm_setr_ps(m[0].radius, m[1].radius, m[2].radius, m[3].radius);
+        __m128 negativeR = _mm_sub_ps(_mm_setzero_ps(), r);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for(int p = 0; p < 6; ++p)
+        {
+            __m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p][0]), cx), _mm_mul_ps(_mm_set1_ps(planes[p][1]), cy)),
+                                  _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes[p][2]), cz), _mm_set1_ps(planes[p][3])));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(d, negativeR));
+        }
+
+        __m128 vx = _mm_sub_ps(cx, _mm_set1_ps(camera[0]));
+        __m128 vy = _mm_sub_ps(cy, _mm_set1_ps(camera[1]));
+        __m128 vz = _mm_sub_ps(cz, _mm_set1_ps(camera[2]));
+        __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz)));
+        __m128 ax = _mm_setr_ps(m[0].coneAxis[0], m[1].coneAxis[0], m[2].coneAxis[0], m[3].coneAxis[0]);
+        __m128 ay = _mm_setr_ps(m[0].coneAxis[1], m[1].coneAxis[1], m[2].coneAxis[1], m[3].coneAxis[1]);
+        __m128 az = _mm_setr_ps(m[0].coneAxis[2], m[1].coneAxis[2], m[2].coneAxis[2], m[3].coneAxis[2]);
+        __m128 cutoff = _mm_setr_ps(m[0].coneCutoff, m[1].coneCutoff, m[2].coneCutoff, m[3].coneCutoff);
+        __m128 facing = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, ax), _mm_mul_ps(vy, ay)), _mm_mul_ps(vz, az));
+        __m128 front = _mm_cmplt_ps(facing, _mm_add_ps(_mm_mul_ps(cutoff, distance), r));
+
+        int mask = _mm_movemask_ps(_mm_and_ps(inside, front));
+        for(int k = 0; k < 4; ++k)
+            visible[i + k] = (mask >> k) & 1;
+    }
+#endif
+    for(; i < count; ++i)
+        visible[i] = isMeshletVisible(meshlets[i], planes, camera);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// meshlets next to each other in the index buffer share a command
+///////////////////////////////////////////////////////////////////////////////
+unsigned int cullMeshlets(const Meshlet* meshlets, unsigned int count, const float planes[6][4], const float camera[3],
+                          std::vector<DrawElementsIndirectCommand>& commands)
+{
+    std::vector<unsigned char> visible(count);
+    testMeshlets(meshlets, count, planes, camera, visible.data());
+
+    unsigned int indexCount = 0;
+    bool extending = false;
+    for(unsigned int i = 0; i < count; ++i)
+    {
+        if(!visible[i])
+        {
+            extending = false;
+            continue;
+        }
+
+        const Meshlet& meshlet = meshlets[i];
+        if(extending && commands.back().firstIndex + commands.back().count == meshlet.firstIndex)
+        {
+            commands.back().count += meshlet.indexCount;
+        }
+        else
+        {
+            DrawElementsIndirectCommand command = { meshlet.indexCount, 1, meshlet.firstIndex, 0, 0 };
+            commands.push_back(command);
+        }
+        extending = true;
+        indexCount += meshlet.indexCount;
+    }
+    return indexCount / 3;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+const char* getMeshletKernelName()
+{
+#if MESHLET_SSE2
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,69 @@
+///////////////////////////////////////////////////////////////////////////////
+// Meshlets.h
+// ==========
+// Clusters of at most MESHLET_MAX_VERTICES vertices and MESHLET_MAX_TRIANGLES
+// triangles of an indexed triangle mesh (interleaved vertices of any stride,
+// position and normal in the first 6 floats), for culling parts of a mesh.
+// - buildMeshlets()    : reorders the triangles into meshlets grown across
+//                        shared vertices, each with a bounding sphere and
+//                        a cone around its triangle normals
+// - getFrustumPlanes() : planes of a model view projection matrix, in the
+//                        object space of the model
+// - cullMeshlets()     : keeps the meshlets inside the frustum that face the
+//                        camera, 4 at a time (SSE2) or one by one, as
+//                        indirect draw commands
+//
+// A meshlet is a range of the reordered indices, so the survivors are drawn
+// from the unchanged index buffer, one command per run of consecutive
+// meshlets. A meshlet faces away when every normal of its cone does from
+// every point of its sphere: dot(center - camera, axis) >= cutoff * distance
+// + radius. Culling in object space keeps this exact under non-uniform scale.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef MESHLETS_H
+#define MESHLETS_H
+
+#include <vector>
+
+const unsigned int MESHLET_MAX_VERTICES = 64;
+const unsigned int MESHLET_MAX_TRIANGLES = 124;
+
+struct Meshlet
+{
+    unsigned int firstIndex;
+    unsigned int indexCount;
+    float center[3];            // bounding sphere
+    float radius;
+    float coneAxis[3];          // mean triangle normal
+    float coneCutoff;           // sine of the widest angle of a normal from the axis, 1 when it cannot be culled
+};
+
+// layout of glMultiDrawElementsIndirect()
+struct DrawElementsIndirectCommand
+{
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    int baseVertex;
+    unsigned int baseInstance;
+};
+
+// reorder the triangles of indices into dst (may not alias indices) meshlet by meshlet
+// and append the meshlets, whose first indices are offset by baseIndex
+void buildMeshlets(unsigned int* dst, const unsigned int* indices, unsigned int indexCount,
+                   const float* vertices, unsigned int vertexCount, unsigned int stride,
+                   std::vector<Meshlet>& meshlets, unsigned int baseIndex=0);
+
+// planes a, b, c, d with unit normals, ax + by + cz + d >= 0 inside, of a
+// column-major OpenGL matrix; with a model view projection they are in object space
+void getFrustumPlanes(const float matrix[16], float planes[6][4]);
+
+// append a command per run of consecutive meshlets inside planes that face camera
+// (an object space position); returns the # of triangles the commands draw
+unsigned int cullMeshlets(const Meshlet* meshlets, unsigned int count, const float planes[6][4], const float camera[3],
+                          std::vector<DrawElementsIndirectCommand>& commands);
+
+// name of the compiled cullMeshlets() kernel: "sse2" or "scalar"
+const char* getMeshletKernelName();
+
+#endif
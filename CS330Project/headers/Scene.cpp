@@ -0,0 +1,589 @@
+///////////////////////////////////////////////////////////////////////////////
+// Scene.cpp
+// =========
+// Text parser, binary image builder and loader of scene descriptions.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include "Scene.h"
+
+
+
+// constants //////////////////////////////////////////////////////////////////
+const char SCENE_MAGIC[8] = { 'C', 'S', '3', '3', '0', 'S', 'C', 'N' };
+const unsigned int SCENE_VERSION = 1;
+const float SCENE_DEG_TO_RAD = 3.14159265f / 180.0f;
+
+// smallest tessellations the Sphere and Cylinder generators accept
+const int SCENE_MIN_SECTORS = 3;
+const int SCENE_MIN_SPHERE_STACKS = 2;
+const int SCENE_MIN_CYLINDER_STACKS = 1;
+
+// one whitespace separated word of a line
+struct SceneToken
+{
+    const char* text;
+    std::size_t length;
+
+    bool is(const char* word) const
+    {
+        return strlen(word) == length && strncmp(text, word, length) == 0;
+    }
+    std::string str() const { return std::string(text, length); }
+};
+
+// scene being parsed, before it is laid out as a binary image
+struct SceneSource
+{
+    std::vector<std::string> texturePaths;
+    std::vector<SceneMesh> meshes;
+    std::vector<SceneMaterial> materials;
+    std::vector<SceneLight> lights;
+    std::vector<float> models;
+    std::vector<unsigned int> objectMeshes;
+    std::vector<unsigned int> objectMaterials;
+};
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// round up to a multiple of 16
+///////////////////////////////////////////////////////////////////////////////
+static unsigned int align16(std::size_t offset)
+{
+    return (unsigned int)((offset + 15) & ~(std::size_t)15);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the sectors and stacks of a sphere or cylinder are at least the generator minimums
+///////////////////////////////////////////////////////////////////////////////
+static bool hasValidTessellation(const SceneMesh& mesh)
+{
+    if(mesh.type == SCENE_MESH_SPHERE)
+        return mesh.sectors >= SCENE_MIN_SECTORS && mesh.stacks >= SCENE_MIN_SPHERE_STACKS;
+    if(mesh.type == SCENE_MESH_CYLINDER)
+        return mesh.sectors >= SCENE_MIN_SECTORS && mesh.stacks >= SCENE_MIN_CYLINDER_STACKS;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// parse a number token; returns false if the whole token is not a number
+///////////////////////////////////////////////////////////////////////////////
+static bool toFloat(const SceneToken& token, float& value)
+{
+    char buffer[64];
+    if(token.length >= sizeof(buffer))
+        return false;
+    memcpy(buffer, token.text, token.length);
+    buffer[token.length] = '\0';
+
+    char* end;
+    value = strtof(buffer, &end);
+    return end == buffer + token.length;
+}
+
+static bool toInt(const SceneToken& token, int& value)
+{
+    float f;
+    if(!toFloat(token, f) || f != (float)(int)f)
+        return false;
+    value = (int)f;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// model = translate * rotate * scale, column-major
+///////////////////////////////////////////////////////////////////////////////
+static void composeModel(const float translation[3], float degrees, const float axis[3],
+                         const float scale[3], float* m)
+{
+    float x = axis[0], y = axis[1], z = axis[2];
+    float length = sqrtf(x * x + y * y + z * z);
+    if(length > 0.0f)
+    {
+        x /= length;
+        y /= length;
+        z /= length;
+    }
+    else
+    {
+        degrees = 0.0f;
+    }
+
+    float c = cosf(degrees * SCENE_DEG_TO_RAD);
+    float s = sinf(degrees * SCENE_DEG_TO_RAD);
+    float t = 1.0f - c;
+
+    // rotation columns, each scaled by the matching scale factor
+    m[0]  = (t * x * x + c) * scale[0];
+    m[1]  = (t * x * y + s * z) * scale[0];
+    m[2]  = (t * x * z - s * y) * scale[0];
+    m[3]  = 0.0f;
+    m[4]  = (t * x * y - s * z) * scale[1];
+    m[5]  = (t * y * y + c) * scale[1];
+    m[6]  = (t * y * z + s * x) * scale[1];
+    m[7]  = 0.0f;
+    m[8]  = (t * x * z + s * y) * scale[2];
+    m[9]  = (t * y * z - s * x) * scale[2];
+    m[10] = (t * z * z + c) * scale[2];
+    m[11] = 0.0f;
+    m[12] = translation[0];
+    m[13] = translation[1];
+    m[14] = translation[2];
+    m[15] = 1.0f;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// look up a name defined by an earlier statement
+///////////////////////////////////////////////////////////////////////////////
+static bool findName(const std::map<std::string, int>& names, const SceneToken& token, int& index)
+{
+    std::map<std::string, int>::const_iterator it = names.find(token.str());
+    if(it == names.end())
+        return false;
+    index = it->second;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+Scene::Scene() : header(0), models(0), objectMeshes(0), objectMaterials(0), meshes(0),
+                 materials(0), lights(0), textureOffsets(0), strings(0)
+{
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// dealloc
+///////////////////////////////////////////////////////////////////////////////
+void Scene::clear()
+{
+    file.close();
+    std::vector<unsigned int>().swap(storage);
+    header = 0;
+    models = 0;
+    objectMeshes = 0;
+    objectMaterials = 0;
+    meshes = 0;
+    materials = 0;
+    lights = 0;
+    textureOffsets = 0;
+    strings = 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// load a binary or text scene
+///////////////////////////////////////////////////////////////////////////////
+bool Scene::load(const char* filename)
+{
+    clear();
+    if(!file.open(filename))
+        return false;
+
+    // binary: use the mapping in place
+    if(file.getSize() >= sizeof(SCENE_MAGIC) && memcmp(file.getData(), SCENE_MAGIC, sizeof(SCENE_MAGIC)) == 0)
+    {
+        if(attach(file.getData(), file.getSize()))
+            return true;
+        std::cout << "Invalid binary scene " << filename << std::endl;
+        clear();
+        return false;
+    }
+
+    // text: parse() copies what it needs before clear() unmaps the file
+    if(parse((const char*)file.getData(), file.getSize()))
+        return true;
+    std::cout << "Failed to parse scene " << filename << std::endl;
+    clear();
+    return false;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// parse the text form and lay it out as a binary image in storage
+///////////////////////////////////////////////////////////////////////////////
+bool Scene::parse(const char* text, std::size_t size)
+{
+    SceneSource source;
+    std::map<std::string, int> textureNames, meshNames, materialNames;
+    std::vector<SceneToken> tokens;
+
+    int lineNumber = 0;
+    std::size_t position = 0;
+    while(position < size)
+    {
+        // split the next line into tokens
+        ++lineNumber;
+        tokens.clear();
+        while(position < size && text[position] != '\n')
+        {
+            char c = text[position];
+            if(c == '#')
+            {
+                while(position < size && text[position] != '\n')
+                    ++position;
+                break;
+            }
+            if(c == ' ' || c == '\t' || c == '\r')
+            {
+                ++position;
+                continue;
+            }
+
+            SceneToken token;
+            token.text = text + position;
+            while(position < size && text[position] != '\n' && text[position] != '#' &&
+                  text[position] != ' ' && text[position] != '\t' && text[position] != '\r')
+            {
+                ++position;
+            }
+            token.length = (std::size_t)(text + position - token.text);
+            tokens.push_back(token);
+        }
+        ++position; // skip '\n'
+
+        if(tokens.empty())
+            continue;
+
+        const SceneToken& keyword = tokens[0];
+        std::size_t count = tokens.size();
+        bool ok = true;
+
+        if(keyword.is("texture") && count == 3)
+        {
+            textureNames[tokens[1].str()] = (int)source.texturePaths.size();
+            source.texturePaths.push_back(tokens[2].str());
+        }
+        else if(keyword.is("mesh") && count >= 3)
+        {
+            SceneMesh mesh;
+            memset(&mesh, 0, sizeof(mesh));
+            mesh.smooth = 1;
+
+            std::size_t next = 3;
+            if(tokens[2].is("sphere") && count >= 6)
+            {
+                mesh.type = SCENE_MESH_SPHERE;
+                ok = toFloat(tokens[3], mesh.params[0]) && toInt(tokens[4], mesh.sectors) && toInt(tokens[5], mesh.stacks);
+                next = 6;
+            }
+            else if(tokens[2].is("cylinder") && count >= 8)
+            {
+                mesh.type = SCENE_MESH_CYLINDER;
+                ok = toFloat(tokens[3], mesh.params[0]) && toFloat(tokens[4], mesh.params[1]) &&
+                     toFloat(tokens[5], mesh.params[2]) && toInt(tokens[6], mesh.sectors) && toInt(tokens[7], mesh.stacks);
+                next = 8;
+            }
+            else if(tokens[2].is("plane"))
+                mesh.type = SCENE_MESH_PLANE;
+            else if(tokens[2].is("box"))
+                mesh.type = SCENE_MESH_BOX;
+            else
+                ok = false;
+
+            if(ok && next < count)
+            {
+                ok = next + 1 == count && (tokens[next].is("smooth") || tokens[next].is("flat"));
+                mesh.smooth = tokens[next].is("smooth") ? 1 : 0;
+            }
+            if(ok && !hasValidTessellation(mesh))
+            {
+                std::cout << "Scene line " << lineNumber << ": too few sectors or stacks (at least " << SCENE_MIN_SECTORS << " sectors, "
+                          << SCENE_MIN_SPHERE_STACKS << " sphere stacks, " << SCENE_MIN_CYLINDER_STACKS << " cylinder stack)" << std::endl;
+                ok = false;
+            }
+
+            meshNames[tokens[1].str()] = (int)source.meshes.size();
+            source.meshes.push_back(mesh);
+        }
+        else if(keyword.is("material") && count >= 4)
+        {
+            SceneMaterial material;
+            material.program = tokens[2].is("plane") ? SCENE_PROGRAM_PLANE : SCENE_PROGRAM_OBJECT;
+            material.overlay = -1;
+            material.textureScale[0] = material.textureScale[1] = 1.0f;
+            ok = (tokens[2].is("plane") || tokens[2].is("object")) && findName(textureNames, tokens[3], material.texture);
+
+            for(std::size_t i = 4; ok && i < count; )
+            {
+                if(tokens[i].is("overlay") && i + 1 < count)
+                {
+                    ok = findName(textureNames, tokens[i+1], material.overlay);
+                    i += 2;
+                }
+                else if(tokens[i].is("textureScale") && i + 2 < count)
+                {
+                    ok = toFloat(tokens[i+1], material.textureScale[0]) && toFloat(tokens[i+2], material.textureScale[1]);
+                    i += 3;
+                }
+                else
+                    ok = false;
+            }
+
+            materialNames[tokens[1].str()] = (int)source.materials.size();
+            source.materials.push_back(material);
+        }
+        else if(keyword.is("light") && (count == 7 || count == 9))
+        {
+            SceneLight light;
+            light.scale = 1.0f;
+            for(int i = 0; ok && i < 3; ++i)
+                ok = toFloat(tokens[1+i], light.position[i]) && toFloat(tokens[4+i], light.color[i]);
+            if(ok && count == 9)
+                ok = tokens[7].is("scale") && toFloat(tokens[8], light.scale);
+            source.lights.push_back(light);
+        }
+        else if(keyword.is("object") && count >= 3)
+        {
+            int mesh = 0, material = 0;
+            ok = findName(meshNames, tokens[1], mesh) && findName(materialNames, tokens[2], material);
+
+            float translation[3] = { 0.0f, 0.0f, 0.0f };
+            float degrees = 0.0f;
+            float axis[3] = { 1.0f, 0.0f, 0.0f };
+            float scale[3] = { 1.0f, 1.0f, 1.0f };
+            for(std::size_t i = 3; ok && i < count; )
+            {
+                if(tokens[i].is("translate") && i + 3 < count)
+                {
+                    ok = toFloat(tokens[i+1], translation[0]) && toFloat(tokens[i+2], translation[1]) && toFloat(tokens[i+3], translation[2]);
+                    i += 4;
+                }
+                else if(tokens[i].is("rotate") && i + 4 < count)
+                {
+                    ok = toFloat(tokens[i+1], degrees) && toFloat(tokens[i+2], axis[0]) &&
+                         toFloat(tokens[i+3], axis[1]) && toFloat(tokens[i+4], axis[2]);
+                    i += 5;
+                }
+                else if(tokens[i].is("scale") && i + 1 < count)
+                {
+                    // uniform "scale s" unless three numbers follow
+                    if(i + 3 < count && toFloat(tokens[i+2], scale[1]) && toFloat(tokens[i+3], scale[2]))
+                    {
+                        ok = toFloat(tokens[i+1], scale[0]);
+                        i += 4;
+                    }
+                    else
+                    {
+                        ok = toFloat(tokens[i+1], scale[0]);
+                        scale[1] = scale[2] = scale[0];
+                        i += 2;
+                    }
+                }
+                else
+                    ok = false;
+            }
+
+            std::size_t offset = source.models.size();
+            source.models.resize(offset + 16);
+            composeModel(translation, degrees, axis, scale, &source.models[offset]);
+            source.objectMeshes.push_back((unsigned int)mesh);
+            source.objectMaterials.push_back((unsigned int)material);
+        }
+        else
+            ok = false;
+
+        if(!ok)
+        {
+            std::cout << "Scene line " << lineNumber << ": invalid statement \"" << keyword.str() << "\"" << std::endl;
+            return false;
+        }
+    }
+
+    // sort the objects by material, then mesh; stable so the file order is kept inside a group
+    std::size_t objectCount = source.objectMeshes.size();
+    std::vector<unsigned int> order(objectCount);
+    for(std::size_t i = 0; i < objectCount; ++i)
+        order[i] = (unsigned int)i;
+    std::stable_sort(order.begin(), order.end(), [&source](unsigned int a, unsigned int b)
+    {
+        if(source.objectMaterials[a] != source.objectMaterials[b])
+            return source.objectMaterials[a] < source.objectMaterials[b];
+        return source.objectMeshes[a] < source.objectMeshes[b];
+    });
+
+    // lay out the binary image
+    std::size_t stringSize = 0;
+    for(std::size_t i = 0; i < source.texturePaths.size(); ++i)
+        stringSize += source.texturePaths[i].size() + 1;
+
+    SceneHeader layout;
+    memset(&layout, 0, sizeof(layout));
+    memcpy(layout.magic, SCENE_MAGIC, sizeof(SCENE_MAGIC));
+    layout.version = SCENE_VERSION;
+    layout.objectCount = (unsigned int)objectCount;
+    layout.meshCount = (unsigned int)source.meshes.size();
+    layout.materialCount = (unsigned int)source.materials.size();
+    layout.textureCount = (unsigned int)source.texturePaths.size();
+    layout.lightCount = (unsigned int)source.lights.size();
+    layout.stringSize = (unsigned int)stringSize;
+
+    std::size_t offset = align16(sizeof(SceneHeader));
+    layout.modelOffset = (unsigned int)offset;          offset = align16(offset + objectCount * 16 * sizeof(float));
+    layout.objectMeshOffset = (unsigned int)offset;     offset = align16(offset + objectCount * sizeof(unsigned int));
+    layout.objectMaterialOffset = (unsigned int)offset; offset = align16(offset + objectCount * sizeof(unsigned int));
+    layout.meshOffset = (unsigned int)offset;           offset = align16(offset + source.meshes.size() * sizeof(SceneMesh));
+    layout.materialOffset = (unsigned int)offset;       offset = align16(offset + source.materials.size() * sizeof(SceneMaterial));
+    layout.lightOffset = (unsigned int)offset;          offset = align16(offset + source.lights.size() * sizeof(SceneLight));
+    layout.textureOffset = (unsigned int)offset;        offset = align16(offset + source.texturePaths.size() * sizeof(unsigned int));
+    layout.stringOffset = (unsigned int)offset;         offset = align16(offset + stringSize);
+    layout.fileSize = (unsigned int)offset;
+
+    clear();
+    storage.assign(offset / sizeof(unsigned int), 0);
+    unsigned char* image = (unsigned char*)storage.data();
+    memcpy(image, &layout, sizeof(layout));
+
+    float* outModels = (float*)(image + layout.modelOffset);
+    unsigned int* outMeshes = (unsigned int*)(image + layout.objectMeshOffset);
+    unsigned int* outMaterials = (unsigned int*)(image + layout.objectMaterialOffset);
+    for(std::size_t i = 0; i < objectCount; ++i)
+    {
+        unsigned int object = order[i];
+        memcpy(outModels + i * 16, &source.models[object * 16], 16 * sizeof(float));
+        outMeshes[i] = source.objectMeshes[object];
+        outMaterials[i] = source.objectMaterials[object];
+    }
+
+    if(!source.meshes.empty())
+        memcpy(image + layout.meshOffset, source.meshes.data(), source.meshes.size() * sizeof(SceneMesh));
+    if(!source.materials.empty())
+        memcpy(image + layout.materialOffset, source.materials.data(), source.materials.size() * sizeof(SceneMaterial));
+    if(!source.lights.empty())
+        memcpy(image + layout.lightOffset, source.lights.data(), source.lights.size() * sizeof(SceneLight));
+
+    unsigned int* outTextures = (unsigned int*)(image + layout.textureOffset);
+    char* outStrings = (char*)(image + layout.stringOffset);
+    std::size_t stringOffset = 0;
+    for(std::size_t i = 0; i < source.texturePaths.size(); ++i)
+    {
+        const std::string& path = source.texturePaths[i];
+        outTextures[i] = (unsigned int)stringOffset;
+        memcpy(outStrings + stringOffset, path.c_str(), path.size() + 1);
+        stringOffset += path.size() + 1;
+    }
+
+    return attach(image, offset);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// validate a binary image and point the arrays into it
+///////////////////////////////////////////////////////////////////////////////
+bool Scene::attach(const unsigned char* data, std::size_t size)
+{
+    if(size < sizeof(SceneHeader))
+        return false;
+
+    const SceneHeader* h = (const SceneHeader*)data;
+    if(memcmp(h->magic, SCENE_MAGIC, sizeof(SCENE_MAGIC)) != 0 || h->version != SCENE_VERSION || h->fileSize > size)
+        return false;
+
+    // every section must be 4-byte aligned and inside the file
+    struct Section { unsigned int offset; unsigned long long bytes; };
+    Section sections[] =
+    {
+        { h->modelOffset,          (unsigned long long)h->objectCount * 16 * sizeof(float) },
+        { h->objectMeshOffset,     (unsigned long long)h->objectCount * sizeof(unsigned int) },
+        { h->objectMaterialOffset, (unsigned long long)h->objectCount * sizeof(unsigned int) },
+        { h->meshOffset,           (unsigned long long)h->meshCount * sizeof(SceneMesh) },
+        { h->materialOffset,       (unsigned long long)h->materialCount * sizeof(SceneMaterial) },
+        { h->lightOffset,          (unsigned long long)h->lightCount * sizeof(SceneLight) },
+        { h->textureOffset,        (unsigned long long)h->textureCount * sizeof(unsigned int) },
+        { h->stringOffset,         (unsigned long long)h->stringSize }
+    };
+    for(std::size_t i = 0; i < sizeof(sections) / sizeof(sections[0]); ++i)
+    {
+        if(sections[i].offset % 4 != 0 || sections[i].offset + sections[i].bytes > h->fileSize)
+            return false;
+    }
+
+    const unsigned int* objectMeshData = (const unsigned int*)(data + h->objectMeshOffset);
+    const unsigned int* objectMaterialData = (const unsigned int*)(data + h->objectMaterialOffset);
+    const SceneMesh* meshData = (const SceneMesh*)(data + h->meshOffset);
+    const SceneMaterial* materialData = (const SceneMaterial*)(data + h->materialOffset);
+    const unsigned int* textureData = (const unsigned int*)(data + h->textureOffset);
+    const char* stringData = (const char*)(data + h->stringOffset);
+
+    // indices, so the renderer can use them unchecked
+    if(h->stringSize > 0 && stringData[h->stringSize - 1] != '\0')
+        return false;
+    for(unsigned int i = 0; i < h->textureCount; ++i)
+    {
+        if(textureData[i] >= h->stringSize)
+            return false;
+    }
+    for(unsigned int i = 0; i < h->meshCount; ++i)
+    {
+        if(meshData[i].type > SCENE_MESH_BOX || !hasValidTessellation(meshData[i]))
+            return false;
+    }
+    for(unsigned int i = 0; i < h->materialCount; ++i)
+    {
+        const SceneMaterial& material = materialData[i];
+        if(material.program > SCENE_PROGRAM_PLANE ||
+           material.texture < 0 || material.texture >= (int)h->textureCount ||
+           material.overlay < -1 || material.overlay >= (int)h->textureCount)
+        {
+            return false;
+        }
+    }
+    for(unsigned int i = 0; i < h->objectCount; ++i)
+    {
+        if(objectMeshData[i] >= h->meshCount || objectMaterialData[i] >= h->materialCount)
+            return false;
+    }
+
+    header = h;
+    models = (const float*)(data + h->modelOffset);
+    objectMeshes = objectMeshData;
+    objectMaterials = objectMaterialData;
+    meshes = meshData;
+    materials = materialData;
+    lights = (const SceneLight*)(data + h->lightOffset);
+    textureOffsets = textureData;
+    strings = stringData;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// write the binary image; it is the same for parsed and mapped scenes
+///////////////////////////////////////////////////////////////////////////////
+bool Scene::writeBinary(const char* filename) const
+{
+    if(!header)
+        return false;
+
+    FILE* out = fopen(filename, "wb");
+    if(!out)
+        return false;
+
+    bool ok = fwrite(header, 1, header->fileSize, out) == header->fileSize;
+    fclose(out);
+    return ok;
+}
@@ -0,0 +1,148 @@
+///////////////////////////////////////////////////////////////////////////////
+// Scene.h
+// =======
+// Scene description: textures, meshes, materials, lights and objects.
+//
+// Text form (.scene), one statement per line, '#' starts a comment:
+//   texture  <name> <path>
+//   mesh     <name> sphere   <radius> <sectors> <stacks> [smooth|flat]
+//   mesh     <name> cylinder <baseRadius> <topRadius> <height> <sectors> <stacks> [smooth|flat]
+//   mesh     <name> plane|box
+//   material <name> object|plane <texture> [overlay <texture>] [textureScale <u> <v>]
+//   light    <x> <y> <z> <r> <g> <b> [scale <s>]
+//   object   <mesh> <material> [translate <x> <y> <z>] [rotate <degrees> <x> <y> <z>] [scale <s> | scale <x> <y> <z>]
+// Object transforms are applied as translate * rotate * scale. Spheres need at
+// least 3 sectors and 2 stacks, cylinders 3 sectors and 1 stack.
+//
+// Binary form (.scenebin, see tools/SceneCompile.cpp): a SceneHeader followed
+// by the arrays below, 16-byte aligned, in native byte order. A binary scene
+// is memory-mapped and the arrays are used in place; loading only validates
+// the header and the object indices.
+//
+// Objects are stored as SoA (model matrices, mesh indices, material indices)
+// sorted by material and then mesh, so a renderer walking them in order only
+// switches state between groups.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <cstddef>
+#include <vector>
+#include "MappedFile.h"
+
+enum SceneMeshType
+{
+    SCENE_MESH_SPHERE,          // params: radius
+    SCENE_MESH_CYLINDER,        // params: base radius, top radius, height
+    SCENE_MESH_PLANE,
+    SCENE_MESH_BOX
+};
+
+enum SceneProgram
+{
+    SCENE_PROGRAM_OBJECT,       // lit, textured, optional overlay texture
+    SCENE_PROGRAM_PLANE         // lit, textured floor
+};
+
+struct SceneMesh
+{
+    unsigned int type;          // SceneMeshType
+    int sectors;
+    int stacks;
+    unsigned int smooth;
+    float params[4];
+};
+
+struct SceneMaterial
+{
+    unsigned int program;       // SceneProgram
+    int texture;                // texture index
+    int overlay;                // texture index, -1 for none
+    float textureScale[2];
+};
+
+struct SceneLight
+{
+    float position[3];
+    float color[3];
+    float scale;                // size of the light cube
+};
+
+// start of a .scenebin file; offsets are in bytes from the start of the file
+struct SceneHeader
+{
+    char magic[8];              // "CS330SCN"
+    unsigned int version;
+    unsigned int fileSize;
+
+    unsigned int objectCount;
+    unsigned int meshCount;
+    unsigned int materialCount;
+    unsigned int textureCount;
+    unsigned int lightCount;
+    unsigned int stringSize;
+
+    unsigned int modelOffset;           // float[16] per object, column-major
+    unsigned int objectMeshOffset;      // unsigned int per object
+    unsigned int objectMaterialOffset;  // unsigned int per object
+    unsigned int meshOffset;            // SceneMesh per mesh
+    unsigned int materialOffset;        // SceneMaterial per material
+    unsigned int lightOffset;           // SceneLight per light
+    unsigned int textureOffset;         // unsigned int string offset per texture path
+    unsigned int stringOffset;          // NUL terminated texture paths
+};
+
+class Scene
+{
+public:
+    // ctor/dtor
+    Scene();
+    ~Scene() {}
+
+    // load a .scenebin (mapped and used in place) or a text .scene
+    bool load(const char* filename);
+
+    // parse the text form
+    bool parse(const char* text, std::size_t size);
+
+    // write the binary form of the loaded scene
+    bool writeBinary(const char* filename) const;
+
+    void clear();
+
+    // getters
+    unsigned int getObjectCount() const             { return header ? header->objectCount : 0; }
+    unsigned int getMeshCount() const               { return header ? header->meshCount : 0; }
+    unsigned int getMaterialCount() const           { return header ? header->materialCount : 0; }
+    unsigned int getTextureCount() const            { return header ? header->textureCount : 0; }
+    unsigned int getLightCount() const              { return header ? header->lightCount : 0; }
+
+    const float* getModelMatrices() const           { return models; }
+    const float* getModelMatrix(unsigned int object) const { return models + object * 16; }
+    const unsigned int* getObjectMeshes() const     { return objectMeshes; }
+    const unsigned int* getObjectMaterials() const  { return objectMaterials; }
+    const SceneMesh* getMeshes() const              { return meshes; }
+    const SceneMaterial* getMaterials() const       { return materials; }
+    const SceneLight* getLights() const             { return lights; }
+    const char* getTexturePath(unsigned int texture) const { return strings + textureOffsets[texture]; }
+
+private:
+    // point the arrays into a binary image after validating it
+    bool attach(const unsigned char* data, std::size_t size);
+
+    MappedFile file;                        // backing of a loaded .scenebin
+    std::vector<unsigned int> storage;      // backing of a parsed scene (4-byte aligned)
+
+    const SceneHeader* header;
+    const float* models;
+    const unsigned int* objectMeshes;
+    const unsigned int* objectMaterials;
+    const SceneMesh* meshes;
+    const SceneMaterial* materials;
+    const SceneLight* lights;
+    const unsigned int* textureOffsets;
+    const char* strings;
+};
+
+#endif
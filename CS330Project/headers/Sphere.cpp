@@ -22,7 +22,11 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <vector>
+#include "GeometryKernel.h"
+#include "MeshKernels.h"
 #include "Sphere.h"
+#include "ThreadPool.h"
 
 
 
@@ -35,9 +39,12 @@ const int MIN_STACK_COUNT  = 2;
 ///////////////////////////////////////////////////////////////////////////////
 // ctor
 ///////////////////////////////////////////////////////////////////////////////
-Sphere::Sphere(float radius, int sectors, int stacks, bool smooth) : interleavedStride(32)
+Sphere::Sphere(float radius, int sectors, int stacks, bool smooth, unsigned int outputs,
+               std::pmr::memory_resource* resource)
+    : vertices(resource), normals(resource), texCoords(resource), indices(resource), lineIndices(resource),
+      interleavedVertices(resource), interleavedStride(32)
 {
-    set(radius, sectors, stacks, smooth);
+    set(radius, sectors, stacks, smooth, outputs);
 }
 
 
@@ -45,16 +52,17 @@ Sphere::Sphere(float radius, int sectors, int stacks, bool smooth) : interleaved
 ///////////////////////////////////////////////////////////////////////////////
 // setters
 ///////////////////////////////////////////////////////////////////////////////
-void Sphere::set(float radius, int sectors, int stacks, bool smooth)
+void Sphere::set(float radius, int sectors, int stacks, bool smooth, unsigned int outputs)
 {
     this->radius = radius;
     this->sectorCount = sectors;
     if(sectors < MIN_SECTOR_COUNT)
         this->sectorCount = MIN_SECTOR_COUNT;
     this->stackCount = stacks;
-    if(sectors < MIN_STACK_COUNT)
-        this->sectorCount = MIN_STACK_COUNT;
+    if(stacks < MIN_STACK_COUNT)
+        this->stackCount = MIN_STACK_COUNT;
     this->smooth = smooth;
+    this->outputs = outputs;
 
     if(smooth)
         buildVerticesSmooth();
@@ -64,20 +72,27 @@ void Sphere::set(float radius, int sectors, int stacks, bool smooth)
 
 void Sphere::setRadius(float radius)
 {
-    if(radius != this->radius)
-        set(radius, sectorCount, stackCount, smooth);
+    if(radius == this->radius)
+        return;
+
+    // the topology does not depend on the radius, so the arrays are rewritten in place
+    this->radius = radius;
+    if(interleavedVertices.empty())
+        set(radius, sectorCount, stackCount, smooth, outputs);
+    else
+        updateVertices();
 }
 
 void Sphere::setSectorCount(int sectors)
 {
     if(sectors != this->sectorCount)
-        set(radius, sectors, stackCount, smooth);
+        set(radius, sectors, stackCount, smooth, outputs);
 }
 
 void Sphere::setStackCount(int stacks)
 {
     if(stacks != this->stackCount)
-        set(radius, sectorCount, stacks, smooth);
+        set(radius, sectorCount, stacks, smooth, outputs);
 }
 
 void Sphere::setSmooth(bool smooth)
@@ -92,6 +107,12 @@ void Sphere::setSmooth(bool smooth)
         buildVerticesFlat();
 }
 
+void Sphere::setOutputs(unsigned int outputs)
+{
+    if(this->outputs != outputs)
+        set(radius, sectorCount, stackCount, smooth, outputs);
+}
+
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -178,29 +199,29 @@ void Sphere::drawWithLines(const float lineColor[4]) const
 
 
 
-/*@@ FIXME: when the radius  = 0
 ///////////////////////////////////////////////////////////////////////////////
-// update vertex positions only
+// rewrite the positions and normals of the existing arrays after a radius
+// change; tex coords and indices stay as they are
+// written from the parametric equation again, so repeated changes do not
+// accumulate rounding errors and match a full rebuild
 ///////////////////////////////////////////////////////////////////////////////
-void Sphere::updateRadius()
+void Sphere::updateVertices()
 {
-    float scale = sqrtf(radius * radius / (vertices[0] * vertices[0] + vertices[1] * vertices[1] + vertices[2] * vertices[2]));
-
-    std::size_t i, j;
-    std::size_t count = vertices.size();
-    for(i = 0, j = 0; i < count; i += 3, j += 8)
+    if(smooth)
+    {
+        std::vector<float> cosTable(sectorCount + 1), sinTable(sectorCount + 1);
+        getSectorTable(sectorCount, &cosTable[0], &sinTable[0]);
+        writeSmoothRows(radius, sectorCount, stackCount, &cosTable[0], &sinTable[0], 0, stackCount + 1,
+                        &interleavedVertices[0]);
+    }
+    else
     {
-        vertices[i]   *= scale;
-        vertices[i+1] *= scale;
-        vertices[i+2] *= scale;
-
-        // for interleaved array
-        interleavedVertices[j]   *= scale;
-        interleavedVertices[j+1] *= scale;
-        interleavedVertices[j+2] *= scale;
+        writeFlat(radius, sectorCount, stackCount, &interleavedVertices[0], 0);
     }
+
+    if(outputs & MESH_OUTPUT_SEPARATE)
+        buildSeparateVertices();
 }
-*/
 
 
 
@@ -209,387 +230,482 @@ void Sphere::updateRadius()
 ///////////////////////////////////////////////////////////////////////////////
 void Sphere::clearArrays()
 {
-    std::vector<float>().swap(vertices);
-    std::vector<float>().swap(normals);
-    std::vector<float>().swap(texCoords);
-    std::vector<unsigned int>().swap(indices);
-    std::vector<unsigned int>().swap(lineIndices);
+    // swap with empty arrays of the same memory resource
+    std::pmr::vector<float>(vertices.get_allocator()).swap(vertices);
+    std::pmr::vector<float>(normals.get_allocator()).swap(normals);
+    std::pmr::vector<float>(texCoords.get_allocator()).swap(texCoords);
+    std::pmr::vector<unsigned int>(indices.get_allocator()).swap(indices);
+    std::pmr::vector<unsigned int>(lineIndices.get_allocator()).swap(lineIndices);
+    std::pmr::vector<float>(interleavedVertices.get_allocator()).swap(interleavedVertices);
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// build vertices of sphere with smooth shading using parametric equation
-// x = r * cos(u) * cos(v)
-// y = r * cos(u) * sin(v)
-// z = r * sin(u)
-// where u: stack(latitude) angle (-90 <= u <= 90)
-//       v: sector(longitude) angle (0 <= v <= 360)
+// non-owning view of the interleaved vertices and indices
 ///////////////////////////////////////////////////////////////////////////////
-void Sphere::buildVerticesSmooth()
+MeshView Sphere::getMeshView() const
 {
-    const float PI = acos(-1);
+    return MeshView(interleavedVertices.data(), getInterleavedVertexCount(),
+                    indices.data(), getIndexCount(), interleavedStride);
+}
 
-    // clear memory of prev arrays
-    clearArrays();
 
-    float x, y, z, xy;                              // vertex position
-    float nx, ny, nz, lengthInv = 1.0f / radius;    // normal
-    float s, t;                                     // texCoord
 
-    float sectorStep = 2 * PI / sectorCount;
-    float stackStep = PI / stackCount;
-    float sectorAngle, stackAngle;
+///////////////////////////////////////////////////////////////////////////////
+// # of interleaved vertices and indices written by writeInterleaved()
+// smooth: (stacks+1)*(sectors+1) shared vertices
+// flat  : 3 vertices per triangle of the 1st/last stacks, 4 per quad of others
+///////////////////////////////////////////////////////////////////////////////
+void Sphere::getInterleavedCounts(int sectors, int stacks, bool smooth,
+                                  unsigned int& vertexCount, unsigned int& indexCount)
+{
+    if(sectors < MIN_SECTOR_COUNT)
+        sectors = MIN_SECTOR_COUNT;
+    if(stacks < MIN_STACK_COUNT)
+        stacks = MIN_STACK_COUNT;
 
-    for(int i = 0; i <= stackCount; ++i)
-    {
-        stackAngle = PI / 2 - i * stackStep;        // starting from pi/2 to -pi/2
-        xy = radius * cosf(stackAngle);             // r * cos(u)
-        z = radius * sinf(stackAngle);              // r * sin(u)
+    if(smooth)
+        vertexCount = (stacks + 1) * (sectors + 1);
+    else
+        vertexCount = sectors * (6 + (stacks - 2) * 4);
+    indexCount = sectors * (stacks - 1) * 6;   // 1 triangle per sector for 1st/last stacks, 2 for others
+}
 
-        // add (sectorCount+1) vertices per stack
-        // the first and last vertices have same position and normal, but different tex coords
-        for(int j = 0; j <= sectorCount; ++j)
-        {
-            sectorAngle = j * sectorStep;           // starting from 0 to 2pi
-
-            // vertex position
-            x = xy * cosf(sectorAngle);             // r * cos(u) * cos(v)
-            y = xy * sinf(sectorAngle);             // r * cos(u) * sin(v)
-            addVertex(x, y, z);
-
-            // normalized vertex normal
-            nx = x * lengthInv;
-            ny = y * lengthInv;
-            nz = z * lengthInv;
-            addNormal(nx, ny, nz);
-
-            // vertex tex coord between [0, 1]
-            s = (float)j / sectorCount;
-            t = (float)i / stackCount;
-            addTexCoord(s, t);
-        }
-    }
 
-    // indices
-    //  k1--k1+1
-    //  |  / |
-    //  | /  |
-    //  k2--k2+1
-    unsigned int k1, k2;
-    for(int i = 0; i < stackCount; ++i)
-    {
-        k1 = i * (sectorCount + 1);     // beginning of current stack
-        k2 = k1 + sectorCount + 1;      // beginning of next stack
 
-        for(int j = 0; j < sectorCount; ++j, ++k1, ++k2)
-        {
-            // 2 triangles per sector excluding 1st and last stacks
-            if(i != 0)
-            {
-                addIndices(k1, k2, k1+1);   // k1---k2---k1+1
-            }
+///////////////////////////////////////////////////////////////////////////////
+// write interleaved vertices (32-byte stride) and indices into caller memory
+// sized by getInterleavedCounts()
+///////////////////////////////////////////////////////////////////////////////
+void Sphere::writeInterleaved(float radius, int sectors, int stacks, bool smooth,
+                              float* vertices, unsigned int* indices, ThreadPool* pool)
+{
+    if(sectors < MIN_SECTOR_COUNT)
+        sectors = MIN_SECTOR_COUNT;
+    if(stacks < MIN_STACK_COUNT)
+        stacks = MIN_STACK_COUNT;
+
+    if(smooth)
+        writeSmooth(radius, sectors, stacks, vertices, indices, pool);
+    else
+        writeFlat(radius, sectors, stacks, vertices, indices);
+}
 
-            if(i != (stackCount-1))
-            {
-                addIndices(k1+1, k2, k2+1); // k1+1---k2---k2+1
-            }
 
-            // vertical lines for all stacks
-            lineIndices.push_back(k1);
-            lineIndices.push_back(k2);
-            if(i != 0)  // horizontal lines except 1st stack
-            {
-                lineIndices.push_back(k1);
-                lineIndices.push_back(k1 + 1);
-            }
-        }
-    }
 
-    // generate interleaved vertex array as well
-    buildInterleavedVertices();
+///////////////////////////////////////////////////////////////////////////////
+// builder mode with packed vertices
+// the float vertices are written to a temporary array and packed from there;
+// the quantization comes from the sphere bounds, so it is known up front
+///////////////////////////////////////////////////////////////////////////////
+void Sphere::writeInterleavedPacked(float radius, int sectors, int stacks, bool smooth,
+                                    PackedVertex* vertices, unsigned int* indices,
+                                    VertexQuantization& quantization)
+{
+    unsigned int vertexCount, indexCount;
+    getInterleavedCounts(sectors, stacks, smooth, vertexCount, indexCount);
+    std::vector<float> floats((std::size_t)vertexCount * MESH_VERTEX_FLOATS);
+    writeInterleaved(radius, sectors, stacks, smooth, floats.data(), indices);
+
+    float min[3] = { -radius, -radius, -radius };
+    float max[3] = { radius, radius, radius };
+    quantization = makeVertexQuantization(min, max);
+    packVertices(floats.data(), vertexCount, MESH_VERTEX_STRIDE, quantization, vertices);
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// generate vertices with flat shading
-// each triangle is independent (no shared vertices)
+// one strip per stack, zigzagging k1, k2, k1+1, k2+1, ... so the triangles
+// and their winding match the list of writeSmooth()
+// the pole stacks keep their zero-area triangles; the GPU drops them cheaply
 ///////////////////////////////////////////////////////////////////////////////
-void Sphere::buildVerticesFlat()
+unsigned int Sphere::getStripIndexCount(int sectors, int stacks)
 {
-    const float PI = acos(-1);
+    if(sectors < MIN_SECTOR_COUNT)
+        sectors = MIN_SECTOR_COUNT;
+    if(stacks < MIN_STACK_COUNT)
+        stacks = MIN_STACK_COUNT;
 
-    // tmp vertex definition (x,y,z,s,t)
-    struct Vertex
-    {
-        float x, y, z, s, t;
-    };
-    std::vector<Vertex> tmpVertices;
+    return stacks * (sectors + 1) * 2 + (stacks - 1);      // + a restart between strips
+}
 
-    float sectorStep = 2 * PI / sectorCount;
-    float stackStep = PI / stackCount;
-    float sectorAngle, stackAngle;
+void Sphere::writeStripIndices(int sectors, int stacks, unsigned int* indices)
+{
+    if(sectors < MIN_SECTOR_COUNT)
+        sectors = MIN_SECTOR_COUNT;
+    if(stacks < MIN_STACK_COUNT)
+        stacks = MIN_STACK_COUNT;
 
-    // compute all vertices first, each vertex contains (x,y,z,s,t) except normal
-    for(int i = 0; i <= stackCount; ++i)
+    for(int i = 0; i < stacks; ++i)
     {
-        stackAngle = PI / 2 - i * stackStep;        // starting from pi/2 to -pi/2
-        float xy = radius * cosf(stackAngle);       // r * cos(u)
-        float z = radius * sinf(stackAngle);        // r * sin(u)
+        if(i > 0)
+            *indices++ = MESH_RESTART_INDEX;
 
-        // add (sectorCount+1) vertices per stack
-        // the first and last vertices have same position and normal, but different tex coords
-        for(int j = 0; j <= sectorCount; ++j)
+        unsigned int k1 = i * (sectors + 1);    // beginning of current stack
+        unsigned int k2 = k1 + sectors + 1;     // beginning of next stack
+        for(int j = 0; j <= sectors; ++j)
         {
-            sectorAngle = j * sectorStep;           // starting from 0 to 2pi
-
-            Vertex vertex;
-            vertex.x = xy * cosf(sectorAngle);      // x = r * cos(u) * cos(v)
-            vertex.y = xy * sinf(sectorAngle);      // y = r * cos(u) * sin(v)
-            vertex.z = z;                           // z = r * sin(u)
-            vertex.s = (float)j/sectorCount;        // s
-            vertex.t = (float)i/stackCount;         // t
-            tmpVertices.push_back(vertex);
+            *indices++ = k1 + j;
+            *indices++ = k2 + j;
         }
     }
+}
+
+
 
+///////////////////////////////////////////////////////////////////////////////
+// build vertices of sphere with smooth shading
+// the interleaved array is written first, the other outputs are made from it
+///////////////////////////////////////////////////////////////////////////////
+void Sphere::buildVerticesSmooth()
+{
     // clear memory of prev arrays
     clearArrays();
 
-    Vertex v1, v2, v3, v4;                          // 4 vertex positions and tex coords
-    std::vector<float> n;                           // 1 face normal
+    getInterleavedCounts(sectorCount, stackCount, true, vertexCount, indexCount);
+    interleavedVertices.resize(vertexCount * 8);
+    indices.resize(indexCount);
+    writeSmooth(radius, sectorCount, stackCount, &interleavedVertices[0], &indices[0]);
+    buildOutputs();
+}
 
-    int i, j, k, vi1, vi2;
-    int index = 0;                                  // index for vertex
-    for(i = 0; i < stackCount; ++i)
-    {
-        vi1 = i * (sectorCount + 1);                // index of tmpVertices
-        vi2 = (i + 1) * (sectorCount + 1);
 
-        for(j = 0; j < sectorCount; ++j, ++vi1, ++vi2)
-        {
-            // get 4 vertices per sector
-            //  v1--v3
-            //  |    |
-            //  v2--v4
-            v1 = tmpVertices[vi1];
-            v2 = tmpVertices[vi2];
-            v3 = tmpVertices[vi1 + 1];
-            v4 = tmpVertices[vi2 + 1];
 
-            // if 1st stack and last stack, store only 1 triangle per sector
-            // otherwise, store 2 triangles (quad) per sector
-            if(i == 0) // a triangle for first stack ==========================
-            {
-                // put a triangle
-                addVertex(v1.x, v1.y, v1.z);
-                addVertex(v2.x, v2.y, v2.z);
-                addVertex(v4.x, v4.y, v4.z);
-
-                // put tex coords of triangle
-                addTexCoord(v1.s, v1.t);
-                addTexCoord(v2.s, v2.t);
-                addTexCoord(v4.s, v4.t);
-
-                // put normal
-                n = computeFaceNormal(v1.x,v1.y,v1.z, v2.x,v2.y,v2.z, v4.x,v4.y,v4.z);
-                for(k = 0; k < 3; ++k)  // same normals for 3 vertices
-                {
-                    addNormal(n[0], n[1], n[2]);
-                }
+///////////////////////////////////////////////////////////////////////////////
+// generate vertices with flat shading
+// each triangle is independent (no shared vertices)
+///////////////////////////////////////////////////////////////////////////////
+void Sphere::buildVerticesFlat()
+{
+    // clear memory of prev arrays
+    clearArrays();
 
-                // put indices of 1 triangle
-                addIndices(index, index+1, index+2);
+    getInterleavedCounts(sectorCount, stackCount, false, vertexCount, indexCount);
+    interleavedVertices.resize(vertexCount * 8);
+    indices.resize(indexCount);
+    writeFlat(radius, sectorCount, stackCount, &interleavedVertices[0], &indices[0]);
+    buildOutputs();
+}
 
-                // indices for line (first stack requires only vertical line)
-                lineIndices.push_back(index);
-                lineIndices.push_back(index+1);
 
-                index += 3;     // for next
-            }
-            else if(i == (stackCount-1)) // a triangle for last stack =========
-            {
-                // put a triangle
-                addVertex(v1.x, v1.y, v1.z);
-                addVertex(v2.x, v2.y, v2.z);
-                addVertex(v3.x, v3.y, v3.z);
-
-                // put tex coords of triangle
-                addTexCoord(v1.s, v1.t);
-                addTexCoord(v2.s, v2.t);
-                addTexCoord(v3.s, v3.t);
-
-                // put normal
-                n = computeFaceNormal(v1.x,v1.y,v1.z, v2.x,v2.y,v2.z, v3.x,v3.y,v3.z);
-                for(k = 0; k < 3; ++k)  // same normals for 3 vertices
-                {
-                    addNormal(n[0], n[1], n[2]);
-                }
 
-                // put indices of 1 triangle
-                addIndices(index, index+1, index+2);
+///////////////////////////////////////////////////////////////////////////////
+// build the arrays selected by the output mask from the interleaved array,
+// then drop the interleaved array if it was not selected
+///////////////////////////////////////////////////////////////////////////////
+void Sphere::buildOutputs()
+{
+    if(outputs & MESH_OUTPUT_SEPARATE)
+        buildSeparateVertices();
+    if(!(outputs & MESH_OUTPUT_INTERLEAVED))
+        std::pmr::vector<float>(interleavedVertices.get_allocator()).swap(interleavedVertices);
+    if(outputs & MESH_OUTPUT_LINES)
+        buildLineIndices();
+    lineIndexCount = (unsigned int)lineIndices.size();
+}
 
-                // indices for lines (last stack requires both vert/hori lines)
-                lineIndices.push_back(index);
-                lineIndices.push_back(index+1);
-                lineIndices.push_back(index);
-                lineIndices.push_back(index+2);
 
-                index += 3;     // for next
-            }
-            else // 2 triangles for others ====================================
+
+///////////////////////////////////////////////////////////////////////////////
+// build line indices, following the vertex order of writeSmooth() or writeFlat()
+///////////////////////////////////////////////////////////////////////////////
+void Sphere::buildLineIndices()
+{
+    // a vertical line per sector of every stack, a horizontal one except the 1st stack
+    lineIndices.reserve((2 * stackCount - 1) * sectorCount * 2);
+
+    //  k1--k1+1
+    //  |  / |
+    //  | /  |
+    //  k2--k2+1
+    unsigned int k1, k2, index = 0;
+    for(int i = 0; i < stackCount; ++i)
+    {
+        k1 = i * (sectorCount + 1);     // beginning of current stack
+        k2 = k1 + sectorCount + 1;      // beginning of next stack
+
+        for(int j = 0; j < sectorCount; ++j, ++k1, ++k2)
+        {
+            if(smooth)
             {
-                // put quad vertices: v1-v2-v3-v4
-                addVertex(v1.x, v1.y, v1.z);
-                addVertex(v2.x, v2.y, v2.z);
-                addVertex(v3.x, v3.y, v3.z);
-                addVertex(v4.x, v4.y, v4.z);
-
-                // put tex coords of quad
-                addTexCoord(v1.s, v1.t);
-                addTexCoord(v2.s, v2.t);
-                addTexCoord(v3.s, v3.t);
-                addTexCoord(v4.s, v4.t);
-
-                // put normal
-                n = computeFaceNormal(v1.x,v1.y,v1.z, v2.x,v2.y,v2.z, v3.x,v3.y,v3.z);
-                for(k = 0; k < 4; ++k)  // same normals for 4 vertices
+                // vertical lines for all stacks
+                lineIndices.push_back(k1);
+                lineIndices.push_back(k2);
+                if(i != 0)  // horizontal lines except 1st stack
                 {
-                    addNormal(n[0], n[1], n[2]);
+                    lineIndices.push_back(k1);
+                    lineIndices.push_back(k1 + 1);
                 }
+                continue;
+            }
 
-                // put indices of quad (2 triangles)
-                addIndices(index, index+1, index+2);
-                addIndices(index+2, index+1, index+3);
-
-                // indices for lines
-                lineIndices.push_back(index);
-                lineIndices.push_back(index+1);
-                lineIndices.push_back(index);
-                lineIndices.push_back(index+2);
+            // vertical line per sector
+            lineIndices.push_back(index);
+            lineIndices.push_back(index+1);
 
-                index += 4;     // for next
+            if(i == 0)  // first stack requires only vertical line
+            {
+                index += 3;
+                continue;
             }
+
+            // horizontal line
+            lineIndices.push_back(index);
+            lineIndices.push_back(index+2);
+            index += (i == stackCount - 1) ? 3 : 4;
         }
     }
-
-    // generate interleaved vertex array as well
-    buildInterleavedVertices();
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// generate interleaved vertices: V/N/T
-// stride must be 32 bytes
+// free the arrays after upload; counts and bounds are kept
 ///////////////////////////////////////////////////////////////////////////////
-void Sphere::buildInterleavedVertices()
+void Sphere::releaseCpuData()
 {
-    std::vector<float>().swap(interleavedVertices);
+    clearArrays();
+}
 
-    std::size_t i, j;
-    std::size_t count = vertices.size();
-    for(i = 0, j = 0; i < count; i += 3, j += 2)
-    {
-        interleavedVertices.push_back(vertices[i]);
-        interleavedVertices.push_back(vertices[i+1]);
-        interleavedVertices.push_back(vertices[i+2]);
 
-        interleavedVertices.push_back(normals[i]);
-        interleavedVertices.push_back(normals[i+1]);
-        interleavedVertices.push_back(normals[i+2]);
 
-        interleavedVertices.push_back(texCoords[j]);
-        interleavedVertices.push_back(texCoords[j+1]);
+///////////////////////////////////////////////////////////////////////////////
+// bounds of the sphere
+///////////////////////////////////////////////////////////////////////////////
+void Sphere::getBounds(float min[3], float max[3]) const
+{
+    for(int i = 0; i < 3; ++i)
+    {
+        min[i] = -radius;
+        max[i] = radius;
     }
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// add single vertex to array
+// write vertices of sphere with smooth shading using parametric equation
+// x = r * cos(u) * cos(v)
+// y = r * cos(u) * sin(v)
+// z = r * sin(u)
+// where u: stack(latitude) angle (-90 <= u <= 90)
+//       v: sector(longitude) angle (0 <= v <= 360)
+// cos(v) and sin(v) are the same for every stack, so they come from a table;
+// rows and stacks are independent and are split over the pool if one is given
 ///////////////////////////////////////////////////////////////////////////////
-void Sphere::addVertex(float x, float y, float z)
+void Sphere::writeSmooth(float radius, int sectorCount, int stackCount, float* vertices, unsigned int* indices,
+                         ThreadPool* pool)
 {
-    vertices.push_back(x);
-    vertices.push_back(y);
-    vertices.push_back(z);
+    std::vector<float> cosTable(sectorCount + 1), sinTable(sectorCount + 1);
+    getSectorTable(sectorCount, &cosTable[0], &sinTable[0]);
+
+    if(!pool)
+    {
+        writeSmoothRows(radius, sectorCount, stackCount, &cosTable[0], &sinTable[0], 0, stackCount + 1, vertices);
+        writeSmoothIndices(sectorCount, stackCount, 0, stackCount, indices);
+        return;
+    }
+
+    pool->parallelFor(stackCount + 1, getRowChunk(sectorCount), [&](std::size_t begin, std::size_t end)
+    {
+        writeSmoothRows(radius, sectorCount, stackCount, &cosTable[0], &sinTable[0], (int)begin, (int)end, vertices);
+        writeSmoothIndices(sectorCount, stackCount, (int)begin, (int)end < stackCount ? (int)end : stackCount, indices);
+    });
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// add single normal to array
+// write vertex rows [rowBegin, rowEnd), (sectorCount+1) vertices per row
+// vertices points at the first vertex of the mesh
 ///////////////////////////////////////////////////////////////////////////////
-void Sphere::addNormal(float nx, float ny, float nz)
+void Sphere::writeSmoothRows(float radius, int sectorCount, int stackCount,
+                             const float* cosTable, const float* sinTable,
+                             int rowBegin, int rowEnd, float* vertices)
 {
-    normals.push_back(nx);
-    normals.push_back(ny);
-    normals.push_back(nz);
+    const float PI = acos(-1);
+
+    float z, xy;                                    // vertex position
+    float nz, nxy;                                  // normal
+    float t;                                        // texCoord
+
+    float stackStep = PI / stackCount;
+    float stackAngle;
+
+    vertices += (std::size_t)rowBegin * (sectorCount + 1) * 8;
+    for(int i = rowBegin; i < rowEnd; ++i)
+    {
+        stackAngle = PI / 2 - i * stackStep;        // starting from pi/2 to -pi/2
+        nxy = cosf(stackAngle);                     // cos(u)
+        nz = sinf(stackAngle);                      // sin(u)
+        xy = radius * nxy;                          // r * cos(u)
+        z = radius * nz;                            // r * sin(u)
+        t = (float)i / stackCount;
+
+        // add (sectorCount+1) vertices per stack
+        // the first and last vertices have same position and normal, but different tex coords
+        // position (xy * cos(v), xy * sin(v), z), normal (cos(u) * cos(v), cos(u) * sin(v), sin(u)):
+        // the unit direction, so a sphere of radius 0 still gets valid normals
+        writeRing(cosTable, sinTable, cosTable, sinTable, sectorCount + 1, sectorCount,
+                  xy, z, nxy, 1.0f, nz, t, vertices);
+        vertices += (sectorCount + 1) * 8;
+    }
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// add single texture coord to array
+// write the triangle indices of stacks [stackBegin, stackEnd)
+// indices points at the first index of the mesh
 ///////////////////////////////////////////////////////////////////////////////
-void Sphere::addTexCoord(float s, float t)
+void Sphere::writeSmoothIndices(int sectorCount, int stackCount, int stackBegin, int stackEnd, unsigned int* indices)
 {
-    texCoords.push_back(s);
-    texCoords.push_back(t);
+    // 1st stack has 1 triangle per sector, the others before the last have 2
+    if(stackBegin > 0)
+        indices += (std::size_t)sectorCount * 3 + (std::size_t)(stackBegin - 1) * sectorCount * 6;
+
+    // indices
+    //  k1--k1+1
+    //  |  / |
+    //  | /  |
+    //  k2--k2+1
+    unsigned int k1, k2;
+    for(int i = stackBegin; i < stackEnd; ++i)
+    {
+        k1 = i * (sectorCount + 1);     // beginning of current stack
+        k2 = k1 + sectorCount + 1;      // beginning of next stack
+
+        for(int j = 0; j < sectorCount; ++j, ++k1, ++k2)
+        {
+            // 2 triangles per sector excluding 1st and last stacks
+            if(i != 0)
+            {
+                *indices++ = k1;        // k1---k2---k1+1
+                *indices++ = k2;
+                *indices++ = k1 + 1;
+            }
+
+            if(i != (stackCount-1))
+            {
+                *indices++ = k1 + 1;    // k1+1---k2---k2+1
+                *indices++ = k2;
+                *indices++ = k2 + 1;
+            }
+        }
+    }
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// add 3 indices to array
+// write vertices with flat shading
+// each triangle is independent (no shared vertices)
+// indices may be null to rewrite the vertices only
 ///////////////////////////////////////////////////////////////////////////////
-void Sphere::addIndices(unsigned int i1, unsigned int i2, unsigned int i3)
+void Sphere::writeFlat(float radius, int sectorCount, int stackCount, float* vertices, unsigned int* indices)
 {
-    indices.push_back(i1);
-    indices.push_back(i2);
-    indices.push_back(i3);
+    const float PI = acos(-1);
+
+    // all scratch arrays are sized once: the (x,y,z,s,t) grid, the sector
+    // table and one row of face normals
+    std::vector<GridVertex> grid((stackCount + 1) * (sectorCount + 1));
+    std::vector<float> cosTable(sectorCount + 1), sinTable(sectorCount + 1);
+    std::vector<Vec3> faceNormals(sectorCount);
+    getSectorTable(sectorCount, &cosTable[0], &sinTable[0]);
+
+    float stackStep = PI / stackCount;
+    float stackAngle;
+
+    // compute all vertices of the unit sphere first, each vertex contains (x,y,z,s,t) except normal
+    // the first and last vertices of a stack have same position, but different tex coords
+    // the face normals come from the unit sphere and the positions are scaled by the radius
+    // when written, so a sphere of radius 0 still gets valid normals
+    for(int i = 0; i <= stackCount; ++i)
+    {
+        stackAngle = PI / 2 - i * stackStep;        // starting from pi/2 to -pi/2
+        float xy = cosf(stackAngle);                // cos(u)
+        float z = sinf(stackAngle);                 // sin(u)
+        writeGridRing(&cosTable[0], &sinTable[0], sectorCount + 1, sectorCount,
+                      xy, z, (float)i / stackCount, &grid[i * (sectorCount + 1)]);
+    }
+
+    GridVertex v[4];                                // 4 vertex positions and tex coords
+
+    int i, j;
+    unsigned int index = 0;                         // index for vertex
+    for(i = 0; i < stackCount; ++i)
+    {
+        const GridVertex* row1 = &grid[i * (sectorCount + 1)];
+        const GridVertex* row2 = row1 + sectorCount + 1;
+
+        // same normal for all vertices of a triangle or quad: v1-v2-v3,
+        // or v1-v2-v4 for the triangles of the first stack
+        computeFaceNormals(row1, row2, i == 0 ? row2 + 1 : row1 + 1, sectorCount, &faceNormals[0]);
+
+        for(j = 0; j < sectorCount; ++j)
+        {
+            // get 4 vertices per sector
+            //  v1--v3
+            //  |    |
+            //  v2--v4
+            v[0] = row1[j];
+            v[1] = row2[j];
+            v[2] = row1[j + 1];
+            v[3] = row2[j + 1];
+
+            // if 1st stack and last stack, store only 1 triangle per sector
+            // otherwise, store 2 triangles (quad) per sector
+            int count = 4;
+            if(i == 0)                      // a triangle for first stack: v1-v2-v4
+            {
+                v[2] = v[3];
+                count = 3;
+            }
+            else if(i == (stackCount-1))    // a triangle for last stack: v1-v2-v3
+            {
+                count = 3;
+            }
+
+            for(int k = 0; k < count; ++k)
+            {
+                v[k].position.x *= radius;
+                v[k].position.y *= radius;
+                v[k].position.z *= radius;
+            }
+            vertices = writeFlatFace(vertices, v, count, faceNormals[j]);
+
+            // put indices of 1 triangle or a quad (2 triangles)
+            if(indices)
+            {
+                *indices++ = index;
+                *indices++ = index+1;
+                *indices++ = index+2;
+                if(count == 4)
+                {
+                    *indices++ = index+2;
+                    *indices++ = index+1;
+                    *indices++ = index+3;
+                }
+            }
+
+            index += count;     // for next
+        }
+    }
 }
 
 
 
 ///////////////////////////////////////////////////////////////////////////////
-// return face normal of a triangle v1-v2-v3
-// if a triangle has no surface (normal length = 0), then return a zero vector
+// split interleaved vertices: V/N/T into separate arrays
 ///////////////////////////////////////////////////////////////////////////////
-std::vector<float> Sphere::computeFaceNormal(float x1, float y1, float z1,  // v1
-                                             float x2, float y2, float z2,  // v2
-                                             float x3, float y3, float z3)  // v3
+void Sphere::buildSeparateVertices()
 {
-    const float EPSILON = 0.000001f;
-
-    std::vector<float> normal(3, 0.0f);     // default return value (0,0,0)
-    float nx, ny, nz;
-
-    // find 2 edge vectors: v1-v2, v1-v3
-    float ex1 = x2 - x1;
-    float ey1 = y2 - y1;
-    float ez1 = z2 - z1;
-    float ex2 = x3 - x1;
-    float ey2 = y3 - y1;
-    float ez2 = z3 - z1;
-
-    // cross product: e1 x e2
-    nx = ey1 * ez2 - ez1 * ey2;
-    ny = ez1 * ex2 - ex1 * ez2;
-    nz = ex1 * ey2 - ey1 * ex2;
-
-    // normalize only if the length is > 0
-    float length = sqrtf(nx * nx + ny * ny + nz * nz);
-    if(length > EPSILON)
-    {
-        // normalize
-        float lengthInv = 1.0f / length;
-        normal[0] = nx * lengthInv;
-        normal[1] = ny * lengthInv;
-        normal[2] = nz * lengthInv;
-    }
-
-    return normal;
+    std::size_t count = interleavedVertices.size() / 8;
+    vertices.resize(count * 3);
+    normals.resize(count * 3);
+    texCoords.resize(count * 2);
+    if(count > 0)
+        splitInterleaved(&interleavedVertices[0], count, &vertices[0], &normals[0], &texCoords[0]);
 }
@@ -12,31 +12,48 @@
 #ifndef GEOMETRY_SPHERE_H
 #define GEOMETRY_SPHERE_H
 
+#include <memory_resource>
 #include <vector>
+#include "MeshView.h"
+#include "VertexFormat.h"
+
+class ThreadPool;
 
 class Sphere
 {
 public:
     // ctor/dtor
-    Sphere(float radius=1.0f, int sectorCount=36, int stackCount=18, bool smooth=true);
+    Sphere(float radius=1.0f, int sectorCount=36, int stackCount=18, bool smooth=true,
+           unsigned int outputs=MESH_OUTPUT_ALL,
+           std::pmr::memory_resource* resource=std::pmr::get_default_resource());
     ~Sphere() {}
 
     // getters/setters
     float getRadius() const                 { return radius; }
     int getSectorCount() const              { return sectorCount; }
     int getStackCount() const               { return stackCount; }
-    void set(float radius, int sectorCount, int stackCount, bool smooth=true);
-    void setRadius(float radius);
+    void set(float radius, int sectorCount, int stackCount, bool smooth=true,
+             unsigned int outputs=MESH_OUTPUT_ALL);
+    void setRadius(float radius);           // rewrites positions/normals in place, keeps the indices
     void setSectorCount(int sectorCount);
     void setStackCount(int stackCount);
     void setSmooth(bool smooth);
+    void setOutputs(unsigned int outputs);  // MeshOutput flags
+    unsigned int getOutputs() const         { return outputs; }
+
+    // the arrays are allocated from the memory resource given to the ctor, e.g. a
+    // std::pmr::monotonic_buffer_resource freed in one go after upload; the resource
+    // must outlive the object. copies use the default resource, like std::pmr containers
+    std::pmr::memory_resource* getMemoryResource() const { return interleavedVertices.get_allocator().resource(); }
 
     // for vertex data
-    unsigned int getVertexCount() const     { return (unsigned int)vertices.size() / 3; }
-    unsigned int getNormalCount() const     { return (unsigned int)normals.size() / 3; }
-    unsigned int getTexCoordCount() const   { return (unsigned int)texCoords.size() / 2; }
-    unsigned int getIndexCount() const      { return (unsigned int)indices.size(); }
-    unsigned int getLineIndexCount() const  { return (unsigned int)lineIndices.size(); }
+    // counts describe the mesh and survive releaseCpuData(); sizes and pointers
+    // are those of the arrays held, 0/null if an array was not built or released
+    unsigned int getVertexCount() const     { return vertexCount; }
+    unsigned int getNormalCount() const     { return vertexCount; }
+    unsigned int getTexCoordCount() const   { return vertexCount; }
+    unsigned int getIndexCount() const      { return indexCount; }
+    unsigned int getLineIndexCount() const  { return lineIndexCount; }
     unsigned int getTriangleCount() const   { return getIndexCount() / 3; }
     unsigned int getVertexSize() const      { return (unsigned int)vertices.size() * sizeof(float); }
     unsigned int getNormalSize() const      { return (unsigned int)normals.size() * sizeof(float); }
@@ -55,7 +72,36 @@ public:
     int getInterleavedStride() const                { return interleavedStride; }   // should be 32 bytes
     const float* getInterleavedVertices() const     { return interleavedVertices.data(); }
 
-    // draw in VertexArray mode
+    // non-owning view of the interleaved vertices and indices, for uploading without a copy
+    MeshView getMeshView() const;
+
+    // builder mode: write interleaved V/N/T vertices and triangle indices straight into
+    // caller memory (e.g. a mapped GPU buffer) without building the arrays of a Sphere
+    static void getInterleavedCounts(int sectorCount, int stackCount, bool smooth,
+                                     unsigned int& vertexCount, unsigned int& indexCount);
+    // smooth rows are split over pool when one is given (not from inside one of its tasks)
+    static void writeInterleaved(float radius, int sectorCount, int stackCount, bool smooth,
+                                 float* vertices, unsigned int* indices, ThreadPool* pool=0);
+    // same with 16-byte PackedVertex; quantization receives the position scale/bias
+    static void writeInterleavedPacked(float radius, int sectorCount, int stackCount, bool smooth,
+                                       PackedVertex* vertices, unsigned int* indices,
+                                       VertexQuantization& quantization);
+
+    // triangle strips over the smooth vertices of writeInterleaved(), separated
+    // by MESH_RESTART_INDEX; draw with GL_TRIANGLE_STRIP and primitive restart
+    // flat shading shares no vertices, so it has no strip form
+    static unsigned int getStripIndexCount(int sectorCount, int stackCount);
+    static void writeStripIndices(int sectorCount, int stackCount, unsigned int* indices);
+
+    // axis-aligned bounds in object space, kept after releaseCpuData()
+    void getBounds(float min[3], float max[3]) const;
+
+    // free all vertex and index arrays once they are uploaded; counts and bounds remain
+    void releaseCpuData();
+
+    // draw in VertexArray mode (needs MESH_OUTPUT_INTERLEAVED, lines need MESH_OUTPUT_SEPARATE and MESH_OUTPUT_LINES)
+    // these use client-side arrays, which a core profile context does not have; there, upload
+    // getMeshView() once (MeshUpload.h) and draw the edges with a wireframe shader instead
     void draw() const;                                  // draw surface
     void drawLines(const float lineColor[4]) const;     // draw lines only
     void drawWithLines(const float lineColor[4]) const; // draw surface and lines
@@ -69,29 +115,36 @@ private:
     // member functions
     void buildVerticesSmooth();
     void buildVerticesFlat();
-    void buildInterleavedVertices();
+    void buildOutputs();
+    void buildSeparateVertices();
+    void buildLineIndices();
+    void updateVertices();
     void clearArrays();
-    void addVertex(float x, float y, float z);
-    void addNormal(float x, float y, float z);
-    void addTexCoord(float s, float t);
-    void addIndices(unsigned int i1, unsigned int i2, unsigned int i3);
-    std::vector<float> computeFaceNormal(float x1, float y1, float z1,
-                                         float x2, float y2, float z2,
-                                         float x3, float y3, float z3);
+    static void writeSmooth(float radius, int sectorCount, int stackCount, float* vertices, unsigned int* indices,
+                            ThreadPool* pool=0);
+    static void writeSmoothRows(float radius, int sectorCount, int stackCount,
+                                const float* cosTable, const float* sinTable,
+                                int rowBegin, int rowEnd, float* vertices);
+    static void writeSmoothIndices(int sectorCount, int stackCount, int stackBegin, int stackEnd, unsigned int* indices);
+    static void writeFlat(float radius, int sectorCount, int stackCount, float* vertices, unsigned int* indices);
 
     // memeber vars
     float radius;
     int sectorCount;                        // longitude, # of slices
     int stackCount;                         // latitude, # of stacks
     bool smooth;
-    std::vector<float> vertices;
-    std::vector<float> normals;
-    std::vector<float> texCoords;
-    std::vector<unsigned int> indices;
-    std::vector<unsigned int> lineIndices;
+    unsigned int outputs;                   // MeshOutput flags
+    unsigned int vertexCount;
+    unsigned int indexCount;
+    unsigned int lineIndexCount;
+    std::pmr::vector<float> vertices;
+    std::pmr::vector<float> normals;
+    std::pmr::vector<float> texCoords;
+    std::pmr::vector<unsigned int> indices;
+    std::pmr::vector<unsigned int> lineIndices;
 
     // interleaved
-    std::vector<float> interleavedVertices;
+    std::pmr::vector<float> interleavedVertices;
     int interleavedStride;                  // # of bytes to hop to the next vertex (should be 32 bytes)
 
 };
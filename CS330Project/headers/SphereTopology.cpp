@@ -0,0 +1,267 @@
+///////////////////////////////////////////////////////////////////////////////
+// SphereTopology.cpp
+// ==================
+// Equirectangular tex coords, seam fix-up and chord error of sphere meshes.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include "MeshView.h"
+#include "Sphere.h"
+#include "SphereTopology.h"
+
+// normal z of a pole vertex; the pole of a generated sphere is exactly (0, 0, +-1)
+const float POLE_Z = 0.999999f;
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// same angles as Sphere: sector angle atan2(y, x), stack angle asin(z)
+///////////////////////////////////////////////////////////////////////////////
+void getSphereTexCoord(float x, float y, float z, float& s, float& t)
+{
+    const float PI = acos(-1);
+    float sectorAngle = atan2f(y, x);
+    if(sectorAngle < 0)
+        sectorAngle += 2 * PI;
+    s = sectorAngle / (2 * PI);
+    if(s >= 1.0f)
+        s = 0.0f;
+
+    if(z > 1.0f) z = 1.0f;
+    if(z < -1.0f) z = -1.0f;
+    t = acosf(z) / PI;      // (pi/2 - stack angle) / pi
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the normal of a sphere is its unit direction
+///////////////////////////////////////////////////////////////////////////////
+void writeSphereVertices(const Vec3* directions, unsigned int count, float radius, float* vertices)
+{
+    for(unsigned int i = 0; i < count; ++i)
+    {
+        GridVertex v;
+        v.position.x = directions[i].x * radius;
+        v.position.y = directions[i].y * radius;
+        v.position.z = directions[i].z * radius;
+        getSphereTexCoord(directions[i].x, directions[i].y, directions[i].z, v.s, v.t);
+        vertices = writeVertex(vertices, v, directions[i]);
+    }
+}
+
+void scaleSphereVertices(float radius, unsigned int count, float* vertices)
+{
+    for(unsigned int i = 0; i < count; ++i, vertices += MESH_VERTEX_FLOATS)
+    {
+        vertices[0] = vertices[3] * radius;
+        vertices[1] = vertices[4] * radius;
+        vertices[2] = vertices[5] * radius;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// copy vertex index to the end of vertices and return the index of the copy
+///////////////////////////////////////////////////////////////////////////////
+static unsigned int duplicateVertex(std::pmr::vector<float>& vertices, unsigned int index)
+{
+    unsigned int copy = (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS);
+    vertices.resize(vertices.size() + MESH_VERTEX_FLOATS);
+    std::copy(vertices.begin() + (std::size_t)index * MESH_VERTEX_FLOATS,
+              vertices.begin() + (std::size_t)(index + 1) * MESH_VERTEX_FLOATS,
+              vertices.begin() + (std::size_t)copy * MESH_VERTEX_FLOATS);
+    return copy;
+}
+
+static bool isPole(const std::pmr::vector<float>& vertices, unsigned int index)
+{
+    return fabsf(vertices[(std::size_t)index * MESH_VERTEX_FLOATS + 5]) > POLE_Z;
+}
+
+static float& getS(std::pmr::vector<float>& vertices, unsigned int index)
+{
+    return vertices[(std::size_t)index * MESH_VERTEX_FLOATS + 6];
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// seam first, so the pole copies average the tex coords of the fixed corners
+///////////////////////////////////////////////////////////////////////////////
+void fixSphereSeams(std::pmr::vector<float>& vertices, std::pmr::vector<unsigned int>& indices)
+{
+    const unsigned int NONE = 0xffffffff;
+    unsigned int vertexCount = (unsigned int)(vertices.size() / MESH_VERTEX_FLOATS);
+    std::vector<unsigned int> wrapped(vertexCount, NONE);     // copy with s + 1 of each vertex
+
+    for(std::size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        // the s of a pole is arbitrary, so poles do not count for the span
+        float minS = 1.0f, maxS = 0.0f;
+        for(int k = 0; k < 3; ++k)
+        {
+            if(isPole(vertices, indices[i+k]))
+                continue;
+            float s = getS(vertices, indices[i+k]);
+            minS = std::min(minS, s);
+            maxS = std::max(maxS, s);
+        }
+        if(maxS - minS <= 0.5f)
+            continue;
+
+        for(int k = 0; k < 3; ++k)
+        {
+            unsigned int index = indices[i+k];
+            if(isPole(vertices, index) || getS(vertices, index) >= 0.5f)
+                continue;
+            if(wrapped[index] == NONE)
+            {
+                wrapped[index] = duplicateVertex(vertices, index);
+                getS(vertices, wrapped[index]) += 1.0f;
+            }
+            indices[i+k] = wrapped[index];
+        }
+    }
+
+    for(std::size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            if(!isPole(vertices, indices[i+k]))
+                continue;
+            unsigned int a = indices[i + (k + 1) % 3];
+            unsigned int b = indices[i + (k + 2) % 3];
+            unsigned int pole = duplicateVertex(vertices, indices[i+k]);
+            getS(vertices, pole) = (getS(vertices, a) + getS(vertices, b)) * 0.5f;
+            indices[i+k] = pole;
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// each edge as a 64-bit (smaller, larger) key, sorted and made unique
+///////////////////////////////////////////////////////////////////////////////
+void buildEdgeIndices(const unsigned int* indices, unsigned int indexCount, std::pmr::vector<unsigned int>& lines)
+{
+    std::vector<unsigned long long> edges;
+    edges.reserve(indexCount);
+    for(unsigned int i = 0; i + 2 < indexCount; i += 3)
+    {
+        for(int k = 0; k < 3; ++k)
+        {
+            unsigned int a = indices[i+k];
+            unsigned int b = indices[i + (k + 1) % 3];
+            if(a > b)
+                std::swap(a, b);
+            edges.push_back(((unsigned long long)a << 32) | b);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+
+    lines.resize(edges.size() * 2);
+    for(std::size_t i = 0; i < edges.size(); ++i)
+    {
+        lines[i*2]   = (unsigned int)(edges[i] >> 32);
+        lines[i*2+1] = (unsigned int)(edges[i] & 0xffffffff);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// squared distance from the origin to the closest point of triangle abc
+// (Ericson, Real-Time Collision Detection 5.1.5, with p at the origin)
+///////////////////////////////////////////////////////////////////////////////
+static double getClosestDistanceSquared(const double a[3], const double b[3], const double c[3])
+{
+    double ab[3], ac[3], ap[3], bp[3], cp[3];
+    for(int i = 0; i < 3; ++i)
+    {
+        ab[i] = b[i] - a[i];
+        ac[i] = c[i] - a[i];
+        ap[i] = -a[i];
+        bp[i] = -b[i];
+        cp[i] = -c[i];
+    }
+    double d1 = ab[0]*ap[0] + ab[1]*ap[1] + ab[2]*ap[2];
+    double d2 = ac[0]*ap[0] + ac[1]*ap[1] + ac[2]*ap[2];
+    double d3 = ab[0]*bp[0] + ab[1]*bp[1] + ab[2]*bp[2];
+    double d4 = ac[0]*bp[0] + ac[1]*bp[1] + ac[2]*bp[2];
+    double d5 = ab[0]*cp[0] + ab[1]*cp[1] + ab[2]*cp[2];
+    double d6 = ac[0]*cp[0] + ac[1]*cp[1] + ac[2]*cp[2];
+    double va = d3*d6 - d5*d4;
+    double vb = d5*d2 - d1*d6;
+    double vc = d1*d4 - d3*d2;
+
+    // barycentric coords of the closest point, clamped to the vertex or edge regions
+    double v, w;
+    if(d1 <= 0 && d2 <= 0)                          { v = 0; w = 0; }
+    else if(d3 >= 0 && d4 <= d3)                    { v = 1; w = 0; }
+    else if(d6 >= 0 && d5 <= d6)                    { v = 0; w = 1; }
+    else if(vc <= 0 && d1 >= 0 && d3 <= 0)          { v = d1 / (d1 - d3); w = 0; }
+    else if(vb <= 0 && d2 >= 0 && d6 <= 0)          { v = 0; w = d2 / (d2 - d6); }
+    else if(va <= 0 && (d4 - d3) >= 0 && (d5 - d6) >= 0)
+    {
+        w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        v = 1 - w;
+    }
+    else
+    {
+        double denom = 1 / (va + vb + vc);
+        v = vb * denom;
+        w = vc * denom;
+    }
+
+    double distanceSquared = 0;
+    for(int i = 0; i < 3; ++i)
+    {
+        double p = a[i] + ab[i] * v + ac[i] * w;
+        distanceSquared += p * p;
+    }
+    return distanceSquared;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// 1 - the distance from the center to the closest point of any triangle
+///////////////////////////////////////////////////////////////////////////////
+float computeChordError(const float* vertices, unsigned int stride,
+                        const unsigned int* indices, unsigned int indexCount)
+{
+    unsigned int floats = stride / sizeof(float);
+    double minDistanceSquared = 1.0;
+    for(unsigned int i = 0; i + 2 < indexCount; i += 3)
+    {
+        double corners[3][3];
+        for(int k = 0; k < 3; ++k)
+        {
+            const float* position = vertices + (std::size_t)indices[i+k] * floats;
+            for(int j = 0; j < 3; ++j)
+                corners[k][j] = position[j];
+        }
+        minDistanceSquared = std::min(minDistanceSquared, getClosestDistanceSquared(corners[0], corners[1], corners[2]));
+    }
+    return (float)(1.0 - sqrt(minDistanceSquared));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// measured on the mesh Sphere writes, so it includes the small pole triangles
+///////////////////////////////////////////////////////////////////////////////
+float getUVSphereChordError(int sectors, int stacks)
+{
+    unsigned int vertexCount, indexCount;
+    Sphere::getInterleavedCounts(sectors, stacks, true, vertexCount, indexCount);
+    std::vector<float> vertices((std::size_t)vertexCount * MESH_VERTEX_FLOATS);
+    std::vector<unsigned int> indices(indexCount);
+    Sphere::writeInterleaved(1.0f, sectors, stacks, true, vertices.data(), indices.data());
+    return computeChordError(vertices.data(), MESH_VERTEX_STRIDE, indices.data(), indexCount);
+}
@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+// SphereTopology.h
+// ================
+// Helpers shared by the sphere generators (Sphere, Icosphere, Cubesphere).
+//
+// - tex coords: all three use the equirectangular mapping of Sphere, so a
+//   texture made for the UV sphere fits the others too. A mesh whose vertices
+//   are not laid out along meridians needs its seam and poles fixed up:
+//   fixSphereSeams() duplicates the vertices of triangles that cross s = 0/1
+//   and gives every triangle at a pole its own pole vertex.
+// - chord error: the largest distance between the sphere and its mesh,
+//   relative to the radius. It is the silhouette error of a tessellation, so
+//   it is how the three topologies are compared at equal visual quality.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef GEOMETRY_SPHERE_TOPOLOGY_H
+#define GEOMETRY_SPHERE_TOPOLOGY_H
+
+#include <memory_resource>
+#include <vector>
+#include "GeometryKernel.h"
+
+enum SphereTopology
+{
+    SPHERE_TOPOLOGY_UV,     // Sphere: sectors x stacks, dense at the poles
+    SPHERE_TOPOLOGY_ICO,    // Icosphere: subdivided icosahedron, near-uniform triangles
+    SPHERE_TOPOLOGY_CUBE    // Cubesphere: 6 cube faces projected onto the sphere
+};
+
+// tex coords of a direction (unit vector) the way Sphere lays them out:
+// s = longitude / 2pi in [0, 1), t = 0 at +z to 1 at -z
+void getSphereTexCoord(float x, float y, float z, float& s, float& t);
+
+// write interleaved V/N/T vertices of a sphere of radius from unit directions:
+// position = direction * radius, normal = direction, tex coords as above
+void writeSphereVertices(const Vec3* directions, unsigned int count, float radius, float* vertices);
+
+// rewrite the positions of interleaved vertices from their normals for a new
+// radius; tex coords, seam copies and indices stay as they are
+void scaleSphereVertices(float radius, unsigned int count, float* vertices);
+
+// make the tex coords of interleaved V/N/T vertices continuous (the normals
+// must be the unit directions): vertices of triangles that span more than half
+// of s are duplicated with s + 1, and each triangle at a pole gets a copy of
+// the pole vertex with the mean s of its other corners
+void fixSphereSeams(std::pmr::vector<float>& vertices, std::pmr::vector<unsigned int>& indices);
+
+// unique edges of a triangle list as GL_LINES indices, sorted
+void buildEdgeIndices(const unsigned int* indices, unsigned int indexCount, std::pmr::vector<unsigned int>& lines);
+
+// largest distance between the unit sphere and the triangles of a mesh
+// inscribed in it (vertices with the position in the first 3 floats)
+float computeChordError(const float* vertices, unsigned int stride,
+                        const unsigned int* indices, unsigned int indexCount);
+
+// chord error of a smooth unit Sphere(1, sectors, stacks)
+float getUVSphereChordError(int sectors, int stacks);
+
+#endif
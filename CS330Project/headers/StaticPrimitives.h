@@ -0,0 +1,311 @@
+///////////////////////////////////////////////////////////////////////////////
+// StaticPrimitives.h
+// ==================
+// Sphere and cylinder with the sector and stack counts fixed at compile time:
+// StaticSphere<Sectors, Stacks> and StaticCylinder<Sectors, Stacks>.
+// They write the same smooth V/N/T vertices and triangle indices as Sphere
+// and Cylinder (values may differ in the last bit), but:
+// - cos/sin of the sector and stack angles are constexpr tables, evaluated
+//   by the compiler instead of calling cosf/sinf per vertex
+// - each vertex ring is a fold expression over the sectors, fully unrolled
+// - vertices live in a std::array member and the indices, which only depend
+//   on the counts, in one static constexpr std::array per specialisation;
+//   nothing is allocated on the heap
+// The constructors are constexpr, so a mesh with constant dimensions can be
+// built entirely at compile time:
+//   constexpr StaticSphere<24, 12> sphere(0.5f);
+//   uploadMesh(mesh, sphere.getMeshView());
+// Needs C++17 (constexpr std::array access, inline static members).
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef STATIC_PRIMITIVES_H
+#define STATIC_PRIMITIVES_H
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include "MeshView.h"
+
+constexpr double STATIC_PI = 3.14159265358979323846;
+
+// sin(x) by its Taylor series after reducing x to [-pi, pi]; exact to double precision
+constexpr double staticSin(double x)
+{
+    while(x > STATIC_PI)
+        x -= 2 * STATIC_PI;
+    while(x < -STATIC_PI)
+        x += 2 * STATIC_PI;
+
+    double term = x, sum = x;
+    for(int n = 1; n < 14; ++n)
+    {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double staticCos(double x)
+{
+    return staticSin(x + STATIC_PI / 2);
+}
+
+// sqrt(x) by Newton's method
+constexpr double staticSqrt(double x)
+{
+    if(x <= 0)
+        return 0;
+    double y = x > 1 ? x : 1;
+    for(int i = 0; i < 64; ++i)
+        y = 0.5 * (y + x / y);
+    return y;
+}
+
+// cos/sin of start + i * step for i in [0, Count)
+template<std::size_t Count>
+struct AngleTable
+{
+    std::array<float, Count> cosines;
+    std::array<float, Count> sines;
+};
+
+template<std::size_t Count>
+constexpr AngleTable<Count> makeAngleTable(double start, double step)
+{
+    AngleTable<Count> table = {};
+    for(std::size_t i = 0; i < Count; ++i)
+    {
+        table.cosines[i] = (float)staticCos(start + i * step);
+        table.sines[i] = (float)staticSin(start + i * step);
+    }
+    return table;
+}
+
+// same triangles as Sphere: 1 per sector for the 1st/last stacks, 2 for others
+template<int Sectors, int Stacks>
+constexpr std::array<unsigned int, Sectors * (Stacks - 1) * 6> makeStaticSphereIndices()
+{
+    std::array<unsigned int, Sectors * (Stacks - 1) * 6> indices = {};
+    std::size_t n = 0;
+    for(int i = 0; i < Stacks; ++i)
+    {
+        unsigned int k1 = i * (Sectors + 1);     // beginning of current stack
+        unsigned int k2 = k1 + Sectors + 1;      // beginning of next stack
+        for(int j = 0; j < Sectors; ++j, ++k1, ++k2)
+        {
+            if(i != 0)
+            {
+                indices[n++] = k1;
+                indices[n++] = k2;
+                indices[n++] = k1 + 1;
+            }
+            if(i != Stacks - 1)
+            {
+                indices[n++] = k1 + 1;
+                indices[n++] = k2;
+                indices[n++] = k2 + 1;
+            }
+        }
+    }
+    return indices;
+}
+
+// same triangles as Cylinder: 2 per side sector, base clockwise seen from the top
+template<int Sectors, int Stacks>
+constexpr std::array<unsigned int, (Stacks + 1) * Sectors * 6> makeStaticCylinderIndices()
+{
+    std::array<unsigned int, (Stacks + 1) * Sectors * 6> indices = {};
+    std::size_t n = 0;
+    for(int i = 0; i < Stacks; ++i)
+    {
+        unsigned int k1 = i * (Sectors + 1);
+        unsigned int k2 = k1 + Sectors + 1;
+        for(int j = 0; j < Sectors; ++j, ++k1, ++k2)
+        {
+            indices[n++] = k1;
+            indices[n++] = k1 + 1;
+            indices[n++] = k2;
+            indices[n++] = k2;
+            indices[n++] = k1 + 1;
+            indices[n++] = k2 + 1;
+        }
+    }
+
+    for(int cap = 0; cap < 2; ++cap)
+    {
+        unsigned int center = (Stacks + 1) * (Sectors + 1) + cap * (Sectors + 1);
+        for(unsigned int j = 0, k = center + 1; j < (unsigned int)Sectors; ++j, ++k)
+        {
+            unsigned int next = (j < (unsigned int)Sectors - 1) ? k + 1 : center + 1;    // last triangle wraps around
+            indices[n++] = center;
+            indices[n++] = cap == 0 ? next : k;
+            indices[n++] = cap == 0 ? k : next;
+        }
+    }
+    return indices;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// smooth sphere, same layout as Sphere::writeInterleaved()
+///////////////////////////////////////////////////////////////////////////////
+template<int Sectors, int Stacks>
+class StaticSphere
+{
+    static_assert(Sectors >= 3 && Stacks >= 2, "a sphere needs at least 3 sectors and 2 stacks");
+
+public:
+    static constexpr unsigned int VERTEX_COUNT = (Stacks + 1) * (Sectors + 1);
+    static constexpr unsigned int INDEX_COUNT = Sectors * (Stacks - 1) * 6;
+
+    // ctor
+    constexpr explicit StaticSphere(float radius=1.0f) : radius(radius), vertices()
+    {
+        for(int i = 0; i <= Stacks; ++i)
+        {
+            float xy = radius * STACKS.cosines[i];          // r * cos(u)
+            float z = radius * STACKS.sines[i];             // r * sin(u)
+            writeRing(i * (Sectors + 1) * 8, xy, z, STACKS.cosines[i], STACKS.sines[i], (float)i / Stacks,
+                      std::make_index_sequence<Sectors + 1>());
+        }
+    }
+
+    // getters
+    constexpr float getRadius() const                       { return radius; }
+    constexpr unsigned int getVertexCount() const           { return VERTEX_COUNT; }
+    constexpr unsigned int getIndexCount() const            { return INDEX_COUNT; }
+    constexpr const float* getInterleavedVertices() const   { return vertices.data(); }
+    constexpr const unsigned int* getIndices() const        { return INDICES.data(); }
+    MeshView getMeshView() const    { return MeshView(vertices.data(), VERTEX_COUNT, INDICES.data(), INDEX_COUNT); }
+
+private:
+    // sector angle from 0 to 2pi, stack angle from pi/2 to -pi/2
+    static constexpr AngleTable<Sectors + 1> SECTORS = makeAngleTable<Sectors + 1>(0, 2 * STATIC_PI / Sectors);
+    static constexpr AngleTable<Stacks + 1> STACKS = makeAngleTable<Stacks + 1>(STATIC_PI / 2, -STATIC_PI / Stacks);
+
+    // one vertex per sector of the ring, unrolled; the normal is the unit direction (nxy, nz), not position / radius
+    template<std::size_t... J>
+    constexpr void writeRing(std::size_t offset, float xy, float z, float nxy, float nz, float t, std::index_sequence<J...>)
+    {
+        (writeVertex(offset + J * 8, xy * SECTORS.cosines[J], xy * SECTORS.sines[J], z,
+                     nxy * SECTORS.cosines[J], nxy * SECTORS.sines[J], nz, (float)J / Sectors, t), ...);
+    }
+
+    constexpr void writeVertex(std::size_t offset, float x, float y, float z, float nx, float ny, float nz, float s, float t)
+    {
+        vertices[offset]     = x;
+        vertices[offset + 1] = y;
+        vertices[offset + 2] = z;
+        vertices[offset + 3] = nx;
+        vertices[offset + 4] = ny;
+        vertices[offset + 5] = nz;
+        vertices[offset + 6] = s;
+        vertices[offset + 7] = t;
+    }
+
+    static constexpr std::array<unsigned int, INDEX_COUNT> INDICES = makeStaticSphereIndices<Sectors, Stacks>();
+
+    float radius;
+    std::array<float, VERTEX_COUNT * 8> vertices;
+};
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// smooth cylinder or cone, same layout as Cylinder::writeInterleaved():
+// side rows from base to top, then the base and top caps (a center vertex
+// and Sectors rim vertices each)
+///////////////////////////////////////////////////////////////////////////////
+template<int Sectors, int Stacks>
+class StaticCylinder
+{
+    static_assert(Sectors >= 3 && Stacks >= 1, "a cylinder needs at least 3 sectors and 1 stack");
+
+public:
+    static constexpr unsigned int SIDE_VERTEX_COUNT = (Stacks + 1) * (Sectors + 1);
+    static constexpr unsigned int VERTEX_COUNT = SIDE_VERTEX_COUNT + 2 * (Sectors + 1);
+    static constexpr unsigned int SIDE_INDEX_COUNT = Stacks * Sectors * 6;
+    static constexpr unsigned int INDEX_COUNT = SIDE_INDEX_COUNT + 2 * Sectors * 3;
+
+    // ctor
+    constexpr StaticCylinder(float baseRadius=1.0f, float topRadius=1.0f, float height=1.0f)
+        : baseRadius(baseRadius), topRadius(topRadius), height(height), vertices()
+    {
+        // side normal at 0 degree, tilted by the slope of a cone
+        double slope = baseRadius - topRadius;
+        double length = staticSqrt((double)height * height + slope * slope);
+        float nr = length > 0 ? (float)(height / length) : 1.0f;
+        float nz = length > 0 ? (float)(slope / length) : 0.0f;
+
+        for(int i = 0; i <= Stacks; ++i)
+        {
+            float z = -(height * 0.5f) + (float)i / Stacks * height;
+            float radius = baseRadius + (float)i / Stacks * (topRadius - baseRadius);     // lerp
+            writeSideRing(i * (Sectors + 1) * 8, radius, z, nr, nz, 1.0f - (float)i / Stacks,
+                          std::make_index_sequence<Sectors + 1>());
+        }
+
+        // base faces down and its tex coords are flipped horizontally
+        std::size_t offset = (std::size_t)SIDE_VERTEX_COUNT * 8;
+        writeVertex(offset, 0, 0, -height * 0.5f, 0, 0, -1.0f, 0.5f, 0.5f);
+        writeCapRing(offset + 8, baseRadius, -height * 0.5f, -1.0f, std::make_index_sequence<Sectors>());
+        offset += (Sectors + 1) * 8;
+        writeVertex(offset, 0, 0, height * 0.5f, 0, 0, 1.0f, 0.5f, 0.5f);
+        writeCapRing(offset + 8, topRadius, height * 0.5f, 1.0f, std::make_index_sequence<Sectors>());
+    }
+
+    // getters
+    constexpr float getBaseRadius() const                   { return baseRadius; }
+    constexpr float getTopRadius() const                    { return topRadius; }
+    constexpr float getHeight() const                       { return height; }
+    constexpr unsigned int getVertexCount() const           { return VERTEX_COUNT; }
+    constexpr unsigned int getIndexCount() const            { return INDEX_COUNT; }
+    constexpr unsigned int getBaseStartIndex() const        { return SIDE_INDEX_COUNT; }
+    constexpr unsigned int getTopStartIndex() const         { return SIDE_INDEX_COUNT + Sectors * 3; }
+    constexpr const float* getInterleavedVertices() const   { return vertices.data(); }
+    constexpr const unsigned int* getIndices() const        { return INDICES.data(); }
+    MeshView getMeshView() const    { return MeshView(vertices.data(), VERTEX_COUNT, INDICES.data(), INDEX_COUNT); }
+
+private:
+    // unit circle from 0 to 2pi
+    static constexpr AngleTable<Sectors + 1> SECTORS = makeAngleTable<Sectors + 1>(0, 2 * STATIC_PI / Sectors);
+
+    template<std::size_t... J>
+    constexpr void writeSideRing(std::size_t offset, float radius, float z, float nr, float nz, float t,
+                                 std::index_sequence<J...>)
+    {
+        (writeVertex(offset + J * 8, SECTORS.cosines[J] * radius, SECTORS.sines[J] * radius, z,
+                     SECTORS.cosines[J] * nr, SECTORS.sines[J] * nr, nz, (float)J / Sectors, t), ...);
+    }
+
+    template<std::size_t... J>
+    constexpr void writeCapRing(std::size_t offset, float radius, float z, float nz, std::index_sequence<J...>)
+    {
+        (writeVertex(offset + J * 8, SECTORS.cosines[J] * radius, SECTORS.sines[J] * radius, z, 0, 0, nz,
+                     nz < 0 ? -SECTORS.cosines[J] * 0.5f + 0.5f : SECTORS.cosines[J] * 0.5f + 0.5f,
+                     -SECTORS.sines[J] * 0.5f + 0.5f), ...);
+    }
+
+    constexpr void writeVertex(std::size_t offset, float x, float y, float z, float nx, float ny, float nz,
+                               float s, float t)
+    {
+        vertices[offset]     = x;
+        vertices[offset + 1] = y;
+        vertices[offset + 2] = z;
+        vertices[offset + 3] = nx;
+        vertices[offset + 4] = ny;
+        vertices[offset + 5] = nz;
+        vertices[offset + 6] = s;
+        vertices[offset + 7] = t;
+    }
+
+    static constexpr std::array<unsigned int, INDEX_COUNT> INDICES = makeStaticCylinderIndices<Sectors, Stacks>();
+
+    float baseRadius;
+    float topRadius;
+    float height;
+    std::array<float, VERTEX_COUNT * 8> vertices;
+};
+
+#endif
@@ -0,0 +1,207 @@
+///////////////////////////////////////////////////////////////////////////////
+// TessellationPlanner.cpp
+// =======================
+// Error-bounded sector and stack counts of the scene's spheres and cylinders.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Cubesphere.h"
+#include "Cylinder.h"
+#include "Icosphere.h"
+#include "Sphere.h"
+#include "SphereTopology.h"
+#include "TessellationPlanner.h"
+
+// bounds of the search, the min counts of Sphere and Cylinder
+const int MIN_SECTOR_COUNT = 3;
+const int MIN_SPHERE_STACK_COUNT = 2;
+const int MAX_SPHERE_STACK_COUNT = 1024;
+const int MAX_SECTOR_COUNT = 4096;
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the view height at distance is 2 * distance * tan(fovY / 2)
+///////////////////////////////////////////////////////////////////////////////
+float getPixelWorldSize(float pixels, float distance, float fovY, int viewportHeight)
+{
+    if(viewportHeight <= 0)
+        return 0.0f;
+    return pixels * 2.0f * distance * tanf(fovY * 0.5f) / viewportHeight;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// fewest segments of an arc of angle turn on a circle of radius whose chords
+// stay within maxChordError of it, r * (1 - cos(pi / n)) <= maxChordError for
+// a full circle, and whose faces turn by at most maxNormalError
+///////////////////////////////////////////////////////////////////////////////
+static int getSegmentCount(float radius, float turn, const TessellationTolerance& tolerance)
+{
+    double segments = 1;
+    if(tolerance.maxChordError > 0 && radius > tolerance.maxChordError)
+        segments = std::max(segments, turn / (2 * acos(1.0 - (double)tolerance.maxChordError / radius)));
+    if(tolerance.maxNormalError > 0)
+        segments = std::max(segments, turn / (double)tolerance.maxNormalError);
+
+    // the epsilon keeps an exact quotient from rounding up a whole segment
+    return (int)std::min((double)MAX_SECTOR_COUNT, ceil(segments - 1e-6));
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the normal turns by 2pi / sectors around and pi / stacks from pole to pole,
+// the same angle with 2 sectors per stack. the chord error of a quad is
+// larger than that of its edges, so it is measured on the mesh (SphereTopology)
+///////////////////////////////////////////////////////////////////////////////
+void planSphere(float radius, const TessellationTolerance& tolerance, int& sectors, int& stacks)
+{
+    TessellationTolerance normalOnly = { 0.0f, tolerance.maxNormalError };
+    stacks = std::max(MIN_SPHERE_STACK_COUNT, getSegmentCount(radius, (float)acos(-1.0), normalOnly));
+
+    if(tolerance.maxChordError > 0 && radius > 0)
+    {
+        float maxError = tolerance.maxChordError / radius;      // relative to the unit sphere
+        while(stacks < MAX_SPHERE_STACK_COUNT && getUVSphereChordError(stacks * 2, stacks) > maxError)
+            ++stacks;
+    }
+    sectors = stacks * 2;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the chord error of a cylinder is that of its larger ring; its sides are
+// flat between the rings
+///////////////////////////////////////////////////////////////////////////////
+void planCylinder(float baseRadius, float topRadius, const TessellationTolerance& tolerance,
+                  int& sectors, int& stacks)
+{
+    float radius = std::max(fabsf(baseRadius), fabsf(topRadius));
+    sectors = std::max(MIN_SECTOR_COUNT, getSegmentCount(radius, 2 * (float)acos(-1.0), tolerance));
+    if(baseRadius == topRadius || stacks < 1)
+        stacks = 1;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the set is 1, 2, 3, 4, 6, 8, 12, 16, 24, ...: each power of 2 and 1.5 times it
+///////////////////////////////////////////////////////////////////////////////
+int roundTessellationCount(int count)
+{
+    for(int power = 1; ; power *= 2)
+    {
+        if(power >= count)
+            return power;
+        if(power >= 2 && power / 2 * 3 >= count)
+            return power / 2 * 3;
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// round a planned mesh up to the shared set, or take the preferred
+// tessellation when the plan fits in it. a sphere keeps 2 sectors per stack
+// and a cylinder its stacks; a straight cylinder is never snapped, as its
+// 1 stack would turn back into preferredStacks
+///////////////////////////////////////////////////////////////////////////////
+static void quantizeTessellation(const TessellationQuantization& quantization, SceneMesh& mesh)
+{
+    bool straightCylinder = mesh.type == SCENE_MESH_CYLINDER && mesh.params[0] == mesh.params[1];
+    if(quantization.preferredSectors > 0 && quantization.preferredStacks > 0 && !straightCylinder &&
+       mesh.sectors <= quantization.preferredSectors && mesh.stacks <= quantization.preferredStacks)
+    {
+        mesh.sectors = quantization.preferredSectors;
+        mesh.stacks = quantization.preferredStacks;
+    }
+    else if(quantization.roundCounts && mesh.type == SCENE_MESH_SPHERE)
+    {
+        mesh.stacks = roundTessellationCount(mesh.stacks);
+        mesh.sectors = mesh.stacks * 2;
+    }
+    else if(quantization.roundCounts)
+    {
+        mesh.sectors = roundTessellationCount(mesh.sectors);
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// same counts as the generators. a smooth sphere of a subdivided topology is
+// as fine as its chord error as a UV sphere, like buildSubdividedSphere() in
+// Source.cpp builds it
+///////////////////////////////////////////////////////////////////////////////
+unsigned int getSceneMeshTriangleCount(const SceneMesh& mesh, SphereTopology sphereTopology)
+{
+    if(mesh.type == SCENE_MESH_SPHERE && mesh.smooth != 0 && sphereTopology != SPHERE_TOPOLOGY_UV)
+    {
+        float maxError = getUVSphereChordError(mesh.sectors, mesh.stacks);
+        if(sphereTopology == SPHERE_TOPOLOGY_ICO)
+            return Icosphere::getTriangleCount(Icosphere::getFrequencyForError(maxError));
+        return Cubesphere::getTriangleCount(Cubesphere::getSegmentCountForError(maxError));
+    }
+
+    unsigned int vertexCount = 0, indexCount = 0;
+    if(mesh.type == SCENE_MESH_SPHERE)
+        Sphere::getInterleavedCounts(mesh.sectors, mesh.stacks, mesh.smooth != 0, vertexCount, indexCount);
+    else if(mesh.type == SCENE_MESH_CYLINDER)
+        Cylinder::getInterleavedCounts(mesh.sectors, mesh.stacks, mesh.smooth != 0, vertexCount, indexCount);
+    return indexCount / 3;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// the scale of a mesh is the longest axis of the model matrices using it
+///////////////////////////////////////////////////////////////////////////////
+void planSceneTessellation(const Scene& scene, const TessellationTolerance& tolerance,
+                           SceneMesh* meshes, TessellationStats* stats,
+                           const TessellationQuantization* quantization, SphereTopology sphereTopology)
+{
+    std::vector<float> scales(scene.getMeshCount(), 0.0f);
+    std::vector<unsigned int> instances(scene.getMeshCount(), 0);
+    for(unsigned int i = 0; i < scene.getObjectCount(); ++i)
+    {
+        unsigned int mesh = scene.getObjectMeshes()[i];
+        const float* m = scene.getModelMatrix(i);
+        for(int axis = 0; axis < 3; ++axis)
+        {
+            const float* column = m + axis * 4;
+            float scale = sqrtf(column[0] * column[0] + column[1] * column[1] + column[2] * column[2]);
+            scales[mesh] = std::max(scales[mesh], scale);
+        }
+        ++instances[mesh];
+    }
+
+    TessellationStats total = { 0, 0, 0 };
+    for(unsigned int i = 0; i < scene.getMeshCount(); ++i)
+    {
+        SceneMesh& mesh = meshes[i];
+        if(mesh.type != SCENE_MESH_SPHERE && mesh.type != SCENE_MESH_CYLINDER)
+            continue;
+
+        total.trianglesBefore += (unsigned long long)getSceneMeshTriangleCount(mesh, sphereTopology) * instances[i];
+        if(instances[i] > 0)
+        {
+            float scale = scales[i];
+            if(mesh.type == SCENE_MESH_SPHERE)
+                planSphere(mesh.params[0] * scale, tolerance, mesh.sectors, mesh.stacks);
+            else
+                planCylinder(mesh.params[0] * scale, mesh.params[1] * scale, tolerance, mesh.sectors, mesh.stacks);
+            if(quantization)
+                quantizeTessellation(*quantization, mesh);
+            ++total.meshesPlanned;
+        }
+        total.trianglesAfter += (unsigned long long)getSceneMeshTriangleCount(mesh, sphereTopology) * instances[i];
+    }
+
+    if(stats)
+        *stats = total;
+}
@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// TessellationPlanner.h
+// =====================
+// Picks the fewest sectors and stacks a sphere or cylinder needs to stay
+// within an error bound, instead of one tessellation for every primitive.
+//
+// - chord error: the largest distance between the surface and its triangles,
+//   in world units. getPixelWorldSize() turns an error in pixels at a
+//   reference distance into world units for a perspective camera.
+// - normal error: the largest angle between the normals of neighbouring
+//   faces, which is what smooth shading has to interpolate across.
+//
+// The sides of a cylinder or cone are ruled: a stack is a flat strip of
+// quads, so more stacks add no geometry. A straight cylinder gets 1 stack;
+// a cone keeps its stacks, which only shorten the trapezoids its tex coords
+// are interpolated across.
+//
+// Planned counts can be rounded up to a small shared set (quantization), so
+// meshes of similar size get the same tessellation and can share one unit
+// mesh, and snapped to a preferred tessellation when the plan fits in it
+// (never a straight cylinder, which would get its stacks back). Rounding up
+// only makes the error smaller.
+//
+// Triangle counts follow the sphere topology the meshes are built with: a
+// smooth sphere of an icosphere or cubesphere topology is counted as the mesh
+// with the chord error of its sectors and stacks as a UV sphere.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TESSELLATION_PLANNER_H
+#define TESSELLATION_PLANNER_H
+
+#include "Scene.h"
+#include "SphereTopology.h"
+
+struct TessellationTolerance
+{
+    float maxChordError;        // world units, 0 for no limit
+    float maxNormalError;       // radians, 0 for no limit
+};
+
+struct TessellationQuantization
+{
+    bool roundCounts;           // round sectors (and sphere stacks) up to 3, 4, 6, 8, 12, 16, 24, ...: at most 1.5 times the plan
+    int preferredSectors;       // tessellation taken whenever the plan needs no more sectors and stacks (except by
+                                // straight cylinders), 0 for none
+    int preferredStacks;
+};
+
+struct TessellationStats
+{
+    unsigned int meshesPlanned;             // spheres and cylinders
+    unsigned long long trianglesBefore;     // drawn by all objects of the scene
+    unsigned long long trianglesAfter;
+};
+
+// world size of pixels at distance from a camera with a vertical field of
+// view fovY (radians) and a viewport height in pixels
+float getPixelWorldSize(float pixels, float distance, float fovY, int viewportHeight);
+
+// fewest sectors and stacks within tolerance for a primitive of this size;
+// a sphere keeps 2 sectors per stack, so its quads are square at the equator.
+// the height of a cylinder does not matter; stacks is read for cones, which keep it
+void planSphere(float radius, const TessellationTolerance& tolerance, int& sectors, int& stacks);
+void planCylinder(float baseRadius, float topRadius, const TessellationTolerance& tolerance,
+                  int& sectors, int& stacks);
+
+// # of triangles of a scene sphere or cylinder as generated, 0 for other meshes;
+// smooth spheres as built by sphereTopology
+unsigned int getSceneMeshTriangleCount(const SceneMesh& mesh, SphereTopology sphereTopology=SPHERE_TOPOLOGY_UV);
+
+// smallest count of the shared set (powers of 2 and 3 times powers of 2) that is at least count
+int roundTessellationCount(int count);
+
+// replan the spheres and cylinders of meshes (a copy of the scene's, indexed
+// like it) at the largest scale any object draws them with, so every
+// instance is within tolerance; quantization and stats are optional, and the
+// stats count smooth spheres as built by sphereTopology
+void planSceneTessellation(const Scene& scene, const TessellationTolerance& tolerance,
+                           SceneMesh* meshes, TessellationStats* stats=0,
+                           const TessellationQuantization* quantization=0,
+                           SphereTopology sphereTopology=SPHERE_TOPOLOGY_UV);
+
+#endif
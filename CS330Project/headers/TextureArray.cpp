@@ -0,0 +1,239 @@
+///////////////////////////////////////////////////////////////////////////////
+// TextureArray.cpp
+// ================
+// Packs decoded textures into GL_TEXTURE_2D_ARRAYs grouped by size class.
+//
+// Images are stretched (not padded) to the class size so that texture
+// coordinates in [0,1] and GL_REPEAT wrapping keep working unchanged.
+// Shrinking starts from the nearest mip level and averages several bilinear
+// taps per texel (resampleRGBA), so detail finer than a texel does not alias.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include "TextureArray.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+TextureArraySet::TextureArraySet(int maxLayerSize) : maxLayerSize(maxLayerSize)
+{
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// size class of a dimension: the nearest power of two, up to maxLayerSize
+///////////////////////////////////////////////////////////////////////////////
+int TextureArraySet::getClassSize(int size) const
+{
+    return nearestPowerOfTwo(size, maxLayerSize);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// find or create the size class of a size and format
+///////////////////////////////////////////////////////////////////////////////
+std::size_t TextureArraySet::findClass(int width, int height, GLenum format)
+{
+    std::size_t index = 0;
+    while(index < classes.size() &&
+          (classes[index].width != width || classes[index].height != height || classes[index].format != format))
+        ++index;
+    if(index == classes.size())
+    {
+        SizeClass sizeClass;
+        sizeClass.width = width;
+        sizeClass.height = height;
+        sizeClass.format = format;
+        sizeClass.layerCount = 0;
+        sizeClass.textureId = 0;
+        classes.push_back(sizeClass);
+    }
+    return index;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// resize the image into its size class and queue it as a layer
+///////////////////////////////////////////////////////////////////////////////
+bool TextureArraySet::add(const unsigned char* image, int width, int height, int channels,
+                          TextureLayer& layer)
+{
+    PreparedImage prepared;
+    return prepared.prepare(image, width, height, channels, IMAGE_BUILD_MIPS) && add(prepared, layer);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// resample a prepared image into its size class, from the smallest mip level
+// that is not smaller than the class, and queue it as a layer
+///////////////////////////////////////////////////////////////////////////////
+bool TextureArraySet::add(const PreparedImage& image, TextureLayer& layer)
+{
+    if(image.getLevelCount() == 0)
+        return false;
+
+    int classWidth = getClassSize(image.getWidth(0));
+    int classHeight = getClassSize(image.getHeight(0));
+    int level = 0;
+    while(level + 1 < image.getLevelCount() &&
+          image.getWidth(level + 1) >= classWidth && image.getHeight(level + 1) >= classHeight)
+        ++level;
+
+    std::size_t index = findClass(classWidth, classHeight, GL_RGBA8);
+    SizeClass& sizeClass = classes[index];
+    std::size_t layerSize = (std::size_t)classWidth * classHeight * 4;
+    sizeClass.levels.resize(1);
+    sizeClass.levels[0].resize(layerSize * (sizeClass.layerCount + 1));
+    resampleRGBA(image.getPixels(level), image.getWidth(level), image.getHeight(level),
+                 &sizeClass.levels[0][layerSize * sizeClass.layerCount], classWidth, classHeight);
+
+    layer.array = (int)index;
+    layer.layer = sizeClass.layerCount++;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// first level of a compressed mip chain within maxLayerSize, and its size
+///////////////////////////////////////////////////////////////////////////////
+int TextureArraySet::findFittingLevel(const CompressedImage& image, int& width, int& height) const
+{
+    int level = 0;
+    width = image.width;
+    height = image.height;
+    while((width > maxLayerSize || height > maxLayerSize) && level + 1 < (int)image.levels.size())
+    {
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+        ++level;
+    }
+    return level;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// compressed blocks cannot be resampled, so the fitting level must already be
+// a size class
+///////////////////////////////////////////////////////////////////////////////
+bool TextureArraySet::canAdd(const CompressedImage& image) const
+{
+    if(image.levels.empty())
+        return false;
+
+    int width, height;
+    findFittingLevel(image, width, height);
+    return width <= maxLayerSize && height <= maxLayerSize &&
+           (width & (width - 1)) == 0 && (height & (height - 1)) == 0;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// queue the fitting levels of a compressed image as a layer. a class keeps the
+// levels every one of its layers has
+///////////////////////////////////////////////////////////////////////////////
+bool TextureArraySet::add(const CompressedImage& image, TextureLayer& layer)
+{
+    if(!canAdd(image))
+        return false;
+
+    int width, height;
+    int firstLevel = findFittingLevel(image, width, height);
+    std::size_t levelCount = image.levels.size() - firstLevel;
+
+    std::size_t index = findClass(width, height, image.glInternalFormat);
+    SizeClass& sizeClass = classes[index];
+    if(sizeClass.layerCount == 0 || levelCount < sizeClass.levels.size())
+        sizeClass.levels.resize(levelCount);
+    for(std::size_t i = 0; i < sizeClass.levels.size(); ++i)
+    {
+        const std::vector<unsigned char>& level = image.levels[firstLevel + i];
+        sizeClass.levels[i].insert(sizeClass.levels[i].end(), level.begin(), level.end());
+    }
+
+    layer.array = (int)index;
+    layer.layer = sizeClass.layerCount++;
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// create the array textures
+// OpenGL RC must be set before calling it
+///////////////////////////////////////////////////////////////////////////////
+bool TextureArraySet::upload()
+{
+    GLint maxLayers = 0;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &maxLayers);
+
+    for(std::size_t i = 0; i < classes.size(); ++i)
+    {
+        SizeClass& sizeClass = classes[i];
+        if(sizeClass.layerCount > maxLayers)
+        {
+            std::cout << "Texture array " << sizeClass.width << "x" << sizeClass.height
+                      << " exceeds " << maxLayers << " layers" << std::endl;
+            return false;
+        }
+
+        glGenTextures(1, &sizeClass.textureId);
+        glBindTexture(GL_TEXTURE_2D_ARRAY, sizeClass.textureId);
+
+        // same sampling as the 2D textures created by TextureLoader
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        if(sizeClass.format == GL_RGBA8)
+        {
+            glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGBA8, sizeClass.width, sizeClass.height,
+                         sizeClass.layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, sizeClass.levels[0].data());
+            glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+        }
+        else
+        {
+            // the baked mip chain, every layer of a level in one upload
+            int width = sizeClass.width;
+            int height = sizeClass.height;
+            GLint levelCount = (GLint)sizeClass.levels.size();
+            for(GLint level = 0; level < levelCount; ++level)
+            {
+                glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, sizeClass.format, width, height, sizeClass.layerCount, 0,
+                                       (GLsizei)sizeClass.levels[level].size(), sizeClass.levels[level].data());
+                width = width > 1 ? width / 2 : 1;
+                height = height > 1 ? height / 2 : 1;
+            }
+            glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+        }
+
+        std::vector<std::vector<unsigned char> >().swap(sizeClass.levels);
+    }
+
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// delete the GL textures
+///////////////////////////////////////////////////////////////////////////////
+void TextureArraySet::release()
+{
+    for(std::size_t i = 0; i < classes.size(); ++i)
+    {
+        if(classes[i].textureId)
+            glDeleteTextures(1, &classes[i].textureId);
+        classes[i].textureId = 0;
+    }
+}
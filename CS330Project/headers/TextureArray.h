@@ -0,0 +1,81 @@
+///////////////////////////////////////////////////////////////////////////////
+// TextureArray.h
+// ==============
+// Packs decoded textures into GL_TEXTURE_2D_ARRAYs so that objects with
+// different textures can be drawn without rebinding.
+// Images are resized to a power-of-two size class (each dimension rounded to
+// the nearest power of two, clamped to maxLayerSize) and every size class
+// becomes one array. A texture is then addressed by (array, layer).
+// Baked BC1/BC3 images stay compressed: their mip chain starts at the first
+// level that fits maxLayerSize, and they get size classes of their own format.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include <GL/glew.h>
+#include <vector>
+#include "ImageProcess.h"
+#include "TextureCompress.h"
+
+// location of a texture inside a TextureArraySet
+struct TextureLayer
+{
+    int array;      // index of the texture array (size class)
+    int layer;      // layer inside that array
+};
+
+class TextureArraySet
+{
+public:
+    // ctor/dtor
+    TextureArraySet(int maxLayerSize=1024);
+    ~TextureArraySet() {}
+
+    // resize an image with 3 or 4 channels into its size class and queue it as a new layer
+    bool add(const unsigned char* image, int width, int height, int channels, TextureLayer& layer);
+    // same for a prepared image, resampled from its smallest mip level that still covers the size class
+    bool add(const PreparedImage& image, TextureLayer& layer);
+    // queue the levels of a compressed image that fit maxLayerSize as a new layer
+    bool add(const CompressedImage& image, TextureLayer& layer);
+
+    // a compressed image can be added without decoding it: the first level that fits
+    // maxLayerSize has power-of-two dimensions. safe to call from worker threads
+    bool canAdd(const CompressedImage& image) const;
+
+    // create one GL_TEXTURE_2D_ARRAY per size class and upload all queued layers
+    // the CPU copies are freed afterwards
+    bool upload();
+
+    // delete the GL textures
+    void release();
+
+    // size class of an image dimension. safe to call from worker threads
+    int getClassSize(int size) const;
+
+    int getArrayCount() const               { return (int)classes.size(); }
+    GLuint getTextureId(int array) const    { return classes[array].textureId; }
+    int getLayerWidth(int array) const      { return classes[array].width; }
+    int getLayerHeight(int array) const     { return classes[array].height; }
+    int getLayerCount(int array) const      { return classes[array].layerCount; }
+
+private:
+    // all layers of one size class and format
+    struct SizeClass
+    {
+        int width;
+        int height;
+        GLenum format;          // GL_RGBA8 or a compressed internal format
+        int layerCount;
+        GLuint textureId;
+        std::vector<std::vector<unsigned char> > levels;    // per mip level, the layers back to back (GL_RGBA8: level 0 only)
+    };
+
+    int findFittingLevel(const CompressedImage& image, int& width, int& height) const;
+    std::size_t findClass(int width, int height, GLenum format);
+
+    int maxLayerSize;
+    std::vector<SizeClass> classes;
+};
+
+#endif
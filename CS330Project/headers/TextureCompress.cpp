@@ -0,0 +1,498 @@
+///////////////////////////////////////////////////////////////////////////////
+// TextureCompress.cpp
+// ===================
+// Offline block compression (BC1/BC3) of prepared RGBA8 mip chains,
+// stored in a KTX 1.1 container.
+//
+// The encoder fits the block endpoints along the principal axis of the block
+// colours and then picks the nearest palette entry per pixel. It is meant for
+// a bake step, not for real-time use.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
+#include <filesystem>
+#include "TextureCompress.h"
+
+
+
+// constants //////////////////////////////////////////////////////////////////
+const unsigned char KTX_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n' };
+const unsigned int  KTX_ENDIANNESS = 0x04030201;
+const unsigned int  KTX_GL_RGB     = 0x1907;
+const unsigned int  KTX_GL_RGBA    = 0x1908;
+
+// header of a KTX 1.1 file, following the 12 byte identifier
+struct KtxHeader
+{
+    unsigned int endianness;
+    unsigned int glType;
+    unsigned int glTypeSize;
+    unsigned int glFormat;
+    unsigned int glInternalFormat;
+    unsigned int glBaseInternalFormat;
+    unsigned int pixelWidth;
+    unsigned int pixelHeight;
+    unsigned int pixelDepth;
+    unsigned int numberOfArrayElements;
+    unsigned int numberOfFaces;
+    unsigned int numberOfMipmapLevels;
+    unsigned int bytesOfKeyValueData;
+};
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// helpers for 5:6:5 colours
+///////////////////////////////////////////////////////////////////////////////
+static unsigned short packColor565(float r, float g, float b)
+{
+    int r5 = (int)(r * 31.0f / 255.0f + 0.5f);
+    int g6 = (int)(g * 63.0f / 255.0f + 0.5f);
+    int b5 = (int)(b * 31.0f / 255.0f + 0.5f);
+    r5 = r5 < 0 ? 0 : (r5 > 31 ? 31 : r5);
+    g6 = g6 < 0 ? 0 : (g6 > 63 ? 63 : g6);
+    b5 = b5 < 0 ? 0 : (b5 > 31 ? 31 : b5);
+    return (unsigned short)((r5 << 11) | (g6 << 5) | b5);
+}
+
+static void unpackColor565(unsigned short c, int rgb[3])
+{
+    int r5 = (c >> 11) & 31;
+    int g6 = (c >> 5) & 63;
+    int b5 = c & 31;
+    rgb[0] = (r5 << 3) | (r5 >> 2);     // replicate high bits into the low bits
+    rgb[1] = (g6 << 2) | (g6 >> 4);
+    rgb[2] = (b5 << 3) | (b5 >> 2);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// compress the colour part of a block (8 bytes)
+// the block is always encoded in 4-colour mode (color0 > color1) so the same
+// routine serves BC1 and the colour half of BC3
+///////////////////////////////////////////////////////////////////////////////
+static void compressColorBlock(const unsigned char* rgba, unsigned char* out)
+{
+    // mean colour of the block
+    float mean[3] = { 0, 0, 0 };
+    for(int i = 0; i < 16; ++i)
+    {
+        mean[0] += rgba[i*4];
+        mean[1] += rgba[i*4+1];
+        mean[2] += rgba[i*4+2];
+    }
+    mean[0] /= 16; mean[1] /= 16; mean[2] /= 16;
+
+    // covariance matrix (symmetric)
+    float cov[6] = { 0, 0, 0, 0, 0, 0 };
+    for(int i = 0; i < 16; ++i)
+    {
+        float r = rgba[i*4]   - mean[0];
+        float g = rgba[i*4+1] - mean[1];
+        float b = rgba[i*4+2] - mean[2];
+        cov[0] += r*r; cov[1] += r*g; cov[2] += r*b;
+        cov[3] += g*g; cov[4] += g*b; cov[5] += b*b;
+    }
+
+    // principal axis by power iteration
+    float axis[3] = { 1, 1, 1 };
+    for(int k = 0; k < 8; ++k)
+    {
+        float x = cov[0]*axis[0] + cov[1]*axis[1] + cov[2]*axis[2];
+        float y = cov[1]*axis[0] + cov[3]*axis[1] + cov[4]*axis[2];
+        float z = cov[2]*axis[0] + cov[4]*axis[1] + cov[5]*axis[2];
+        float length = sqrtf(x*x + y*y + z*z);
+        if(length < 0.000001f)
+            break;              // flat block, keep the previous axis
+        axis[0] = x / length; axis[1] = y / length; axis[2] = z / length;
+    }
+
+    // project onto the axis to find the extreme colours
+    float minT = 1e30f, maxT = -1e30f;
+    for(int i = 0; i < 16; ++i)
+    {
+        float t = (rgba[i*4]   - mean[0]) * axis[0] +
+                  (rgba[i*4+1] - mean[1]) * axis[1] +
+                  (rgba[i*4+2] - mean[2]) * axis[2];
+        if(t < minT) minT = t;
+        if(t > maxT) maxT = t;
+    }
+
+    // inset the endpoints slightly to reduce the error of the interior colours
+    float inset = (maxT - minT) / 16.0f;
+    minT += inset;
+    maxT -= inset;
+
+    unsigned short c0 = packColor565(mean[0] + axis[0]*maxT, mean[1] + axis[1]*maxT, mean[2] + axis[2]*maxT);
+    unsigned short c1 = packColor565(mean[0] + axis[0]*minT, mean[1] + axis[1]*minT, mean[2] + axis[2]*minT);
+    if(c0 < c1)
+    {
+        unsigned short tmp = c0;
+        c0 = c1;
+        c1 = tmp;
+    }
+
+    // palette of 4 colours
+    int palette[4][3];
+    unpackColor565(c0, palette[0]);
+    unpackColor565(c1, palette[1]);
+    for(int c = 0; c < 3; ++c)
+    {
+        palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+        palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    // pick the nearest palette entry per pixel
+    unsigned int bits = 0;
+    if(c0 != c1)
+    {
+        for(int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            int bestError = 0x7fffffff;
+            for(int p = 0; p < 4; ++p)
+            {
+                int dr = rgba[i*4]   - palette[p][0];
+                int dg = rgba[i*4+1] - palette[p][1];
+                int db = rgba[i*4+2] - palette[p][2];
+                int error = dr*dr + dg*dg + db*db;
+                if(error < bestError)
+                {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            bits |= (unsigned int)best << (i * 2);
+        }
+    }
+
+    out[0] = (unsigned char)(c0 & 0xff);
+    out[1] = (unsigned char)(c0 >> 8);
+    out[2] = (unsigned char)(c1 & 0xff);
+    out[3] = (unsigned char)(c1 >> 8);
+    out[4] = (unsigned char)(bits & 0xff);
+    out[5] = (unsigned char)((bits >> 8) & 0xff);
+    out[6] = (unsigned char)((bits >> 16) & 0xff);
+    out[7] = (unsigned char)(bits >> 24);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// compress the alpha part of a BC3 block (8 bytes)
+// uses the 8-value mode so that fully transparent and fully opaque pixels
+// keep their exact alpha when they are the block extremes
+///////////////////////////////////////////////////////////////////////////////
+static void compressAlphaBlock(const unsigned char* rgba, unsigned char* out)
+{
+    int a0 = 0, a1 = 255;
+    for(int i = 0; i < 16; ++i)
+    {
+        int a = rgba[i*4+3];
+        if(a > a0) a0 = a;
+        if(a < a1) a1 = a;
+    }
+
+    unsigned long long bits = 0;
+    if(a0 != a1)
+    {
+        int palette[8];
+        palette[0] = a0;
+        palette[1] = a1;
+        for(int p = 1; p < 7; ++p)
+            palette[p+1] = ((7 - p) * a0 + p * a1) / 7;
+
+        for(int i = 0; i < 16; ++i)
+        {
+            int a = rgba[i*4+3];
+            int best = 0;
+            int bestError = 256;
+            for(int p = 0; p < 8; ++p)
+            {
+                int error = a > palette[p] ? a - palette[p] : palette[p] - a;
+                if(error < bestError)
+                {
+                    bestError = error;
+                    best = p;
+                }
+            }
+            bits |= (unsigned long long)best << (i * 3);
+        }
+    }
+
+    out[0] = (unsigned char)a0;
+    out[1] = (unsigned char)a1;
+    for(int i = 0; i < 6; ++i)
+        out[2+i] = (unsigned char)((bits >> (i * 8)) & 0xff);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// compress one 4x4 RGBA block
+///////////////////////////////////////////////////////////////////////////////
+void compressBlockBC1(const unsigned char* rgba, unsigned char* out)
+{
+    compressColorBlock(rgba, out);
+}
+
+void compressBlockBC3(const unsigned char* rgba, unsigned char* out)
+{
+    compressAlphaBlock(rgba, out);
+    compressColorBlock(rgba, out + 8);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// compress a single RGBA level into 4x4 blocks
+///////////////////////////////////////////////////////////////////////////////
+static void compressLevel(const unsigned char* rgba, int width, int height, bool bc3,
+                          std::vector<unsigned char>& out)
+{
+    int blocksX = (width + 3) / 4;
+    int blocksY = (height + 3) / 4;
+    int blockSize = bc3 ? 16 : 8;
+    out.resize((std::size_t)blocksX * blocksY * blockSize);
+
+    unsigned char block[64];
+    unsigned char* dst = out.data();
+    for(int by = 0; by < blocksY; ++by)
+    {
+        for(int bx = 0; bx < blocksX; ++bx)
+        {
+            // gather the block, clamping at the image border
+            for(int y = 0; y < 4; ++y)
+            {
+                int sy = by * 4 + y;
+                if(sy >= height) sy = height - 1;
+                for(int x = 0; x < 4; ++x)
+                {
+                    int sx = bx * 4 + x;
+                    if(sx >= width) sx = width - 1;
+                    memcpy(&block[(y * 4 + x) * 4], &rgba[((std::size_t)sy * width + sx) * 4], 4);
+                }
+            }
+
+            if(bc3)
+                compressBlockBC3(block, dst);
+            else
+                compressBlockBC1(block, dst);
+            dst += blockSize;
+        }
+    }
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// compress all levels of a prepared image
+// the mip chain is built (and filtered) by PreparedImage, see ImageProcess.h
+///////////////////////////////////////////////////////////////////////////////
+bool compressImage(const PreparedImage& image, CompressedImage& out)
+{
+    if(image.getLevelCount() == 0)
+        return false;
+
+    bool hasAlpha = image.hasAlpha();
+    out.glInternalFormat = hasAlpha ? KTX_COMPRESSED_RGBA_S3TC_DXT5 : KTX_COMPRESSED_RGB_S3TC_DXT1;
+    out.glBaseInternalFormat = hasAlpha ? KTX_GL_RGBA : KTX_GL_RGB;
+    out.width = image.getWidth(0);
+    out.height = image.getHeight(0);
+    out.levels.resize(image.getLevelCount());
+
+    for(int i = 0; i < image.getLevelCount(); ++i)
+        compressLevel(image.getPixels(i), image.getWidth(i), image.getHeight(i), hasAlpha, out.levels[i]);
+
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// write the image as a KTX 1.1 file
+// the pixel rows are stored bottom-up (already flipped for OpenGL), which is
+// recorded in the KTXorientation key
+///////////////////////////////////////////////////////////////////////////////
+bool writeKtx(const char* filename, const CompressedImage& image)
+{
+    FILE* file = fopen(filename, "wb");
+    if(!file)
+        return false;
+
+    // key/value pair: uint32 size, "key\0value\0", padded to 4 bytes
+    const char keyValue[] = "KTXorientation\0S=r,T=u";
+    unsigned int keyValueSize = sizeof(keyValue);
+    unsigned int keyValuePadding = (4 - (keyValueSize % 4)) % 4;
+
+    KtxHeader header;
+    header.endianness = KTX_ENDIANNESS;
+    header.glType = 0;                  // compressed
+    header.glTypeSize = 1;
+    header.glFormat = 0;                // compressed
+    header.glInternalFormat = image.glInternalFormat;
+    header.glBaseInternalFormat = image.glBaseInternalFormat;
+    header.pixelWidth = image.width;
+    header.pixelHeight = image.height;
+    header.pixelDepth = 0;
+    header.numberOfArrayElements = 0;
+    header.numberOfFaces = 1;
+    header.numberOfMipmapLevels = (unsigned int)image.levels.size();
+    header.bytesOfKeyValueData = 4 + keyValueSize + keyValuePadding;
+
+    const unsigned char zeros[4] = { 0, 0, 0, 0 };
+    bool ok = fwrite(KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER), 1, file) == 1 &&
+              fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(&keyValueSize, 4, 1, file) == 1 &&
+              fwrite(keyValue, keyValueSize, 1, file) == 1 &&
+              fwrite(zeros, 1, keyValuePadding, file) == keyValuePadding;
+
+    for(std::size_t i = 0; ok && i < image.levels.size(); ++i)
+    {
+        // block sizes are multiples of 8, so no mip padding is needed
+        unsigned int imageSize = (unsigned int)image.levels[i].size();
+        ok = fwrite(&imageSize, 4, 1, file) == 1 &&
+             fwrite(image.levels[i].data(), 1, imageSize, file) == imageSize;
+    }
+
+    fclose(file);
+    return ok;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// parse a KTX 1.1 file written by writeKtx() from memory
+// only single-face 2D BC1/BC3 textures in the native byte order are accepted,
+// with every level present and sized for its blocks
+///////////////////////////////////////////////////////////////////////////////
+bool readKtx(const unsigned char* data, std::size_t size, CompressedImage& image)
+{
+    KtxHeader header;
+    if(size < sizeof(KTX_IDENTIFIER) + sizeof(header) ||
+       memcmp(data, KTX_IDENTIFIER, sizeof(KTX_IDENTIFIER)) != 0)
+    {
+        return false;
+    }
+    memcpy(&header, data + sizeof(KTX_IDENTIFIER), sizeof(header));
+
+    std::size_t offset = sizeof(KTX_IDENTIFIER) + sizeof(header);
+    bool ok = header.endianness == KTX_ENDIANNESS &&
+              header.glType == 0 &&
+              header.numberOfFaces == 1 &&
+              header.pixelDepth == 0 &&
+              header.numberOfArrayElements == 0 &&
+              (header.glInternalFormat == KTX_COMPRESSED_RGB_S3TC_DXT1 ||
+               header.glInternalFormat == KTX_COMPRESSED_RGBA_S3TC_DXT5) &&
+              header.pixelWidth > 0 && header.pixelHeight > 0 &&
+              header.numberOfMipmapLevels > 0 &&
+              header.bytesOfKeyValueData <= size - offset;
+    if(!ok)
+        return false;
+    offset += header.bytesOfKeyValueData;
+
+    // no more levels than the chain down to 1x1 has
+    unsigned int maxLevels = 1;
+    for(unsigned int extent = std::max(header.pixelWidth, header.pixelHeight); extent > 1; extent /= 2)
+        ++maxLevels;
+    if(header.numberOfMipmapLevels > maxLevels)
+        return false;
+    std::size_t blockSize = header.glInternalFormat == KTX_COMPRESSED_RGBA_S3TC_DXT5 ? 16 : 8;
+
+    image.glInternalFormat = header.glInternalFormat;
+    image.glBaseInternalFormat = header.glBaseInternalFormat;
+    image.width = (int)header.pixelWidth;
+    image.height = (int)header.pixelHeight;
+    image.levels.resize(header.numberOfMipmapLevels);
+
+    unsigned int width = header.pixelWidth;
+    unsigned int height = header.pixelHeight;
+    for(std::size_t i = 0; i < image.levels.size(); ++i)
+    {
+        unsigned int imageSize;
+        if(size - offset < 4)
+            return false;
+        memcpy(&imageSize, data + offset, 4);
+        offset += 4;
+
+        // every level must hold exactly its 4x4 blocks, and all of them must be in the file
+        std::size_t expectedSize = (std::size_t)((width + 3) / 4) * ((height + 3) / 4) * blockSize;
+        if(imageSize != expectedSize || size - offset < imageSize)
+            return false;
+        image.levels[i].assign(data + offset, data + offset + imageSize);
+        offset += imageSize;
+        offset += (4 - (imageSize % 4)) % 4;   // mip padding
+        if(offset > size)
+            offset = size;
+
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return true;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// read a KTX 1.1 file written by writeKtx()
+///////////////////////////////////////////////////////////////////////////////
+bool readKtx(const char* filename, CompressedImage& image)
+{
+    FILE* file = fopen(filename, "rb");
+    if(!file)
+        return false;
+
+    std::vector<unsigned char> data;
+    unsigned char buffer[65536];
+    std::size_t count;
+    while((count = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        data.insert(data.end(), buffer, buffer + count);
+    fclose(file);
+
+    return !data.empty() && readKtx(data.data(), data.size(), image);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// replace the file extension with .ktx
+///////////////////////////////////////////////////////////////////////////////
+std::string ktxPathFor(const char* filename)
+{
+    std::string path(filename);
+    std::string::size_type dot = path.find_last_of('.');
+    std::string::size_type slash = path.find_last_of("/\\");
+    if(dot != std::string::npos && (slash == std::string::npos || dot > slash))
+        path.erase(dot);
+    return path + ".ktx";
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// replace the file extension with .layer.ktx
+///////////////////////////////////////////////////////////////////////////////
+std::string layerKtxPathFor(const char* filename)
+{
+    std::string path = ktxPathFor(filename);
+    return path.insert(path.size() - 4, ".layer");
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// compare the modification times of a baked ktx and its source image
+///////////////////////////////////////////////////////////////////////////////
+bool isKtxCurrent(const char* ktxPath, const char* filename)
+{
+    std::error_code ktxError, sourceError;
+    std::filesystem::file_time_type ktxTime = std::filesystem::last_write_time(ktxPath, ktxError);
+    std::filesystem::file_time_type sourceTime = std::filesystem::last_write_time(filename, sourceError);
+    if(ktxError)
+        return false;
+    return sourceError || ktxTime >= sourceTime;
+}
@@ -0,0 +1,53 @@
+///////////////////////////////////////////////////////////////////////////////
+// TextureCompress.h
+// =================
+// Offline block compression (BC1/BC3) of 8-bit RGB/RGBA images with a
+// precomputed mip chain, stored in a KTX 1.1 container so the renderer can
+// upload every level with glCompressedTexImage2D.
+// - BC1 (DXT1): 8 bytes per 4x4 block, used for opaque RGB images
+// - BC3 (DXT5): 16 bytes per 4x4 block, used for images with an alpha channel
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TEXTURE_COMPRESS_H
+#define TEXTURE_COMPRESS_H
+
+#include <string>
+#include <vector>
+#include "ImageProcess.h"
+
+// GL enums of the formats written to the container (EXT_texture_compression_s3tc)
+const unsigned int KTX_COMPRESSED_RGB_S3TC_DXT1  = 0x83F0;
+const unsigned int KTX_COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+
+// block-compressed image with all of its mip levels, level 0 first
+struct CompressedImage
+{
+    unsigned int glInternalFormat;      // KTX_COMPRESSED_RGB_S3TC_DXT1 or KTX_COMPRESSED_RGBA_S3TC_DXT5
+    unsigned int glBaseInternalFormat;  // GL_RGB or GL_RGBA
+    int width;                          // width of level 0
+    int height;                         // height of level 0
+    std::vector<std::vector<unsigned char> > levels;
+};
+
+// compress every level of a prepared RGBA image (BC3 when it has an alpha channel, otherwise BC1)
+bool compressImage(const PreparedImage& image, CompressedImage& out);
+
+// compress one 4x4 block of RGBA pixels (64 bytes, row-major)
+void compressBlockBC1(const unsigned char* rgba, unsigned char* out);
+void compressBlockBC3(const unsigned char* rgba, unsigned char* out);
+
+// KTX 1.1 container io
+bool writeKtx(const char* filename, const CompressedImage& image);
+bool readKtx(const char* filename, CompressedImage& image);
+bool readKtx(const unsigned char* data, std::size_t size, CompressedImage& image);   // file contents in memory
+
+// "textures/glass.jpg" -> "textures/glass.ktx"
+std::string ktxPathFor(const char* filename);
+// "textures/glass.jpg" -> "textures/glass.layer.ktx", baked at its texture array size class
+std::string layerKtxPathFor(const char* filename);
+
+// a ktx baked from a source image exists and is not older than the image
+// (a missing source image leaves the ktx current)
+bool isKtxCurrent(const char* ktxPath, const char* filename);
+
+#endif
@@ -0,0 +1,260 @@
+///////////////////////////////////////////////////////////////////////////////
+// TextureLoader.cpp
+// =================
+// Loads a batch of 2D textures with decoding on worker threads and uploads
+// on the thread that owns the OpenGL RC.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <filesystem>
+#include <future>
+#include <iostream>
+#include <memory>
+#include "stb_image.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "TextureArray.h"
+#include "TextureLoader.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// ctor
+///////////////////////////////////////////////////////////////////////////////
+TextureLoader::TextureLoader(unsigned int threadCount) : threadCount(threadCount)
+{
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// queue a texture
+///////////////////////////////////////////////////////////////////////////////
+void TextureLoader::add(const char* filename, GLuint& textureId)
+{
+    Request request;
+    request.filename = filename;
+    request.textureId = &textureId;
+    request.arrays = 0;
+    request.layer = 0;
+    request.loaded = false;
+    request.compressed = false;
+    requests.push_back(request);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// queue a texture array layer
+///////////////////////////////////////////////////////////////////////////////
+void TextureLoader::add(const char* filename, TextureArraySet& arrays, TextureLayer& layer)
+{
+    Request request;
+    request.filename = filename;
+    request.textureId = 0;
+    request.arrays = &arrays;
+    request.layer = &layer;
+    request.loaded = false;
+    request.compressed = false;
+    requests.push_back(request);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// decode all queued textures on the pool and upload them in order
+///////////////////////////////////////////////////////////////////////////////
+bool TextureLoader::loadAll()
+{
+    // GLEW state is read here, on the RC thread, and passed to the workers
+    bool allowCompressed = GLEW_EXT_texture_compression_s3tc != 0;
+
+    // map every file up front, the baked ktx when there is one and it is not older than the image
+    std::size_t count = requests.size();
+    std::unique_ptr<MappedFile[]> files(new MappedFile[count]);
+    for(std::size_t i = 0; i < count; ++i)
+    {
+        Request& request = requests[i];
+        // an array layer takes the ktx baked at its size class when there is one
+        std::string ktxPath = ktxPathFor(request.filename.c_str());
+        std::string layerKtxPath = layerKtxPathFor(request.filename.c_str());
+        if(request.arrays && std::filesystem::exists(layerKtxPath))
+            ktxPath = layerKtxPath;
+
+        bool ktxCurrent = isKtxCurrent(ktxPath.c_str(), request.filename.c_str());
+        if(!ktxCurrent && std::filesystem::exists(ktxPath))
+            std::cout << ktxPath << " is older than " << request.filename << ", run TextureBake to update it" << std::endl;
+
+        request.compressed = allowCompressed && ktxCurrent && files[i].open(ktxPath.c_str());
+        if(!request.compressed)
+            files[i].open(request.filename.c_str());
+    }
+
+    bool ok = true;
+    {
+        ThreadPool pool(threadCount);
+
+        // read ahead the first wave of jobs; each job then prefetches the file
+        // one wave further, so the disk stays ahead of the decoders
+        std::size_t lookahead = pool.getThreadCount();
+        for(std::size_t i = 0; i < count && i < lookahead; ++i)
+            files[i].prefetch();
+
+        std::vector<std::future<void> > jobs;
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            Request* request = &requests[i];
+            const MappedFile* file = &files[i];
+            const MappedFile* next = (i + lookahead < count) ? &files[i + lookahead] : 0;
+            jobs.push_back(pool.submit([this, request, file, next]()
+            {
+                if(next)
+                    next->prefetch();
+                decode(*request, *file);
+            }));
+        }
+
+        // upload as soon as each texture is ready, in queue order
+        // mappings are only closed here, after every job that may prefetch them has run
+        for(std::size_t i = 0; i < count; ++i)
+        {
+            jobs[i].get();
+            files[i].close();
+            if(!upload(requests[i]))
+                ok = false;
+        }
+    }
+
+    requests.clear();
+    return ok;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// worker job: parse the baked ktx or decode and preprocess the source image,
+// reading straight from the mapped file
+///////////////////////////////////////////////////////////////////////////////
+void TextureLoader::decode(Request& request, const MappedFile& file)
+{
+    if(!file.isOpen())
+        return;
+    file.adviseSequential();
+
+    if(request.compressed)
+    {
+        request.loaded = readKtx(file.getData(), file.getSize(), request.ktx);
+        if(request.loaded && request.arrays && !request.arrays->canAdd(request.ktx))
+        {
+            request.loaded = false;
+            request.ktx.levels.clear();
+        }
+        if(request.loaded)
+            return;
+
+        // unreadable ktx (or one the texture array cannot take), fall back to the source image
+        request.compressed = false;
+        MappedFile source;
+        if(source.open(request.filename.c_str()))
+            decodeImage(request, source);
+        return;
+    }
+
+    decodeImage(request, file);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// decode a JPG/PNG from memory into upload-ready levels
+///////////////////////////////////////////////////////////////////////////////
+void TextureLoader::decodeImage(Request& request, const MappedFile& file)
+{
+    int width, height, channels;
+    unsigned char* image = stbi_load_from_memory(file.getData(), (int)file.getSize(), &width, &height, &channels, 0);
+    if(!image)
+        return;
+
+    request.loaded = request.image.prepare(image, width, height, channels,
+                                           IMAGE_FLIP_VERTICAL | IMAGE_PREMULTIPLY_ALPHA | IMAGE_BUILD_MIPS);
+    stbi_image_free(image);
+
+    // an array layer is resampled to its size class here, off the upload thread (the array builds its own mips)
+    if(request.loaded && request.arrays)
+        request.image.resize(request.arrays->getClassSize(width), request.arrays->getClassSize(height), 0);
+
+    if(!request.loaded)
+        std::cout << "Not implemented to handle image with " << channels << " channels" << std::endl;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// create the GL texture and upload all levels, or add the layer to its set
+///////////////////////////////////////////////////////////////////////////////
+bool TextureLoader::upload(Request& request)
+{
+    if(!request.loaded)
+    {
+        std::cout << "Failed to load texture " << request.filename << std::endl;
+        return false;
+    }
+
+    // an array layer is only queued in its set here
+    if(request.arrays)
+    {
+        bool added = request.compressed ? request.arrays->add(request.ktx, *request.layer)
+                                        : request.arrays->add(request.image, *request.layer);
+        request.ktx.levels.clear();
+        request.image.clear();
+        if(!added)
+            std::cout << "Failed to add texture " << request.filename << " to a texture array" << std::endl;
+        return added;
+    }
+
+    GLuint& textureId = *request.textureId;
+    glGenTextures(1, &textureId);
+    glBindTexture(GL_TEXTURE_2D, textureId);
+
+    // set the texture wrapping parameters.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    // set texture filtering parameters.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    int levelCount;
+    if(request.compressed)
+    {
+        const CompressedImage& ktx = request.ktx;
+        levelCount = (int)ktx.levels.size();
+
+        int width = ktx.width;
+        int height = ktx.height;
+        for(int level = 0; level < levelCount; ++level)
+        {
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, ktx.glInternalFormat, width, height, 0,
+                                   (GLsizei)ktx.levels[level].size(), ktx.levels[level].data());
+            width = width > 1 ? width / 2 : 1;
+            height = height > 1 ? height / 2 : 1;
+        }
+    }
+    else
+    {
+        // RGBA8 rows are always 4-byte aligned, which is the default GL_UNPACK_ALIGNMENT
+        const PreparedImage& image = request.image;
+        levelCount = image.getLevelCount();
+        for(int level = 0; level < levelCount; ++level)
+        {
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, image.getWidth(level), image.getHeight(level), 0,
+                         GL_RGBA, GL_UNSIGNED_BYTE, image.getPixels(level));
+        }
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, levelCount - 1);
+
+    glBindTexture(GL_TEXTURE_2D, 0); // unbind the texture.
+
+    // free the CPU copy right away
+    request.ktx.levels.clear();
+    request.image.clear();
+    return true;
+}
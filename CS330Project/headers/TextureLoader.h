@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// TextureLoader.h
+// ===============
+// Loads a batch of 2D textures. Decoding and preprocessing (flip, RGB->RGBA,
+// premultiplied alpha, mip chain) run on worker threads; the calling thread
+// only uploads the finished levels, in the order the textures were added, so
+// uploads overlap with the decoding of the remaining files.
+//
+// Files are memory-mapped and decoded straight from the mapping; the files
+// queued behind the ones being decoded are prefetched in the background.
+//
+// A baked "<name>.ktx" next to the source image (see tools/TextureBake.cpp)
+// is uploaded as-is with glCompressedTexImage2D when S3TC is available and
+// the ktx is not older than the image; a stale ktx is skipped with a warning.
+// Images with an alpha channel are stored with premultiplied alpha.
+//
+// A texture can also be queued as a layer of a TextureArraySet. It is decoded
+// the same way (and resampled to its size class on the worker), then added to
+// the set instead of becoming a 2D texture. "<name>.layer.ktx", baked at the
+// size class, is preferred over "<name>.ktx"; a ktx stays compressed when the
+// set can take its size, otherwise the source image is decoded.
+// TextureArraySet::upload() creates the arrays.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef TEXTURE_LOADER_H
+#define TEXTURE_LOADER_H
+
+#include <GL/glew.h>
+#include <string>
+#include <vector>
+#include "ImageProcess.h"
+#include "TextureCompress.h"
+
+class MappedFile;
+class TextureArraySet;
+struct TextureLayer;
+
+class TextureLoader
+{
+public:
+    // ctor/dtor
+    // threadCount = 0 uses one worker per hardware thread
+    TextureLoader(unsigned int threadCount=0);
+    ~TextureLoader() {}
+
+    // queue a texture; textureId is written by loadAll()
+    void add(const char* filename, GLuint& textureId);
+    // queue a texture array layer; layer is written by loadAll()
+    void add(const char* filename, TextureArraySet& arrays, TextureLayer& layer);
+
+    // decode all queued textures and upload them
+    // OpenGL RC must be set before calling it
+    bool loadAll();
+
+private:
+    // one queued texture and the result of its worker job
+    struct Request
+    {
+        std::string filename;
+        GLuint* textureId;      // null for an array layer
+        TextureArraySet* arrays;
+        TextureLayer* layer;
+        bool loaded;            // set by the worker
+        bool compressed;        // true: ktx is valid, false: image is valid
+        CompressedImage ktx;
+        PreparedImage image;
+    };
+
+    void decode(Request& request, const MappedFile& file);
+    void decodeImage(Request& request, const MappedFile& file);
+    bool upload(Request& request);
+
+    unsigned int threadCount;
+    std::vector<Request> requests;
+};
+
+#endif
@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+// ThreadPool.h
+// ============
+// Fixed-size pool of worker threads with a FIFO task queue.
+// - submit()      : run a task on a worker and get a future to wait on
+// - parallelFor() : split [0, count) into chunks, run them on the workers and
+//                   the calling thread, and return when all are done
+// Tasks must not call OpenGL; only the thread owning the RC may do that.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+class ThreadPool
+{
+public:
+    // ctor/dtor
+    // threadCount = 0 uses one worker per hardware thread
+    explicit ThreadPool(unsigned int threadCount=0) : stopping(false)
+    {
+        if(threadCount == 0)
+            threadCount = std::thread::hardware_concurrency();
+        if(threadCount == 0)
+            threadCount = 1;
+
+        for(unsigned int i = 0; i < threadCount; ++i)
+            workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        condition.notify_all();
+        for(std::size_t i = 0; i < workers.size(); ++i)
+            workers[i].join();
+    }
+
+    unsigned int getThreadCount() const     { return (unsigned int)workers.size(); }
+
+    // queue a task, the future becomes ready when it has run
+    std::future<void> submit(std::function<void()> task)
+    {
+        std::shared_ptr<std::packaged_task<void()> > job =
+            std::make_shared<std::packaged_task<void()> >(task);
+        std::future<void> result = job->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push([job]() { (*job)(); });
+        }
+        condition.notify_one();
+        return result;
+    }
+
+    // call body(begin, end) over [0, count) in chunks of at least minChunk items
+    void parallelFor(std::size_t count, std::size_t minChunk,
+                     const std::function<void(std::size_t, std::size_t)>& body)
+    {
+        if(count == 0)
+            return;
+        if(minChunk == 0)
+            minChunk = 1;
+
+        std::size_t chunkCount = workers.size() + 1;   // workers + calling thread
+        std::size_t chunk = (count + chunkCount - 1) / chunkCount;
+        if(chunk < minChunk)
+            chunk = minChunk;
+
+        std::vector<std::future<void> > pending;
+        std::size_t begin = chunk;
+        for(; begin < count; begin += chunk)
+        {
+            std::size_t end = (begin + chunk < count) ? begin + chunk : count;
+            pending.push_back(submit([&body, begin, end]() { body(begin, end); }));
+        }
+
+        // the calling thread takes the first chunk instead of idling
+        body(0, chunk < count ? chunk : count);
+
+        for(std::size_t i = 0; i < pending.size(); ++i)
+            pending[i].get();
+    }
+
+private:
+    void workerLoop()
+    {
+        while(true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+                if(stopping && tasks.empty())
+                    return;
+                task = tasks.front();
+                tasks.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::queue<std::function<void()> > tasks;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping;
+};
+
+#endif
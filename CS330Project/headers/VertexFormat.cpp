@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+// VertexFormat.cpp
+// ================
+// Packing of float V/N/T vertices into PackedVertex.
+///////////////////////////////////////////////////////////////////////////////
+
+#include <cmath>
+#include "VertexFormat.h"
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// float -> normalized integer, rounded to nearest
+// snorm follows the GL 4.2+ rule c / (2^(b-1) - 1), so 0 and +-1 are exact
+///////////////////////////////////////////////////////////////////////////////
+static int toSnorm(float value, int maxValue)
+{
+    if(value > 1.0f)
+        value = 1.0f;
+    else if(value < -1.0f)
+        value = -1.0f;
+    return (int)std::floor(value * maxValue + 0.5f);
+}
+
+static unsigned int toUnorm(float value, unsigned int maxValue)
+{
+    if(value > 1.0f)
+        value = 1.0f;
+    else if(!(value > 0.0f))        // also catches NaN
+        value = 0.0f;
+    return (unsigned int)(value * maxValue + 0.5f);
+}
+
+static float fromSnorm(int value, int maxValue)
+{
+    float f = (float)value / maxValue;
+    return f < -1.0f ? -1.0f : f;
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// scale and bias so the box maps onto [-1, 1]
+// a flat axis (e.g. the floor plane's y) keeps scale 1 so nothing divides by 0
+///////////////////////////////////////////////////////////////////////////////
+VertexQuantization makeVertexQuantization(const float min[3], const float max[3])
+{
+    VertexQuantization quantization;
+    for(int i = 0; i < 3; ++i)
+    {
+        float halfExtent = (max[i] - min[i]) * 0.5f;
+        quantization.scale[i] = halfExtent > 0.0f ? halfExtent : 1.0f;
+        quantization.bias[i] = (max[i] + min[i]) * 0.5f;
+    }
+    return quantization;
+}
+
+VertexQuantization makeVertexQuantization(const float* vertices, unsigned int count, unsigned int stride)
+{
+    float min[3] = { 0.0f, 0.0f, 0.0f };
+    float max[3] = { 0.0f, 0.0f, 0.0f };
+    const unsigned char* bytes = (const unsigned char*)vertices;
+    for(unsigned int i = 0; i < count; ++i, bytes += stride)
+    {
+        const float* position = (const float*)bytes;
+        for(int j = 0; j < 3; ++j)
+        {
+            if(i == 0 || position[j] < min[j])
+                min[j] = position[j];
+            if(i == 0 || position[j] > max[j])
+                max[j] = position[j];
+        }
+    }
+    return makeVertexQuantization(min, max);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// pack one V/N/T vertex
+///////////////////////////////////////////////////////////////////////////////
+void packVertex(const float* vertex, const VertexQuantization& quantization, PackedVertex& packed)
+{
+    for(int i = 0; i < 3; ++i)
+        packed.position[i] = (short)toSnorm((vertex[i] - quantization.bias[i]) / quantization.scale[i], 32767);
+    packed.position[3] = 0;
+
+    // x in bits 0-9, y in 10-19, z in 20-29, w (0) in 30-31
+    unsigned int nx = (unsigned int)toSnorm(vertex[3], 511) & 0x3ff;
+    unsigned int ny = (unsigned int)toSnorm(vertex[4], 511) & 0x3ff;
+    unsigned int nz = (unsigned int)toSnorm(vertex[5], 511) & 0x3ff;
+    packed.normal = nx | (ny << 10) | (nz << 20);
+
+    packed.texCoord[0] = (unsigned short)toUnorm(vertex[6], 65535);
+    packed.texCoord[1] = (unsigned short)toUnorm(vertex[7], 65535);
+}
+
+void packVertices(const float* vertices, unsigned int count, unsigned int stride,
+                  const VertexQuantization& quantization, PackedVertex* packed)
+{
+    const unsigned char* bytes = (const unsigned char*)vertices;
+    for(unsigned int i = 0; i < count; ++i, bytes += stride)
+        packVertex((const float*)bytes, quantization, packed[i]);
+}
+
+
+
+///////////////////////////////////////////////////////////////////////////////
+// unpack one vertex
+///////////////////////////////////////////////////////////////////////////////
+void unpackVertex(const PackedVertex& packed, const VertexQuantization& quantization, float vertex[8])
+{
+    for(int i = 0; i < 3; ++i)
+        vertex[i] = fromSnorm(packed.position[i], 32767) * quantization.scale[i] + quantization.bias[i];
+
+    for(int i = 0; i < 3; ++i)
+    {
+        int n = (int)((packed.normal >> (i * 10)) & 0x3ff);
+        if(n & 0x200)               // sign extend the 10-bit value
+            n -= 0x400;
+        vertex[3 + i] = fromSnorm(n, 511);
+    }
+
+    vertex[6] = packed.texCoord[0] / 65535.0f;
+    vertex[7] = packed.texCoord[1] / 65535.0f;
+}
@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////
+// VertexFormat.h
+// ==============
+// Vertex layouts a mesh can be uploaded with.
+// - VERTEX_FORMAT_FLOAT  : 32 bytes, float V/N/T (see MeshView.h)
+// - VERTEX_FORMAT_PACKED : 16 bytes, PackedVertex
+//     position  : 3 x snorm16 (+ 1 pad) in the mesh bounds; the shader
+//                 restores it with position * scale + bias
+//     normal    : GL_INT_2_10_10_10_REV, snorm10 x/y/z
+//     tex coord : 2 x unorm16, coords have to lie in [0, 1]
+//
+// All three are normalized vertex attributes, so the only shader change is
+// the per-mesh scale and bias of the position.
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef VERTEX_FORMAT_H
+#define VERTEX_FORMAT_H
+
+enum VertexFormat
+{
+    VERTEX_FORMAT_FLOAT,
+    VERTEX_FORMAT_PACKED
+};
+
+struct PackedVertex
+{
+    short position[4];              // x, y, z, unused
+    unsigned int normal;            // 2_10_10_10_REV
+    unsigned short texCoord[2];
+};
+
+const unsigned int PACKED_VERTEX_STRIDE = sizeof(PackedVertex);     // 16 bytes
+
+// maps the packed position in [-1, 1] back to the mesh: position * scale + bias
+struct VertexQuantization
+{
+    float scale[3];
+    float bias[3];
+};
+
+// quantization covering the box [min, max]
+VertexQuantization makeVertexQuantization(const float min[3], const float max[3]);
+
+// quantization covering the positions of count interleaved V/N/T vertices
+VertexQuantization makeVertexQuantization(const float* vertices, unsigned int count, unsigned int stride);
+
+// pack interleaved V/N/T vertices (stride in bytes)
+void packVertex(const float* vertex, const VertexQuantization& quantization, PackedVertex& packed);
+void packVertices(const float* vertices, unsigned int count, unsigned int stride,
+                  const VertexQuantization& quantization, PackedVertex* packed);
+
+// decode a packed vertex back to V/N/T floats, as the GPU does
+void unpackVertex(const PackedVertex& packed, const VertexQuantization& quantization, float vertex[8]);
+
+#endif
@@ -86,6 +86,13 @@
   #endif
 #endif
 
+// 16-byte alignment for the coefficient blocks handed to an installed IDCT
+#ifdef _MSC_VER
+  #define STBI_ALIGN16 __declspec(align(16))
+#else
+  #define STBI_ALIGN16 __attribute__((aligned(16)))
+#endif
+
 
 // implementation:
 typedef unsigned char uint8;
@@ -1023,7 +1030,7 @@ static int parse_entropy_coded_data(jpeg *z)
    if (z->scan_n == 1) {
       int i,j;
       #if STBI_SIMD
-      __declspec(align(16))
+      STBI_ALIGN16
       #endif
       short data[64];
       int n = z->order[0];
@@ -1053,6 +1060,9 @@ static int parse_entropy_coded_data(jpeg *z)
       }
    } else { // interleaved!
       int i,j,k,x,y;
+      #if STBI_SIMD
+      STBI_ALIGN16
+      #endif
       short data[64];
       for (j=0; j < z->img_mcu_y; ++j) {
          for (i=0; i < z->img_mcu_x; ++i) {
@@ -1116,7 +1126,7 @@ static int process_marker(jpeg *z, int m)
                z->dequant[t][dezigzag[i]] = get8u(&z->s);
             #if STBI_SIMD
             for (i=0; i < 64; ++i)
-               z->dequant2[t][i] = dequant[t][i];
+               z->dequant2[t][i] = z->dequant[t][i];
             #endif
             L -= 65;
          }
@@ -1382,7 +1392,7 @@ static uint8 *resample_row_generic(uint8 *out, uint8 *in_near, uint8 *in_far, in
 
 // 0.38 seconds on 3*anemones.jpg   (0.25 with processor = Pro)
 // VC6 without processor=Pro is generating multiple LEAs per multiply!
-static void YCbCr_to_RGB_row(uint8 *out, uint8 *y, uint8 *pcb, uint8 *pcr, int count, int step)
+static void YCbCr_to_RGB_row(uint8 *out, uint8 const *y, uint8 const *pcb, uint8 const *pcr, int count, int step)
 {
    int i;
    for (i=0; i < count; ++i) {
@@ -0,0 +1,145 @@
+/*
+ * Description: JPEG decode benchmark for the IDCT/colour conversion hooks of
+ *              the augmented stb_image decoder. Every texture is decoded from
+ *              memory with each kernel set in JpegSimd.cpp; the output is
+ *              checked against the scalar kernels byte for byte.
+ *
+ * Build (from the CS330Project directory; drop /arch:AVX2 / -mavx2 to measure SSE2 only):
+ *   cl /O2 /EHsc /arch:AVX2 /DSTBI_SIMD=1 /DSTBI_NO_DDS tools\DecodeBench.cpp headers\JpegSimd.cpp headers\stb_image_aug.c
+ *   gcc -O2 -DSTBI_SIMD=1 -DSTBI_NO_DDS -c headers/stb_image_aug.c
+ *   g++ -O2 -mavx2 -o DecodeBench tools/DecodeBench.cpp headers/JpegSimd.cpp stb_image_aug.o
+ *
+ * Usage: DecodeBench [iterations] [image ...]   (defaults to 10 iterations over the scene textures)
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include "../headers/JpegSimd.h"
+
+// JPEG textures loaded by Source.cpp
+const char* const DEFAULT_TEXTURES[] =
+{
+    "textures/glass.jpg",
+    "textures/plane.jpg",
+    "textures/pen.jpg",
+    "textures/box.jpg",
+    "textures/perfume.jpg"
+};
+
+const JpegKernel KERNELS[] = { JPEG_KERNEL_SCALAR, JPEG_KERNEL_SSE2, JPEG_KERNEL_AVX2 };
+const int KERNEL_COUNT = sizeof(KERNELS) / sizeof(KERNELS[0]);
+
+// total decode time per kernel, for the summary
+double gTotalMs[KERNEL_COUNT];
+
+
+// read a whole file into memory so the timings do not include disk I/O
+bool readFile(const char* filename, std::vector<unsigned char>& data)
+{
+    std::ifstream file(filename, std::ios::binary);
+    if (!file)
+        return false;
+    data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !data.empty();
+}
+
+
+// decode one image with every kernel set. returns a boolean to show whether all kernels decoded it identically
+bool benchImage(const char* filename, int iterations)
+{
+    std::vector<unsigned char> file;
+    if (!readFile(filename, file))
+    {
+        std::cout << "Failed to read " << filename << std::endl;
+        return false;
+    }
+
+    std::vector<unsigned char> reference;
+    double scalarMs = 0.0;
+    bool ok = true;
+
+    for (int k = 0; k < KERNEL_COUNT; ++k)
+    {
+        if (!installJpegKernel(KERNELS[k]))
+            continue;
+
+        int width = 0, height = 0, channels = 0;
+        double bestMs = 0.0;
+        std::vector<unsigned char> pixels;
+        for (int i = 0; i < iterations; ++i)
+        {
+            std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+            unsigned char* image = stbi_load_from_memory(file.data(), (int)file.size(), &width, &height, &channels, 0);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (!image)
+            {
+                // stbi-1.16 only handles baseline JPEG; progressive files are skipped, not failed
+                std::cout << "Skipped " << filename << ": " << stbi_failure_reason() << std::endl;
+                return true;
+            }
+
+            if (i == 0)
+                pixels.assign(image, image + (std::size_t)width * height * channels);
+            stbi_image_free(image);
+
+            if (i == 0 || ms < bestMs)
+                bestMs = ms;
+        }
+        gTotalMs[k] += bestMs;
+
+        if (KERNELS[k] == JPEG_KERNEL_SCALAR)
+        {
+            reference.swap(pixels);
+            scalarMs = bestMs;
+            std::cout << filename << " (" << width << "x" << height << "x" << channels << ")" << std::endl;
+        }
+
+        bool identical = pixels.empty() || pixels == reference;
+        ok = ok && identical;
+        std::cout << "    " << getJpegKernelName(KERNELS[k]) << ": " << bestMs << " ms";
+        if (KERNELS[k] != JPEG_KERNEL_SCALAR)
+            std::cout << ", " << scalarMs / bestMs << "x" << (identical ? "" : ", OUTPUT DIFFERS");
+        std::cout << std::endl;
+    }
+
+    return ok;
+}
+
+
+int main(int argc, char** argv)
+{
+    int iterations = 10;
+    int first = 1;
+    if (argc > 1 && atoi(argv[1]) > 0)
+    {
+        iterations = atoi(argv[1]);
+        first = 2;
+    }
+
+    bool ok = true;
+    if (first < argc)
+    {
+        for (int i = first; i < argc; ++i)
+            ok = benchImage(argv[i], iterations) && ok;
+    }
+    else
+    {
+        for (std::size_t i = 0; i < sizeof(DEFAULT_TEXTURES) / sizeof(DEFAULT_TEXTURES[0]); ++i)
+            ok = benchImage(DEFAULT_TEXTURES[i], iterations) && ok;
+    }
+
+    // best-of-N times summed over all images
+    std::cout << "total:" << std::endl;
+    for (int k = 0; k < KERNEL_COUNT; ++k)
+    {
+        if (hasJpegKernel(KERNELS[k]))
+            std::cout << "    " << getJpegKernelName(KERNELS[k]) << ": " << gTotalMs[k] << " ms" << std::endl;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+/*
+ * Description: Builds the LOD chains (MeshSimplifier.h) of the generated
+ *              meshes of a scene, one mesh per thread, and prints per mesh
+ *              the triangles and error of every LOD: the largest distance
+ *              between a LOD and LOD 0, in the units of the scene file.
+ *              The meshes are optimized first (MeshOptimizer.h), as the
+ *              program does. Flat meshes have a vertex per triangle corner,
+ *              which the simplifier cannot collapse, so they only have LOD 0.
+ *              The plane and box are hand-written in Source.cpp and are not
+ *              listed.
+ *
+ * Build (from the CS330Project directory):
+ *   cl /O2 /EHsc tools\MeshLod.cpp headers\MeshSimplifier.cpp headers\MeshOptimizer.cpp headers\Sphere.cpp headers\Cylinder.cpp headers\MeshKernels.cpp headers\VertexFormat.cpp headers\Scene.cpp headers\MappedFile.cpp opengl32.lib
+ *   g++ -O2 -o MeshLod tools/MeshLod.cpp headers/MeshSimplifier.cpp headers/MeshOptimizer.cpp headers/Sphere.cpp headers/Cylinder.cpp headers/MeshKernels.cpp headers/VertexFormat.cpp headers/Scene.cpp headers/MappedFile.cpp -lGL -pthread
+ *
+ * Usage: MeshLod [scene [lodCount [ratio [maxError]]]]   (defaults to scenes/desk.scene, 4 LODs, 0.5 and no error limit)
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../headers/Cylinder.h"
+#include "../headers/MeshOptimizer.h"
+#include "../headers/MeshSimplifier.h"
+#include "../headers/Scene.h"
+#include "../headers/Sphere.h"
+#include "../headers/ThreadPool.h"
+
+// vertices and optimized indices of a generated mesh
+struct MeshArrays
+{
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+};
+
+// build one generated mesh and optimise it like the program does
+void buildMesh(const SceneMesh& mesh, MeshArrays& arrays)
+{
+    bool smooth = mesh.smooth != 0;
+    unsigned int vertexCount, indexCount;
+    if (mesh.type == SCENE_MESH_SPHERE)
+        Sphere::getInterleavedCounts(mesh.sectors, mesh.stacks, smooth, vertexCount, indexCount);
+    else
+        Cylinder::getInterleavedCounts(mesh.sectors, mesh.stacks, smooth, vertexCount, indexCount);
+
+    arrays.vertices.resize(vertexCount * MESH_VERTEX_FLOATS);
+    arrays.indices.resize(indexCount);
+    if (mesh.type == SCENE_MESH_SPHERE)
+        Sphere::writeInterleaved(mesh.params[0], mesh.sectors, mesh.stacks, smooth, arrays.vertices.data(), arrays.indices.data());
+    else
+        Cylinder::writeInterleaved(mesh.params[0], mesh.params[1], mesh.params[2], mesh.sectors, mesh.stacks, smooth,
+                                   arrays.vertices.data(), arrays.indices.data());
+
+    optimizeMesh(arrays.vertices.data(), vertexCount, MESH_VERTEX_STRIDE, arrays.indices.data(), indexCount);
+    arrays.vertices.resize(vertexCount * MESH_VERTEX_FLOATS);
+    arrays.indices.resize(indexCount);
+}
+
+int main(int argc, char** argv)
+{
+    const char* filename = argc > 1 ? argv[1] : "scenes/desk.scene";
+    unsigned int lodCount = argc > 2 ? (unsigned int)atoi(argv[2]) : 4;
+    float ratio = argc > 3 ? (float)atof(argv[3]) : 0.5f;
+    float maxError = argc > 4 ? (float)atof(argv[4]) : 0.0f;
+    if (lodCount == 0)
+        lodCount = 4;
+    if (ratio <= 0.0f || ratio >= 1.0f)
+        ratio = 0.5f;
+
+    Scene scene;
+    if (!scene.load(filename))
+    {
+        printf("Failed to load scene %s\n", filename);
+        return 1;
+    }
+
+    const SceneMesh* meshes = scene.getMeshes();
+    std::vector<unsigned int> sources;
+    for (unsigned int i = 0; i < scene.getMeshCount(); ++i)
+    {
+        if (meshes[i].type == SCENE_MESH_SPHERE || meshes[i].type == SCENE_MESH_CYLINDER)
+            sources.push_back(i);
+    }
+
+    std::vector<MeshArrays> arrays(sources.size());
+    std::vector<LodChainJob> jobs(sources.size());
+    for (std::size_t i = 0; i < sources.size(); ++i)
+    {
+        buildMesh(meshes[sources[i]], arrays[i]);
+        jobs[i].vertices = arrays[i].vertices.data();
+        jobs[i].vertexCount = (unsigned int)(arrays[i].vertices.size() / MESH_VERTEX_FLOATS);
+        jobs[i].stride = MESH_VERTEX_STRIDE;
+        jobs[i].indices = arrays[i].indices.data();
+        jobs[i].indexCount = (unsigned int)arrays[i].indices.size();
+    }
+
+    ThreadPool pool;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    buildLodChains(jobs.data(), jobs.size(), lodCount, ratio, maxError, SimplifyOptions(), &pool);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    printf("%s, up to %u LODs at %g of the triangles of the one before, %zu meshes in %.1f ms on %u threads\n",
+           filename, lodCount, ratio, jobs.size(), ms, pool.getThreadCount() + 1);
+    for (std::size_t i = 0; i < jobs.size(); ++i)
+    {
+        const SceneMesh& mesh = meshes[sources[i]];
+        printf("%2u %-8s %-6s %3d x %3d ", sources[i], mesh.type == SCENE_MESH_SPHERE ? "sphere" : "cylinder",
+               mesh.smooth != 0 ? "smooth" : "flat", mesh.sectors, mesh.stacks);
+        for (std::size_t k = 0; k < jobs[i].lods.size(); ++k)
+            printf(" %6u tris %.5f", jobs[i].lods[k].indexCount / 3, jobs[i].lods[k].error);
+        printf("\n");
+    }
+    return 0;
+}
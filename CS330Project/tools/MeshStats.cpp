@@ -0,0 +1,107 @@
+/*
+ * Description: Runs the mesh optimizer (MeshOptimizer.h) over the generated
+ *              meshes of a scene and prints, per mesh, the triangle and
+ *              vertex counts and the ACMR/ATVR of a FIFO vertex cache before
+ *              and after, plus the index buffer size with 32 and 16-bit
+ *              indices. Smooth meshes also list the triangle strip form
+ *              (one strip per stack with primitive restart): its ACMR and
+ *              index buffer size. The plane and box are hand-written in
+ *              Source.cpp and are not listed.
+ *
+ * Build (from the CS330Project directory):
+ *   cl /O2 /EHsc tools\MeshStats.cpp headers\MeshOptimizer.cpp headers\Sphere.cpp headers\Cylinder.cpp headers\MeshKernels.cpp headers\VertexFormat.cpp headers\Scene.cpp headers\MappedFile.cpp opengl32.lib
+ *   g++ -O2 -o MeshStats tools/MeshStats.cpp headers/MeshOptimizer.cpp headers/Sphere.cpp headers/Cylinder.cpp headers/MeshKernels.cpp headers/VertexFormat.cpp headers/Scene.cpp headers/MappedFile.cpp -lGL -pthread
+ *
+ * Usage: MeshStats [scene [cacheSize]]   (defaults to scenes/desk.scene and 16 entries)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../headers/Cylinder.h"
+#include "../headers/MeshOptimizer.h"
+#include "../headers/Scene.h"
+#include "../headers/Sphere.h"
+
+// optimise one generated mesh and print its stats
+void printMeshStats(unsigned int index, const SceneMesh& mesh, unsigned int cacheSize)
+{
+    bool smooth = mesh.smooth != 0;
+    unsigned int vertexCount, indexCount;
+    if (mesh.type == SCENE_MESH_SPHERE)
+        Sphere::getInterleavedCounts(mesh.sectors, mesh.stacks, smooth, vertexCount, indexCount);
+    else
+        Cylinder::getInterleavedCounts(mesh.sectors, mesh.stacks, smooth, vertexCount, indexCount);
+
+    std::vector<float> vertices(vertexCount * MESH_VERTEX_FLOATS);
+    std::vector<unsigned int> indices(indexCount);
+    if (mesh.type == SCENE_MESH_SPHERE)
+        Sphere::writeInterleaved(mesh.params[0], mesh.sectors, mesh.stacks, smooth, vertices.data(), indices.data());
+    else
+        Cylinder::writeInterleaved(mesh.params[0], mesh.params[1], mesh.params[2], mesh.sectors, mesh.stacks, smooth,
+                                   vertices.data(), indices.data());
+
+    float acmrBefore = computeACMR(indices.data(), indexCount, vertexCount, cacheSize);
+    float atvrBefore = computeATVR(indices.data(), indexCount, vertexCount, cacheSize);
+    unsigned int trianglesBefore = indexCount / 3;
+    unsigned int verticesBefore = vertexCount;
+
+    indexCount = removeDegenerateTriangles(indices.data(), indexCount, vertices.data(), MESH_VERTEX_STRIDE);
+    std::vector<unsigned int> ordered(indexCount);
+    optimizeVertexCache(ordered.data(), indices.data(), indexCount, vertexCount, cacheSize);
+    vertexCount = optimizeVertexFetch(vertices.data(), vertexCount, MESH_VERTEX_STRIDE, ordered.data(), indexCount);
+
+    float acmrAfter = computeACMR(ordered.data(), indexCount, vertexCount, cacheSize);
+    float atvrAfter = computeATVR(ordered.data(), indexCount, vertexCount, cacheSize);
+    unsigned int indexSize = indexCount * (canUse16BitIndices(vertexCount) ? 2 : 4);
+
+    printf("%2u %-8s %-6s %3d x %3d  tris %6u -> %6u  verts %6u -> %6u  ACMR %.3f -> %.3f  ATVR %.3f -> %.3f  indices %7u -> %7u bytes",
+           index, mesh.type == SCENE_MESH_SPHERE ? "sphere" : "cylinder", smooth ? "smooth" : "flat",
+           mesh.sectors, mesh.stacks, trianglesBefore, indexCount / 3, verticesBefore, vertexCount,
+           acmrBefore, acmrAfter, atvrBefore, atvrAfter, trianglesBefore * 12, indexSize);
+
+    // strips index the unoptimized smooth vertices, so the vertex count is the original one
+    if (smooth)
+    {
+        std::vector<unsigned int> strips;
+        if (mesh.type == SCENE_MESH_SPHERE)
+        {
+            strips.resize(Sphere::getStripIndexCount(mesh.sectors, mesh.stacks));
+            Sphere::writeStripIndices(mesh.sectors, mesh.stacks, strips.data());
+        }
+        else
+        {
+            strips.resize(Cylinder::getStripIndexCount(mesh.sectors, mesh.stacks));
+            Cylinder::writeStripIndices(mesh.sectors, mesh.stacks, strips.data());
+        }
+        printf("  strips ACMR %.3f  %7u bytes",
+               computeStripACMR(strips.data(), (unsigned int)strips.size(), verticesBefore, cacheSize),
+               (unsigned int)strips.size() * (canUse16BitIndices(verticesBefore) ? 2 : 4));
+    }
+    printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+    const char* filename = argc > 1 ? argv[1] : "scenes/desk.scene";
+    unsigned int cacheSize = argc > 2 ? (unsigned int)atoi(argv[2]) : MESH_CACHE_SIZE;
+    if (cacheSize == 0)
+        cacheSize = MESH_CACHE_SIZE;
+
+    Scene scene;
+    if (!scene.load(filename))
+    {
+        printf("Failed to load scene %s\n", filename);
+        return 1;
+    }
+
+    printf("%s, %u-entry FIFO cache\n", filename, cacheSize);
+    const SceneMesh* meshes = scene.getMeshes();
+    for (unsigned int i = 0; i < scene.getMeshCount(); ++i)
+    {
+        if (meshes[i].type == SCENE_MESH_SPHERE || meshes[i].type == SCENE_MESH_CYLINDER)
+            printMeshStats(i, meshes[i], cacheSize);
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+/*
+ * Description: Splits the generated meshes of a scene into meshlets
+ *              (Meshlets.h), after the mesh optimizer as the program does,
+ *              and prints per mesh the meshlet count, the mean vertices and
+ *              triangles per meshlet, and the share of the triangles
+ *              cullMeshlets() keeps for a camera looking at the mesh from
+ *              evenly spread directions at 4 times its bounding radius. With
+ *              the whole mesh in view this measures the normal cones alone.
+ *              The ACMR of the mesh optimizer's order and of the meshlet
+ *              order (Tipsify inside each meshlet) shows what clustering
+ *              costs the vertex cache.
+ *              sectors and stacks replace those of the scene file, to try
+ *              finer tessellations. The plane and box are hand-written in
+ *              Source.cpp and are not listed.
+ *
+ * Build (from the CS330Project directory):
+ *   cl /O2 /EHsc tools\MeshletStats.cpp headers\Meshlets.cpp headers\MeshOptimizer.cpp headers\Sphere.cpp headers\Cylinder.cpp headers\MeshKernels.cpp headers\VertexFormat.cpp headers\Scene.cpp headers\MappedFile.cpp opengl32.lib
+ *   g++ -O2 -o MeshletStats tools/MeshletStats.cpp headers/Meshlets.cpp headers/MeshOptimizer.cpp headers/Sphere.cpp headers/Cylinder.cpp headers/MeshKernels.cpp headers/VertexFormat.cpp headers/Scene.cpp headers/MappedFile.cpp -lGL -pthread
+ *
+ * Usage: MeshletStats [scene [sectors stacks]]   (defaults to scenes/desk.scene and its tessellation)
+ */
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../headers/Cylinder.h"
+#include "../headers/MeshOptimizer.h"
+#include "../headers/Meshlets.h"
+#include "../headers/Scene.h"
+#include "../headers/Sphere.h"
+
+const int VIEW_COUNT = 64;              // camera directions, on a Fibonacci sphere
+const float VIEW_DISTANCE = 4.0f;       // in bounding radii
+
+// build, optimise and cluster one generated mesh and print its stats
+void printMeshletStats(unsigned int index, const SceneMesh& mesh)
+{
+    bool smooth = mesh.smooth != 0;
+    unsigned int vertexCount, indexCount;
+    if (mesh.type == SCENE_MESH_SPHERE)
+        Sphere::getInterleavedCounts(mesh.sectors, mesh.stacks, smooth, vertexCount, indexCount);
+    else
+        Cylinder::getInterleavedCounts(mesh.sectors, mesh.stacks, smooth, vertexCount, indexCount);
+
+    std::vector<float> vertices(vertexCount * MESH_VERTEX_FLOATS);
+    std::vector<unsigned int> indices(indexCount);
+    if (mesh.type == SCENE_MESH_SPHERE)
+        Sphere::writeInterleaved(mesh.params[0], mesh.sectors, mesh.stacks, smooth, vertices.data(), indices.data());
+    else
+        Cylinder::writeInterleaved(mesh.params[0], mesh.params[1], mesh.params[2], mesh.sectors, mesh.stacks, smooth,
+                                   vertices.data(), indices.data());
+    optimizeMesh(vertices.data(), vertexCount, MESH_VERTEX_STRIDE, indices.data(), indexCount);
+
+    std::vector<unsigned int> ordered(indexCount);
+    std::vector<Meshlet> meshlets;
+    buildMeshlets(ordered.data(), indices.data(), indexCount, vertices.data(), vertexCount, MESH_VERTEX_STRIDE, meshlets);
+    float acmrOptimized = computeACMR(indices.data(), indexCount, vertexCount);
+    float acmrMeshlets = computeACMR(ordered.data(), indexCount, vertexCount);
+
+    // unique vertices per meshlet, and the bounds of the mesh
+    std::vector<unsigned int> owner(vertexCount, ~0u);
+    unsigned int meshletVertices = 0;
+    for (std::size_t i = 0; i < meshlets.size(); ++i)
+    {
+        for (unsigned int k = meshlets[i].firstIndex; k < meshlets[i].firstIndex + meshlets[i].indexCount; ++k)
+        {
+            if (owner[ordered[k]] != i)
+            {
+                owner[ordered[k]] = (unsigned int)i;
+                ++meshletVertices;
+            }
+        }
+    }
+    float radius = 0.0f;
+    for (unsigned int v = 0; v < vertexCount; ++v)
+    {
+        const float* p = &vertices[v * MESH_VERTEX_FLOATS];
+        radius = std::max(radius, sqrtf(p[0] * p[0] + p[1] * p[1] + p[2] * p[2]));
+    }
+
+    // planes that keep everything, so only the cones cull
+    float planes[6][4] = {};
+    for (int i = 0; i < 6; ++i)
+        planes[i][3] = 1.0f;
+    std::vector<DrawElementsIndirectCommand> commands;
+    double kept = 0.0;
+    unsigned int commandCount = 0;
+    for (int i = 0; i < VIEW_COUNT; ++i)
+    {
+        float y = 1.0f - 2.0f * (i + 0.5f) / VIEW_COUNT;
+        float ring = sqrtf(1.0f - y * y);
+        float angle = i * 2.39996323f;      // golden angle
+        float camera[3] = { cosf(angle) * ring * radius * VIEW_DISTANCE, y * radius * VIEW_DISTANCE,
+                            sinf(angle) * ring * radius * VIEW_DISTANCE };
+        commands.clear();
+        kept += cullMeshlets(meshlets.data(), (unsigned int)meshlets.size(), planes, camera, commands);
+        commandCount += (unsigned int)commands.size();
+    }
+
+    unsigned int triangles = indexCount / 3;
+    printf("%2u %-8s %-6s %3d x %3d  tris %6u  meshlets %5u  verts/meshlet %5.1f  tris/meshlet %5.1f  kept %5.1f%%  commands %5.1f  ACMR %.3f -> %.3f\n",
+           index, mesh.type == SCENE_MESH_SPHERE ? "sphere" : "cylinder", smooth ? "smooth" : "flat", mesh.sectors, mesh.stacks,
+           triangles, (unsigned int)meshlets.size(), (double)meshletVertices / meshlets.size(), (double)triangles / meshlets.size(),
+           100.0 * kept / ((double)triangles * VIEW_COUNT), (double)commandCount / VIEW_COUNT, acmrOptimized, acmrMeshlets);
+}
+
+int main(int argc, char** argv)
+{
+    const char* filename = argc > 1 ? argv[1] : "scenes/desk.scene";
+    int sectors = argc > 3 ? atoi(argv[2]) : 0;
+    int stacks = argc > 3 ? atoi(argv[3]) : 0;
+
+    Scene scene;
+    if (!scene.load(filename))
+    {
+        printf("Failed to load scene %s\n", filename);
+        return 1;
+    }
+
+    printf("%s, %u vertices and %u triangles per meshlet at most, %s culling\n", filename,
+           MESHLET_MAX_VERTICES, MESHLET_MAX_TRIANGLES, getMeshletKernelName());
+    const SceneMesh* meshes = scene.getMeshes();
+    for (unsigned int i = 0; i < scene.getMeshCount(); ++i)
+    {
+        if (meshes[i].type != SCENE_MESH_SPHERE && meshes[i].type != SCENE_MESH_CYLINDER)
+            continue;
+        SceneMesh mesh = meshes[i];
+        if (sectors > 0 && stacks > 0)
+        {
+            mesh.sectors = sectors;
+            mesh.stacks = stacks;
+        }
+        printMeshletStats(i, mesh);
+    }
+    return 0;
+}
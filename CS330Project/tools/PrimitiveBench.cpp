@@ -0,0 +1,159 @@
+/*
+ * Description: Builds many Sphere and Cylinder objects with their arrays on
+ *              the default heap, then in a std::pmr::monotonic_buffer_resource
+ *              arena, and prints the build and release times and the peak
+ *              resident set size of each. The objects are all alive at once,
+ *              like the temporary geometry of a scene build before it is
+ *              buffered to GPU. Peak RSS is per process, so each mode runs in
+ *              a process of its own: without a mode the tool runs itself once
+ *              per mode. Before that it checks that dimensions of 0, built or
+ *              set in place, give finite vertices.
+ *
+ * Build (from the CS330Project directory):
+ *   cl /O2 /EHsc /std:c++17 tools\PrimitiveBench.cpp headers\Sphere.cpp headers\Cylinder.cpp headers\MeshKernels.cpp headers\VertexFormat.cpp opengl32.lib psapi.lib
+ *   g++ -O2 -std=c++17 -o PrimitiveBench tools/PrimitiveBench.cpp headers/Sphere.cpp headers/Cylinder.cpp headers/MeshKernels.cpp headers/VertexFormat.cpp -lGL -pthread
+ *
+ * Usage: PrimitiveBench [count [default|arena]]   (defaults to 10000 primitives, both modes)
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#include "../headers/Cylinder.h"
+#include "../headers/Sphere.h"
+
+// peak resident set size of this process in MB
+double getPeakRssMb()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return 0.0;
+    return counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;    // KB on Linux
+#endif
+}
+
+double getElapsedMs(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// # of floats of the interleaved vertices that are NaN or infinite
+unsigned int countNonFinite(const float* vertices, unsigned int size)
+{
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < size / sizeof(float); ++i)
+        count += std::isfinite(vertices[i]) ? 0 : 1;
+    return count;
+}
+
+// spheres and cylinders collapsed to a point or a disc, by the ctor or by the setters, have finite vertices
+bool checkZeroDimensions()
+{
+    Sphere smoothSphere(1.0f, 24, 12, true), flatSphere(1.0f, 24, 12, false);
+    smoothSphere.setRadius(0.0f);
+    flatSphere.setRadius(0.0f);
+    Sphere zeroSphere(0.0f, 24, 12, true);
+    Cylinder cylinder(1.0f, 0.5f, 2.0f, 24, 4, true);
+    cylinder.setBaseRadius(0.0f);
+    cylinder.setTopRadius(0.0f);
+    cylinder.setHeight(0.0f);
+    Cylinder zeroCylinder(0.0f, 0.0f, 0.0f, 24, 4, false);
+
+    const Sphere* spheres[] = { &smoothSphere, &flatSphere, &zeroSphere };
+    const Cylinder* cylinders[] = { &cylinder, &zeroCylinder };
+    unsigned int nonFinite = 0;
+    for (const Sphere* sphere : spheres)
+        nonFinite += countNonFinite(sphere->getInterleavedVertices(), sphere->getInterleavedVertexSize());
+    for (const Cylinder* c : cylinders)
+        nonFinite += countNonFinite(c->getInterleavedVertices(), c->getInterleavedVertexSize());
+
+    if (nonFinite > 0)
+        printf("%u NaN or infinite vertex floats with dimensions of 0\n", nonFinite);
+    return nonFinite == 0;
+}
+
+// build count primitives (half spheres, half cylinders, mixed tessellations and shading) from resource, then free them
+void benchPrimitives(unsigned int count, bool useArena)
+{
+    std::pmr::monotonic_buffer_resource arena;
+    std::pmr::memory_resource* resource = useArena ? &arena : std::pmr::get_default_resource();
+
+    // reserved up front: the objects are not moved, so their arrays stay in the resource
+    std::vector<Sphere> spheres;
+    std::vector<Cylinder> cylinders;
+    spheres.reserve(count / 2 + 1);
+    cylinders.reserve(count / 2 + 1);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    unsigned long long vertexCount = 0;
+    for (unsigned int i = 0; i < count; ++i)
+    {
+        int sectors = 12 + (i % 4) * 8;
+        int stacks = 6 + (i % 3) * 6;
+        bool smooth = (i / 2) % 2 == 0;
+        if (i % 2 == 0)
+        {
+            spheres.emplace_back(1.0f, sectors, stacks, smooth, MESH_OUTPUT_ALL, resource);
+            vertexCount += spheres.back().getVertexCount();
+        }
+        else
+        {
+            cylinders.emplace_back(1.0f, 0.5f, 2.0f, sectors, stacks / 6, smooth, MESH_OUTPUT_ALL, resource);
+            vertexCount += cylinders.back().getVertexCount();
+        }
+    }
+    double buildMs = getElapsedMs(start);
+
+    start = std::chrono::steady_clock::now();
+    spheres.clear();
+    cylinders.clear();
+    arena.release();
+    double releaseMs = getElapsedMs(start);
+
+    printf("%-7s %u primitives, %llu vertices: build %8.2f ms, release %7.2f ms, peak RSS %7.1f MB\n",
+           useArena ? "arena" : "default", count, vertexCount, buildMs, releaseMs, getPeakRssMb());
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int count = argc > 1 ? (unsigned int)atoi(argv[1]) : 10000;
+    if (count == 0)
+        count = 10000;
+
+    if (argc > 2)
+    {
+        benchPrimitives(count, strcmp(argv[2], "arena") == 0);
+        return 0;
+    }
+
+    if (!checkZeroDimensions())
+        return 1;
+
+    // one process per mode, so each peak RSS is its own
+    for (int mode = 0; mode < 2; ++mode)
+    {
+        std::string command = std::string("\"") + argv[0] + "\" " + std::to_string(count) + (mode == 0 ? " default" : " arena");
+        fflush(stdout);
+        if (std::system(command.c_str()) != 0)
+            return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,130 @@
+/*
+ * Description: Compiles a text scene description (.scene) into the binary
+ *              form (.scenebin) that Source.cpp maps and uses in place.
+ *              With --bench it generates a scene of N objects and times
+ *              parsing the text form against loading the binary form.
+ *
+ * Build (from the CS330Project directory):
+ *   cl /O2 /EHsc tools\SceneCompile.cpp headers\Scene.cpp headers\MappedFile.cpp
+ *   g++ -O2 -o SceneCompile tools/SceneCompile.cpp headers/Scene.cpp headers/MappedFile.cpp
+ *
+ * Usage: SceneCompile [in.scene [out.scenebin]]   (defaults to scenes/desk.scene)
+ *        SceneCompile --bench [objects]           (defaults to 100000 objects)
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "../headers/Scene.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// milliseconds since start
+double elapsedMs(Clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// "scenes/desk.scene" -> "scenes/desk.scenebin"
+std::string binaryPathFor(const std::string& filename)
+{
+    std::string::size_type dot = filename.find_last_of('.');
+    std::string::size_type slash = filename.find_last_of("/\\");
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+        return filename + ".scenebin";
+    return filename.substr(0, dot) + ".scenebin";
+}
+
+// compile one scene. returns a boolean to show whether the process was successful or not
+bool compileScene(const char* filename, const std::string& outFilename)
+{
+    Scene scene;
+    if (!scene.load(filename))
+    {
+        std::cout << "Failed to load scene " << filename << std::endl;
+        return false;
+    }
+
+    if (!scene.writeBinary(outFilename.c_str()))
+    {
+        std::cout << "Failed to write " << outFilename << std::endl;
+        return false;
+    }
+
+    std::cout << filename << " -> " << outFilename << " (" << scene.getObjectCount() << " objects, "
+              << scene.getMeshCount() << " meshes, " << scene.getMaterialCount() << " materials, "
+              << scene.getTextureCount() << " textures, " << scene.getLightCount() << " lights)" << std::endl;
+    return true;
+}
+
+// generate a scene of random objects, then time text parsing against binary loading
+bool benchScene(int objectCount)
+{
+    std::ostringstream text;
+    text << "texture glass textures/glass.jpg\n"
+         << "texture pen textures/pen.jpg\n"
+         << "mesh ball sphere 0.5 24 12 smooth\n"
+         << "mesh tube cylinder 0.5 0.5 2.0 24 12 smooth\n"
+         << "mesh cone cylinder 0.5 0 1.0 24 12 flat\n"
+         << "material glass object glass\n"
+         << "material pen object pen textureScale 2 2\n"
+         << "light 0 4 2 1 1 1 scale 0.2\n";
+
+    const char* meshNames[] = { "ball", "tube", "cone" };
+    const char* materialNames[] = { "glass", "pen" };
+    srand(330);
+    for (int i = 0; i < objectCount; ++i)
+    {
+        text << "object " << meshNames[rand() % 3] << " " << materialNames[rand() % 2]
+             << " translate " << rand() % 200 - 100 << " " << rand() % 200 - 100 << " " << rand() % 200 - 100
+             << " rotate " << rand() % 360 << " 0 1 0 scale " << (rand() % 100 + 1) * 0.01f << "\n";
+    }
+
+    const char* textFilename = "bench.scene";
+    const char* binaryFilename = "bench.scenebin";
+    std::string source = text.str();
+    FILE* out = fopen(textFilename, "wb");
+    if (!out)
+        return false;
+    fwrite(source.data(), 1, source.size(), out);
+    fclose(out);
+
+    Scene scene;
+    Clock::time_point start = Clock::now();
+    bool ok = scene.load(textFilename);
+    double textMs = elapsedMs(start);
+    ok = ok && scene.writeBinary(binaryFilename);
+    scene.clear();
+
+    start = Clock::now();
+    ok = ok && scene.load(binaryFilename);
+    double binaryMs = elapsedMs(start);
+
+    // touch every matrix so the binary time includes faulting the pages in
+    double sum = 0.0;
+    for (unsigned int i = 0; ok && i < scene.getObjectCount(); ++i)
+        sum += scene.getModelMatrix(i)[12];
+    double touchMs = elapsedMs(start);
+
+    std::cout << objectCount << " objects: text " << textMs << " ms, binary " << binaryMs
+              << " ms (" << touchMs << " ms with all matrices read, checksum " << sum << ")" << std::endl;
+
+    scene.clear();
+    remove(textFilename);
+    remove(binaryFilename);
+    return ok;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc > 1 && std::string(argv[1]) == "--bench")
+        return benchScene(argc > 2 ? atoi(argv[2]) : 100000) ? 0 : 1;
+
+    const char* filename = argc > 1 ? argv[1] : "scenes/desk.scene";
+    std::string outFilename = argc > 2 ? argv[2] : binaryPathFor(filename);
+    return compileScene(filename, outFilename) ? 0 : 1;
+}
@@ -0,0 +1,87 @@
+/*
+ * Description: Prints the fewest triangles the UV sphere (Sphere), the
+ *              icosphere (Icosphere) and the cube-sphere (Cubesphere) need to
+ *              stay within a maximum chord error: the largest distance between
+ *              the sphere and its mesh, as a fraction of the radius. Equal
+ *              chord error means an equally round silhouette, so the counts
+ *              are the triangle budgets of the three topologies at the same
+ *              visual quality. The UV sphere uses 2 sectors per stack, as the
+ *              scene does.
+ *
+ * Build (from the CS330Project directory):
+ *   cl /O2 /EHsc /std:c++17 tools\SphereBudget.cpp headers\SphereTopology.cpp headers\Icosphere.cpp headers\Cubesphere.cpp headers\Sphere.cpp headers\MeshKernels.cpp headers\VertexFormat.cpp opengl32.lib
+ *   g++ -O2 -std=c++17 -o SphereBudget tools/SphereBudget.cpp headers/SphereTopology.cpp headers/Icosphere.cpp headers/Cubesphere.cpp headers/Sphere.cpp headers/MeshKernels.cpp headers/VertexFormat.cpp -lGL -pthread
+ *
+ * Usage: SphereBudget [maxError ...]   (defaults to 0.01 0.005 0.001 0.0005)
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "../headers/Cubesphere.h"
+#include "../headers/Icosphere.h"
+#include "../headers/SphereTopology.h"
+
+const int MAX_UV_STACKS = 1024;
+
+// fewest stacks (with 2 sectors each) of a UV sphere within maxError; the error is only measured around the answer
+int getUVStacksForError(float maxError)
+{
+    int high = 2;
+    while (high < MAX_UV_STACKS && getUVSphereChordError(high * 2, high) > maxError)
+        high *= 2;
+
+    int low = high / 2;
+    while (high - low > 1 && low >= 2)
+    {
+        int middle = (low + high) / 2;
+        if (getUVSphereChordError(middle * 2, middle) > maxError)
+            low = middle;
+        else
+            high = middle;
+    }
+    return high;
+}
+
+int main(int argc, char** argv)
+{
+    std::vector<float> errors;
+    for (int i = 1; i < argc; ++i)
+    {
+        float error = (float)atof(argv[i]);
+        if (error > 0.0f)
+            errors.push_back(error);
+    }
+    if (errors.empty())
+    {
+        const float DEFAULT_ERRORS[] = { 0.01f, 0.005f, 0.001f, 0.0005f };
+        errors.assign(DEFAULT_ERRORS, DEFAULT_ERRORS + 4);
+    }
+
+    // each column: triangles, tessellation, achieved chord error
+    printf("%-9s  %-29s  %-25s  %-25s  %s\n", "max error", "UV sphere (sectors x stacks)", "icosphere (frequency)",
+           "cube-sphere (segments)", "ico/UV  cube/UV");
+    for (std::size_t i = 0; i < errors.size(); ++i)
+    {
+        float maxError = errors[i];
+
+        // smooth UV spheres: 2 triangles per quad, 1 per sector in the first and last stacks
+        int stacks = getUVStacksForError(maxError);
+        int sectors = stacks * 2;
+        unsigned int uvTriangles = (unsigned int)(sectors * (stacks - 1) * 2);
+
+        int frequency = Icosphere::getFrequencyForError(maxError);
+        int segments = Cubesphere::getSegmentCountForError(maxError);
+        unsigned int icoTriangles = Icosphere::getTriangleCount(frequency);
+        unsigned int cubeTriangles = Cubesphere::getTriangleCount(segments);
+
+        char uv[64], ico[64], cube[64];
+        snprintf(uv, sizeof(uv), "%8u %4dx%-4d %.6f", uvTriangles, sectors, stacks, getUVSphereChordError(sectors, stacks));
+        snprintf(ico, sizeof(ico), "%8u %-6d %.6f", icoTriangles, frequency, Icosphere::getChordError(frequency));
+        snprintf(cube, sizeof(cube), "%8u %-6d %.6f", cubeTriangles, segments, Cubesphere::getChordError(segments));
+        printf("%-9g  %-29s  %-25s  %-25s  %5.1f%%  %5.1f%%\n", maxError, uv, ico, cube,
+               100.0 * icoTriangles / uvTriangles, 100.0 * cubeTriangles / uvTriangles);
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * Description: Asset bake step that converts the scene textures into
+ *              block-compressed KTX files with a precomputed mip chain.
+ *              TextureLoader picks up "<name>.ktx" next to the source image
+ *              and falls back to decoding the JPG/PNG when it is missing.
+ *              Images that are not a power of two in size also get
+ *              "<name>.layer.ktx", resampled to their texture array size
+ *              class, so texture array layers stay compressed too.
+ *
+ * Build (from the CS330Project directory):
+ *   cl /O2 /EHsc tools\TextureBake.cpp headers\TextureCompress.cpp headers\ImageProcess.cpp
+ *   g++ -O2 -o TextureBake tools/TextureBake.cpp headers/TextureCompress.cpp headers/ImageProcess.cpp
+ *
+ * Usage: TextureBake [image ...]   (defaults to the textures used by the scene)
+ */
+
+#include <iostream>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include "../headers/stb_image.h"
+#include "../headers/ImageProcess.h"
+#include "../headers/TextureCompress.h"
+
+// largest texture array layer baked, the default maxLayerSize of TextureArraySet
+const int LAYER_MAX_SIZE = 1024;
+
+// textures loaded by Source.cpp
+const char* const DEFAULT_TEXTURES[] =
+{
+    "textures/glass.jpg",
+    "textures/Label.png",
+    "textures/plane.jpg",
+    "textures/pen.jpg",
+    "textures/box.jpg",
+    "textures/perfume.jpg"
+};
+
+// decode, compress and write one texture. returns a boolean to show whether the process was successful or not
+bool bakeTexture(const char* filename)
+{
+    int width, height, channels;
+    unsigned char* image = stbi_load(filename, &width, &height, &channels, 0); // load image
+    if (!image)
+    {
+        std::cout << "Failed to load texture " << filename << std::endl;
+        return false;
+    }
+
+    // same preprocessing as TextureLoader: flip, premultiplied alpha and a filtered mip chain
+    PreparedImage prepared;
+    bool ok = prepared.prepare(image, width, height, channels,
+                               IMAGE_FLIP_VERTICAL | IMAGE_PREMULTIPLY_ALPHA | IMAGE_BUILD_MIPS);
+    stbi_image_free(image);
+
+    CompressedImage compressed;
+    if (!ok || !compressImage(prepared, compressed))
+    {
+        std::cout << "Not implemented to handle image with " << channels << " channels" << std::endl;
+        return false;
+    }
+
+    std::string outFilename = ktxPathFor(filename);
+    if (!writeKtx(outFilename.c_str(), compressed))
+    {
+        std::cout << "Failed to write " << outFilename << std::endl;
+        return false;
+    }
+
+    // report the GPU memory of the compressed chain against uncompressed RGB(A)8 + mipmaps
+    std::size_t compressedBytes = 0;
+    for (std::size_t i = 0; i < compressed.levels.size(); ++i)
+        compressedBytes += compressed.levels[i].size();
+    std::size_t rawBytes = (std::size_t)width * height * channels * 4 / 3;
+
+    std::cout << filename << " -> " << outFilename << " (" << width << "x" << height << ", "
+              << (channels == 4 ? "BC3" : "BC1") << ", " << compressed.levels.size() << " levels, "
+              << compressedBytes / 1024 << " KB vs " << rawBytes / 1024 << " KB)" << std::endl;
+
+    // texture array layers need a power-of-two size class; bake one when the image is not one already
+    if ((width & (width - 1)) == 0 && (height & (height - 1)) == 0)
+        return true;
+
+    int layerWidth = nearestPowerOfTwo(width, LAYER_MAX_SIZE);
+    int layerHeight = nearestPowerOfTwo(height, LAYER_MAX_SIZE);
+    std::string layerFilename = layerKtxPathFor(filename);
+    CompressedImage layer;
+    if (!prepared.resize(layerWidth, layerHeight, IMAGE_BUILD_MIPS) || !compressImage(prepared, layer) ||
+        !writeKtx(layerFilename.c_str(), layer))
+    {
+        std::cout << "Failed to write " << layerFilename << std::endl;
+        return false;
+    }
+    std::cout << filename << " -> " << layerFilename << " (" << layerWidth << "x" << layerHeight << ")" << std::endl;
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    bool ok = true;
+    if (argc > 1)
+    {
+        for (int i = 1; i < argc; ++i)
+            ok = bakeTexture(argv[i]) && ok;
+    }
+    else
+    {
+        for (std::size_t i = 0; i < sizeof(DEFAULT_TEXTURES) / sizeof(DEFAULT_TEXTURES[0]); ++i)
+            ok = bakeTexture(DEFAULT_TEXTURES[i]) && ok;
+    }
+
+    return ok ? 0 : 1;
+}